@@ -0,0 +1,77 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include "main.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include <windows.h>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <tclap/CmdLine.h>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+#include "read_batch.hpp"
+#include "read_string.hpp"
+#include "scanner.hpp"
+#include "write_batch.hpp"
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    std::cout << "HadesMem Benchmarks [" << HADESMEM_VERSION_STRING << "]\n";
+
+    TCLAP::CmdLine cmd{"Benchmarks", ' ', HADESMEM_VERSION_STRING};
+    TCLAP::ValueArg<std::size_t> iterations_arg{
+      "", "iterations", "Iterations per benchmark", false, 100, "int", cmd};
+    TCLAP::ValueArg<std::string> filter_arg{
+      "", "filter", "Only run the named benchmark", false, "", "string", cmd};
+    cmd.parse(argc, argv);
+
+    std::size_t const iterations = iterations_arg.getValue();
+    std::string const filter = filter_arg.getValue();
+    auto const should_run = [&](std::string const& name) {
+      return filter.empty() || filter == name;
+    };
+
+    hadesmem::Process const process(::GetCurrentProcessId());
+
+    if (should_run("read_batch"))
+    {
+      hadesmem::bench::BenchReadBatch(process, iterations);
+    }
+
+    if (should_run("read_string"))
+    {
+      hadesmem::bench::BenchReadString(process, iterations);
+    }
+
+    if (should_run("scanner"))
+    {
+      hadesmem::bench::BenchScanner(process, iterations);
+    }
+
+    if (should_run("write_batch"))
+    {
+      hadesmem::bench::BenchWriteBatch(process, iterations);
+    }
+
+    std::cout << "\nDone.\n";
+
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << "\nError!\n";
+    std::cerr << boost::current_exception_diagnostic_information() << '\n';
+
+    return 1;
+  }
+}
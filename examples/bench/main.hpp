@@ -0,0 +1,42 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace hadesmem
+{
+namespace bench
+{
+// Runs func the given number of times and returns the average time per
+// iteration in microseconds.
+template <typename Func> double TimeIt(std::size_t iterations, Func func)
+{
+  auto const beg = std::chrono::high_resolution_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+  {
+    func();
+  }
+  auto const end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> const elapsed = end - beg;
+  return elapsed.count() / static_cast<double>(iterations ? iterations : 1);
+}
+
+inline void PrintResult(std::string const& name, double us, double baseline_us)
+{
+  std::cout << "  " << std::left << std::setw(40) << name << std::right
+            << std::fixed << std::setprecision(2) << std::setw(12) << us
+            << " us";
+  if (baseline_us > 0 && us > 0)
+  {
+    std::cout << std::setw(10) << (baseline_us / us) << "x";
+  }
+  std::cout << '\n';
+}
+}
+}
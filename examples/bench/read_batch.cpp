@@ -0,0 +1,93 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include "read_batch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+
+#include "main.hpp"
+
+namespace
+{
+// Typical game-style object list, where we want a couple of fields out of
+// every element.
+struct Entity
+{
+  float pos[3];
+  float rot[4];
+  std::int32_t health;
+  std::int32_t team;
+  void* next;
+  char name[32];
+};
+
+std::size_t const kNumEntities = 1000;
+}
+
+namespace hadesmem
+{
+namespace bench
+{
+void BenchReadBatch(hadesmem::Process const& process, std::size_t iterations)
+{
+  std::cout << "\nReadBatch (" << kNumEntities
+            << " entities, 3 fields each):\n";
+
+  // The entities live in our own process, but all reads still go through
+  // ReadProcessMemory so the per-call overhead is representative.
+  std::vector<Entity> entities(kNumEntities);
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    entities[i].health = static_cast<std::int32_t>(i);
+    entities[i].team = static_cast<std::int32_t>(i % 2);
+    entities[i].next = &entities[(i + 1) % entities.size()];
+  }
+
+  std::vector<std::int32_t> health(entities.size());
+  std::vector<std::int32_t> team(entities.size());
+  std::vector<void*> next(entities.size());
+
+  double const individual_us = TimeIt(iterations, [&]() {
+    for (std::size_t i = 0; i < entities.size(); ++i)
+    {
+      health[i] = hadesmem::Read<std::int32_t>(process, &entities[i].health);
+      team[i] = hadesmem::Read<std::int32_t>(process, &entities[i].team);
+      next[i] = hadesmem::Read<void*>(process, &entities[i].next);
+    }
+  });
+  PrintResult("Read<T> per field", individual_us, 0);
+
+  std::vector<hadesmem::ReadRequest> requests;
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    requests.push_back(
+      hadesmem::MakeReadRequest(&entities[i].health, health[i]));
+    requests.push_back(hadesmem::MakeReadRequest(&entities[i].team, team[i]));
+    requests.push_back(hadesmem::MakeReadRequest(&entities[i].next, next[i]));
+  }
+
+  for (std::size_t const gap : {std::size_t{0},
+                                std::size_t{0x40},
+                                hadesmem::detail::kReadBatchDefaultMergeGap,
+                                std::size_t{0x1000}})
+  {
+    std::size_t num_reads = 0;
+    double const batch_us = TimeIt(iterations, [&]() {
+      num_reads = hadesmem::ReadBatch(process, requests, gap);
+    });
+    PrintResult("ReadBatch gap=" + std::to_string(gap) + " reads=" +
+                  std::to_string(num_reads),
+                batch_us,
+                individual_us);
+  }
+}
+}
+}
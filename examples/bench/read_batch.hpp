@@ -0,0 +1,16 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+namespace bench
+{
+void BenchReadBatch(hadesmem::Process const& process, std::size_t iterations);
+}
+}
@@ -0,0 +1,106 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include "read_string.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/find_terminator.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+
+#include "main.hpp"
+
+namespace
+{
+// Roughly the length of a typical export or import name.
+std::size_t const kNumShortStrings = 1000;
+std::size_t const kShortStringLen = 24;
+
+// Pathological names seen in malformed files.
+std::size_t const kLongStringLen = 4 * 1024 * 1024;
+
+template <typename CharT>
+void BenchTerminatorScan(std::string const& name, std::size_t iterations)
+{
+  std::vector<CharT> buf(kLongStringLen, static_cast<CharT>('A'));
+  buf.back() = CharT();
+  CharT const* found = nullptr;
+
+  double const find_us = TimeIt(iterations, [&]() {
+    found = std::find(buf.data(), buf.data() + buf.size(), CharT());
+  });
+  PrintResult("std::find " + name, find_us, 0);
+
+  double const simd_us = TimeIt(iterations, [&]() {
+    found = hadesmem::detail::FindTerminator(buf.data(),
+                                             buf.data() + buf.size());
+  });
+  PrintResult("FindTerminator " + name, simd_us, find_us);
+
+  if (found != &buf.back())
+  {
+    std::cout << "  Mismatch!\n";
+  }
+}
+}
+
+namespace hadesmem
+{
+namespace bench
+{
+void BenchReadString(hadesmem::Process const& process, std::size_t iterations)
+{
+  std::cout << "\nReadString:\n";
+
+  BenchTerminatorScan<char>("(4MB char)", iterations);
+  BenchTerminatorScan<wchar_t>("(4MB wchar_t)", iterations);
+
+  // Short strings, where the number of reads dominates.
+  std::vector<std::string> short_strings(
+    kNumShortStrings, std::string(kShortStringLen, 'A'));
+  std::size_t total = 0;
+  double const fixed_us = TimeIt(iterations, [&]() {
+    for (auto& s : short_strings)
+    {
+      total +=
+        hadesmem::ReadStringEx<char>(process, &s[0], kShortStringLen / 4)
+          .size();
+    }
+  });
+  PrintResult("ReadStringEx short, small chunk", fixed_us, 0);
+
+  double const short_us = TimeIt(iterations, [&]() {
+    for (auto& s : short_strings)
+    {
+      total += hadesmem::ReadString<char>(process, &s[0]).size();
+    }
+  });
+  PrintResult("ReadString short", short_us, fixed_us);
+
+  // A single long string, where the chunk growth keeps the number of reads
+  // logarithmic rather than linear in the length.
+  std::string long_string(kLongStringLen, 'A');
+  double const long_us = TimeIt(iterations, [&]() {
+    total += hadesmem::ReadString<char>(process, &long_string[0]).size();
+  });
+  PrintResult("ReadString 4MB", long_us, 0);
+
+  double const bounded_us = TimeIt(iterations, [&]() {
+    total += hadesmem::ReadStringBounded<char>(
+               process, &long_string[0], &long_string[1024])
+               .size();
+  });
+  PrintResult("ReadStringBounded 4MB (1KB bound)", bounded_us, long_us);
+
+  if (!total)
+  {
+    std::cout << "  Mismatch!\n";
+  }
+}
+}
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include "scanner.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/scanner.hpp>
+
+#include "main.hpp"
+
+namespace
+{
+std::size_t const kBufferSize = 256 * 1024 * 1024;
+
+double GetThroughput(double us)
+{
+  return us > 0 ? (kBufferSize / (1024.0 * 1024.0 * 1024.0)) / (us / 1e6) : 0;
+}
+}
+
+namespace hadesmem
+{
+namespace bench
+{
+void BenchScanner(hadesmem::Process const& process, std::size_t iterations)
+{
+  std::cout << "\nScanner (256MB, exact std::uint32_t):\n";
+
+  // Scanning a snapshot keeps the numbers independent of the cost of
+  // ReadProcessMemory, so this measures the scan itself and how it scales.
+  std::vector<std::uint32_t> snapshot(kBufferSize / sizeof(std::uint32_t));
+  for (std::size_t i = 0; i < snapshot.size(); ++i)
+  {
+    snapshot[i] = static_cast<std::uint32_t>(i * 2654435761U);
+  }
+  hadesmem::BufferMemorySource const snapshot_source{snapshot.data(),
+                                                     kBufferSize};
+
+  std::size_t found = 0;
+  double single_us = 0;
+  for (std::size_t const num_threads :
+       {std::size_t{1},
+        std::size_t{2},
+        std::size_t{4},
+        static_cast<std::size_t>(std::thread::hardware_concurrency())})
+  {
+    hadesmem::ScanOptions options;
+    options.num_threads = num_threads;
+    hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{
+      snapshot_source, options};
+    double const us = TimeIt(iterations, [&]() {
+      found += scanner.ScanExact(std::uint32_t{12345}).size();
+    });
+    if (num_threads == 1)
+    {
+      single_us = us;
+    }
+    PrintResult("threads=" + std::to_string(num_threads) + " GB/s=" +
+                  std::to_string(GetThroughput(us)),
+                us,
+                single_us);
+  }
+
+  // The same buffer through ReadProcessMemory.
+  hadesmem::ProcessMemorySource const process_source{process};
+  hadesmem::ScanOptions options;
+  options.start = snapshot.data();
+  options.end = snapshot.data() + snapshot.size();
+  hadesmem::Scanner<hadesmem::ProcessMemorySource> const scanner{
+    process_source, options};
+  double const process_us = TimeIt(iterations, [&]() {
+    found += scanner.ScanExact(std::uint32_t{12345}).size();
+  });
+  PrintResult("ProcessMemorySource GB/s=" +
+                std::to_string(GetThroughput(process_us)),
+              process_us,
+              single_us);
+
+  if (!found)
+  {
+    std::cout << "  No matches!\n";
+  }
+}
+}
+}
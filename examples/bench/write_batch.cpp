@@ -0,0 +1,107 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include "write_batch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/alloc.hpp>
+#include <hadesmem/patch_raw.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/protect.hpp>
+#include <hadesmem/write_batch.hpp>
+
+#include "main.hpp"
+
+namespace
+{
+// Roughly what a typical game mod applies at startup.
+std::size_t const kNumPatches = 300;
+std::size_t const kPatchSpacing = 0x40;
+
+void PrintStats(std::string const& name,
+                hadesmem::WriteBatchStats const& stats)
+{
+  std::cout << "  " << name << ": suspensions=" << stats.suspensions
+            << " protect_changes=" << stats.protect_changes
+            << " writes=" << stats.writes << " flushes=" << stats.flushes
+            << '\n';
+}
+
+void AddStats(hadesmem::WriteBatchStats& total,
+              hadesmem::WriteBatchStats const& stats)
+{
+  total.suspensions += stats.suspensions;
+  total.protect_changes += stats.protect_changes;
+  total.writes += stats.writes;
+  total.flushes += stats.flushes;
+}
+}
+
+namespace hadesmem
+{
+namespace bench
+{
+void BenchWriteBatch(hadesmem::Process const& process, std::size_t iterations)
+{
+  std::cout << "\nWriteBatch (" << kNumPatches << " patches):\n";
+
+  // Patch targets are read-only code pages, as they would be in a real image.
+  hadesmem::Allocator const alloc{process, kNumPatches * kPatchSpacing};
+  auto const base = static_cast<std::uint8_t*>(alloc.GetBase());
+  hadesmem::Protect(process, base, PAGE_EXECUTE_READ);
+
+  std::vector<std::uint8_t> const patch_data{0x90, 0x90, 0xCC};
+  auto const get_target = [&](std::size_t i) {
+    return base + i * kPatchSpacing;
+  };
+
+  double const individual_us = TimeIt(iterations, [&]() {
+    std::vector<std::unique_ptr<hadesmem::PatchRaw>> patches;
+    for (std::size_t i = 0; i < kNumPatches; ++i)
+    {
+      patches.emplace_back(std::make_unique<hadesmem::PatchRaw>(
+        process, get_target(i), patch_data));
+      patches.back()->Apply();
+    }
+    // Removal happens on destruction, which is timed too, to match the
+    // Revert below.
+  });
+  PrintResult("PatchRaw::Apply per patch", individual_us, 0);
+
+  hadesmem::WriteBatch batch{process};
+  for (std::size_t i = 0; i < kNumPatches; ++i)
+  {
+    batch.Add(get_target(i), patch_data);
+  }
+
+  double const batch_us = TimeIt(iterations, [&]() {
+    batch.Apply();
+    batch.Revert();
+  });
+  PrintResult("WriteBatch::Apply", batch_us, individual_us);
+
+  // PatchRaw doesn't expose its counts, so apply each patch as its own batch
+  // with the same flags, which performs the same operations.
+  hadesmem::WriteBatchStats individual_stats{};
+  for (std::size_t i = 0; i < kNumPatches; ++i)
+  {
+    hadesmem::WriteBatch single{process};
+    single.Add(get_target(i), patch_data);
+    AddStats(individual_stats, single.Apply());
+    single.Revert();
+  }
+  PrintStats("Per patch", individual_stats);
+
+  PrintStats("Batched", batch.Apply());
+  batch.Revert();
+}
+}
+}
@@ -0,0 +1,197 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+// Micro-benchmark for the scanner's compare kernels (see
+// hadesmem/detail/compare_kernels.hpp). Everything runs on synthetic buffers
+// in this process, so unlike the main benchmarks it doesn't need Windows, and
+// can be built anywhere with e.g.:
+//
+//   g++ -std=c++14 -O2 -Iinclude/memory examples/compare_bench/main.cpp
+//
+// Usage: compare_bench [iterations] [buffer size in MB]
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/compare_kernels.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/scan_compare.hpp>
+
+#include "../bench/main.hpp"
+
+namespace
+{
+char const* GetSimdLevelName(hadesmem::detail::SimdLevel level)
+{
+  switch (level)
+  {
+  case hadesmem::detail::SimdLevel::kAvx2:
+    return "avx2";
+  case hadesmem::detail::SimdLevel::kSse2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+char const* GetCompareTypeName(hadesmem::ScanCompareType type)
+{
+  switch (type)
+  {
+  case hadesmem::ScanCompareType::kEqual:
+    return "==";
+  case hadesmem::ScanCompareType::kNotEqual:
+    return "!=";
+  case hadesmem::ScanCompareType::kLess:
+    return "<";
+  case hadesmem::ScanCompareType::kGreater:
+    return ">";
+  case hadesmem::ScanCompareType::kBetween:
+    return "between";
+  default:
+    return "approx";
+  }
+}
+
+std::uint64_t g_sink = 0;
+
+template <typename T>
+void BenchCompare(std::string const& type_name,
+                  std::vector<std::uint8_t> const& buf,
+                  std::size_t stride,
+                  hadesmem::ScanCompare<T> const& cmp,
+                  std::size_t iterations)
+{
+  std::size_t const count = (buf.size() - sizeof(T)) / stride + 1;
+  std::vector<std::uint64_t> mask(
+    hadesmem::detail::GetCompareMaskWords(count));
+  double const gb =
+    static_cast<double>(buf.size()) / (1024.0 * 1024.0 * 1024.0);
+
+  std::vector<hadesmem::detail::SimdLevel> levels{
+    hadesmem::detail::SimdLevel::kScalar};
+  auto const best = hadesmem::detail::GetSimdLevel();
+  if (best >= hadesmem::detail::SimdLevel::kSse2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kSse2);
+  }
+  if (best >= hadesmem::detail::SimdLevel::kAvx2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kAvx2);
+  }
+
+  double scalar_us = 0;
+  for (auto const level : levels)
+  {
+    double const us = hadesmem::bench::TimeIt(iterations, [&]() {
+      hadesmem::detail::CompareValues(
+        buf.data(), count, stride, cmp, mask.data(), level);
+      g_sink += mask[0] ^ mask.back();
+    });
+    if (level == hadesmem::detail::SimdLevel::kScalar)
+    {
+      scalar_us = us;
+    }
+    hadesmem::bench::PrintResult(
+      type_name + " " + GetCompareTypeName(cmp.type) + " stride=" +
+        std::to_string(stride) + " " + GetSimdLevelName(level) + " GB/s=" +
+        std::to_string(us > 0 ? gb / (us / 1e6) : 0),
+      us,
+      scalar_us);
+  }
+}
+
+template <typename T>
+void BenchType(std::string const& type_name,
+               std::vector<std::uint8_t> const& buf,
+               T value,
+               T upper,
+               std::size_t iterations)
+{
+  std::cout << "\n" << type_name << ":\n";
+
+  hadesmem::ScanCompare<T> cmp;
+  cmp.value = value;
+  cmp.upper = upper;
+  cmp.epsilon = static_cast<T>(1);
+  hadesmem::ScanCompareType const types[] = {
+    hadesmem::ScanCompareType::kEqual,
+    hadesmem::ScanCompareType::kLess,
+    hadesmem::ScanCompareType::kBetween,
+    hadesmem::ScanCompareType::kApprox};
+  for (auto const type : types)
+  {
+    cmp.type = type;
+    BenchCompare(type_name, buf, sizeof(T), cmp, iterations);
+  }
+
+  // Unaligned scans of multi-byte values.
+  if (sizeof(T) > 1)
+  {
+    cmp.type = hadesmem::ScanCompareType::kEqual;
+    BenchCompare(type_name, buf, 1, cmp, iterations);
+  }
+}
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t const iterations =
+    argc > 1 ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10))
+             : 20;
+  std::size_t const size_mb =
+    argc > 2 ? static_cast<std::size_t>(std::strtoul(argv[2], nullptr, 10))
+             : 64;
+
+  std::cout << "HadesMem Compare Kernel Benchmarks [" << HADESMEM_VERSION_STRING
+            << "]\n";
+  std::cout << "Buffer: " << size_mb << "MB, iterations: " << iterations
+            << ", best instruction set: "
+            << GetSimdLevelName(hadesmem::detail::GetSimdLevel()) << "\n";
+
+  // Pseudo-random contents, so that hits are rare and the branch predictor
+  // doesn't flatter the scalar loop.
+  std::vector<std::uint8_t> buf(size_mb * 1024 * 1024);
+  std::uint32_t state = 0x12345678;
+  for (auto& b : buf)
+  {
+    state = state * 1664525U + 1013904223U;
+    b = static_cast<std::uint8_t>(state >> 24);
+  }
+
+  BenchType<std::uint8_t>("std::uint8_t", buf, 0x42, 0x50, iterations);
+  BenchType<std::int16_t>("std::int16_t", buf, 1234, 2000, iterations);
+  BenchType<std::uint32_t>(
+    "std::uint32_t", buf, 12345, 1000000, iterations);
+  BenchType<std::int64_t>("std::int64_t", buf, 12345, 1000000, iterations);
+
+  // Floats in a sensible range rather than random bit patterns (which are
+  // mostly huge or tiny).
+  std::vector<std::uint8_t> float_buf(buf.size());
+  for (std::size_t i = 0; i + sizeof(float) <= float_buf.size();
+       i += sizeof(float))
+  {
+    float const f = static_cast<float>(buf[i] | (buf[i + 1] << 8)) / 64.0f;
+    std::memcpy(&float_buf[i], &f, sizeof(f));
+  }
+  BenchType<float>("float", float_buf, 100.0f, 200.0f, iterations);
+
+  std::vector<std::uint8_t> double_buf(buf.size());
+  for (std::size_t i = 0; i + sizeof(double) <= double_buf.size();
+       i += sizeof(double))
+  {
+    double const d = static_cast<double>(buf[i] | (buf[i + 1] << 8)) / 64.0;
+    std::memcpy(&double_buf[i], &d, sizeof(d));
+  }
+  BenchType<double>("double", double_buf, 100.0, 200.0, iterations);
+
+  std::cout << "\nDone. (" << g_sink % 2 << ")\n";
+
+  return 0;
+}
@@ -49,7 +49,8 @@ void DumpFile(std::wstring const& path)
     hadesmem::PeFile const pe_file(process,
                                    buf.data(),
                                    hadesmem::PeFileType::kData,
-                                   static_cast<DWORD>(buf.size()));
+                                   static_cast<DWORD>(buf.size()),
+                                   hadesmem::PeFileBacking::kBuffer);
 
     try
     {
@@ -3,7 +3,9 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void Toggle3D(hadesmem::Process const& process);
+void Toggle3D(hadesmem::Process const& process,
+              hadesmem::PatternScanContext const& context);
@@ -7,11 +7,14 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
-void SetMaxCameraDistance(hadesmem::Process const& process, float value)
+void SetMaxCameraDistance(hadesmem::Process const& process,
+                          hadesmem::PatternScanContext const& context,
+                          float value)
 {
   std::cout << "\nPreparing to set max camera distance.\n";
 
@@ -20,10 +23,11 @@ void SetMaxCameraDistance(hadesmem::Process const& process, float value)
   // .text:0038DFF3                   mov     ecx, dword_153C96C
   // .text:0038DFF9                   fstp    [ebp+var_4]
   // .text:0038DFFC                   call    sub_43C680
+  constexpr auto kGlobalPointerManagerRefPattern =
+    HADESMEM_PATTERN("D9 E8 8B 0D ?? ?? ?? ?? D9 5D FC E8");
   auto const global_pointer_manager_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"D9 E8 8B 0D ?? ?? ?? ?? D9 5D FC E8",
+    hadesmem::Find(context,
+                   kGlobalPointerManagerRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got global pointer manager ref. ["
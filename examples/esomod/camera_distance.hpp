@@ -3,7 +3,10 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void SetMaxCameraDistance(hadesmem::Process const& process, float value);
+void SetMaxCameraDistance(hadesmem::Process const& process,
+                          hadesmem::PatternScanContext const& context,
+                          float value);
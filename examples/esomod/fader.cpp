@@ -7,11 +7,13 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
-void ToggleFader(hadesmem::Process const& process)
+void ToggleFader(hadesmem::Process const& process,
+                 hadesmem::PatternScanContext const& context)
 {
   std::cout << "\nPreparing to toggle fader.\n";
 
@@ -20,10 +22,11 @@ void ToggleFader(hadesmem::Process const& process)
   // .text:011C391B                 lea     ebx, [esi+1C8h]
   // .text:011C3921                 fstp    dword ptr [ebx]
   // .text:011C3923                 cmp     ds:byte_21282AA, 0
+  constexpr auto kFaderFlagRefPattern =
+    HADESMEM_PATTERN("8D BE ?? ?? ?? ?? 8D 9E ?? ?? ?? ?? D9 1B 80 3D");
   auto const fader_flag_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"8D BE ?? ?? ?? ?? 8D 9E ?? ?? ?? ?? D9 1B 80 3D",
+    hadesmem::Find(context,
+                   kFaderFlagRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got fader flag ref. [" << static_cast<void*>(fader_flag_ref)
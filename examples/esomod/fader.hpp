@@ -3,7 +3,9 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void ToggleFader(hadesmem::Process const& process);
+void ToggleFader(hadesmem::Process const& process,
+                 hadesmem::PatternScanContext const& context);
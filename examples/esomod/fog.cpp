@@ -7,11 +7,13 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
-void ToggleFog(hadesmem::Process const& process)
+void ToggleFog(hadesmem::Process const& process,
+               hadesmem::PatternScanContext const& context)
 {
   std::cout << "\nPreparing to toggle fog.\n";
 
@@ -19,10 +21,11 @@ void ToggleFog(hadesmem::Process const& process)
   // .text:019122CF                 lea     ecx, [ebp-0C0h]
   // .text:019122D5                 call    sub_1919430
   // .text:019122DA                 cmp     ds:byte_21282AB, bl
+  constexpr auto kFogFlagRefPattern =
+    HADESMEM_PATTERN("8D 8D 40 FF FF FF E8 ?? ?? ?? ?? 38 1D");
   auto const fog_flag_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"8D 8D 40 FF FF FF E8 ?? ?? ?? ?? 38 1D",
+    hadesmem::Find(context,
+                   kFogFlagRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got fog flag ref. [" << static_cast<void*>(fog_flag_ref)
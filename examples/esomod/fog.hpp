@@ -3,7 +3,9 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void ToggleFog(hadesmem::Process const& process);
+void ToggleFog(hadesmem::Process const& process,
+               hadesmem::PatternScanContext const& context);
@@ -7,6 +7,7 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
@@ -21,17 +22,21 @@ float DegToRad(float f)
 }
 }
 
-void SetFov(hadesmem::Process const& process, float* third, float* first)
+void SetFov(hadesmem::Process const& process,
+            hadesmem::PatternScanContext const& context,
+            float* third,
+            float* first)
 {
   std::cout << "\nPreparing to set FoV.\n";
 
   // eso.live.1.1.2.995904 (dumped with module base of 0x00960000)
   // .text:00A58435                 jnz     loc_A58641
   // .text:00A5843B                 mov     edx, dword_1BCA930
+  constexpr auto kCameraManagerRefPattern =
+    HADESMEM_PATTERN("0F 85 ?? ?? ?? ?? 8B 15 ?? ?? ?? ?? 8B 4A 14");
   auto const camera_manager_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"0F 85 ?? ?? ?? ?? 8B 15 ?? ?? ?? ?? 8B 4A 14",
+    hadesmem::Find(context,
+                   kCameraManagerRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got camera manager ref. ["
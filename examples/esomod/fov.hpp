@@ -3,7 +3,11 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void SetFov(hadesmem::Process const& process, float* third, float* first);
+void SetFov(hadesmem::Process const& process,
+            hadesmem::PatternScanContext const& context,
+            float* third,
+            float* first);
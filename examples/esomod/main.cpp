@@ -161,6 +161,10 @@ int main(int argc, char* argv[])
         hadesmem::GetProcessByName(kProcName, false));
     }
 
+    // All of the patterns are in the main module, so its sections are only
+    // looked up and read once no matter how many of the options are set.
+    hadesmem::PatternScanContext const context{*process, L""};
+
     bool const set_fov_both = fov_arg.isSet();
     bool const set_fov_3p = fov_3p_arg.isSet();
     bool const set_fov_1p = fov_1p_arg.isSet();
@@ -175,28 +179,29 @@ int main(int argc, char* argv[])
       }
 
       float* fov_both = &fov_arg.getValue();
-      SetFov(*process, fov_both, fov_both);
+      SetFov(*process, context, fov_both, fov_both);
     }
     else if (set_fov_3p || set_fov_1p)
     {
       float* fov_3p = set_fov_3p ? &fov_3p_arg.getValue() : nullptr;
       float* fov_1p = set_fov_1p ? &fov_1p_arg.getValue() : nullptr;
-      SetFov(*process, fov_3p, fov_1p);
+      SetFov(*process, context, fov_3p, fov_1p);
     }
 
     if (max_camera_distance_arg.isSet())
     {
-      SetMaxCameraDistance(*process, max_camera_distance_arg.getValue());
+      SetMaxCameraDistance(
+        *process, context, max_camera_distance_arg.getValue());
     }
 
     if (time_arg.isSet())
     {
-      SetTime(*process, time_arg.getValue());
+      SetTime(*process, context, time_arg.getValue());
     }
 
     if (tone_mapping_arg.isSet())
     {
-      SetToneMappingType(*process, tone_mapping_arg.getValue());
+      SetToneMappingType(*process, context, tone_mapping_arg.getValue());
     }
 
     bool const set_min_view_distance = min_view_distance_arg.isSet();
@@ -210,23 +215,26 @@ int main(int argc, char* argv[])
         set_max_view_distance ? &max_view_distance_arg.getValue() : nullptr;
       auto const cur_view_distance =
         set_cur_view_distance ? &cur_view_distance_arg.getValue() : nullptr;
-      SetViewDistances(
-        *process, min_view_distance, max_view_distance, cur_view_distance);
+      SetViewDistances(*process,
+                       context,
+                       min_view_distance,
+                       max_view_distance,
+                       cur_view_distance);
     }
 
     if (fog_arg.isSet())
     {
-      ToggleFog(*process);
+      ToggleFog(*process, context);
     }
 
     if (anaglyph_arg.isSet())
     {
-      Toggle3D(*process);
+      Toggle3D(*process, context);
     }
 
     if (fader_arg.isSet())
     {
-      ToggleFader(*process);
+      ToggleFader(*process, context);
     }
 
     std::cout << "\nFinished.\n";
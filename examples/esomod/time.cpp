@@ -7,21 +7,24 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
-void SetTime(hadesmem::Process const& process, float time)
+void SetTime(hadesmem::Process const& process,
+             hadesmem::PatternScanContext const& context,
+             float time)
 {
   std::cout << "\nPreparing to set time.\n";
 
   // eso.live.1.1.3.998958 (dumped with module base of 0x002D0000)
   // .text:006A7E56                 fiadd   [ebp+var_8]
   // .text:006A7E59                 fstp    flt_133BDB0
+  constexpr auto kTimeRefPattern = HADESMEM_PATTERN("DA 45 F8 D9 1D");
   auto const time_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"DA 45 F8 D9 1D",
+    hadesmem::Find(context,
+                   kTimeRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got time ref. [" << static_cast<void*>(time_ref) << "].\n";
@@ -3,7 +3,10 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void SetTime(hadesmem::Process const& process, float time);
+void SetTime(hadesmem::Process const& process,
+             hadesmem::PatternScanContext const& context,
+             float time);
@@ -7,11 +7,14 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
-void SetToneMappingType(hadesmem::Process const& process, std::uint32_t type)
+void SetToneMappingType(hadesmem::Process const& process,
+                        hadesmem::PatternScanContext const& context,
+                        std::uint32_t type)
 {
   std::cout << "\nPreparing to set tone mapping type.\n";
 
@@ -20,10 +23,11 @@ void SetToneMappingType(hadesmem::Process const& process, std::uint32_t type)
   // .text:00C74BD0                 cmp     eax, ebx
   // .text:00C74BD2                 jz      short loc_C74BE0
   // .text:00C74BD4                 push    eax
+  constexpr auto kToneMappingTypeRefPattern =
+    HADESMEM_PATTERN("A1 ?? ?? ?? ?? 3B C3 74 0C 50");
   auto tone_mapping_type_ref =
-    static_cast<std::uint8_t*>(hadesmem::Find(process,
-                                              L"",
-                                              L"A1 ?? ?? ?? ?? 3B C3 74 0C 50",
+    static_cast<std::uint8_t*>(hadesmem::Find(context,
+                                              kToneMappingTypeRefPattern,
                                               hadesmem::PatternFlags::kNone,
                                               0));
   auto tone_mapping_type_ref_offset = 0x01;
@@ -41,10 +45,11 @@ void SetToneMappingType(hadesmem::Process const& process, std::uint32_t type)
     // .text:00E8A426                 lea     ecx, [ebp+var_C8]
     // .text:00E8A42C                 call    sub_1338A70
     // .text:00E8A431                 mov     ecx, ds:dword_1C0F7A8
+    constexpr auto kToneMappingTypeRefPattern2 =
+      HADESMEM_PATTERN("74 1D 8D 8D ?? ?? ?? ?? E8 ?? ?? ?? ?? 8B 0D");
     tone_mapping_type_ref = static_cast<std::uint8_t*>(
-      hadesmem::Find(process,
-                     L"",
-                     L"74 1D 8D 8D ?? ?? ?? ?? E8 ?? ?? ?? ?? 8B 0D",
+      hadesmem::Find(context,
+                     kToneMappingTypeRefPattern2,
                      hadesmem::PatternFlags::kThrowOnUnmatch,
                      0));
     tone_mapping_type_ref_offset = 0x0F;
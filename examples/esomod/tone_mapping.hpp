@@ -5,7 +5,10 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
-void SetToneMappingType(hadesmem::Process const& process, std::uint32_t type);
+void SetToneMappingType(hadesmem::Process const& process,
+                        hadesmem::PatternScanContext const& context,
+                        std::uint32_t type);
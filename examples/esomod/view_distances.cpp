@@ -7,11 +7,13 @@
 
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_pattern.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 #include <hadesmem/read.hpp>
 #include <hadesmem/write.hpp>
 
 void SetViewDistances(hadesmem::Process const& process,
+                      hadesmem::PatternScanContext const& context,
                       float* min,
                       float* max,
                       float* value)
@@ -23,10 +25,11 @@ void SetViewDistances(hadesmem::Process const& process,
   // .text:00CBCB1C                 fld     flt_1E82620
   // .text:00CBCB22                 fld     ds:flt_1C0F76C
   // .text:00CBCB28                 fcom    st(1)
+  constexpr auto kMaxAndCurViewDistanceRefPattern =
+    HADESMEM_PATTERN("74 ?? D9 05 ?? ?? ?? ?? D9 05 ?? ?? ?? ?? D8 D1");
   auto const max_and_cur_view_distance_ref = static_cast<std::uint8_t*>(
-    hadesmem::Find(process,
-                   L"",
-                   L"74 ?? D9 05 ?? ?? ?? ?? D9 05 ?? ?? ?? ?? D8 D1",
+    hadesmem::Find(context,
+                   kMaxAndCurViewDistanceRefPattern,
                    hadesmem::PatternFlags::kThrowOnUnmatch,
                    0));
   std::cout << "Got tone mapping type ref. ["
@@ -3,10 +3,12 @@
 
 namespace hadesmem
 {
+class PatternScanContext;
 class Process;
 }
 
 void SetViewDistances(hadesmem::Process const& process,
+                      hadesmem::PatternScanContext const& context,
                       float* min,
                       float* max,
                       float* value);
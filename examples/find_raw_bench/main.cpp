@@ -0,0 +1,277 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+// Benchmark for the raw pattern search used by FindPattern (see
+// hadesmem/detail/find_raw.hpp), against the std::search it replaced. The
+// patterns are searched for in a real .text section: by default that of
+// ntdll.dll on Windows and of this executable elsewhere, or of any PE file
+// given on the command line. Other files are searched as they are, so e.g.
+// the output of 'objcopy -O binary --only-section=.text' works too.
+//
+//   g++ -std=c++14 -O2 -Iinclude/memory examples/find_raw_bench/main.cpp
+//
+// Usage: find_raw_bench [iterations] [file]
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif // #if defined(_WIN32)
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/detail/simd.hpp>
+
+#include "../bench/main.hpp"
+
+namespace
+{
+char const* GetSimdLevelName(hadesmem::detail::SimdLevel level)
+{
+  switch (level)
+  {
+  case hadesmem::detail::SimdLevel::kAvx2:
+    return "avx2";
+  case hadesmem::detail::SimdLevel::kSse2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+template <typename T> T ReadField(std::uint8_t const* data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// Finds the .text section of a PE image, either as a file or as mapped by the
+// loader. Returns an empty range if the data isn't a PE image.
+std::pair<std::size_t, std::size_t>
+  GetPeTextSection(std::uint8_t const* data, std::size_t size, bool mapped)
+{
+  if (size < 0x40 || data[0] != 'M' || data[1] != 'Z')
+  {
+    return {0, 0};
+  }
+
+  auto const nt = ReadField<std::uint32_t>(data + 0x3C);
+  if (nt > size - 24 || std::memcmp(data + nt, "PE\0\0", 4))
+  {
+    return {0, 0};
+  }
+
+  auto const num_sections = ReadField<std::uint16_t>(data + nt + 6);
+  auto const optional_size = ReadField<std::uint16_t>(data + nt + 20);
+  std::size_t const sections = nt + 24 + optional_size;
+  for (std::size_t i = 0; i < num_sections; ++i)
+  {
+    std::uint8_t const* const section = data + sections + i * 40;
+    if (sections + (i + 1) * 40 > size)
+    {
+      break;
+    }
+
+    if (std::memcmp(section, ".text", 6))
+    {
+      continue;
+    }
+
+    auto const virtual_size = ReadField<std::uint32_t>(section + 8);
+    auto const virtual_address = ReadField<std::uint32_t>(section + 12);
+    auto const raw_size = ReadField<std::uint32_t>(section + 16);
+    auto const raw_address = ReadField<std::uint32_t>(section + 20);
+    std::size_t const beg = mapped ? virtual_address : raw_address;
+    std::size_t const len = mapped ? virtual_size : raw_size;
+    if (beg <= size && len <= size - beg)
+    {
+      return {beg, len};
+    }
+  }
+
+  return {0, 0};
+}
+
+std::vector<std::uint8_t> LoadText(char const* path)
+{
+  if (!path)
+  {
+#if defined(_WIN32)
+    auto const base =
+      reinterpret_cast<std::uint8_t const*>(::GetModuleHandleW(L"ntdll"));
+    auto const nt = ReadField<std::uint32_t>(base + 0x3C);
+    auto const image_size = ReadField<std::uint32_t>(base + nt + 24 + 56);
+    auto const text = GetPeTextSection(base, image_size, true);
+    return std::vector<std::uint8_t>(base + text.first,
+                                     base + text.first + text.second);
+#else  // #if defined(_WIN32)
+    path = "/proc/self/exe";
+#endif // #if defined(_WIN32)
+  }
+
+  std::ifstream file{path, std::ios::binary};
+  std::vector<std::uint8_t> const data{std::istreambuf_iterator<char>{file},
+                                       std::istreambuf_iterator<char>{}};
+  auto const text = GetPeTextSection(data.data(), data.size(), false);
+  if (!text.second)
+  {
+    return data;
+  }
+
+  return std::vector<std::uint8_t>(data.begin() + text.first,
+                                   data.begin() + text.first + text.second);
+}
+
+std::size_t FindWithSearch(
+  std::vector<std::uint8_t> const& haystack,
+  std::vector<hadesmem::detail::PatternDataByte> const& needle)
+{
+  auto const iter =
+    std::search(std::begin(haystack),
+                std::end(haystack),
+                std::begin(needle),
+                std::end(needle),
+                [](std::uint8_t h_cur,
+                   hadesmem::detail::PatternDataByte const& n_cur) {
+                  return (h_cur & n_cur.mask) == n_cur.value;
+                });
+  return iter == std::end(haystack)
+           ? hadesmem::detail::kNoPatternMatch
+           : static_cast<std::size_t>(iter - std::begin(haystack));
+}
+
+std::size_t g_sink = 0;
+
+void BenchPattern(std::string const& name,
+                  std::vector<std::uint8_t> const& text,
+                  std::vector<hadesmem::detail::PatternDataByte> const& needle,
+                  std::size_t iterations)
+{
+  std::size_t const expected = FindWithSearch(text, needle);
+  std::size_t const scanned = expected == hadesmem::detail::kNoPatternMatch
+                                ? text.size()
+                                : expected + needle.size();
+  double const gb = static_cast<double>(scanned) / (1024.0 * 1024.0 * 1024.0);
+  std::cout << "\n" << name << " (" << scanned << " bytes scanned):\n";
+
+  double const search_us = hadesmem::bench::TimeIt(
+    iterations, [&]() { g_sink += FindWithSearch(text, needle); });
+  hadesmem::bench::PrintResult(
+    "std::search GB/s=" + std::to_string(search_us > 0 ? gb / (search_us / 1e6)
+                                                        : 0),
+    search_us,
+    0);
+
+  auto const pattern =
+    hadesmem::detail::CompilePattern(std::begin(needle), std::end(needle));
+  std::vector<hadesmem::detail::SimdLevel> levels{
+    hadesmem::detail::SimdLevel::kScalar};
+  auto const best = hadesmem::detail::GetSimdLevel();
+  if (best >= hadesmem::detail::SimdLevel::kSse2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kSse2);
+  }
+  if (best >= hadesmem::detail::SimdLevel::kAvx2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kAvx2);
+  }
+
+  for (auto const level : levels)
+  {
+    std::size_t found = 0;
+    double const us = hadesmem::bench::TimeIt(iterations, [&]() {
+      found = hadesmem::detail::FindCompiledPattern(
+        text.data(), text.size(), pattern, level);
+      g_sink += found;
+    });
+    if (found != expected)
+    {
+      std::cout << "  Mismatch for " << GetSimdLevelName(level) << "!\n";
+    }
+    hadesmem::bench::PrintResult(
+      std::string{GetSimdLevelName(level)} + " GB/s=" +
+        std::to_string(us > 0 ? gb / (us / 1e6) : 0),
+      us,
+      search_us);
+  }
+}
+
+// Takes the pattern at the given offset, with the bytes at the given indices
+// wildcarded, as a signature for e.g. a displacement would be.
+std::vector<hadesmem::detail::PatternDataByte>
+  MakeNeedle(std::vector<std::uint8_t> const& text,
+             std::size_t offset,
+             std::size_t len,
+             std::vector<std::size_t> const& wildcards)
+{
+  std::vector<hadesmem::detail::PatternDataByte> needle;
+  for (std::size_t i = 0; i < len; ++i)
+  {
+    bool const wildcard =
+      std::find(std::begin(wildcards), std::end(wildcards), i) !=
+      std::end(wildcards);
+    needle.push_back(hadesmem::detail::PatternDataByte{
+      static_cast<std::uint8_t>(wildcard ? 0 : text[offset + i]),
+      static_cast<std::uint8_t>(wildcard ? 0 : 0xFF)});
+  }
+  return needle;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t const iterations =
+    argc > 1 ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10))
+             : 20;
+  auto const text = LoadText(argc > 2 ? argv[2] : nullptr);
+
+  std::cout << "HadesMem FindRaw Benchmarks [" << HADESMEM_VERSION_STRING
+            << "]\n";
+  std::cout << "Text: " << text.size() << " bytes, iterations: " << iterations
+            << ", best instruction set: "
+            << GetSimdLevelName(hadesmem::detail::GetSimdLevel()) << "\n";
+  if (text.size() < 0x1000)
+  {
+    std::cout << "Not enough code to search.\n";
+    return 1;
+  }
+
+  // A typical signature that isn't there, so the whole section is scanned.
+  BenchPattern("Missing",
+               text,
+               hadesmem::detail::ConvertData(
+                 L"48 8B 05 ?? ?? ?? ?? 48 85 C0 74 ?? 8B 4D F1 E9"),
+               iterations);
+
+  // Every byte is common, so there are lots of candidates to verify.
+  BenchPattern("Missing, common bytes",
+               text,
+               hadesmem::detail::ConvertData(L"00 00 48 8B ?? 24 00 00 FF"),
+               iterations);
+
+  // Signatures taken from the section, so they're found part way through.
+  std::size_t const offsets[] = {text.size() / 2, text.size() * 9 / 10};
+  std::vector<std::size_t> const wildcards = {3, 4, 5, 6, 11};
+  for (auto const offset : offsets)
+  {
+    BenchPattern("Found at " + std::to_string(offset),
+                 text,
+                 MakeNeedle(text, offset, 16, wildcards),
+                 iterations);
+  }
+
+  std::cout << "\nDone. (" << g_sink % 2 << ")\n";
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+// Compiles a pattern file to a pattern database (see
+// hadesmem/detail/pattern_database.hpp), which can be loaded with
+// hadesmem::PatternDatabase and passed to hadesmem::FindPattern instead of the
+// pattern file, so that nothing has to be parsed at runtime.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <tclap/CmdLine.h>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/filesystem.hpp>
+#include <hadesmem/detail/str_conv.hpp>
+#include <hadesmem/find_pattern.hpp>
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    std::cout << "HadesMem Pattern Compiler [" << HADESMEM_VERSION_STRING
+              << "]\n";
+
+    TCLAP::CmdLine cmd{"Pattern compiler", ' ', HADESMEM_VERSION_STRING};
+    TCLAP::ValueArg<std::string> input_arg{
+      "", "input", "Pattern file", true, "", "string", cmd};
+    TCLAP::ValueArg<std::string> output_arg{
+      "", "output", "Pattern database", true, "", "string", cmd};
+    cmd.parse(argc, argv);
+
+    auto const input_path =
+      hadesmem::detail::MultiByteToWideChar(input_arg.getValue());
+    auto const output_path =
+      hadesmem::detail::MultiByteToWideChar(output_arg.getValue());
+
+    auto const database = hadesmem::CompilePatternFile(input_path, false);
+
+    // Check that it loads before writing it out.
+    hadesmem::PatternDatabase const view{database.data(), database.size()};
+    std::cout << "\nModules: " << view.GetView().GetNumModules() << "\n";
+    std::cout << "Size: " << database.size() << " bytes\n";
+
+    hadesmem::detail::BufferToFile(
+      output_path,
+      database.data(),
+      static_cast<std::streamsize>(database.size()));
+
+    std::cout << "\nDone.\n";
+
+    return 0;
+  }
+  catch (...)
+  {
+    std::cerr << "\nError!\n";
+    std::cerr << boost::current_exception_diagnostic_information() << '\n';
+
+    return 1;
+  }
+}
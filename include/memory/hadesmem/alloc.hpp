@@ -11,6 +11,7 @@
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/trace.hpp>
 #include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/query_region.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/process.hpp>
 
@@ -20,11 +21,17 @@ namespace detail
 {
 inline PVOID TryAlloc(Process const& process, SIZE_T size, PVOID base = nullptr)
 {
-  return ::VirtualAllocEx(process.GetHandle(),
-                          base,
-                          size,
-                          MEM_COMMIT | MEM_RESERVE,
-                          PAGE_EXECUTE_READWRITE);
+  PVOID const address = ::VirtualAllocEx(process.GetHandle(),
+                                         base,
+                                         size,
+                                         MEM_COMMIT | MEM_RESERVE,
+                                         PAGE_EXECUTE_READWRITE);
+  if (address)
+  {
+    InvalidateRegionCache(process, address, size);
+  }
+
+  return address;
 }
 }
 
@@ -43,18 +50,25 @@ inline PVOID Alloc(Process const& process, SIZE_T size, PVOID base = nullptr)
                                     << ErrorCodeWinLast{last_error});
   }
 
+  detail::InvalidateRegionCache(process, address, size);
+
   return address;
 }
 
 inline void Free(Process const& process, LPVOID address)
 {
+  // The size of the allocation isn't known here and it may span multiple cached
+  // regions, so just drop everything.
   if (!::VirtualFreeEx(process.GetHandle(), address, 0, MEM_RELEASE))
   {
     DWORD const last_error = ::GetLastError();
+    detail::InvalidateRegionCache(process);
     HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                     << ErrorString{"VirtualFreeEx failed."}
                                     << ErrorCodeWinLast{last_error});
   }
+
+  detail::InvalidateRegionCache(process);
 }
 
 class Allocator
@@ -0,0 +1,262 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/detail/write_impl.hpp>
+#include <hadesmem/page_cache.hpp>
+#include <hadesmem/process.hpp>
+
+namespace hadesmem
+{
+struct CachedProcessViewFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    // Successful writes update the cached copy instead of invalidating it.
+    kWriteThrough = 1 << 0,
+    // Fetch pages with ReadFlags::kAssumeAccessible. Faster, but the direct
+    // read will trip (and so consume) a PAGE_GUARD rather than reporting it.
+    kAssumeAccessible = 1 << 1
+  };
+};
+
+namespace detail
+{
+inline void ReadCached(Process const& process,
+                       PageCache& cache,
+                       void* address,
+                       void* data,
+                       std::size_t len,
+                       std::uint32_t read_flags = ReadFlags::kNone)
+{
+  cache.Read(
+    address, data, len, [&](void* page, void* buf, std::size_t buf_len) {
+      ReadImpl(process, page, buf, buf_len, read_flags);
+    });
+}
+
+template <typename CharT>
+std::basic_string<CharT>
+  ReadStringCached(Process const& process,
+                   PageCache& cache,
+                   void* address,
+                   void* upper_bound = nullptr,
+                   std::uint32_t read_flags = ReadFlags::kNone)
+{
+  return cache.ReadString<CharT>(
+    address,
+    [&](void* page, void* buf, std::size_t buf_len) {
+      ReadImpl(process, page, buf, buf_len, read_flags);
+    },
+    upper_bound);
+}
+
+inline void WriteCached(Process const& process,
+                        PageCache& cache,
+                        void* address,
+                        void const* data,
+                        std::size_t len,
+                        bool write_through)
+{
+  try
+  {
+    WriteImpl(process, address, data, len);
+  }
+  catch (...)
+  {
+    // The write may have partially succeeded.
+    cache.Invalidate(address, len);
+    throw;
+  }
+
+  if (write_through)
+  {
+    cache.Update(address, data, len);
+  }
+  else
+  {
+    cache.Invalidate(address, len);
+  }
+}
+}
+
+// Wraps a Process and serves reads from a local page cache (see PageCache).
+// Useful for tools which repeatedly read the same small structures, such as
+// walking the headers and directories of a live image or polling the state
+// of a game every frame.
+//
+// Call NewEpoch whenever the target may have changed its memory. Copies share
+// the same cache.
+class CachedProcessView
+{
+public:
+  explicit CachedProcessView(
+    Process const& process,
+    std::size_t budget = PageCache::kDefaultBudget,
+    std::uint32_t flags = CachedProcessViewFlags::kNone)
+    : process_{&process},
+      cache_{std::make_shared<PageCache>(budget)},
+      flags_{flags}
+  {
+  }
+
+  explicit CachedProcessView(
+    Process const&& process,
+    std::size_t budget = PageCache::kDefaultBudget,
+    std::uint32_t flags = CachedProcessViewFlags::kNone) = delete;
+
+  Process const& GetProcess() const noexcept
+  {
+    return *process_;
+  }
+
+  // Shared so that it can also be attached to a PeFile (see
+  // PeFile::SetPageCache).
+  std::shared_ptr<PageCache> GetPageCache() const noexcept
+  {
+    return cache_;
+  }
+
+  std::uint32_t GetFlags() const noexcept
+  {
+    return flags_;
+  }
+
+  template <typename T> T Read(PVOID address) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    T data;
+    detail::ReadCached(*process_,
+                       *cache_,
+                       address,
+                       std::addressof(data),
+                       sizeof(T),
+                       GetReadFlags());
+    return data;
+  }
+
+  template <typename T, typename Alloc = std::allocator<T>>
+  std::vector<T, Alloc> ReadVector(PVOID address, std::size_t count) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(count ? address != nullptr : true);
+
+    if (!count)
+    {
+      return {};
+    }
+
+    std::vector<T, Alloc> data(count);
+    detail::ReadCached(*process_,
+                       *cache_,
+                       address,
+                       data.data(),
+                       sizeof(T) * count,
+                       GetReadFlags());
+    return data;
+  }
+
+  template <typename T> std::basic_string<T> ReadString(PVOID address) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsCharType<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    return detail::ReadStringCached<T>(
+      *process_, *cache_, address, nullptr, GetReadFlags());
+  }
+
+  template <typename T> void Write(PVOID address, T const& data) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    detail::WriteCached(*process_,
+                        *cache_,
+                        address,
+                        std::addressof(data),
+                        sizeof(T),
+                        IsWriteThrough());
+  }
+
+  template <typename T>
+  void WriteVector(PVOID address, std::vector<T> const& data) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+    HADESMEM_DETAIL_ASSERT(!data.empty());
+
+    detail::WriteCached(*process_,
+                        *cache_,
+                        address,
+                        data.data(),
+                        sizeof(T) * data.size(),
+                        IsWriteThrough());
+  }
+
+  template <typename T>
+  void WriteString(PVOID address, std::basic_string<T> const& data) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsCharType<T>::value);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    detail::WriteCached(*process_,
+                        *cache_,
+                        address,
+                        data.c_str(),
+                        (data.size() + 1) * sizeof(T),
+                        IsWriteThrough());
+  }
+
+  void Invalidate(PVOID address, std::size_t len) const
+  {
+    cache_->Invalidate(address, len);
+  }
+
+  void NewEpoch() const
+  {
+    cache_->NewEpoch();
+  }
+
+private:
+  bool IsWriteThrough() const noexcept
+  {
+    return !!(flags_ & CachedProcessViewFlags::kWriteThrough);
+  }
+
+  std::uint32_t GetReadFlags() const noexcept
+  {
+    return !!(flags_ & CachedProcessViewFlags::kAssumeAccessible)
+             ? ReadFlags::kAssumeAccessible
+             : ReadFlags::kNone;
+  }
+
+  Process const* process_;
+  std::shared_ptr<PageCache> cache_;
+  std::uint32_t flags_;
+};
+}
@@ -5,9 +5,8 @@
 
 #include <memory>
 
-#include <windows.h>
-
 #include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/winnt.hpp>
 
 #define HADESMEM_VERSION_MAJOR 2
 #define HADESMEM_VERSION_MINOR 0
@@ -25,22 +24,44 @@
   HADESMEM_DETAIL_VERSION_STRING_GEN(                                          \
     HADESMEM_VERSION_MAJOR, HADESMEM_VERSION_MINOR, HADESMEM_VERSION_PATCH)
 
-#if defined(_M_IX86)
+#if defined(_WIN32)
+#define HADESMEM_DETAIL_PLATFORM_WINDOWS
+#endif // #if defined(_WIN32)
+
+#if defined(_M_IX86) || defined(__i386__)
 #define HADESMEM_DETAIL_ARCH_X86
-#elif defined(_M_AMD64)
+#elif defined(_M_AMD64) || defined(__x86_64__)
 #define HADESMEM_DETAIL_ARCH_X64
-#else // #if defined(_M_IX86)
-// #elif defined(_M_AMD64)
+#else // #if defined(_M_IX86) || defined(__i386__)
+// #elif defined(_M_AMD64) || defined(__x86_64__)
 #error "[HadesMem] Unsupported architecture."
-#endif // #if defined(_M_IX86)
-// #elif defined(_M_AMD64)
+#endif // #if defined(_M_IX86) || defined(__i386__)
+// #elif defined(_M_AMD64) || defined(__x86_64__)
 
-#if !(defined(HADESMEM_DETAIL_ARCH_X64) ||                                     \
-      (defined(HADESMEM_DETAIL_ARCH_X86) && _M_IX86_FP >= 2))
+#if !defined(_MSC_VER) ||                                                      \
+  !(defined(HADESMEM_DETAIL_ARCH_X64) ||                                       \
+    (defined(HADESMEM_DETAIL_ARCH_X86) && _M_IX86_FP >= 2))
 #define HADESMEM_DETAIL_NO_VECTORCALL
-#endif // !(defined(HADESMEM_DETAIL_ARCH_X64) ||
+#endif // !defined(_MSC_VER) ||
+       // !(defined(HADESMEM_DETAIL_ARCH_X64) ||
        // (defined(HADESMEM_DETAIL_ARCH_X86) && _M_IX86_FP >= 2))
 
+// SSE2 is part of the x64 baseline, and on x86 we only use it when the
+// compiler has been told it's available. AVX2 is never assumed. Code which
+// uses it is dispatched at runtime (see detail/simd.hpp), which only needs
+// the compiler to be able to emit AVX2 for individual functions.
+#if defined(HADESMEM_DETAIL_ARCH_X64) ||                                       \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define HADESMEM_DETAIL_SSE2
+#endif // #if defined(HADESMEM_DETAIL_ARCH_X64) ||
+       // (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+
+#if defined(HADESMEM_DETAIL_SSE2) &&                                           \
+  (defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__))
+#define HADESMEM_DETAIL_AVX2_DISPATCH
+#endif // #if defined(HADESMEM_DETAIL_SSE2) &&
+       // (defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__))
+
 // Approximate equivalent of MAX_PATH for Unicode APIs.
 // See: http://bit.ly/17CCZFX
 #define HADESMEM_DETAIL_MAX_PATH_UNICODE (1 << 15)
@@ -0,0 +1,1002 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/scan_compare.hpp>
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+#include <immintrin.h>
+#elif defined(HADESMEM_DETAIL_SSE2)
+#include <emmintrin.h>
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+// Kernels which compare every value in a buffer against a ScanCompare and
+// produce a bitmask of hits (bit N of word N / 64 is set if value N passed),
+// so that the per-value work is a single vector compare rather than a call
+// through a predicate.
+//
+// Each instruction set has an 'ops' struct per element type which provides
+// the handful of vector operations the kernels need. Whole 64-value words
+// are done with the best instruction set available at runtime (see
+// GetSimdLevel), and whatever is left over is done by the scalar kernel,
+// which is also the reference implementation for the tests.
+
+namespace hadesmem
+{
+namespace detail
+{
+template <typename T>
+bool IsApproxEqual(T x, T value, T epsilon, ScanEpsilonType type) noexcept
+{
+  T const diff = std::fabs(x - value);
+  T const limit =
+    type == ScanEpsilonType::kRelative
+      ? epsilon * (std::max)(std::fabs(x), std::fabs(value))
+      : epsilon;
+  return diff <= limit;
+}
+
+// Calls func with a predicate for a single value.
+template <typename T, typename Func>
+void WithScalarComparePred(ScanCompare<T> const& cmp, Func func)
+{
+  T const value = cmp.value;
+  switch (cmp.type)
+  {
+  case ScanCompareType::kEqual:
+    return func([value](T x) { return x == value; });
+  case ScanCompareType::kNotEqual:
+    return func([value](T x) { return x != value; });
+  case ScanCompareType::kLess:
+    return func([value](T x) { return x < value; });
+  case ScanCompareType::kGreater:
+    return func([value](T x) { return x > value; });
+  case ScanCompareType::kBetween:
+  {
+    T const upper = cmp.upper;
+    return func([value, upper](T x) { return x >= value && x <= upper; });
+  }
+  case ScanCompareType::kApprox:
+  {
+    T const epsilon = cmp.epsilon;
+    ScanEpsilonType const type = cmp.epsilon_type;
+    return func([value, epsilon, type](T x) {
+      return IsApproxEqual(x, value, epsilon, type);
+    });
+  }
+  default:
+    HADESMEM_DETAIL_ASSERT(false);
+  }
+}
+
+// Values [first, count), where first is a multiple of 64.
+template <typename T>
+void CompareValuesScalar(std::uint8_t const* data,
+                         std::size_t first,
+                         std::size_t count,
+                         std::size_t stride,
+                         ScanCompare<T> const& cmp,
+                         std::uint64_t* mask)
+{
+  HADESMEM_DETAIL_ASSERT(first % 64 == 0);
+
+  WithScalarComparePred(cmp, [&](auto pred) {
+    for (std::size_t w = first / 64; w * 64 < count; ++w)
+    {
+      std::size_t const n = (std::min)(count - w * 64, std::size_t(64));
+      std::uint8_t const* p = data + w * 64 * stride;
+      std::uint64_t bits = 0;
+      for (std::size_t b = 0; b < n; ++b, p += stride)
+      {
+        T x;
+        std::memcpy(&x, p, sizeof(T));
+        bits |= static_cast<std::uint64_t>(pred(x)) << b;
+      }
+      mask[w] = bits;
+    }
+  });
+}
+
+// An approximate comparison of integers is just a range with saturated
+// bounds. Integer epsilons are always absolute.
+template <typename T>
+ScanCompare<T> NormalizeScanCompare(ScanCompare<T> const& cmp,
+                                    std::true_type /*is_integral*/)
+{
+  if (cmp.type != ScanCompareType::kApprox)
+  {
+    return cmp;
+  }
+
+  ScanCompare<T> range{cmp};
+  range.type = ScanCompareType::kBetween;
+  T const epsilon = cmp.epsilon < 0 ? T(0) : cmp.epsilon;
+  range.value = cmp.value < (std::numeric_limits<T>::min)() + epsilon
+                  ? (std::numeric_limits<T>::min)()
+                  : static_cast<T>(cmp.value - epsilon);
+  range.upper = cmp.value > (std::numeric_limits<T>::max)() - epsilon
+                  ? (std::numeric_limits<T>::max)()
+                  : static_cast<T>(cmp.value + epsilon);
+  return range;
+}
+
+template <typename T>
+ScanCompare<T> NormalizeScanCompare(ScanCompare<T> const& cmp,
+                                    std::false_type /*is_integral*/)
+{
+  return cmp;
+}
+
+#if defined(HADESMEM_DETAIL_SSE2)
+
+template <typename T, typename Enable = void> struct Sse2Ops
+{
+  static bool const kSupported = false;
+};
+
+// SSE2 has no 64-bit integer compares, so those are left to the scalar
+// kernel.
+template <typename T>
+struct Sse2Ops<T,
+               typename std::enable_if<std::is_integral<T>::value &&
+                                       sizeof(T) <= 4>::type>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 16 / sizeof(T);
+  typedef __m128i Vec;
+  typedef std::integral_constant<std::size_t, sizeof(T)> Size;
+  typedef std::integral_constant<std::size_t, 1> Size1;
+  typedef std::integral_constant<std::size_t, 2> Size2;
+  typedef std::integral_constant<std::size_t, 4> Size4;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+  }
+
+  static Vec Set1(T v)
+  {
+    return Set1(v, Size{});
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return Eq(a, b, Size{});
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm_xor_si128(Eq(a, b), _mm_set1_epi32(-1));
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    if (std::is_signed<T>::value)
+    {
+      return GtSigned(a, b, Size{});
+    }
+
+    // Flip the sign bits so that a signed compare gives the unsigned result.
+    Vec const bias = Set1(static_cast<T>(T(1) << (sizeof(T) * 8 - 1)));
+    return GtSigned(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias), Size{});
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return Gt(b, a);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm_xor_si128(_mm_or_si128(Lt(x, lo), Gt(x, hi)),
+                         _mm_set1_epi32(-1));
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return Mask(v, Size{});
+  }
+
+private:
+  static Vec Set1(T v, Size1)
+  {
+    return _mm_set1_epi8(static_cast<char>(v));
+  }
+
+  static Vec Set1(T v, Size2)
+  {
+    return _mm_set1_epi16(static_cast<short>(v));
+  }
+
+  static Vec Set1(T v, Size4)
+  {
+    return _mm_set1_epi32(static_cast<int>(v));
+  }
+
+  static Vec Eq(Vec a, Vec b, Size1)
+  {
+    return _mm_cmpeq_epi8(a, b);
+  }
+
+  static Vec Eq(Vec a, Vec b, Size2)
+  {
+    return _mm_cmpeq_epi16(a, b);
+  }
+
+  static Vec Eq(Vec a, Vec b, Size4)
+  {
+    return _mm_cmpeq_epi32(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size1)
+  {
+    return _mm_cmpgt_epi8(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size2)
+  {
+    return _mm_cmpgt_epi16(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size4)
+  {
+    return _mm_cmpgt_epi32(a, b);
+  }
+
+  static std::uint32_t Mask(Vec v, Size1)
+  {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(v));
+  }
+
+  static std::uint32_t Mask(Vec v, Size2)
+  {
+    return static_cast<std::uint32_t>(
+      _mm_movemask_epi8(_mm_packs_epi16(v, _mm_setzero_si128())));
+  }
+
+  static std::uint32_t Mask(Vec v, Size4)
+  {
+    return static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+  }
+};
+
+template <> struct Sse2Ops<float>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 4;
+  typedef __m128 Vec;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm_loadu_ps(reinterpret_cast<float const*>(p));
+  }
+
+  static Vec Set1(float v)
+  {
+    return _mm_set1_ps(v);
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return _mm_cmpeq_ps(a, b);
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm_cmpneq_ps(a, b);
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    return _mm_cmpgt_ps(a, b);
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return _mm_cmplt_ps(a, b);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm_and_ps(_mm_cmpge_ps(x, lo), _mm_cmple_ps(x, hi));
+  }
+
+  static Vec Approx(Vec x, Vec v, Vec epsilon, bool relative)
+  {
+    Vec const diff = Abs(_mm_sub_ps(x, v));
+    Vec const limit =
+      relative ? _mm_mul_ps(epsilon, _mm_max_ps(Abs(x), Abs(v))) : epsilon;
+    return _mm_cmple_ps(diff, limit);
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return static_cast<std::uint32_t>(_mm_movemask_ps(v));
+  }
+
+private:
+  static Vec Abs(Vec v)
+  {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+  }
+};
+
+template <> struct Sse2Ops<double>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 2;
+  typedef __m128d Vec;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm_loadu_pd(reinterpret_cast<double const*>(p));
+  }
+
+  static Vec Set1(double v)
+  {
+    return _mm_set1_pd(v);
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return _mm_cmpeq_pd(a, b);
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm_cmpneq_pd(a, b);
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    return _mm_cmpgt_pd(a, b);
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return _mm_cmplt_pd(a, b);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm_and_pd(_mm_cmpge_pd(x, lo), _mm_cmple_pd(x, hi));
+  }
+
+  static Vec Approx(Vec x, Vec v, Vec epsilon, bool relative)
+  {
+    Vec const diff = Abs(_mm_sub_pd(x, v));
+    Vec const limit =
+      relative ? _mm_mul_pd(epsilon, _mm_max_pd(Abs(x), Abs(v))) : epsilon;
+    return _mm_cmple_pd(diff, limit);
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return static_cast<std::uint32_t>(_mm_movemask_pd(v));
+  }
+
+private:
+  static Vec Abs(Vec v)
+  {
+    return _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+  }
+};
+
+// Compares whole 64-value words. Returns the number of values done.
+template <typename Ops, typename Pred>
+std::size_t CompareWordsSse2(std::uint8_t const* data,
+                             std::size_t count,
+                             std::size_t elem_size,
+                             std::uint64_t* mask,
+                             Pred pred)
+{
+  std::size_t const num_words = count / 64;
+  for (std::size_t w = 0; w < num_words; ++w)
+  {
+    std::uint8_t const* p = data + w * 64 * elem_size;
+    std::uint64_t bits = 0;
+    for (std::size_t j = 0; j < 64; j += Ops::kLanes)
+    {
+      bits |= static_cast<std::uint64_t>(
+                Ops::Mask(pred(Ops::Load(p + j * elem_size))))
+              << j;
+    }
+    mask[w] = bits;
+  }
+  return num_words * 64;
+}
+
+template <typename Ops, typename T>
+std::size_t CompareApproxSse2(std::uint8_t const* data,
+                              std::size_t count,
+                              ScanCompare<T> const& cmp,
+                              std::uint64_t* mask,
+                              std::true_type /*is_floating_point*/)
+{
+  typedef typename Ops::Vec Vec;
+  Vec const value = Ops::Set1(cmp.value);
+  Vec const epsilon = Ops::Set1(cmp.epsilon);
+  bool const relative = cmp.epsilon_type == ScanEpsilonType::kRelative;
+  return CompareWordsSse2<Ops>(
+    data, count, sizeof(T), mask, [=](Vec x) {
+      return Ops::Approx(x, value, epsilon, relative);
+    });
+}
+
+template <typename Ops, typename T>
+std::size_t CompareApproxSse2(std::uint8_t const* /*data*/,
+                              std::size_t /*count*/,
+                              ScanCompare<T> const& /*cmp*/,
+                              std::uint64_t* /*mask*/,
+                              std::false_type /*is_floating_point*/)
+{
+  // Integers are normalized to a range.
+  HADESMEM_DETAIL_ASSERT(false);
+  return 0;
+}
+
+template <typename T>
+std::size_t CompareValuesSse2(std::uint8_t const* data,
+                              std::size_t count,
+                              ScanCompare<T> const& cmp,
+                              std::uint64_t* mask,
+                              std::true_type /*kSupported*/)
+{
+  typedef Sse2Ops<T> Ops;
+  typedef typename Ops::Vec Vec;
+  Vec const value = Ops::Set1(cmp.value);
+  switch (cmp.type)
+  {
+  case ScanCompareType::kEqual:
+    return CompareWordsSse2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Eq(x, value); });
+  case ScanCompareType::kNotEqual:
+    return CompareWordsSse2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Ne(x, value); });
+  case ScanCompareType::kLess:
+    return CompareWordsSse2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Lt(x, value); });
+  case ScanCompareType::kGreater:
+    return CompareWordsSse2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Gt(x, value); });
+  case ScanCompareType::kBetween:
+  {
+    Vec const upper = Ops::Set1(cmp.upper);
+    return CompareWordsSse2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) {
+        return Ops::InRange(x, value, upper);
+      });
+  }
+  case ScanCompareType::kApprox:
+    return CompareApproxSse2<Ops>(
+      data, count, cmp, mask, std::is_floating_point<T>{});
+  default:
+    HADESMEM_DETAIL_ASSERT(false);
+    return 0;
+  }
+}
+
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+HADESMEM_DETAIL_AVX2_BEGIN
+
+template <typename T, typename Enable = void> struct Avx2Ops
+{
+  static bool const kSupported = false;
+};
+
+template <typename T>
+struct Avx2Ops<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 32 / sizeof(T);
+  typedef __m256i Vec;
+  typedef std::integral_constant<std::size_t, sizeof(T)> Size;
+  typedef std::integral_constant<std::size_t, 1> Size1;
+  typedef std::integral_constant<std::size_t, 2> Size2;
+  typedef std::integral_constant<std::size_t, 4> Size4;
+  typedef std::integral_constant<std::size_t, 8> Size8;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+  }
+
+  static Vec Set1(T v)
+  {
+    return Set1(v, Size{});
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return Eq(a, b, Size{});
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm256_xor_si256(Eq(a, b), _mm256_set1_epi32(-1));
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    if (std::is_signed<T>::value)
+    {
+      return GtSigned(a, b, Size{});
+    }
+
+    // Flip the sign bits so that a signed compare gives the unsigned result.
+    Vec const bias = Set1(static_cast<T>(T(1) << (sizeof(T) * 8 - 1)));
+    return GtSigned(
+      _mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias), Size{});
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return Gt(b, a);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm256_xor_si256(_mm256_or_si256(Lt(x, lo), Gt(x, hi)),
+                            _mm256_set1_epi32(-1));
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return Mask(v, Size{});
+  }
+
+private:
+  static Vec Set1(T v, Size1)
+  {
+    return _mm256_set1_epi8(static_cast<char>(v));
+  }
+
+  static Vec Set1(T v, Size2)
+  {
+    return _mm256_set1_epi16(static_cast<short>(v));
+  }
+
+  static Vec Set1(T v, Size4)
+  {
+    return _mm256_set1_epi32(static_cast<int>(v));
+  }
+
+  static Vec Set1(T v, Size8)
+  {
+    return _mm256_set1_epi64x(static_cast<long long>(v));
+  }
+
+  static Vec Eq(Vec a, Vec b, Size1)
+  {
+    return _mm256_cmpeq_epi8(a, b);
+  }
+
+  static Vec Eq(Vec a, Vec b, Size2)
+  {
+    return _mm256_cmpeq_epi16(a, b);
+  }
+
+  static Vec Eq(Vec a, Vec b, Size4)
+  {
+    return _mm256_cmpeq_epi32(a, b);
+  }
+
+  static Vec Eq(Vec a, Vec b, Size8)
+  {
+    return _mm256_cmpeq_epi64(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size1)
+  {
+    return _mm256_cmpgt_epi8(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size2)
+  {
+    return _mm256_cmpgt_epi16(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size4)
+  {
+    return _mm256_cmpgt_epi32(a, b);
+  }
+
+  static Vec GtSigned(Vec a, Vec b, Size8)
+  {
+    return _mm256_cmpgt_epi64(a, b);
+  }
+
+  static std::uint32_t Mask(Vec v, Size1)
+  {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+  }
+
+  static std::uint32_t Mask(Vec v, Size2)
+  {
+    // Packing works within each 128-bit lane, so the halves have to be put
+    // back in order before the bytes are extracted.
+    Vec const packed = _mm256_permute4x64_epi64(
+      _mm256_packs_epi16(v, _mm256_setzero_si256()), 0xD8);
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(packed)) & 0xFFFF;
+  }
+
+  static std::uint32_t Mask(Vec v, Size4)
+  {
+    return static_cast<std::uint32_t>(
+      _mm256_movemask_ps(_mm256_castsi256_ps(v)));
+  }
+
+  static std::uint32_t Mask(Vec v, Size8)
+  {
+    return static_cast<std::uint32_t>(
+      _mm256_movemask_pd(_mm256_castsi256_pd(v)));
+  }
+};
+
+template <> struct Avx2Ops<float>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 8;
+  typedef __m256 Vec;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm256_loadu_ps(reinterpret_cast<float const*>(p));
+  }
+
+  static Vec Set1(float v)
+  {
+    return _mm256_set1_ps(v);
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return _mm256_cmp_ps(a, b, _CMP_EQ_OQ);
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ);
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm256_and_ps(_mm256_cmp_ps(x, lo, _CMP_GE_OQ),
+                         _mm256_cmp_ps(x, hi, _CMP_LE_OQ));
+  }
+
+  static Vec Approx(Vec x, Vec v, Vec epsilon, bool relative)
+  {
+    Vec const diff = Abs(_mm256_sub_ps(x, v));
+    Vec const limit =
+      relative ? _mm256_mul_ps(epsilon, _mm256_max_ps(Abs(x), Abs(v)))
+               : epsilon;
+    return _mm256_cmp_ps(diff, limit, _CMP_LE_OQ);
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return static_cast<std::uint32_t>(_mm256_movemask_ps(v));
+  }
+
+private:
+  static Vec Abs(Vec v)
+  {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+  }
+};
+
+template <> struct Avx2Ops<double>
+{
+  static bool const kSupported = true;
+  static std::size_t const kLanes = 4;
+  typedef __m256d Vec;
+
+  static Vec Load(std::uint8_t const* p)
+  {
+    return _mm256_loadu_pd(reinterpret_cast<double const*>(p));
+  }
+
+  static Vec Set1(double v)
+  {
+    return _mm256_set1_pd(v);
+  }
+
+  static Vec Eq(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+  }
+
+  static Vec Ne(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ);
+  }
+
+  static Vec Gt(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+  }
+
+  static Vec Lt(Vec a, Vec b)
+  {
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+  }
+
+  static Vec InRange(Vec x, Vec lo, Vec hi)
+  {
+    return _mm256_and_pd(_mm256_cmp_pd(x, lo, _CMP_GE_OQ),
+                         _mm256_cmp_pd(x, hi, _CMP_LE_OQ));
+  }
+
+  static Vec Approx(Vec x, Vec v, Vec epsilon, bool relative)
+  {
+    Vec const diff = Abs(_mm256_sub_pd(x, v));
+    Vec const limit =
+      relative ? _mm256_mul_pd(epsilon, _mm256_max_pd(Abs(x), Abs(v)))
+               : epsilon;
+    return _mm256_cmp_pd(diff, limit, _CMP_LE_OQ);
+  }
+
+  static std::uint32_t Mask(Vec v)
+  {
+    return static_cast<std::uint32_t>(_mm256_movemask_pd(v));
+  }
+
+private:
+  static Vec Abs(Vec v)
+  {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+  }
+};
+
+// The AVX2 kernels are a copy of the SSE2 ones. They can't share code,
+// because everything inlined into an AVX2 function has to be compiled for
+// AVX2 as well (and the SSE2 ones must not be).
+template <typename Ops, typename Pred>
+std::size_t CompareWordsAvx2(std::uint8_t const* data,
+                             std::size_t count,
+                             std::size_t elem_size,
+                             std::uint64_t* mask,
+                             Pred pred)
+{
+  std::size_t const num_words = count / 64;
+  for (std::size_t w = 0; w < num_words; ++w)
+  {
+    std::uint8_t const* p = data + w * 64 * elem_size;
+    std::uint64_t bits = 0;
+    for (std::size_t j = 0; j < 64; j += Ops::kLanes)
+    {
+      bits |= static_cast<std::uint64_t>(
+                Ops::Mask(pred(Ops::Load(p + j * elem_size))))
+              << j;
+    }
+    mask[w] = bits;
+  }
+  return num_words * 64;
+}
+
+template <typename Ops, typename T>
+std::size_t CompareApproxAvx2(std::uint8_t const* data,
+                              std::size_t count,
+                              ScanCompare<T> const& cmp,
+                              std::uint64_t* mask,
+                              std::true_type /*is_floating_point*/)
+{
+  typedef typename Ops::Vec Vec;
+  Vec const value = Ops::Set1(cmp.value);
+  Vec const epsilon = Ops::Set1(cmp.epsilon);
+  bool const relative = cmp.epsilon_type == ScanEpsilonType::kRelative;
+  return CompareWordsAvx2<Ops>(
+    data, count, sizeof(T), mask, [=](Vec x) {
+      return Ops::Approx(x, value, epsilon, relative);
+    });
+}
+
+template <typename Ops, typename T>
+std::size_t CompareApproxAvx2(std::uint8_t const* /*data*/,
+                              std::size_t /*count*/,
+                              ScanCompare<T> const& /*cmp*/,
+                              std::uint64_t* /*mask*/,
+                              std::false_type /*is_floating_point*/)
+{
+  // Integers are normalized to a range.
+  HADESMEM_DETAIL_ASSERT(false);
+  return 0;
+}
+
+template <typename T>
+std::size_t CompareValuesAvx2(std::uint8_t const* data,
+                              std::size_t count,
+                              ScanCompare<T> const& cmp,
+                              std::uint64_t* mask,
+                              std::true_type /*kSupported*/)
+{
+  typedef Avx2Ops<T> Ops;
+  typedef typename Ops::Vec Vec;
+  Vec const value = Ops::Set1(cmp.value);
+  switch (cmp.type)
+  {
+  case ScanCompareType::kEqual:
+    return CompareWordsAvx2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Eq(x, value); });
+  case ScanCompareType::kNotEqual:
+    return CompareWordsAvx2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Ne(x, value); });
+  case ScanCompareType::kLess:
+    return CompareWordsAvx2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Lt(x, value); });
+  case ScanCompareType::kGreater:
+    return CompareWordsAvx2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) { return Ops::Gt(x, value); });
+  case ScanCompareType::kBetween:
+  {
+    Vec const upper = Ops::Set1(cmp.upper);
+    return CompareWordsAvx2<Ops>(
+      data, count, sizeof(T), mask, [=](Vec x) {
+        return Ops::InRange(x, value, upper);
+      });
+  }
+  case ScanCompareType::kApprox:
+    return CompareApproxAvx2<Ops>(
+      data, count, cmp, mask, std::is_floating_point<T>{});
+  default:
+    HADESMEM_DETAIL_ASSERT(false);
+    return 0;
+  }
+}
+
+HADESMEM_DETAIL_AVX2_END
+
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+template <typename T>
+std::size_t CompareValuesSse2(std::uint8_t const* /*data*/,
+                              std::size_t /*count*/,
+                              ScanCompare<T> const& /*cmp*/,
+                              std::uint64_t* /*mask*/,
+                              std::false_type /*kSupported*/)
+{
+  return 0;
+}
+
+template <typename T>
+std::size_t CompareValuesAvx2(std::uint8_t const* /*data*/,
+                              std::size_t /*count*/,
+                              ScanCompare<T> const& /*cmp*/,
+                              std::uint64_t* /*mask*/,
+                              std::false_type /*kSupported*/)
+{
+  return 0;
+}
+
+// Values are packed, i.e. the stride is sizeof(T).
+template <typename T>
+void CompareValuesPacked(std::uint8_t const* data,
+                         std::size_t count,
+                         ScanCompare<T> const& cmp,
+                         std::uint64_t* mask,
+                         SimdLevel level)
+{
+  std::size_t done = 0;
+  switch (level)
+  {
+  case SimdLevel::kAvx2:
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+    done = CompareValuesAvx2<T>(
+      data,
+      count,
+      cmp,
+      mask,
+      std::integral_constant<bool, Avx2Ops<T>::kSupported>{});
+    if (done)
+    {
+      break;
+    }
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+  // Fall through.
+  case SimdLevel::kSse2:
+#if defined(HADESMEM_DETAIL_SSE2)
+    done = CompareValuesSse2<T>(
+      data,
+      count,
+      cmp,
+      mask,
+      std::integral_constant<bool, Sse2Ops<T>::kSupported>{});
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+    break;
+  default:
+    break;
+  }
+
+  CompareValuesScalar(data, done, count, sizeof(T), cmp, mask);
+}
+
+inline std::size_t GetCompareMaskWords(std::size_t count) noexcept
+{
+  return (count + 63) / 64;
+}
+
+// Compares count values, starting at data and stride bytes apart, and
+// writes one bit per value to mask, which must have room for
+// GetCompareMaskWords(count) words. The whole of the last value must be
+// readable.
+//
+// Strides smaller than the value (e.g. 4-byte values at every byte) are
+// done as several packed passes, one per phase, whose hits are then spread
+// out into the mask. Hits are rare in practice, so this costs little more
+// than a single packed pass.
+template <typename T>
+void CompareValues(std::uint8_t const* data,
+                   std::size_t count,
+                   std::size_t stride,
+                   ScanCompare<T> const& cmp,
+                   std::uint64_t* mask,
+                   SimdLevel level = GetSimdLevel())
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+  HADESMEM_DETAIL_ASSERT(stride != 0);
+
+  auto const normalized = NormalizeScanCompare(
+    cmp, std::integral_constant<bool, std::is_integral<T>::value>{});
+
+  if (stride == sizeof(T))
+  {
+    CompareValuesPacked(data, count, normalized, mask, level);
+    return;
+  }
+
+  if (stride > sizeof(T) || sizeof(T) % stride)
+  {
+    CompareValuesScalar(data, 0, count, stride, normalized, mask);
+    return;
+  }
+
+  std::size_t const num_phases = sizeof(T) / stride;
+  std::fill(mask, mask + GetCompareMaskWords(count), 0);
+  std::vector<std::uint64_t> phase_mask;
+  for (std::size_t p = 0; p < num_phases && p < count; ++p)
+  {
+    std::size_t const n = (count - p + num_phases - 1) / num_phases;
+    phase_mask.resize(GetCompareMaskWords(n));
+    CompareValuesPacked(
+      data + p * stride, n, normalized, phase_mask.data(), level);
+    for (std::size_t w = 0; w < phase_mask.size(); ++w)
+    {
+      for (std::uint64_t m = phase_mask[w]; m; m &= m - 1)
+      {
+        std::size_t const i =
+          (w * 64 + CountTrailingZeros64(m)) * num_phases + p;
+        mask[i / 64] |= 1ULL << (i % 64);
+      }
+    }
+  }
+}
+}
+}
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory>
 #include <tuple>
 
 #include <windows.h>
@@ -18,6 +19,7 @@
 #include <hadesmem/detail/peb.hpp>
 #include <hadesmem/detail/str_conv.hpp>
 #include <hadesmem/find_procedure.hpp>
+#include <hadesmem/page_cache.hpp>
 #include <hadesmem/pelib/dos_header.hpp>
 #include <hadesmem/pelib/export.hpp>
 #include <hadesmem/pelib/export_dir.hpp>
@@ -285,6 +287,12 @@ struct ModuleLight
       name_{MakeNameFromPath(path_)},
       priority_{GetModulePriority(name_, path_)}
   {
+    // Building the export map walks the headers and export directory of every
+    // module, re-reading the same few pages thousands of times. The target is
+    // expected to be suspended (or at least not modifying its own headers) so
+    // nothing is invalidated.
+    pe_file_.SetPageCache(std::make_shared<PageCache>(0x100000));
+
     HADESMEM_DETAIL_TRACE_FORMAT_W(
       L"Base: [%p]. Name: [%s]. Priority: [%d]. Path: [%s].",
       base,
@@ -323,7 +331,8 @@ struct ModuleLight
       PeFile pe_file{local_process,
                      buffer.data(),
                      PeFileType::kData,
-                     static_cast<DWORD>(buffer.size())};
+                     static_cast<DWORD>(buffer.size()),
+                     PeFileBacking::kBuffer};
       NtHeaders nt_headers{local_process, pe_file};
       return true;
     }
@@ -1052,7 +1061,8 @@ private:
         std::make_unique<PeFile>(local_process,
                                  pe_file_disk_data.data(),
                                  PeFileType::kData,
-                                 static_cast<DWORD>(pe_file_disk_data.size()));
+                                 static_cast<DWORD>(pe_file_disk_data.size()),
+                                 PeFileBacking::kBuffer);
       return std::make_tuple(
         true, std::move(pe_file_disk_data), std::move(pe_file_disk));
     }
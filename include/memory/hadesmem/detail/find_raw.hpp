@@ -0,0 +1,528 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+#include <immintrin.h>
+#elif defined(HADESMEM_DETAIL_SSE2)
+#include <emmintrin.h>
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+// The parts of FindPattern which only depend on a memory source (see
+// memory_source.hpp), and so can be used with any backend and on any
+// platform.
+
+namespace hadesmem
+{
+namespace detail
+{
+// A byte b of the haystack matches if (b & mask) == value. A full wildcard
+// has a mask of zero, and a nibble wildcard a mask of 0x0F or 0xF0. The value
+// never has bits set outside of the mask.
+struct PatternDataByte
+{
+  std::uint8_t value;
+  std::uint8_t mask;
+};
+
+inline int GetHexDigitValue(wchar_t c) noexcept
+{
+  if (c >= L'0' && c <= L'9')
+  {
+    return c - L'0';
+  }
+  else if (c >= L'a' && c <= L'f')
+  {
+    return c - L'a' + 10;
+  }
+  else if (c >= L'A' && c <= L'F')
+  {
+    return c - L'A' + 10;
+  }
+
+  return -1;
+}
+
+// Bytes are separated by whitespace, and are either hex numbers (e.g. "8B"),
+// full wildcards ("??"), or have a single wildcard nibble (e.g. "D?", which
+// matches D0 to DF, or "?5", which matches 05, 15, ..., F5).
+inline std::vector<PatternDataByte> ConvertData(std::wstring const& data)
+{
+  HADESMEM_DETAIL_ASSERT(!data.empty());
+
+  std::wstring const data_trimmed{
+    data.substr(0, data.find_last_not_of(L" \n\r\t") + 1)};
+
+  HADESMEM_DETAIL_ASSERT(!data_trimmed.empty());
+
+  std::wistringstream data_str{data_trimmed};
+  data_str.imbue(std::locale::classic());
+  std::vector<PatternDataByte> data_real;
+  do
+  {
+    std::wstring data_cur_str;
+    if (!(data_str >> data_cur_str))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Data parsing failed."});
+    }
+
+    if (data_cur_str.find(L'?') != std::wstring::npos)
+    {
+      if (data_cur_str.size() != 2)
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Data conversion failed."});
+      }
+
+      PatternDataByte cur{0, 0};
+      for (std::size_t i = 0; i < 2; ++i)
+      {
+        if (data_cur_str[i] == L'?')
+        {
+          continue;
+        }
+
+        int const digit = GetHexDigitValue(data_cur_str[i]);
+        if (digit < 0)
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Data conversion failed."});
+        }
+
+        unsigned int const shift = i ? 0 : 4;
+        cur.value |= static_cast<std::uint8_t>(digit << shift);
+        cur.mask |= static_cast<std::uint8_t>(0xF << shift);
+      }
+
+      data_real.emplace_back(cur);
+    }
+    else
+    {
+      std::uint32_t current = 0U;
+      std::wistringstream conv{data_cur_str};
+      conv.imbue(std::locale::classic());
+      if (!(conv >> std::hex >> current))
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Data conversion failed."});
+      }
+
+      if (current > static_cast<std::uint8_t>(-1))
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(Error()
+                                        << ErrorString("Invalid data."));
+      }
+
+      data_real.emplace_back(
+        PatternDataByte{static_cast<std::uint8_t>(current), 0xFF});
+    }
+  } while (!data_str.eof());
+
+  return data_real;
+}
+
+std::size_t const kNoPatternMatch = static_cast<std::size_t>(-1);
+
+// How often each byte value appears in x86 code, per 100,000 bytes. Measured
+// over the .text sections of a set of x64 binaries, with 0xCC raised to match
+// 0xFF to account for the int3 padding MSVC puts between functions.
+constexpr std::uint16_t kCodeByteFrequency[0x100] = {
+  12520,  1716,   472,   370,   546,   482,   190,   230,  // 00
+    994,   175,   147,   120,   220,   210,   149,  3056,  // 08
+    899,   252,   107,   101,   175,   168,   107,   105,  // 10
+    492,    73,    69,    71,   103,    84,   121,   778,  // 18
+    572,    78,    74,    71,  2908,   183,    56,    59,  // 20
+    439,   295,    57,   134,    91,    86,   175,    85,  // 28
+    357,   656,    50,    80,   101,   198,    52,    55,  // 30
+    251,   677,    62,   124,   145,   262,    56,    82,  // 38
+    552,  1163,   103,   266,  1236,   495,   133,   168,  // 40
+   8110,  1073,    80,    80,  1824,   393,    68,    71,  // 48
+    360,    62,    63,   239,   361,   295,   135,   127,  // 50
+    174,    52,    55,   223,   268,   302,   122,   113,  // 58
+    235,    45,    56,   141,   198,    66,   665,    52,  // 60
+    155,    50,    59,    72,   159,    76,    97,   150,  // 68
+    396,    52,    77,   111,   925,   436,    79,    85,  // 70
+    191,    60,    54,   122,   355,   136,   104,   146,  // 78
+    463,   188,    77,  1263,  1413,  1647,    77,   114,  // 80
+    225,  4126,    47,  3252,    97,  1551,    73,    68,  // 88
+    319,    44,    48,    65,   137,   123,    47,    51,  // 90
+    115,    47,    39,    45,    86,    68,    43,    46,  // 98
+    153,    47,    42,    52,    71,    61,    50,    43,  // A0
+    119,    50,    60,    69,    90,    55,    43,    60,  // A8
+    143,    48,    45,    60,   104,    93,   232,    80,  // B0
+    223,   109,   229,    86,   192,   182,   253,   160,  // B8
+   1065,   302,   222,   509,   270,   250,   345,   710,  // C0
+    184,   181,    96,    61,  6033,    72,    80,    74,  // C8
+    252,    91,   270,    85,    67,    81,    84,    90,  // D0
+    168,    73,   100,   153,    70,    87,   147,   375,  // D8
+    277,   122,   125,    73,   118,    86,   145,   207,  // E0
+   2090,   987,   155,   348,   214,   202,   210,   400,  // E8
+    258,   104,   168,   211,   103,   128,   375,   269,  // F0
+    367,   187,   301,   269,   266,   382,   571,  6033,  // F8
+};
+
+// A pattern compiled for searching. Byte i of a match is any byte h where
+// (h & mask[i]) == value[i], so a wildcard has a mask of zero. A search looks
+// for the anchor byte first and then the check byte, which are the two bytes
+// least likely to match in code, and only then compares the whole pattern.
+// The anchor is kNoPatternMatch if the pattern is all wildcards, and the check
+// byte is the anchor if there is only one byte to choose from.
+struct CompiledPattern
+{
+  std::vector<std::uint8_t> value;
+  std::vector<std::uint8_t> mask;
+  std::size_t anchor;
+  std::size_t check;
+};
+
+// The frequency of the bytes matched by a single byte of a pattern.
+inline std::uint32_t GetPatternByteFrequency(std::uint8_t value,
+                                             std::uint8_t mask) noexcept
+{
+  std::uint32_t frequency = 0;
+  for (std::uint32_t b = 0; b < 0x100; ++b)
+  {
+    if ((b & mask) == value)
+    {
+      frequency += kCodeByteFrequency[b];
+    }
+  }
+  return frequency;
+}
+
+template <typename NeedleIterator>
+CompiledPattern CompilePattern(NeedleIterator n_beg, NeedleIterator n_end)
+{
+  HADESMEM_DETAIL_ASSERT(n_beg != n_end);
+
+  CompiledPattern pattern;
+  for (; n_beg != n_end; ++n_beg)
+  {
+    pattern.mask.push_back(n_beg->mask);
+    pattern.value.push_back(n_beg->value & n_beg->mask);
+  }
+
+  pattern.anchor = kNoPatternMatch;
+  pattern.check = kNoPatternMatch;
+  std::uint32_t anchor_frequency = 0;
+  std::uint32_t check_frequency = 0;
+  for (std::size_t i = 0; i < pattern.mask.size(); ++i)
+  {
+    if (!pattern.mask[i])
+    {
+      continue;
+    }
+
+    std::uint32_t const frequency =
+      GetPatternByteFrequency(pattern.value[i], pattern.mask[i]);
+    if (pattern.anchor == kNoPatternMatch || frequency < anchor_frequency)
+    {
+      pattern.check = pattern.anchor;
+      check_frequency = anchor_frequency;
+      pattern.anchor = i;
+      anchor_frequency = frequency;
+    }
+    else if (pattern.check == kNoPatternMatch || frequency < check_frequency)
+    {
+      pattern.check = i;
+      check_frequency = frequency;
+    }
+  }
+
+  if (pattern.check == kNoPatternMatch)
+  {
+    pattern.check = pattern.anchor;
+  }
+
+  return pattern;
+}
+
+// Compares the whole pattern, eight bytes at a time.
+inline bool MatchesCompiledPattern(std::uint8_t const* data,
+                                   CompiledPattern const& pattern) noexcept
+{
+  std::size_t const size = pattern.value.size();
+  std::uint8_t const* const value = pattern.value.data();
+  std::uint8_t const* const mask = pattern.mask.data();
+  std::size_t i = 0;
+  for (; size - i >= 8; i += 8)
+  {
+    std::uint64_t h, v, m;
+    std::memcpy(&h, data + i, 8);
+    std::memcpy(&v, value + i, 8);
+    std::memcpy(&m, mask + i, 8);
+    if ((h & m) != v)
+    {
+      return false;
+    }
+  }
+
+  for (; i < size; ++i)
+  {
+    if ((data[i] & mask[i]) != value[i])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Candidate starts [first, num_starts).
+inline std::size_t FindCompiledPatternScalar(std::uint8_t const* data,
+                                             std::size_t first,
+                                             std::size_t num_starts,
+                                             CompiledPattern const& pattern)
+{
+  std::uint8_t const* const anchor = data + pattern.anchor;
+  std::uint8_t const anchor_value = pattern.value[pattern.anchor];
+  std::uint8_t const anchor_mask = pattern.mask[pattern.anchor];
+
+  // memchr is usually vectorized by the CRT.
+  if (anchor_mask == 0xFF)
+  {
+    for (std::size_t i = first; i < num_starts; ++i)
+    {
+      auto const next = static_cast<std::uint8_t const*>(
+        std::memchr(anchor + i, anchor_value, num_starts - i));
+      if (!next)
+      {
+        break;
+      }
+
+      i = static_cast<std::size_t>(next - anchor);
+      if (MatchesCompiledPattern(data + i, pattern))
+      {
+        return i;
+      }
+    }
+
+    return kNoPatternMatch;
+  }
+
+  for (std::size_t i = first; i < num_starts; ++i)
+  {
+    if ((anchor[i] & anchor_mask) == anchor_value &&
+        MatchesCompiledPattern(data + i, pattern))
+    {
+      return i;
+    }
+  }
+
+  return kNoPatternMatch;
+}
+
+#if defined(HADESMEM_DETAIL_SSE2)
+
+// Candidate starts [first, num_starts), in whole vectors. Returns the first
+// match, or kNoPatternMatch with done set to the first start not checked.
+inline std::size_t FindCompiledPatternSse2(std::uint8_t const* data,
+                                           std::size_t first,
+                                           std::size_t num_starts,
+                                           CompiledPattern const& pattern,
+                                           std::size_t& done)
+{
+  std::uint8_t const* const anchor = data + pattern.anchor;
+  std::uint8_t const* const check = data + pattern.check;
+  __m128i const anchor_value =
+    _mm_set1_epi8(static_cast<char>(pattern.value[pattern.anchor]));
+  __m128i const anchor_mask =
+    _mm_set1_epi8(static_cast<char>(pattern.mask[pattern.anchor]));
+  __m128i const check_value =
+    _mm_set1_epi8(static_cast<char>(pattern.value[pattern.check]));
+  __m128i const check_mask =
+    _mm_set1_epi8(static_cast<char>(pattern.mask[pattern.check]));
+
+  std::size_t i = first;
+  for (; num_starts - i >= 16; i += 16)
+  {
+    __m128i const a =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(anchor + i));
+    __m128i const c =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(check + i));
+    __m128i const eq = _mm_and_si128(
+      _mm_cmpeq_epi8(_mm_and_si128(a, anchor_mask), anchor_value),
+      _mm_cmpeq_epi8(_mm_and_si128(c, check_mask), check_value));
+    for (auto bits = static_cast<std::uint32_t>(_mm_movemask_epi8(eq)); bits;
+         bits &= bits - 1)
+    {
+      std::size_t const start = i + CountTrailingZeros(bits);
+      if (MatchesCompiledPattern(data + start, pattern))
+      {
+        return start;
+      }
+    }
+  }
+
+  done = i;
+  return kNoPatternMatch;
+}
+
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+HADESMEM_DETAIL_AVX2_BEGIN
+
+inline __m256i GetPatternCandidatesAvx2(std::uint8_t const* anchor,
+                                        std::uint8_t const* check,
+                                        __m256i anchor_value,
+                                        __m256i anchor_mask,
+                                        __m256i check_value,
+                                        __m256i check_mask)
+{
+  __m256i const a =
+    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(anchor));
+  __m256i const c =
+    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(check));
+  return _mm256_and_si256(
+    _mm256_cmpeq_epi8(_mm256_and_si256(a, anchor_mask), anchor_value),
+    _mm256_cmpeq_epi8(_mm256_and_si256(c, check_mask), check_value));
+}
+
+inline std::size_t FindCompiledPatternAvx2(std::uint8_t const* data,
+                                           std::size_t first,
+                                           std::size_t num_starts,
+                                           CompiledPattern const& pattern,
+                                           std::size_t& done)
+{
+  std::uint8_t const* const anchor = data + pattern.anchor;
+  std::uint8_t const* const check = data + pattern.check;
+  __m256i const anchor_value =
+    _mm256_set1_epi8(static_cast<char>(pattern.value[pattern.anchor]));
+  __m256i const anchor_mask =
+    _mm256_set1_epi8(static_cast<char>(pattern.mask[pattern.anchor]));
+  __m256i const check_value =
+    _mm256_set1_epi8(static_cast<char>(pattern.value[pattern.check]));
+  __m256i const check_mask =
+    _mm256_set1_epi8(static_cast<char>(pattern.mask[pattern.check]));
+
+  // Two vectors at a time, as candidates are rare.
+  std::size_t i = first;
+  for (; num_starts - i >= 64; i += 64)
+  {
+    __m256i const eq_lo = GetPatternCandidatesAvx2(anchor + i,
+                                                   check + i,
+                                                   anchor_value,
+                                                   anchor_mask,
+                                                   check_value,
+                                                   check_mask);
+    __m256i const eq_hi = GetPatternCandidatesAvx2(anchor + i + 32,
+                                                   check + i + 32,
+                                                   anchor_value,
+                                                   anchor_mask,
+                                                   check_value,
+                                                   check_mask);
+    if (_mm256_testz_si256(_mm256_or_si256(eq_lo, eq_hi),
+                           _mm256_or_si256(eq_lo, eq_hi)))
+    {
+      continue;
+    }
+
+    std::uint64_t bits =
+      static_cast<std::uint32_t>(_mm256_movemask_epi8(eq_lo)) |
+      (static_cast<std::uint64_t>(
+         static_cast<std::uint32_t>(_mm256_movemask_epi8(eq_hi)))
+       << 32);
+    for (; bits; bits &= bits - 1)
+    {
+      std::size_t const start = i + CountTrailingZeros64(bits);
+      if (MatchesCompiledPattern(data + start, pattern))
+      {
+        return start;
+      }
+    }
+  }
+
+  done = i;
+  return kNoPatternMatch;
+}
+
+HADESMEM_DETAIL_AVX2_END
+
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+// Returns the offset of the first match of the pattern which lies entirely
+// within [data, data + size), or kNoPatternMatch if there isn't one.
+inline std::size_t FindCompiledPattern(std::uint8_t const* data,
+                                       std::size_t size,
+                                       CompiledPattern const& pattern,
+                                       SimdLevel level = GetSimdLevel())
+{
+  std::size_t const len = pattern.value.size();
+  if (size < len)
+  {
+    return kNoPatternMatch;
+  }
+
+  if (pattern.anchor == kNoPatternMatch)
+  {
+    return 0;
+  }
+
+  std::size_t const num_starts = size - len + 1;
+  std::size_t done = 0;
+  std::size_t found = kNoPatternMatch;
+  switch (level)
+  {
+  case SimdLevel::kAvx2:
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+    found = FindCompiledPatternAvx2(data, done, num_starts, pattern, done);
+    if (found != kNoPatternMatch)
+    {
+      return found;
+    }
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+  // Fall through.
+  case SimdLevel::kSse2:
+#if defined(HADESMEM_DETAIL_SSE2)
+    found = FindCompiledPatternSse2(data, done, num_starts, pattern, done);
+    if (found != kNoPatternMatch)
+    {
+      return found;
+    }
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+    break;
+  default:
+    break;
+  }
+
+  return FindCompiledPatternScalar(data, done, num_starts, pattern);
+}
+
+template <typename MemorySource, typename NeedleIterator>
+void* FindRaw(MemorySource const& source,
+              std::uint8_t* s_beg,
+              std::uint8_t* s_end,
+              NeedleIterator n_beg,
+              NeedleIterator n_end)
+{
+  HADESMEM_DETAIL_ASSERT(s_beg < s_end);
+
+  std::ptrdiff_t const mem_size = s_end - s_beg;
+  std::vector<std::uint8_t> const haystack{SourceReadVector<std::uint8_t>(
+    source, s_beg, static_cast<std::size_t>(mem_size))};
+
+  std::size_t const offset = FindCompiledPattern(
+    haystack.data(), haystack.size(), CompilePattern(n_beg, n_end));
+  return offset == kNoPatternMatch ? nullptr : s_beg + offset;
+}
+}
+}
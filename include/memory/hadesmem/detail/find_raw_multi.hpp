@@ -0,0 +1,256 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+
+// Finds the first match of many patterns with a single pass over a buffer,
+// rather than one std::search per pattern.
+//
+// Each pattern is anchored on two adjacent non-wildcard bytes (or a single one
+// if it has no such pair), picked to avoid bytes which are common in code
+// (see kCodeByteFrequency). The scan looks up every pair of bytes in a bitmap
+// of the anchors, and only when that hits does it look up the patterns
+// anchored there and verify them in full. Patterns without a whole byte to
+// anchor on are searched for separately.
+
+namespace hadesmem
+{
+namespace detail
+{
+class MultiPatternFinder
+{
+public:
+  // Returns the index of the pattern, which is its index in the vectors
+  // passed to FindFirst.
+  std::size_t Add(std::vector<PatternDataByte> const& needle)
+  {
+    HADESMEM_DETAIL_ASSERT(!needle.empty());
+
+    return Add(CompilePattern(std::begin(needle), std::end(needle)));
+  }
+
+  std::size_t Add(CompiledPattern needle)
+  {
+    HADESMEM_DETAIL_ASSERT(!needle.value.empty());
+
+    std::size_t const pattern = needles_.size();
+    needles_.push_back(std::move(needle));
+    auto const& value = needles_.back().value;
+    auto const& mask = needles_.back().mask;
+
+    // Only whole bytes can be looked up in the tables. A pair is weighed by
+    // the product of the frequencies, i.e. how often the pair would show up
+    // if bytes were independent.
+    std::size_t best_offset = kNoPatternMatch;
+    std::uint32_t best_weight = 0;
+    bool best_is_pair = false;
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {
+      if (mask[i] != 0xFF)
+      {
+        continue;
+      }
+
+      bool const is_pair = i + 1 < value.size() && mask[i + 1] == 0xFF;
+      std::uint32_t const weight =
+        is_pair ? static_cast<std::uint32_t>(kCodeByteFrequency[value[i]]) *
+                    kCodeByteFrequency[value[i + 1]]
+                : kCodeByteFrequency[value[i]];
+      if (best_offset == kNoPatternMatch || (is_pair && !best_is_pair) ||
+          (is_pair == best_is_pair && weight < best_weight))
+      {
+        best_offset = i;
+        best_weight = weight;
+        best_is_pair = is_pair;
+      }
+    }
+
+    if (best_offset == kNoPatternMatch)
+    {
+      unindexed_.push_back(pattern);
+    }
+    else if (best_is_pair)
+    {
+      std::uint32_t const key =
+        value[best_offset] |
+        (static_cast<std::uint32_t>(value[best_offset + 1]) << 8);
+      pair_filter_[key / 64] |= 1ULL << (key % 64);
+      InsertAnchor(pair_anchors_, Anchor{key, pattern, best_offset});
+    }
+    else
+    {
+      std::uint8_t const key = value[best_offset];
+      byte_filter_[key] = true;
+      InsertAnchor(byte_anchors_, Anchor{key, pattern, best_offset});
+    }
+
+    return pattern;
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return needles_.size();
+  }
+
+  // Searches data for every pattern i where begins[i] is not
+  // kNoPatternMatch, and sets results[i] to the offset of its first match
+  // at or after begins[i] (or kNoPatternMatch if there isn't one). A match
+  // must lie entirely within the buffer.
+  void FindFirst(std::uint8_t const* data,
+                 std::size_t size,
+                 std::vector<std::size_t> const& begins,
+                 std::vector<std::size_t>& results) const
+  {
+    HADESMEM_DETAIL_ASSERT(begins.size() == needles_.size());
+
+    results.assign(needles_.size(), kNoPatternMatch);
+
+    std::size_t pending = 0;
+    std::size_t scan_beg = size;
+    for (std::size_t i = 0; i < begins.size(); ++i)
+    {
+      if (begins[i] != kNoPatternMatch)
+      {
+        ++pending;
+        scan_beg = (std::min)(scan_beg, begins[i]);
+      }
+    }
+
+    // A single pattern is better off with the vectorized search than with
+    // the table lookups.
+    if (pending == 1)
+    {
+      auto const iter = std::find_if(
+        std::begin(begins), std::end(begins), [](std::size_t beg) {
+          return beg != kNoPatternMatch;
+        });
+      auto const pattern =
+        static_cast<std::size_t>(iter - std::begin(begins));
+      FindOne(data, size, pattern, begins, results);
+      return;
+    }
+
+    for (auto const pattern : unindexed_)
+    {
+      if (begins[pattern] != kNoPatternMatch)
+      {
+        FindOne(data, size, pattern, begins, results);
+        --pending;
+      }
+    }
+
+    bool const has_byte_anchors = !byte_anchors_.empty();
+    for (std::size_t pos = scan_beg; pending && pos < size; ++pos)
+    {
+      std::uint8_t const b = data[pos];
+      if (has_byte_anchors && byte_filter_[b])
+      {
+        CheckAnchors(
+          byte_anchors_, b, data, size, pos, begins, results, pending);
+      }
+
+      if (pos + 1 < size)
+      {
+        std::uint32_t const key =
+          b | (static_cast<std::uint32_t>(data[pos + 1]) << 8);
+        if ((pair_filter_[key / 64] >> (key % 64)) & 1)
+        {
+          CheckAnchors(
+            pair_anchors_, key, data, size, pos, begins, results, pending);
+        }
+      }
+    }
+  }
+
+private:
+  struct Anchor
+  {
+    std::uint32_t key;
+    std::size_t pattern;
+    std::size_t offset;
+  };
+
+  static bool AnchorKeyLess(Anchor const& lhs, Anchor const& rhs) noexcept
+  {
+    return lhs.key < rhs.key;
+  }
+
+  static void InsertAnchor(std::vector<Anchor>& anchors, Anchor const& anchor)
+  {
+    auto const iter = std::upper_bound(
+      std::begin(anchors), std::end(anchors), anchor, &AnchorKeyLess);
+    anchors.insert(iter, anchor);
+  }
+
+  void FindOne(std::uint8_t const* data,
+               std::size_t size,
+               std::size_t pattern,
+               std::vector<std::size_t> const& begins,
+               std::vector<std::size_t>& results) const
+  {
+    std::size_t const beg = begins[pattern];
+    if (beg <= size)
+    {
+      std::size_t const offset =
+        FindCompiledPattern(data + beg, size - beg, needles_[pattern]);
+      results[pattern] =
+        offset == kNoPatternMatch ? kNoPatternMatch : beg + offset;
+    }
+  }
+
+  void CheckAnchors(std::vector<Anchor> const& anchors,
+                    std::uint32_t key,
+                    std::uint8_t const* data,
+                    std::size_t size,
+                    std::size_t pos,
+                    std::vector<std::size_t> const& begins,
+                    std::vector<std::size_t>& results,
+                    std::size_t& pending) const
+  {
+    auto const range = std::equal_range(std::begin(anchors),
+                                        std::end(anchors),
+                                        Anchor{key, 0, 0},
+                                        &AnchorKeyLess);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+      std::size_t const pattern = iter->pattern;
+      if (begins[pattern] == kNoPatternMatch ||
+          results[pattern] != kNoPatternMatch || pos < iter->offset)
+      {
+        continue;
+      }
+
+      std::size_t const start = pos - iter->offset;
+      auto const& needle = needles_[pattern];
+      if (start < begins[pattern] || needle.value.size() > size - start)
+      {
+        continue;
+      }
+
+      if (MatchesCompiledPattern(data + start, needle))
+      {
+        results[pattern] = start;
+        --pending;
+      }
+    }
+  }
+
+  std::vector<CompiledPattern> needles_;
+  std::vector<Anchor> pair_anchors_;
+  std::vector<Anchor> byte_anchors_;
+  std::vector<std::size_t> unindexed_;
+  std::uint64_t pair_filter_[0x10000 / 64] = {};
+  bool byte_filter_[0x100] = {};
+};
+}
+}
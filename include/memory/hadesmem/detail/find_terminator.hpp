@@ -0,0 +1,149 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+#include <immintrin.h>
+#elif defined(HADESMEM_DETAIL_SSE2)
+#include <emmintrin.h>
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+namespace hadesmem
+{
+namespace detail
+{
+// The kernels below advance p over whole vectors with no zero element, and
+// return true with p pointing at the first zero element if they find one.
+// The mask has one bit per byte, so the index of the first set bit divided by
+// the element size is the index of the first zero element.
+
+#if defined(HADESMEM_DETAIL_SSE2)
+
+inline __m128i CmpEqZero(__m128i v, std::integral_constant<std::size_t, 1>)
+{
+  return _mm_cmpeq_epi8(v, _mm_setzero_si128());
+}
+
+inline __m128i CmpEqZero(__m128i v, std::integral_constant<std::size_t, 2>)
+{
+  return _mm_cmpeq_epi16(v, _mm_setzero_si128());
+}
+
+inline __m128i CmpEqZero(__m128i v, std::integral_constant<std::size_t, 4>)
+{
+  return _mm_cmpeq_epi32(v, _mm_setzero_si128());
+}
+
+template <typename T> bool FindTerminatorSse2(T*& p, T* end) noexcept
+{
+  using ElemSize = std::integral_constant<std::size_t, sizeof(T)>;
+
+  std::size_t const kElemsPerXmm = 16 / sizeof(T);
+  for (; static_cast<std::size_t>(end - p) >= kElemsPerXmm; p += kElemsPerXmm)
+  {
+    __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    auto const mask = static_cast<std::uint32_t>(
+      _mm_movemask_epi8(CmpEqZero(v, ElemSize{})));
+    if (mask)
+    {
+      p += CountTrailingZeros(mask) / sizeof(T);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+HADESMEM_DETAIL_AVX2_BEGIN
+
+inline __m256i CmpEqZero(__m256i v, std::integral_constant<std::size_t, 1>)
+{
+  return _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+}
+
+inline __m256i CmpEqZero(__m256i v, std::integral_constant<std::size_t, 2>)
+{
+  return _mm256_cmpeq_epi16(v, _mm256_setzero_si256());
+}
+
+inline __m256i CmpEqZero(__m256i v, std::integral_constant<std::size_t, 4>)
+{
+  return _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+}
+
+template <typename T> bool FindTerminatorAvx2(T*& p, T* end) noexcept
+{
+  using ElemSize = std::integral_constant<std::size_t, sizeof(T)>;
+
+  std::size_t const kElemsPerYmm = 32 / sizeof(T);
+  for (; static_cast<std::size_t>(end - p) >= kElemsPerYmm; p += kElemsPerYmm)
+  {
+    __m256i const v =
+      _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    auto const mask = static_cast<std::uint32_t>(
+      _mm256_movemask_epi8(CmpEqZero(v, ElemSize{})));
+    if (mask)
+    {
+      p += CountTrailingZeros(mask) / sizeof(T);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+HADESMEM_DETAIL_AVX2_END
+
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+// Returns a pointer to the first zero element in [beg, end), or end if there
+// isn't one. Never reads outside of [beg, end).
+template <typename T>
+T* FindTerminator(T* beg, T* end, SimdLevel level = GetSimdLevel()) noexcept
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_integral<T>::value);
+  HADESMEM_DETAIL_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 ||
+                                sizeof(T) == 4);
+
+  T* p = beg;
+
+  switch (level)
+  {
+  case SimdLevel::kAvx2:
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+    if (FindTerminatorAvx2(p, end))
+    {
+      return p;
+    }
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+  // Fall through.
+  case SimdLevel::kSse2:
+#if defined(HADESMEM_DETAIL_SSE2)
+    if (FindTerminatorSse2(p, end))
+    {
+      return p;
+    }
+#endif // #if defined(HADESMEM_DETAIL_SSE2)
+    break;
+  default:
+    break;
+  }
+
+  return std::find(p, end, T());
+}
+}
+}
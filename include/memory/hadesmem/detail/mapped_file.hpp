@@ -0,0 +1,264 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/error.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <windows.h>
+#include <winioctl.h>
+
+#include <hadesmem/detail/smart_handle.hpp>
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <hadesmem/detail/posix_file.hpp>
+#include <hadesmem/detail/winnt.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace hadesmem
+{
+namespace detail
+{
+// A temporary file in the system's temp directory, mapped read/write into our
+// address space. The file is deleted when it's closed (including if we
+// crash). Used to keep large scan state out of RAM.
+//
+// If the file is sparse, pages which are never written don't take up any
+// disk space. This is the default on Linux, and has to be requested on
+// Windows.
+class MappedFile
+{
+public:
+  explicit MappedFile(std::size_t size = 0, bool sparse = false)
+  {
+    Create(sparse);
+    Resize(size);
+  }
+
+  MappedFile(MappedFile const& other) = delete;
+
+  MappedFile& operator=(MappedFile const& other) = delete;
+
+  ~MappedFile()
+  {
+    Unmap();
+  }
+
+  std::uint8_t* GetData() const noexcept
+  {
+    return data_;
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return size_;
+  }
+
+  // Existing contents are preserved (up to the new size), and any new space
+  // is zero filled. Invalidates any pointers into the old mapping.
+  void Resize(std::size_t size)
+  {
+    Unmap();
+    SetFileSize(size);
+    size_ = size;
+    Map();
+  }
+
+private:
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  void Create(bool sparse)
+  {
+    std::vector<wchar_t> temp_dir(MAX_PATH + 1);
+    if (!::GetTempPathW(static_cast<DWORD>(temp_dir.size()), temp_dir.data()))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"GetTempPathW failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    std::vector<wchar_t> temp_path(MAX_PATH + 1);
+    if (!::GetTempFileNameW(temp_dir.data(), L"hdm", 0, temp_path.data()))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"GetTempFileNameW failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    file_ = ::CreateFileW(temp_path.data(),
+                          GENERIC_READ | GENERIC_WRITE,
+                          0,
+                          nullptr,
+                          CREATE_ALWAYS,
+                          FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                          nullptr);
+    if (!file_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"CreateFileW failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    if (sparse)
+    {
+      // Not fatal, the file just takes up more space on disk.
+      DWORD bytes_returned = 0;
+      ::DeviceIoControl(file_.GetHandle(),
+                        FSCTL_SET_SPARSE,
+                        nullptr,
+                        0,
+                        nullptr,
+                        0,
+                        &bytes_returned,
+                        nullptr);
+    }
+  }
+
+  void SetFileSize(std::size_t size)
+  {
+    LARGE_INTEGER distance{};
+    distance.QuadPart = static_cast<LONGLONG>(size);
+    if (!::SetFilePointerEx(file_.GetHandle(), distance, nullptr, FILE_BEGIN) ||
+        !::SetEndOfFile(file_.GetHandle()))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"SetEndOfFile failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+  }
+
+  void Map()
+  {
+    if (!size_)
+    {
+      return;
+    }
+
+    auto const size = static_cast<std::uint64_t>(size_);
+    mapping_ = ::CreateFileMappingW(file_.GetHandle(),
+                                    nullptr,
+                                    PAGE_READWRITE,
+                                    static_cast<DWORD>(size >> 32),
+                                    static_cast<DWORD>(size),
+                                    nullptr);
+    if (!mapping_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"CreateFileMappingW failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    data_ = static_cast<std::uint8_t*>(::MapViewOfFile(
+      mapping_.GetHandle(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size_));
+    if (!data_)
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"MapViewOfFile failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+  }
+
+  void Unmap() noexcept
+  {
+    if (data_)
+    {
+      ::UnmapViewOfFile(data_);
+      data_ = nullptr;
+    }
+
+    mapping_ = nullptr;
+  }
+
+  SmartFileHandle file_;
+  SmartHandle mapping_;
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  void Create(bool /*sparse*/)
+  {
+    char const* const temp_dir = std::getenv("TMPDIR");
+    std::string path_template =
+      std::string{temp_dir && *temp_dir ? temp_dir : "/tmp"} + "/hdmXXXXXX";
+    std::vector<char> path(std::begin(path_template), std::end(path_template));
+    path.push_back('\0');
+
+    int const fd = ::mkstemp(path.data());
+    if (fd == -1)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"mkstemp failed."}
+                << ErrorCodeOther{static_cast<DWORD_PTR>(errno)});
+    }
+    file_.reset(new PosixFile{fd});
+
+    // Deleted as soon as the last reference (our descriptor) goes away.
+    ::unlink(path.data());
+  }
+
+  void SetFileSize(std::size_t size)
+  {
+    if (::ftruncate(file_->GetHandle(), static_cast<off_t>(size)) == -1)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"ftruncate failed."}
+                << ErrorCodeOther{static_cast<DWORD_PTR>(errno)});
+    }
+  }
+
+  void Map()
+  {
+    if (!size_)
+    {
+      return;
+    }
+
+    void* const data = ::mmap(nullptr,
+                              size_,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED,
+                              file_->GetHandle(),
+                              0);
+    if (data == MAP_FAILED)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"mmap failed."}
+                << ErrorCodeOther{static_cast<DWORD_PTR>(errno)});
+    }
+    data_ = static_cast<std::uint8_t*>(data);
+  }
+
+  void Unmap() noexcept
+  {
+    if (data_)
+    {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+    }
+  }
+
+  std::unique_ptr<PosixFile> file_;
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+  std::uint8_t* data_{nullptr};
+  std::size_t size_{0};
+};
+}
+}
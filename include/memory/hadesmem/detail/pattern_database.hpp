@@ -0,0 +1,515 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/error.hpp>
+
+// The binary format of a compiled pattern file (see CompilePatternFile), which
+// FindPattern can use as it is, e.g. straight from a mapped view of the file.
+//
+// The file is a header followed by the module, pattern and manipulator
+// tables, then the strings (as UTF-16) and the pattern bytes:
+//
+//   PatternDatabaseHeader
+//   PatternDatabaseModule[num_modules]
+//   PatternDatabasePattern[num_patterns]
+//   PatternDatabaseManipulator[num_manipulators]
+//   std::uint16_t[num_string_units]
+//   std::uint8_t[num_bytes]
+//
+// Everything is little endian, and every table is 8 byte aligned as long as
+// the file is. The patterns of each module are contiguous and in the order
+// they appear in the pattern file, and a pattern which starts at another one
+// always comes after it (see PatternDatabasePattern::wave). Everything is
+// checked when the file is opened (see PatternDatabaseView), so that nothing
+// needs to be checked when it's used.
+
+namespace hadesmem
+{
+namespace detail
+{
+// "HMPD"
+std::uint32_t const kPatternDatabaseMagic = 0x44504D48;
+
+// Bumped whenever the format changes. Files of other versions have to be
+// compiled again.
+std::uint32_t const kPatternDatabaseVersion = 1;
+
+// Stands in for kNoPatternMatch in the file, so that it's the same size no
+// matter the size of std::size_t.
+std::uint32_t const kPatternDatabaseNone = 0xFFFFFFFF;
+
+enum class PatternDatabaseStart : std::uint32_t
+{
+  // Search the whole module.
+  kNone,
+  // start is an RVA to start after.
+  kRva,
+  // start is the offset of the name of an export, and start_length its
+  // length.
+  kExportName,
+  // start is the ordinal of an export.
+  kExportOrdinal,
+  // start is the index (within the module) of the pattern to start after.
+  kPattern,
+  kInvalidMaxValue
+};
+
+enum class PatternDatabaseOp : std::uint32_t
+{
+  kAdd,
+  kSub,
+  kRel,
+  kLea,
+  kAnd,
+  kInvalidMaxValue
+};
+
+struct PatternDatabaseHeader
+{
+  std::uint32_t magic;
+  std::uint32_t version;
+  // The size of the whole file.
+  std::uint32_t size;
+  std::uint32_t num_modules;
+  std::uint32_t num_patterns;
+  std::uint32_t num_manipulators;
+  std::uint32_t num_string_units;
+  std::uint32_t num_bytes;
+};
+
+struct PatternDatabaseModule
+{
+  std::uint32_t name;
+  std::uint32_t name_length;
+  std::uint32_t first_pattern;
+  std::uint32_t num_patterns;
+  // The number of waves the patterns are resolved in.
+  std::uint32_t num_waves;
+  std::uint32_t reserved;
+};
+
+struct PatternDatabasePattern
+{
+  // Offset and length of the name in the strings.
+  std::uint32_t name;
+  std::uint32_t name_length;
+  // Including the flags of the module.
+  std::uint32_t flags;
+  // Offset of the values in the bytes, which are followed by the masks.
+  std::uint32_t bytes;
+  std::uint32_t length;
+  // See CompiledPattern.
+  std::uint32_t anchor;
+  std::uint32_t check;
+  // A pattern which starts at another one is resolved in the wave after it,
+  // and everything else in the first wave.
+  std::uint32_t wave;
+  std::uint32_t start_type;
+  std::uint32_t start_length;
+  std::uint32_t first_manipulator;
+  std::uint32_t num_manipulators;
+  std::uint64_t start;
+};
+
+struct PatternDatabaseManipulator
+{
+  std::uint32_t op;
+  std::uint32_t num_operands;
+  std::uint64_t operand1;
+  std::uint64_t operand2;
+};
+
+HADESMEM_DETAIL_STATIC_ASSERT(sizeof(PatternDatabaseHeader) == 32);
+HADESMEM_DETAIL_STATIC_ASSERT(sizeof(PatternDatabaseModule) == 24);
+HADESMEM_DETAIL_STATIC_ASSERT(sizeof(PatternDatabasePattern) == 56);
+HADESMEM_DETAIL_STATIC_ASSERT(sizeof(PatternDatabaseManipulator) == 24);
+
+inline std::uint32_t GetPatternDatabaseNumOperands(PatternDatabaseOp op)
+{
+  switch (op)
+  {
+  case PatternDatabaseOp::kRel:
+    return 2;
+  case PatternDatabaseOp::kLea:
+    return 0;
+  default:
+    return 1;
+  }
+}
+
+class PatternDatabaseWriter
+{
+public:
+  void AddModule(std::wstring const& name, std::uint32_t num_waves)
+  {
+    PatternDatabaseModule module{};
+    module.name = AddString(name);
+    module.name_length = ToUInt32(name.size());
+    module.first_pattern = ToUInt32(patterns_.size());
+    module.num_waves = num_waves;
+    modules_.push_back(module);
+  }
+
+  // Adds a pattern to the last module. The flags, wave and start (other than
+  // for kExportName, where it's the name given) are taken from the record.
+  void AddPattern(std::wstring const& name,
+                  CompiledPattern const& pattern,
+                  PatternDatabasePattern record,
+                  std::wstring const& start_export,
+                  std::vector<PatternDatabaseManipulator> const& manipulators)
+  {
+    HADESMEM_DETAIL_ASSERT(!modules_.empty());
+
+    record.name = AddString(name);
+    record.name_length = ToUInt32(name.size());
+    record.bytes = ToUInt32(bytes_.size());
+    record.length = ToUInt32(pattern.value.size());
+    record.anchor = pattern.anchor == kNoPatternMatch
+                      ? kPatternDatabaseNone
+                      : ToUInt32(pattern.anchor);
+    record.check = pattern.check == kNoPatternMatch ? kPatternDatabaseNone
+                                                    : ToUInt32(pattern.check);
+    if (record.start_type ==
+        static_cast<std::uint32_t>(PatternDatabaseStart::kExportName))
+    {
+      record.start = AddString(start_export);
+      record.start_length = ToUInt32(start_export.size());
+    }
+    record.first_manipulator = ToUInt32(manipulators_.size());
+    record.num_manipulators = ToUInt32(manipulators.size());
+    bytes_.insert(
+      std::end(bytes_), std::begin(pattern.value), std::end(pattern.value));
+    bytes_.insert(
+      std::end(bytes_), std::begin(pattern.mask), std::end(pattern.mask));
+    manipulators_.insert(std::end(manipulators_),
+                         std::begin(manipulators),
+                         std::end(manipulators));
+    patterns_.push_back(record);
+    ++modules_.back().num_patterns;
+  }
+
+  std::vector<std::uint8_t> GetData() const
+  {
+    PatternDatabaseHeader header{};
+    header.magic = kPatternDatabaseMagic;
+    header.version = kPatternDatabaseVersion;
+    header.num_modules = ToUInt32(modules_.size());
+    header.num_patterns = ToUInt32(patterns_.size());
+    header.num_manipulators = ToUInt32(manipulators_.size());
+    header.num_string_units = ToUInt32(strings_.size());
+    header.num_bytes = ToUInt32(bytes_.size());
+    std::uint64_t const size =
+      sizeof(header) + modules_.size() * sizeof(PatternDatabaseModule) +
+      patterns_.size() * sizeof(PatternDatabasePattern) +
+      manipulators_.size() * sizeof(PatternDatabaseManipulator) +
+      strings_.size() * sizeof(std::uint16_t) + bytes_.size();
+    header.size = ToUInt32(size);
+
+    std::vector<std::uint8_t> data;
+    data.reserve(header.size);
+    Append(data, &header, sizeof(header));
+    Append(data, modules_.data(), modules_.size() * sizeof(modules_[0]));
+    Append(data, patterns_.data(), patterns_.size() * sizeof(patterns_[0]));
+    Append(data,
+           manipulators_.data(),
+           manipulators_.size() * sizeof(PatternDatabaseManipulator));
+    Append(data, strings_.data(), strings_.size() * sizeof(std::uint16_t));
+    Append(data, bytes_.data(), bytes_.size());
+    return data;
+  }
+
+private:
+  template <typename T> static std::uint32_t ToUInt32(T value)
+  {
+    if (value > (std::numeric_limits<std::uint32_t>::max)())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Pattern database is too large."});
+    }
+
+    return static_cast<std::uint32_t>(value);
+  }
+
+  static void
+    Append(std::vector<std::uint8_t>& data, void const* src, std::size_t size)
+  {
+    auto const bytes = static_cast<std::uint8_t const*>(src);
+    data.insert(std::end(data), bytes, bytes + size);
+  }
+
+  std::uint32_t AddString(std::wstring const& str)
+  {
+    std::uint32_t const offset = ToUInt32(strings_.size());
+    for (auto const c : str)
+    {
+      strings_.push_back(static_cast<std::uint16_t>(c));
+    }
+    return offset;
+  }
+
+  std::vector<PatternDatabaseModule> modules_;
+  std::vector<PatternDatabasePattern> patterns_;
+  std::vector<PatternDatabaseManipulator> manipulators_;
+  std::vector<std::uint16_t> strings_;
+  std::vector<std::uint8_t> bytes_;
+};
+
+// A view of a pattern database in memory, which must outlive it. The
+// database is checked in full on construction, and an exception is thrown if
+// it's invalid.
+class PatternDatabaseView
+{
+public:
+  PatternDatabaseView() = default;
+
+  explicit PatternDatabaseView(void const* data, std::size_t size)
+  {
+    if (!data || size < sizeof(PatternDatabaseHeader) ||
+        reinterpret_cast<std::uintptr_t>(data) % 8)
+    {
+      ThrowInvalid();
+    }
+
+    header_ = static_cast<PatternDatabaseHeader const*>(data);
+    if (header_->magic != kPatternDatabaseMagic ||
+        header_->version != kPatternDatabaseVersion ||
+        header_->size != size)
+    {
+      ThrowInvalid();
+    }
+
+    std::uint64_t const expected_size =
+      sizeof(PatternDatabaseHeader) +
+      std::uint64_t{header_->num_modules} * sizeof(PatternDatabaseModule) +
+      std::uint64_t{header_->num_patterns} * sizeof(PatternDatabasePattern) +
+      std::uint64_t{header_->num_manipulators} *
+        sizeof(PatternDatabaseManipulator) +
+      std::uint64_t{header_->num_string_units} * sizeof(std::uint16_t) +
+      header_->num_bytes;
+    if (expected_size != size)
+    {
+      ThrowInvalid();
+    }
+
+    modules_ = reinterpret_cast<PatternDatabaseModule const*>(header_ + 1);
+    patterns_ = reinterpret_cast<PatternDatabasePattern const*>(
+      modules_ + header_->num_modules);
+    manipulators_ = reinterpret_cast<PatternDatabaseManipulator const*>(
+      patterns_ + header_->num_patterns);
+    strings_ = reinterpret_cast<std::uint16_t const*>(
+      manipulators_ + header_->num_manipulators);
+    bytes_ = reinterpret_cast<std::uint8_t const*>(
+      strings_ + header_->num_string_units);
+
+    std::uint32_t next_pattern = 0;
+    for (std::uint32_t i = 0; i < header_->num_modules; ++i)
+    {
+      auto const& module = modules_[i];
+      if (!IsStringValid(module.name, module.name_length) ||
+          module.first_pattern != next_pattern ||
+          module.num_patterns > header_->num_patterns - next_pattern ||
+          module.num_waves > module.num_patterns)
+      {
+        ThrowInvalid();
+      }
+
+      for (std::uint32_t j = 0; j < module.num_patterns; ++j)
+      {
+        CheckPattern(module, j);
+      }
+
+      next_pattern += module.num_patterns;
+    }
+
+    if (next_pattern != header_->num_patterns)
+    {
+      ThrowInvalid();
+    }
+
+    for (std::uint32_t i = 0; i < header_->num_manipulators; ++i)
+    {
+      auto const& m = manipulators_[i];
+      auto const op = static_cast<PatternDatabaseOp>(m.op);
+      if (op >= PatternDatabaseOp::kInvalidMaxValue ||
+          m.num_operands != GetPatternDatabaseNumOperands(op))
+      {
+        ThrowInvalid();
+      }
+    }
+  }
+
+  std::size_t GetNumModules() const noexcept
+  {
+    return header_ ? header_->num_modules : 0;
+  }
+
+  PatternDatabaseModule const& GetModule(std::size_t index) const noexcept
+  {
+    return modules_[index];
+  }
+
+  PatternDatabasePattern const& GetPattern(PatternDatabaseModule const& module,
+                                           std::size_t index) const noexcept
+  {
+    return patterns_[module.first_pattern + index];
+  }
+
+  PatternDatabaseManipulator const&
+    GetManipulator(PatternDatabasePattern const& pattern,
+                   std::size_t index) const noexcept
+  {
+    return manipulators_[pattern.first_manipulator + index];
+  }
+
+  std::wstring GetString(std::uint32_t offset, std::uint32_t length) const
+  {
+    return std::wstring(strings_ + offset, strings_ + offset + length);
+  }
+
+  std::wstring GetName(PatternDatabaseModule const& module) const
+  {
+    return GetString(module.name, module.name_length);
+  }
+
+  std::wstring GetName(PatternDatabasePattern const& pattern) const
+  {
+    return GetString(pattern.name, pattern.name_length);
+  }
+
+  std::uint8_t const* GetValue(PatternDatabasePattern const& pattern) const
+    noexcept
+  {
+    return bytes_ + pattern.bytes;
+  }
+
+  std::uint8_t const* GetMask(PatternDatabasePattern const& pattern) const
+    noexcept
+  {
+    return bytes_ + pattern.bytes + pattern.length;
+  }
+
+  CompiledPattern
+    GetCompiledPattern(PatternDatabasePattern const& pattern) const
+  {
+    auto const value = GetValue(pattern);
+    auto const mask = GetMask(pattern);
+    return CompiledPattern{
+      std::vector<std::uint8_t>(value, value + pattern.length),
+      std::vector<std::uint8_t>(mask, mask + pattern.length),
+      pattern.anchor == kPatternDatabaseNone ? kNoPatternMatch : pattern.anchor,
+      pattern.check == kPatternDatabaseNone ? kNoPatternMatch : pattern.check};
+  }
+
+private:
+  static void ThrowInvalid()
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Invalid pattern database."});
+  }
+
+  bool IsStringValid(std::uint32_t offset, std::uint32_t length) const noexcept
+  {
+    return offset <= header_->num_string_units &&
+           length <= header_->num_string_units - offset;
+  }
+
+  void CheckPattern(PatternDatabaseModule const& module,
+                    std::uint32_t index) const
+  {
+    auto const& pattern = patterns_[module.first_pattern + index];
+    if (!IsStringValid(pattern.name, pattern.name_length) ||
+        !pattern.length || pattern.bytes > header_->num_bytes ||
+        pattern.length > (header_->num_bytes - pattern.bytes) / 2 ||
+        pattern.wave >= module.num_waves ||
+        pattern.first_manipulator > header_->num_manipulators ||
+        pattern.num_manipulators >
+          header_->num_manipulators - pattern.first_manipulator)
+    {
+      ThrowInvalid();
+    }
+
+    // Wildcarded bits have to be clear, and the anchor and check bytes can't
+    // be wildcards (or past the end).
+    auto const value = GetValue(pattern);
+    auto const mask = GetMask(pattern);
+    for (std::uint32_t i = 0; i < pattern.length; ++i)
+    {
+      if (value[i] & ~mask[i])
+      {
+        ThrowInvalid();
+      }
+    }
+
+    if ((pattern.anchor == kPatternDatabaseNone) !=
+          (pattern.check == kPatternDatabaseNone) ||
+        (pattern.anchor != kPatternDatabaseNone &&
+         (pattern.anchor >= pattern.length || pattern.check >= pattern.length ||
+          !mask[pattern.anchor] || !mask[pattern.check])))
+    {
+      ThrowInvalid();
+    }
+
+    switch (static_cast<PatternDatabaseStart>(pattern.start_type))
+    {
+    case PatternDatabaseStart::kNone:
+    case PatternDatabaseStart::kRva:
+      if (pattern.wave != 0)
+      {
+        ThrowInvalid();
+      }
+      break;
+
+    case PatternDatabaseStart::kExportOrdinal:
+      if (pattern.wave != 0 || pattern.start > 0xFFFF)
+      {
+        ThrowInvalid();
+      }
+      break;
+
+    case PatternDatabaseStart::kExportName:
+      if (pattern.wave != 0 || !pattern.start_length ||
+          pattern.start > header_->num_string_units ||
+          !IsStringValid(static_cast<std::uint32_t>(pattern.start),
+                         pattern.start_length))
+      {
+        ThrowInvalid();
+      }
+      break;
+
+    case PatternDatabaseStart::kPattern:
+      // The pattern it starts at has to come first, and be resolved in the
+      // wave before it.
+      if (pattern.start >= index ||
+          pattern.wave !=
+            patterns_[module.first_pattern + pattern.start].wave + 1)
+      {
+        ThrowInvalid();
+      }
+      break;
+
+    default:
+      ThrowInvalid();
+    }
+  }
+
+  PatternDatabaseHeader const* header_{};
+  PatternDatabaseModule const* modules_{};
+  PatternDatabasePattern const* patterns_{};
+  PatternDatabaseManipulator const* manipulators_{};
+  std::uint16_t const* strings_{};
+  std::uint8_t const* bytes_{};
+};
+}
+}
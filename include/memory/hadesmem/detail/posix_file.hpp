@@ -0,0 +1,46 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <hadesmem/config.hpp>
+
+#if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include <unistd.h>
+
+namespace hadesmem
+{
+namespace detail
+{
+class PosixFile
+{
+public:
+  explicit PosixFile(int fd) noexcept : fd_{fd}
+  {
+  }
+
+  PosixFile(PosixFile const& other) = delete;
+
+  PosixFile& operator=(PosixFile const& other) = delete;
+
+  ~PosixFile()
+  {
+    if (fd_ != -1)
+    {
+      ::close(fd_);
+    }
+  }
+
+  int GetHandle() const noexcept
+  {
+    return fd_;
+  }
+
+private:
+  int fd_;
+};
+}
+}
+
+#endif // #if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
@@ -27,6 +27,19 @@ enum class ProtectGuardType
   kWrite
 };
 
+// Whether the region can be accessed as-is, in which case constructing a
+// ProtectGuard would be a no-op and can be skipped entirely.
+inline bool CanAccessWithoutGuard(MEMORY_BASIC_INFORMATION const& mbi,
+                                  ProtectGuardType type) noexcept
+{
+  if (IsBadProtect(mbi))
+  {
+    return false;
+  }
+
+  return (type == ProtectGuardType::kRead) ? CanRead(mbi) : CanWrite(mbi);
+}
+
 class ProtectGuard
 {
 public:
@@ -6,6 +6,7 @@
 #include <windows.h>
 
 #include <hadesmem/config.hpp>
+#include <hadesmem/detail/query_region.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/process.hpp>
 
@@ -25,11 +26,14 @@ inline DWORD Protect(Process const& process,
                           &old_protect))
   {
     DWORD const last_error = ::GetLastError();
+    InvalidateRegionCache(process, mbi.BaseAddress, mbi.RegionSize);
     HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                     << ErrorString{"VirtualProtectEx failed."}
                                     << ErrorCodeWinLast{last_error});
   }
 
+  InvalidateRegionCache(process, mbi.BaseAddress, mbi.RegionSize);
+
   return old_protect;
 }
 }
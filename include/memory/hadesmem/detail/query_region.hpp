@@ -3,17 +3,21 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include <windows.h>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/process.hpp>
+#include <hadesmem/region_cache.hpp>
 
 namespace hadesmem
 {
 namespace detail
 {
-inline MEMORY_BASIC_INFORMATION Query(Process const& process, LPCVOID address)
+inline MEMORY_BASIC_INFORMATION QueryUncached(Process const& process,
+                                              LPCVOID address)
 {
   MEMORY_BASIC_INFORMATION mbi{};
   if (::VirtualQueryEx(process.GetHandle(), address, &mbi, sizeof(mbi)) !=
@@ -28,6 +32,35 @@ inline MEMORY_BASIC_INFORMATION Query(Process const& process, LPCVOID address)
   return mbi;
 }
 
+inline MEMORY_BASIC_INFORMATION Query(Process const& process, LPCVOID address)
+{
+  if (RegionCache* const region_cache = process.GetRegionCache())
+  {
+    return region_cache->Query(
+      address, [&](LPCVOID a) { return QueryUncached(process, a); });
+  }
+
+  return QueryUncached(process, address);
+}
+
+inline void InvalidateRegionCache(Process const& process,
+                                  LPCVOID address,
+                                  std::size_t size)
+{
+  if (RegionCache* const region_cache = process.GetRegionCache())
+  {
+    region_cache->Invalidate(address, size);
+  }
+}
+
+inline void InvalidateRegionCache(Process const& process)
+{
+  if (RegionCache* const region_cache = process.GetRegionCache())
+  {
+    region_cache->Invalidate();
+  }
+}
+
 inline bool
   CanRead(MEMORY_BASIC_INFORMATION const& mbi) noexcept
 {
@@ -0,0 +1,194 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+struct ReadRequest
+{
+  void* address;
+  void* data;
+  std::size_t len;
+};
+
+template <typename T> inline ReadRequest MakeReadRequest(void* address, T& out)
+{
+  return ReadRequest{address, std::addressof(out), sizeof(T)};
+}
+
+namespace detail
+{
+// Default distance between two requests under which they will be merged into
+// a single read. Reading a few hundred unneeded bytes is far cheaper than the
+// extra syscall.
+std::size_t const kReadBatchDefaultMergeGap = 0x200;
+
+// Upper bound on the size of a single merged read, so that a long chain of
+// nearly adjacent requests doesn't turn into one huge allocation.
+std::size_t const kReadBatchMaxSpan = 0x10000;
+
+// Whether the gap [end, next_beg) between two requests may be read along with
+// them. It must lie in the same region as the last requested byte before it,
+// so that it has the same protection and reading it never needs a protection
+// change (or touches a guard page) which the requested bytes wouldn't. Requests
+// are processed in ascending order, so the last region queried is kept in
+// [region_beg, region_end) and reused where possible.
+template <typename QueryFunc>
+bool CanMergeReadGap(std::uintptr_t end,
+                     std::uintptr_t next_beg,
+                     std::uintptr_t& region_beg,
+                     std::uintptr_t& region_end,
+                     QueryFunc& query)
+{
+  std::uintptr_t const last = end - 1;
+  if (last < region_beg || last >= region_end)
+  {
+    MEMORY_BASIC_INFORMATION mbi;
+    try
+    {
+      mbi = query(reinterpret_cast<void const*>(last));
+    }
+    catch (...)
+    {
+      region_beg = region_end = 0;
+      return false;
+    }
+
+    region_beg = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+    region_end = region_beg + mbi.RegionSize;
+  }
+
+  return next_beg <= region_end;
+}
+
+// ReadFunc must be callable as void(void* address, void* data, std::size_t len)
+// and throw on failure. QueryFunc must be callable as
+// MEMORY_BASIC_INFORMATION(void const* address), with the same semantics as a
+// memory source's Query (see memory_source.hpp), and is used to decide which
+// gaps can be merged (see CanMergeReadGap). Returns the number of calls made
+// to ReadFunc.
+template <typename ReadFunc, typename QueryFunc>
+std::size_t ReadBatchImpl(ReadRequest const* requests,
+                          std::size_t count,
+                          std::size_t merge_gap,
+                          ReadFunc read,
+                          QueryFunc query)
+{
+  HADESMEM_DETAIL_ASSERT(count ? requests != nullptr : true);
+
+  auto const get_beg = [](ReadRequest const* r) {
+    return reinterpret_cast<std::uintptr_t>(r->address);
+  };
+  auto const get_end = [](ReadRequest const* r) {
+    return reinterpret_cast<std::uintptr_t>(r->address) + r->len;
+  };
+
+  std::vector<ReadRequest const*> sorted;
+  sorted.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (requests[i].len)
+    {
+      HADESMEM_DETAIL_ASSERT(requests[i].address != nullptr);
+      HADESMEM_DETAIL_ASSERT(requests[i].data != nullptr);
+      sorted.push_back(&requests[i]);
+    }
+  }
+
+  std::stable_sort(std::begin(sorted),
+                   std::end(sorted),
+                   [&](ReadRequest const* lhs, ReadRequest const* rhs) {
+                     return get_beg(lhs) < get_beg(rhs);
+                   });
+
+  std::size_t num_reads = 0;
+  std::vector<std::uint8_t> buf;
+  std::uintptr_t region_beg = 0;
+  std::uintptr_t region_end = 0;
+  for (std::size_t i = 0; i < sorted.size();)
+  {
+    std::uintptr_t const beg = get_beg(sorted[i]);
+    std::uintptr_t end = get_end(sorted[i]);
+
+    std::size_t j = i + 1;
+    for (; j < sorted.size(); ++j)
+    {
+      std::uintptr_t const next_beg = get_beg(sorted[j]);
+      std::uintptr_t const next_end = (std::max)(end, get_end(sorted[j]));
+      if (next_beg > end && next_beg - end > merge_gap)
+      {
+        break;
+      }
+
+      if (next_end - beg > kReadBatchMaxSpan)
+      {
+        break;
+      }
+
+      if (next_beg > end &&
+          !CanMergeReadGap(end, next_beg, region_beg, region_end, query))
+      {
+        break;
+      }
+
+      end = next_end;
+    }
+
+    if (j - i == 1)
+    {
+      read(sorted[i]->address, sorted[i]->data, sorted[i]->len);
+      ++num_reads;
+      i = j;
+      continue;
+    }
+
+    std::size_t const span = static_cast<std::size_t>(end - beg);
+    buf.resize(span);
+
+    bool merged_ok = true;
+    try
+    {
+      ++num_reads;
+      read(reinterpret_cast<void*>(beg), buf.data(), span);
+    }
+    catch (...)
+    {
+      // The region information may be stale (e.g. the target freed the
+      // memory in a gap since it was queried), so retry the requests
+      // individually. If one of those fails too the error is propagated as
+      // normal.
+      merged_ok = false;
+    }
+
+    for (std::size_t k = i; k < j; ++k)
+    {
+      if (merged_ok)
+      {
+        std::memcpy(
+          sorted[k]->data, &buf[get_beg(sorted[k]) - beg], sorted[k]->len);
+      }
+      else
+      {
+        read(sorted[k]->address, sorted[k]->data, sorted[k]->len);
+        ++num_reads;
+      }
+    }
+
+    i = j;
+  }
+
+  return num_reads;
+}
+}
+}
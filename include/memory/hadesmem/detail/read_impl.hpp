@@ -23,8 +23,14 @@ struct ReadFlags
 {
   enum : std::uint32_t
   {
-    kNone,
-    kZeroFillReserved
+    kNone = 0,
+    kZeroFillReserved = 1 << 0,
+    // Skip querying the region and go straight to ReadProcessMemory, falling
+    // back to the normal path only if that fails. Useful when the caller
+    // knows the memory is almost always readable (e.g. mapped images). The
+    // direct read isn't checked for PAGE_GUARD first, so it trips (and so
+    // removes) the guard instead of failing like a normal read would.
+    kAssumeAccessible = 1 << 1
   };
 };
 
@@ -50,12 +56,29 @@ inline void ReadUnchecked(Process const& process,
       bytes_read != len)
   {
     DWORD const last_error = ::GetLastError();
+    // The cached region info may be stale, so don't trust it next time.
+    InvalidateRegionCache(process, address, len);
     HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                     << ErrorString{"ReadProcessMemory failed."}
                                     << ErrorCodeWinLast{last_error});
   }
 }
 
+inline bool TryReadUnchecked(Process const& process,
+                             void* address,
+                             void* data,
+                             std::size_t len) noexcept
+{
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+  HADESMEM_DETAIL_ASSERT(data != nullptr);
+  HADESMEM_DETAIL_ASSERT(len != 0);
+
+  SIZE_T bytes_read = 0;
+  return ::ReadProcessMemory(
+           process.GetHandle(), address, data, len, &bytes_read) &&
+         bytes_read == len;
+}
+
 inline void ReadImpl(Process const& process,
                      void* address,
                      void* data,
@@ -70,6 +93,13 @@ inline void ReadImpl(Process const& process,
     return;
   }
 
+  if (!!(flags & ReadFlags::kAssumeAccessible) &&
+      TryReadUnchecked(process, address, data, len))
+  {
+    return;
+  }
+
+  bool allow_fast_path = true;
   for (;;)
   {
     MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
@@ -78,49 +108,49 @@ inline void ReadImpl(Process const& process,
     void* const region_next =
       static_cast<std::uint8_t*>(mbi.BaseAddress) + mbi.RegionSize;
 
+    std::size_t const len_cur =
+      (address_end <= region_next)
+        ? len
+        : reinterpret_cast<std::uintptr_t>(region_next) -
+            reinterpret_cast<std::uintptr_t>(address);
+
     bool const should_zero_fill =
       (mbi.State == MEM_RESERVE && !!(flags & ReadFlags::kZeroFillReserved));
 
-    if (address_end <= region_next)
+    if (should_zero_fill)
     {
-      if (should_zero_fill)
-      {
-        std::fill(static_cast<std::uint8_t*>(data),
-                  static_cast<std::uint8_t*>(data) + len,
-                  0);
-      }
-      else
+      std::fill(static_cast<std::uint8_t*>(data),
+                static_cast<std::uint8_t*>(data) + len_cur,
+                0);
+    }
+    else if (allow_fast_path &&
+             CanAccessWithoutGuard(mbi, ProtectGuardType::kRead))
+    {
+      if (!TryReadUnchecked(process, address, data, len_cur))
       {
-        ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
-        ReadUnchecked(process, address, data, len, flags);
-        protect_guard.Restore();
+        // Our view of the region may be stale (e.g. it came from the region
+        // cache), so query it again and retry through ProtectGuard.
+        InvalidateRegionCache(process, address, len_cur);
+        allow_fast_path = false;
+        continue;
       }
-
-      return;
     }
     else
     {
-      std::size_t const len_new =
-        reinterpret_cast<std::uintptr_t>(region_next) -
-        reinterpret_cast<std::uintptr_t>(address);
-
-      if (should_zero_fill)
-      {
-        std::fill(static_cast<std::uint8_t*>(data),
-                  static_cast<std::uint8_t*>(data) + len_new,
-                  0);
-      }
-      else
-      {
-        ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
-        ReadUnchecked(process, address, data, len_new, flags);
-        protect_guard.Restore();
-      }
+      ProtectGuard protect_guard{process, mbi, ProtectGuardType::kRead};
+      ReadUnchecked(process, address, data, len_cur, flags);
+      protect_guard.Restore();
+    }
 
-      address = static_cast<std::uint8_t*>(address) + len_new;
-      data = static_cast<std::uint8_t*>(data) + len_new;
-      len -= len_new;
+    if (len_cur == len)
+    {
+      return;
     }
+
+    address = static_cast<std::uint8_t*>(address) + len_cur;
+    data = static_cast<std::uint8_t*>(data) + len_cur;
+    len -= len_cur;
+    allow_fast_path = true;
   }
 }
 
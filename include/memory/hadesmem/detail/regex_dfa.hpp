@@ -0,0 +1,1093 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/error.hpp>
+
+// A small regex engine for scanning memory. Patterns are parsed into a tree
+// over code points, encoded as UTF-8 or UTF-16LE byte sequences, built into
+// a Thompson NFA and then compiled into a DFA over bytes, so scanning costs
+// one table lookup per byte no matter how complex the pattern is.
+//
+// Supported syntax: literals, '.', character classes ([a-z], [^...]), the
+// escapes \d \w \s \D \W \S \n \r \t \f \v \0 \xHH \uHHHH (and any escaped
+// punctuation), grouping with (...) or (?:...), alternation and the
+// quantifiers * + ? {n} {n,} {n,m}. There are no anchors, backreferences or
+// lookarounds, because a DFA can't do them.
+
+namespace hadesmem
+{
+namespace detail
+{
+typedef std::vector<std::pair<std::uint32_t, std::uint32_t>> CodePointRanges;
+
+std::uint32_t const kMaxCodePoint = 0x10FFFF;
+
+inline void NormalizeCodePointRanges(CodePointRanges& ranges)
+{
+  std::sort(std::begin(ranges), std::end(ranges));
+  CodePointRanges merged;
+  for (auto const& r : ranges)
+  {
+    if (!merged.empty() && r.first <= merged.back().second + 1)
+    {
+      merged.back().second = (std::max)(merged.back().second, r.second);
+    }
+    else
+    {
+      merged.push_back(r);
+    }
+  }
+  ranges.swap(merged);
+}
+
+// The ranges must be normalized.
+inline CodePointRanges NegateCodePointRanges(CodePointRanges const& ranges)
+{
+  CodePointRanges negated;
+  std::uint32_t next = 0;
+  for (auto const& r : ranges)
+  {
+    if (r.first > next)
+    {
+      negated.emplace_back(next, r.first - 1);
+    }
+    next = r.second + 1;
+  }
+  if (next <= kMaxCodePoint)
+  {
+    negated.emplace_back(next, kMaxCodePoint);
+  }
+  return negated;
+}
+
+// The ranges must be normalized.
+inline bool ContainsCodePoint(CodePointRanges const& ranges, std::uint32_t cp)
+{
+  auto const iter = std::upper_bound(
+    std::begin(ranges),
+    std::end(ranges),
+    cp,
+    [](std::uint32_t v, std::pair<std::uint32_t, std::uint32_t> const& r) {
+      return v < r.first;
+    });
+  return iter != std::begin(ranges) && std::prev(iter)->second >= cp;
+}
+
+// Simple (one to one) case mappings from upper to lower case, for the
+// scripts which are likely to turn up in a target: Latin, Greek, Cyrillic
+// and fullwidth Latin. Each range maps every stride'th code point in [lo,
+// hi] to the code point delta away.
+struct CaseFoldRange
+{
+  std::uint32_t lo;
+  std::uint32_t hi;
+  std::int32_t delta;
+  std::uint32_t stride;
+};
+
+CaseFoldRange const kCaseFoldRanges[] = {{0x0041, 0x005A, 32, 1},
+                                         {0x00C0, 0x00D6, 32, 1},
+                                         {0x00D8, 0x00DE, 32, 1},
+                                         {0x0100, 0x012E, 1, 2},
+                                         {0x0132, 0x0136, 1, 2},
+                                         {0x0139, 0x0147, 1, 2},
+                                         {0x014A, 0x0176, 1, 2},
+                                         {0x0178, 0x0178, -121, 1},
+                                         {0x0179, 0x017D, 1, 2},
+                                         {0x0391, 0x03A1, 32, 1},
+                                         {0x03A3, 0x03AB, 32, 1},
+                                         {0x0400, 0x040F, 80, 1},
+                                         {0x0410, 0x042F, 32, 1},
+                                         {0x0460, 0x0480, 1, 2},
+                                         {0x048A, 0x04BE, 1, 2},
+                                         {0xFF21, 0xFF3A, 32, 1}};
+
+// Adds the other case of every code point in the set which has one. The
+// ranges must be normalized, and are normalized again afterwards.
+inline void AddCaseVariants(CodePointRanges& ranges)
+{
+  CodePointRanges added;
+  for (auto const& f : kCaseFoldRanges)
+  {
+    for (std::uint32_t upper = f.lo; upper <= f.hi; upper += f.stride)
+    {
+      auto const lower =
+        static_cast<std::uint32_t>(static_cast<std::int32_t>(upper) + f.delta);
+      bool const has_upper = ContainsCodePoint(ranges, upper);
+      if (has_upper != ContainsCodePoint(ranges, lower))
+      {
+        std::uint32_t const other = has_upper ? lower : upper;
+        added.emplace_back(other, other);
+      }
+    }
+  }
+  ranges.insert(std::end(ranges), std::begin(added), std::end(added));
+  NormalizeCodePointRanges(ranges);
+}
+
+inline std::vector<std::uint32_t> DecodeUtf8(std::string const& str)
+{
+  std::vector<std::uint32_t> cps;
+  for (std::size_t i = 0; i < str.size();)
+  {
+    auto const b = static_cast<std::uint8_t>(str[i]);
+    std::size_t const len = b < 0x80 ? 1 : (b >> 5) == 0x6
+                                             ? 2
+                                             : (b >> 4) == 0xE
+                                                 ? 3
+                                                 : (b >> 3) == 0x1E ? 4 : 0;
+    if (!len || i + len > str.size())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid UTF-8."});
+    }
+
+    std::uint32_t cp = len == 1 ? b : b & (0x7F >> len);
+    for (std::size_t j = 1; j < len; ++j)
+    {
+      auto const c = static_cast<std::uint8_t>(str[i + j]);
+      if ((c & 0xC0) != 0x80)
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                        << ErrorString{"Invalid UTF-8."});
+      }
+      cp = (cp << 6) | (c & 0x3F);
+    }
+    cps.push_back(cp);
+    i += len;
+  }
+  return cps;
+}
+
+// UTF-16 where wchar_t is 16 bits (Windows), and UTF-32 elsewhere.
+inline std::vector<std::uint32_t> DecodeWide(std::wstring const& str)
+{
+  std::vector<std::uint32_t> cps;
+  for (std::size_t i = 0; i < str.size(); ++i)
+  {
+    auto cp = static_cast<std::uint32_t>(str[i]);
+    if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp <= 0xDBFF &&
+        i + 1 < str.size())
+    {
+      auto const low = static_cast<std::uint32_t>(str[i + 1]);
+      if (low >= 0xDC00 && low <= 0xDFFF)
+      {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        ++i;
+      }
+    }
+    cps.push_back(cp);
+  }
+  return cps;
+}
+
+struct RegexNode
+{
+  enum class Type
+  {
+    kSet,
+    kConcat,
+    kAlternate,
+    kRepeat
+  };
+
+  Type type;
+  // kSet only.
+  CodePointRanges set;
+  std::vector<RegexNode> children;
+  // kRepeat only.
+  std::size_t min;
+  std::size_t max;
+};
+
+std::size_t const kRegexUnbounded = static_cast<std::size_t>(-1);
+std::size_t const kRegexMaxRepeat = 1000;
+
+inline RegexNode MakeRegexNode(RegexNode::Type type)
+{
+  RegexNode node;
+  node.type = type;
+  node.min = 0;
+  node.max = 0;
+  return node;
+}
+
+inline RegexNode MakeRegexSetNode(CodePointRanges set, bool case_insensitive)
+{
+  auto node = MakeRegexNode(RegexNode::Type::kSet);
+  NormalizeCodePointRanges(set);
+  if (case_insensitive)
+  {
+    AddCaseVariants(set);
+  }
+  node.set = std::move(set);
+  return node;
+}
+
+// A string which is matched literally.
+inline RegexNode MakeRegexLiteralNode(std::vector<std::uint32_t> const& cps,
+                                      bool case_insensitive)
+{
+  auto node = MakeRegexNode(RegexNode::Type::kConcat);
+  for (auto const cp : cps)
+  {
+    node.children.push_back(
+      MakeRegexSetNode(CodePointRanges{{cp, cp}}, case_insensitive));
+  }
+  return node;
+}
+
+class RegexParser
+{
+public:
+  RegexParser(std::vector<std::uint32_t> const& pattern,
+              bool case_insensitive)
+    : pattern_(pattern), case_insensitive_{case_insensitive}
+  {
+  }
+
+  RegexNode Parse()
+  {
+    auto node = ParseAlternate();
+    if (pos_ != pattern_.size())
+    {
+      Fail("Unbalanced parenthesis in regex.");
+    }
+    return node;
+  }
+
+private:
+  [[noreturn]] void Fail(char const* what) const
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{} << ErrorString{what});
+  }
+
+  bool Peek(std::uint32_t c) const
+  {
+    return pos_ < pattern_.size() && pattern_[pos_] == c;
+  }
+
+  RegexNode ParseAlternate()
+  {
+    auto node = MakeRegexNode(RegexNode::Type::kAlternate);
+    node.children.push_back(ParseConcat());
+    while (Peek('|'))
+    {
+      ++pos_;
+      node.children.push_back(ParseConcat());
+    }
+    if (node.children.size() == 1)
+    {
+      return std::move(node.children[0]);
+    }
+    return node;
+  }
+
+  RegexNode ParseConcat()
+  {
+    auto node = MakeRegexNode(RegexNode::Type::kConcat);
+    while (pos_ < pattern_.size() && !Peek('|') && !Peek(')'))
+    {
+      node.children.push_back(ParseRepeat());
+    }
+    return node;
+  }
+
+  RegexNode ParseRepeat()
+  {
+    auto node = ParseAtom();
+    for (;;)
+    {
+      std::size_t min = 0;
+      std::size_t max = 0;
+      if (Peek('*'))
+      {
+        max = kRegexUnbounded;
+        ++pos_;
+      }
+      else if (Peek('+'))
+      {
+        min = 1;
+        max = kRegexUnbounded;
+        ++pos_;
+      }
+      else if (Peek('?'))
+      {
+        max = 1;
+        ++pos_;
+      }
+      else if (!Peek('{') || !ParseBounds(min, max))
+      {
+        return node;
+      }
+
+      auto repeat = MakeRegexNode(RegexNode::Type::kRepeat);
+      repeat.min = min;
+      repeat.max = max;
+      repeat.children.push_back(std::move(node));
+      node = std::move(repeat);
+    }
+  }
+
+  // Parses {n}, {n,} or {n,m}. Anything else is a literal '{'.
+  bool ParseBounds(std::size_t& min, std::size_t& max)
+  {
+    std::size_t pos = pos_ + 1;
+    auto const parse_number = [&](std::size_t& out) {
+      std::size_t const beg = pos;
+      out = 0;
+      while (pos < pattern_.size() && pattern_[pos] >= '0' &&
+             pattern_[pos] <= '9' && out <= kRegexMaxRepeat)
+      {
+        out = out * 10 + (pattern_[pos++] - '0');
+      }
+      return pos != beg;
+    };
+
+    if (!parse_number(min))
+    {
+      return false;
+    }
+    max = min;
+    if (pos < pattern_.size() && pattern_[pos] == ',')
+    {
+      ++pos;
+      if (!parse_number(max))
+      {
+        max = kRegexUnbounded;
+      }
+    }
+    if (pos >= pattern_.size() || pattern_[pos] != '}')
+    {
+      return false;
+    }
+
+    if (min > kRegexMaxRepeat ||
+        (max != kRegexUnbounded && (max > kRegexMaxRepeat || max < min)))
+    {
+      Fail("Invalid repeat count in regex.");
+    }
+    pos_ = pos + 1;
+    return true;
+  }
+
+  RegexNode ParseAtom()
+  {
+    std::uint32_t const c = pattern_[pos_++];
+    switch (c)
+    {
+    case '(':
+    {
+      if (Peek('?'))
+      {
+        if (pos_ + 1 >= pattern_.size() || pattern_[pos_ + 1] != ':')
+        {
+          Fail("Unsupported group in regex.");
+        }
+        pos_ += 2;
+      }
+      auto node = ParseAlternate();
+      if (!Peek(')'))
+      {
+        Fail("Unbalanced parenthesis in regex.");
+      }
+      ++pos_;
+      return node;
+    }
+    case '*':
+    case '+':
+    case '?':
+      Fail("Nothing to repeat in regex.");
+    case '^':
+    case '$':
+      Fail("Anchors are not supported in regex.");
+    case '[':
+      return ParseClass();
+    case '.':
+      return MakeRegexSetNode(NegateCodePointRanges({{'\n', '\n'}}), false);
+    case '\\':
+      return MakeRegexSetNode(ParseEscape(), case_insensitive_);
+    default:
+      return MakeRegexSetNode({{c, c}}, case_insensitive_);
+    }
+  }
+
+  std::uint32_t ParseHex(std::size_t digits)
+  {
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < digits; ++i, ++pos_)
+    {
+      if (pos_ >= pattern_.size())
+      {
+        Fail("Invalid hex escape in regex.");
+      }
+      std::uint32_t const c = pattern_[pos_];
+      std::uint32_t const digit =
+        c >= '0' && c <= '9'
+          ? c - '0'
+          : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+      if (digit > 15)
+      {
+        Fail("Invalid hex escape in regex.");
+      }
+      value = value * 16 + digit;
+    }
+    return value;
+  }
+
+  CodePointRanges ParseEscape()
+  {
+    if (pos_ >= pattern_.size())
+    {
+      Fail("Trailing backslash in regex.");
+    }
+
+    CodePointRanges const digit{{'0', '9'}};
+    CodePointRanges const word{{'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'}};
+    CodePointRanges const space{{'\t', '\r'}, {' ', ' '}};
+    std::uint32_t const c = pattern_[pos_++];
+    switch (c)
+    {
+    case 'd':
+      return digit;
+    case 'D':
+      return NegateCodePointRanges(digit);
+    case 'w':
+      return word;
+    case 'W':
+      return NegateCodePointRanges(word);
+    case 's':
+      return space;
+    case 'S':
+      return NegateCodePointRanges(space);
+    case 'n':
+      return {{'\n', '\n'}};
+    case 'r':
+      return {{'\r', '\r'}};
+    case 't':
+      return {{'\t', '\t'}};
+    case 'f':
+      return {{'\f', '\f'}};
+    case 'v':
+      return {{'\v', '\v'}};
+    case '0':
+      return {{0, 0}};
+    case 'x':
+    {
+      std::uint32_t const cp = ParseHex(2);
+      return {{cp, cp}};
+    }
+    case 'u':
+    {
+      std::uint32_t const cp = ParseHex(4);
+      return {{cp, cp}};
+    }
+    default:
+      if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+          (c >= 'a' && c <= 'z'))
+      {
+        Fail("Unsupported escape in regex.");
+      }
+      return {{c, c}};
+    }
+  }
+
+  RegexNode ParseClass()
+  {
+    bool const negate = Peek('^');
+    if (negate)
+    {
+      ++pos_;
+    }
+
+    CodePointRanges set;
+    for (bool first = true;; first = false)
+    {
+      if (pos_ >= pattern_.size())
+      {
+        Fail("Unterminated character class in regex.");
+      }
+      if (Peek(']') && !first)
+      {
+        ++pos_;
+        break;
+      }
+
+      auto item = ParseClassItem();
+      if (item.size() == 1 && item[0].first == item[0].second && Peek('-') &&
+          pos_ + 1 < pattern_.size() && pattern_[pos_ + 1] != ']')
+      {
+        ++pos_;
+        auto const hi = ParseClassItem();
+        if (hi.size() != 1 || hi[0].first != hi[0].second ||
+            hi[0].first < item[0].first)
+        {
+          Fail("Invalid range in regex character class.");
+        }
+        item[0].second = hi[0].first;
+      }
+      set.insert(std::end(set), std::begin(item), std::end(item));
+    }
+
+    // Case variants have to be added before negating, so that e.g. [^a]
+    // doesn't match 'A' either.
+    NormalizeCodePointRanges(set);
+    if (case_insensitive_)
+    {
+      AddCaseVariants(set);
+    }
+    return MakeRegexSetNode(negate ? NegateCodePointRanges(set) : set, false);
+  }
+
+  CodePointRanges ParseClassItem()
+  {
+    std::uint32_t const c = pattern_[pos_++];
+    if (c == '\\')
+    {
+      return ParseEscape();
+    }
+    return {{c, c}};
+  }
+
+  std::vector<std::uint32_t> const& pattern_;
+  bool case_insensitive_;
+  std::size_t pos_{0};
+};
+
+typedef std::vector<std::pair<std::uint8_t, std::uint8_t>> ByteRangeSequence;
+
+inline std::size_t EncodeUtf8(std::uint32_t cp, std::uint8_t* out)
+{
+  if (cp < 0x80)
+  {
+    out[0] = static_cast<std::uint8_t>(cp);
+    return 1;
+  }
+  if (cp < 0x800)
+  {
+    out[0] = static_cast<std::uint8_t>(0xC0 | (cp >> 6));
+    out[1] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000)
+  {
+    out[0] = static_cast<std::uint8_t>(0xE0 | (cp >> 12));
+    out[1] = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<std::uint8_t>(0xF0 | (cp >> 18));
+  out[1] = static_cast<std::uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+// Splits a range of code points into sequences of byte ranges, such that
+// the UTF-8 encodings of the code points are exactly the byte strings
+// matched by the sequences. The range is split until the encodings of its
+// ends have the same length and differ only in bytes which cover their
+// full continuation range.
+inline void AddUtf8Sequences(std::uint32_t lo,
+                             std::uint32_t hi,
+                             std::vector<ByteRangeSequence>& out)
+{
+  // Surrogates can't be encoded.
+  if (lo <= 0xDFFF && hi >= 0xD800)
+  {
+    if (lo < 0xD800)
+    {
+      AddUtf8Sequences(lo, 0xD7FF, out);
+    }
+    if (hi > 0xDFFF)
+    {
+      AddUtf8Sequences(0xE000, hi, out);
+    }
+    return;
+  }
+
+  std::uint32_t const length_limits[] = {0x7F, 0x7FF, 0xFFFF};
+  for (auto const limit : length_limits)
+  {
+    if (lo <= limit && hi > limit)
+    {
+      AddUtf8Sequences(lo, limit, out);
+      AddUtf8Sequences(limit + 1, hi, out);
+      return;
+    }
+  }
+
+  for (std::uint32_t i = 1; i < 4 && hi >= 0x80; ++i)
+  {
+    std::uint32_t const m = (1U << (6 * i)) - 1;
+    if ((lo & ~m) != (hi & ~m))
+    {
+      if ((lo & m) != 0)
+      {
+        AddUtf8Sequences(lo, lo | m, out);
+        AddUtf8Sequences((lo | m) + 1, hi, out);
+        return;
+      }
+      if ((hi & m) != m)
+      {
+        AddUtf8Sequences(lo, (hi & ~m) - 1, out);
+        AddUtf8Sequences(hi & ~m, hi, out);
+        return;
+      }
+    }
+  }
+
+  std::uint8_t lo_bytes[4];
+  std::uint8_t hi_bytes[4];
+  std::size_t const len = EncodeUtf8(lo, lo_bytes);
+  EncodeUtf8(hi, hi_bytes);
+  ByteRangeSequence seq;
+  for (std::size_t i = 0; i < len; ++i)
+  {
+    seq.emplace_back(lo_bytes[i], hi_bytes[i]);
+  }
+  out.push_back(std::move(seq));
+}
+
+// As above, for a range of UTF-16 code units (little endian).
+inline void AddUtf16UnitSequences(std::uint32_t lo,
+                                  std::uint32_t hi,
+                                  std::vector<ByteRangeSequence>& out)
+{
+  auto const add = [&](std::uint32_t l, std::uint32_t h) {
+    out.push_back(
+      ByteRangeSequence{{static_cast<std::uint8_t>(l & 0xFF),
+                         static_cast<std::uint8_t>(h & 0xFF)},
+                        {static_cast<std::uint8_t>(l >> 8),
+                         static_cast<std::uint8_t>(h >> 8)}});
+  };
+
+  if ((lo >> 8) == (hi >> 8))
+  {
+    add(lo, hi);
+    return;
+  }
+  if (lo & 0xFF)
+  {
+    add(lo, lo | 0xFF);
+    lo = (lo | 0xFF) + 1;
+  }
+  if ((hi & 0xFF) != 0xFF)
+  {
+    add(hi & ~0xFFU, hi);
+    hi = (hi & ~0xFFU) - 1;
+  }
+  if (lo < hi)
+  {
+    add(lo, hi);
+  }
+}
+
+inline void AddUtf16Sequences(std::uint32_t lo,
+                              std::uint32_t hi,
+                              std::vector<ByteRangeSequence>& out)
+{
+  // Surrogates can't be encoded (on their own).
+  if (lo <= 0xDFFF && hi >= 0xD800)
+  {
+    if (lo < 0xD800)
+    {
+      AddUtf16Sequences(lo, 0xD7FF, out);
+    }
+    if (hi > 0xDFFF)
+    {
+      AddUtf16Sequences(0xE000, hi, out);
+    }
+    return;
+  }
+
+  if (lo <= 0xFFFF)
+  {
+    AddUtf16UnitSequences(lo, (std::min)(hi, 0xFFFFU), out);
+    if (hi <= 0xFFFF)
+    {
+      return;
+    }
+    lo = 0x10000;
+  }
+
+  // Surrogate pairs. Split the range so that every piece either has a single
+  // high surrogate, or covers every low surrogate.
+  std::uint32_t const lo_high = (lo - 0x10000) >> 10;
+  std::uint32_t const hi_high = (hi - 0x10000) >> 10;
+  std::uint32_t const lo_low = (lo - 0x10000) & 0x3FF;
+  std::uint32_t const hi_low = (hi - 0x10000) & 0x3FF;
+  auto const add = [&](std::uint32_t high_lo,
+                       std::uint32_t high_hi,
+                       std::uint32_t low_lo,
+                       std::uint32_t low_hi) {
+    std::vector<ByteRangeSequence> highs;
+    std::vector<ByteRangeSequence> lows;
+    AddUtf16UnitSequences(0xD800 + high_lo, 0xD800 + high_hi, highs);
+    AddUtf16UnitSequences(0xDC00 + low_lo, 0xDC00 + low_hi, lows);
+    for (auto const& high : highs)
+    {
+      for (auto const& low : lows)
+      {
+        ByteRangeSequence seq{high};
+        seq.insert(std::end(seq), std::begin(low), std::end(low));
+        out.push_back(std::move(seq));
+      }
+    }
+  };
+
+  if (lo_high == hi_high)
+  {
+    add(lo_high, lo_high, lo_low, hi_low);
+    return;
+  }
+  std::uint32_t first = lo_high;
+  std::uint32_t last = hi_high;
+  if (lo_low != 0)
+  {
+    add(lo_high, lo_high, lo_low, 0x3FF);
+    ++first;
+  }
+  if (hi_low != 0x3FF)
+  {
+    add(hi_high, hi_high, 0, hi_low);
+    --last;
+  }
+  if (first <= last)
+  {
+    add(first, last, 0, 0x3FF);
+  }
+}
+
+// Length in bytes of the longest encoding of any code point in the set.
+inline std::size_t GetMaxEncodedLength(CodePointRanges const& set, bool wide)
+{
+  if (set.empty())
+  {
+    return 0;
+  }
+  std::uint32_t const max = set.back().second;
+  if (wide)
+  {
+    return max > 0xFFFF ? 4 : 2;
+  }
+  return max < 0x80 ? 1 : max < 0x800 ? 2 : max < 0x10000 ? 3 : 4;
+}
+
+struct NfaEdge
+{
+  std::uint8_t lo;
+  std::uint8_t hi;
+  std::size_t target;
+};
+
+struct NfaState
+{
+  std::vector<NfaEdge> edges;
+  std::vector<std::size_t> epsilons;
+};
+
+std::size_t const kRegexMaxNfaStates = 0x40000;
+
+// Builds a Thompson NFA over bytes. The reverse NFA matches the byte
+// reversal of every string the forward one matches, which is used to find
+// where a match starts once its end has been found.
+class NfaBuilder
+{
+public:
+  NfaBuilder(bool wide, bool reverse) : wide_{wide}, reverse_{reverse}
+  {
+  }
+
+  std::size_t NewState()
+  {
+    if (states_.size() >= kRegexMaxNfaStates)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Regex is too large."});
+    }
+    states_.emplace_back();
+    return states_.size() - 1;
+  }
+
+  // Adds the node, starting from state 'from', and returns the state it
+  // ends in.
+  std::size_t Build(RegexNode const& node, std::size_t from)
+  {
+    switch (node.type)
+    {
+    case RegexNode::Type::kSet:
+      return BuildSet(node.set, from);
+
+    case RegexNode::Type::kConcat:
+    {
+      std::size_t cur = from;
+      if (reverse_)
+      {
+        for (auto iter = node.children.rbegin(); iter != node.children.rend();
+             ++iter)
+        {
+          cur = Build(*iter, cur);
+        }
+      }
+      else
+      {
+        for (auto const& child : node.children)
+        {
+          cur = Build(child, cur);
+        }
+      }
+      return cur;
+    }
+
+    case RegexNode::Type::kAlternate:
+    {
+      std::size_t const exit = NewState();
+      for (auto const& child : node.children)
+      {
+        states_[Build(child, Fork(from))].epsilons.push_back(exit);
+      }
+      return exit;
+    }
+
+    case RegexNode::Type::kRepeat:
+    {
+      auto const& child = node.children[0];
+      std::size_t cur = from;
+      for (std::size_t i = 0; i < node.min; ++i)
+      {
+        cur = Build(child, Fork(cur));
+      }
+
+      if (node.max == kRegexUnbounded)
+      {
+        std::size_t const loop = Fork(cur);
+        states_[Build(child, Fork(loop))].epsilons.push_back(loop);
+        return loop;
+      }
+
+      // x{0,2} is (x(x)?)?.
+      std::size_t const exit = NewState();
+      for (std::size_t i = node.min; i < node.max; ++i)
+      {
+        states_[cur].epsilons.push_back(exit);
+        cur = Build(child, Fork(cur));
+      }
+      states_[cur].epsilons.push_back(exit);
+      return exit;
+    }
+
+    default:
+      HADESMEM_DETAIL_ASSERT(false);
+      return from;
+    }
+  }
+
+  std::vector<NfaState> const& GetStates() const noexcept
+  {
+    return states_;
+  }
+
+private:
+  // A fresh state reached from 'from' by an epsilon, so that loops added to
+  // it can't be entered from anywhere else.
+  std::size_t Fork(std::size_t from)
+  {
+    std::size_t const state = NewState();
+    states_[from].epsilons.push_back(state);
+    return state;
+  }
+
+  std::size_t BuildSet(CodePointRanges const& set, std::size_t from)
+  {
+    std::vector<ByteRangeSequence> seqs;
+    for (auto const& r : set)
+    {
+      if (wide_)
+      {
+        AddUtf16Sequences(r.first, r.second, seqs);
+      }
+      else
+      {
+        AddUtf8Sequences(r.first, r.second, seqs);
+      }
+    }
+
+    std::size_t const exit = NewState();
+    for (auto& seq : seqs)
+    {
+      if (reverse_)
+      {
+        std::reverse(std::begin(seq), std::end(seq));
+      }
+      std::size_t cur = from;
+      for (std::size_t i = 0; i < seq.size(); ++i)
+      {
+        std::size_t const next = i + 1 == seq.size() ? exit : NewState();
+        states_[cur].edges.push_back(
+          NfaEdge{seq[i].first, seq[i].second, next});
+        cur = next;
+      }
+    }
+    return exit;
+  }
+
+  bool wide_;
+  bool reverse_;
+  std::vector<NfaState> states_;
+};
+
+// A DFA over bytes. Bytes are mapped to equivalence classes (bytes which no
+// edge in the NFA tells apart), which keeps the table small.
+struct Dfa
+{
+  std::uint8_t classes[256];
+  std::size_t num_classes;
+  // num_classes entries per state. State 0 is the dead state, which only
+  // ever transitions to itself.
+  std::vector<std::uint32_t> next;
+  std::vector<std::uint8_t> accept;
+  std::uint32_t start;
+
+  std::uint32_t Next(std::uint32_t state, std::uint8_t b) const noexcept
+  {
+    return next[state * num_classes + classes[b]];
+  }
+
+  bool IsAccept(std::uint32_t state) const noexcept
+  {
+    return !!accept[state];
+  }
+};
+
+std::size_t const kRegexMaxDfaStates = 0x4000;
+
+inline void AddNfaClosure(std::vector<NfaState> const& nfa,
+                          std::vector<std::size_t>& set)
+{
+  std::vector<std::size_t> stack(set);
+  std::sort(std::begin(set), std::end(set));
+  while (!stack.empty())
+  {
+    std::size_t const state = stack.back();
+    stack.pop_back();
+    for (auto const next : nfa[state].epsilons)
+    {
+      auto const iter = std::lower_bound(std::begin(set), std::end(set), next);
+      if (iter == std::end(set) || *iter != next)
+      {
+        set.insert(iter, next);
+        stack.push_back(next);
+      }
+    }
+  }
+}
+
+// Subset construction. An unanchored DFA can start a match at any byte, so
+// it finds the end of every match in a single pass.
+inline Dfa BuildDfa(std::vector<NfaState> const& nfa,
+                    std::size_t start,
+                    std::size_t accept,
+                    bool unanchored)
+{
+  Dfa dfa;
+
+  bool boundaries[257] = {};
+  for (auto const& state : nfa)
+  {
+    for (auto const& edge : state.edges)
+    {
+      boundaries[edge.lo] = true;
+      boundaries[edge.hi + 1] = true;
+    }
+  }
+  std::uint8_t reps[256];
+  std::size_t num_classes = 0;
+  for (std::size_t b = 0; b < 256; ++b)
+  {
+    if (b == 0 || boundaries[b])
+    {
+      reps[num_classes++] = static_cast<std::uint8_t>(b);
+    }
+    dfa.classes[b] = static_cast<std::uint8_t>(num_classes - 1);
+  }
+  dfa.num_classes = num_classes;
+
+  std::vector<std::size_t> start_set{start};
+  AddNfaClosure(nfa, start_set);
+
+  std::vector<std::vector<std::size_t>> sets{{}, start_set};
+  std::map<std::vector<std::size_t>, std::uint32_t> ids{{{}, 0},
+                                                        {start_set, 1}};
+  dfa.start = 1;
+  for (std::size_t i = 0; i < sets.size(); ++i)
+  {
+    for (std::size_t c = 0; c < num_classes; ++c)
+    {
+      std::vector<std::size_t> next;
+      if (i != 0)
+      {
+        for (auto const state : sets[i])
+        {
+          for (auto const& edge : nfa[state].edges)
+          {
+            if (reps[c] >= edge.lo && reps[c] <= edge.hi)
+            {
+              next.push_back(edge.target);
+            }
+          }
+        }
+        if (unanchored)
+        {
+          next.insert(
+            std::end(next), std::begin(start_set), std::end(start_set));
+        }
+        AddNfaClosure(nfa, next);
+        next.erase(std::unique(std::begin(next), std::end(next)),
+                   std::end(next));
+      }
+
+      auto const iter = ids.find(next);
+      std::uint32_t id = 0;
+      if (iter == std::end(ids))
+      {
+        if (sets.size() >= kRegexMaxDfaStates)
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Regex is too complex."});
+        }
+        id = static_cast<std::uint32_t>(sets.size());
+        ids.emplace(next, id);
+        sets.push_back(std::move(next));
+      }
+      else
+      {
+        id = iter->second;
+      }
+      dfa.next.push_back(id);
+    }
+  }
+
+  for (auto const& set : sets)
+  {
+    dfa.accept.push_back(
+      std::binary_search(std::begin(set), std::end(set), accept) ? 1 : 0);
+  }
+  return dfa;
+}
+}
+}
@@ -0,0 +1,136 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstdint>
+
+#include <hadesmem/config.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+#include <cpuid.h>
+#endif // #if defined(_MSC_VER)
+
+// Functions between HADESMEM_DETAIL_AVX2_BEGIN and HADESMEM_DETAIL_AVX2_END
+// may use AVX2 intrinsics, and must only be called if GetSimdLevel returns
+// SimdLevel::kAvx2. MSVC lets any function use them.
+#if defined(__clang__)
+#define HADESMEM_DETAIL_AVX2_BEGIN                                             \
+  _Pragma("clang attribute push(__attribute__((target(\"avx2\"))), "           \
+          "apply_to = function)")
+#define HADESMEM_DETAIL_AVX2_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define HADESMEM_DETAIL_AVX2_BEGIN                                             \
+  _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#define HADESMEM_DETAIL_AVX2_END _Pragma("GCC pop_options")
+#else // #if defined(__clang__)
+#define HADESMEM_DETAIL_AVX2_BEGIN
+#define HADESMEM_DETAIL_AVX2_END
+#endif // #if defined(__clang__)
+
+namespace hadesmem
+{
+namespace detail
+{
+enum class SimdLevel
+{
+  kScalar,
+  kSse2,
+  kAvx2
+};
+
+// The mask must be non-zero.
+inline unsigned int CountTrailingZeros(std::uint32_t mask) noexcept
+{
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  ::_BitScanForward(&index, mask);
+  return static_cast<unsigned int>(index);
+#else  // #if defined(_MSC_VER)
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif // #if defined(_MSC_VER)
+}
+
+inline unsigned int CountTrailingZeros64(std::uint64_t mask) noexcept
+{
+  auto const low = static_cast<std::uint32_t>(mask);
+  return low ? CountTrailingZeros(low)
+             : 32 + CountTrailingZeros(static_cast<std::uint32_t>(mask >> 32));
+}
+
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+inline void
+  Cpuid(std::uint32_t leaf, std::uint32_t sub_leaf, std::uint32_t* regs)
+{
+#if defined(_MSC_VER)
+  int info[4] = {};
+  ::__cpuidex(info, static_cast<int>(leaf), static_cast<int>(sub_leaf));
+  for (int i = 0; i < 4; ++i)
+  {
+    regs[i] = static_cast<std::uint32_t>(info[i]);
+  }
+#else  // #if defined(_MSC_VER)
+  unsigned int a = 0, b = 0, c = 0, d = 0;
+  __cpuid_count(leaf, sub_leaf, a, b, c, d);
+  regs[0] = a;
+  regs[1] = b;
+  regs[2] = c;
+  regs[3] = d;
+#endif // #if defined(_MSC_VER)
+}
+
+inline std::uint64_t GetXcr0() noexcept
+{
+#if defined(_MSC_VER)
+  return ::_xgetbv(0);
+#else  // #if defined(_MSC_VER)
+  std::uint32_t eax = 0, edx = 0;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif // #if defined(_MSC_VER)
+}
+
+inline bool IsAvx2Supported()
+{
+  std::uint32_t regs[4] = {};
+  Cpuid(0, 0, regs);
+  if (regs[0] < 7)
+  {
+    return false;
+  }
+
+  // The OS must also save the YMM registers on a context switch.
+  Cpuid(1, 0, regs);
+  std::uint32_t const kOsxsave = 1U << 27;
+  std::uint32_t const kAvx = 1U << 28;
+  if ((regs[2] & (kOsxsave | kAvx)) != (kOsxsave | kAvx) ||
+      (GetXcr0() & 0x6) != 0x6)
+  {
+    return false;
+  }
+
+  Cpuid(7, 0, regs);
+  std::uint32_t const kAvx2 = 1U << 5;
+  return !!(regs[1] & kAvx2);
+}
+
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+
+// The best instruction set supported by both the build and the CPU.
+inline SimdLevel GetSimdLevel()
+{
+#if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+  static SimdLevel const level =
+    IsAvx2Supported() ? SimdLevel::kAvx2 : SimdLevel::kSse2;
+  return level;
+#elif defined(HADESMEM_DETAIL_SSE2)
+  return SimdLevel::kSse2;
+#else  // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+  return SimdLevel::kScalar;
+#endif // #if defined(HADESMEM_DETAIL_AVX2_DISPATCH)
+}
+}
+}
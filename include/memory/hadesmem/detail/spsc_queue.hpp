@@ -0,0 +1,85 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Neither side ever blocks: TryPush fails when the queue is full and
+// TryPop fails when it's empty. T should be cheap to copy, as every element
+// is copied in and out of a fixed ring buffer.
+template <typename T> class SpscQueue
+{
+public:
+  // The capacity is rounded up to a power of two.
+  explicit SpscQueue(std::size_t capacity)
+  {
+    std::size_t size = 2;
+    while (size < capacity)
+    {
+      size *= 2;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(SpscQueue const&) = delete;
+
+  SpscQueue& operator=(SpscQueue const&) = delete;
+
+  // Producer only.
+  bool TryPush(T const& value)
+  {
+    std::size_t const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+    {
+      return false;
+    }
+
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool TryPop(T& value)
+  {
+    std::size_t const head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+
+    value = buffer_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::size_t GetCapacity() const noexcept
+  {
+    return mask_ + 1;
+  }
+
+private:
+  std::vector<T> buffer_;
+  std::size_t mask_;
+  // The indices are only ever incremented (and wrap around with the mask), and
+  // are kept on separate cache lines so that the two threads don't contend.
+  char pad0_[64];
+  std::atomic<std::size_t> head_{0};
+  char pad1_[64];
+  std::atomic<std::size_t> tail_{0};
+  char pad2_[64];
+};
+}
+}
@@ -10,8 +10,7 @@
 #include <string>
 #include <vector>
 
-#include <windows.h>
-
+#include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/detail/assert.hpp>
 #include <hadesmem/detail/static_assert.hpp>
@@ -97,6 +96,8 @@ inline std::string WideCharToMultiByte(std::string const& in,
   return in;
 }
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 inline std::string WideCharToMultiByte(std::wstring const& in,
                                        bool* lossy = nullptr)
 {
@@ -142,11 +143,47 @@ inline std::string WideCharToMultiByte(std::wstring const& in,
   return buf.data();
 }
 
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+// Outside of Windows we only need conversions for diagnostics and for names
+// read out of PE files (which are ASCII in practice), so anything outside of
+// the ASCII range is simply replaced and reported as lossy.
+inline std::string WideCharToMultiByte(std::wstring const& in,
+                                       bool* lossy = nullptr)
+{
+  bool lossy_tmp = false;
+  std::string out;
+  out.reserve(in.size());
+  for (auto const c : in)
+  {
+    if (static_cast<std::uint32_t>(c) > 0x7F)
+    {
+      lossy_tmp = true;
+      out.push_back('?');
+    }
+    else
+    {
+      out.push_back(static_cast<char>(c));
+    }
+  }
+
+  if (lossy)
+  {
+    *lossy = lossy_tmp;
+  }
+
+  return out;
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 inline std::wstring MultiByteToWideChar(std::wstring const& in)
 {
   return in;
 }
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 inline std::wstring MultiByteToWideChar(std::string const& in)
 {
   std::int32_t const buf_len = ::MultiByteToWideChar(
@@ -172,5 +209,21 @@ inline std::wstring MultiByteToWideChar(std::string const& in)
 
   return buf.data();
 }
+
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+inline std::wstring MultiByteToWideChar(std::string const& in)
+{
+  std::wstring out;
+  out.reserve(in.size());
+  for (auto const c : in)
+  {
+    out.push_back(static_cast<wchar_t>(static_cast<unsigned char>(c)));
+  }
+
+  return out;
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 }
 }
@@ -3,11 +3,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <hadesmem/detail/assert.hpp>
 
@@ -80,6 +88,17 @@ public:
     }
   }
 
+  // Unlike WaitForEmpty, also waits for tasks which have already been
+  // dequeued to finish running.
+  void WaitForIdle()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while ((tasks_.size() || active_) && running_)
+    {
+      consumed_condition_.wait(lock);
+    }
+  }
+
   void Stop()
   {
     running_ = false;
@@ -104,7 +123,8 @@ private:
       {
         std::function<void()> task = tasks_.front();
         tasks_.pop();
-        consumed_condition_.notify_one();
+        ++active_;
+        consumed_condition_.notify_all();
 
         lock.unlock();
 
@@ -120,10 +140,14 @@ private:
       }
 
       lock.lock();
+      --active_;
+      consumed_condition_.notify_all();
     }
   }
 
-  bool running_;
+  // Read without the lock by Main and Stop.
+  std::atomic<bool> running_;
+  std::size_t active_{0};
   std::size_t queue_factor_;
   std::queue<std::function<void()>> tasks_;
   std::vector<std::thread> threads_;
@@ -131,5 +155,155 @@ private:
   std::condition_variable queued_condition_;
   std::condition_variable consumed_condition_;
 };
+
+// Resolves a requested thread count, where zero means one per hardware
+// thread.
+inline std::size_t GetParallelThreadCount(std::size_t num_threads) noexcept
+{
+  if (num_threads)
+  {
+    return num_threads;
+  }
+
+  auto const hw_threads = std::thread::hardware_concurrency();
+  return hw_threads ? hw_threads : 1;
+}
+
+// Calls work(i) for each i in [0, count) on up to num_threads threads (zero
+// means one per hardware thread). Work items are pulled from a shared index so
+// that the load is balanced even when they vary in cost, and with a single
+// thread they are done in order on the calling thread.
+//
+// If work throws, the remaining items are abandoned and the first exception
+// is rethrown.
+template <typename WorkFunc>
+void ParallelFor(std::size_t count, std::size_t num_threads, WorkFunc work)
+{
+  std::atomic<std::size_t> next_item{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex mutex;
+
+  auto const worker = [&]() {
+    try
+    {
+      for (;;)
+      {
+        std::size_t const i = next_item++;
+        if (i >= count || failed)
+        {
+          break;
+        }
+
+        work(i);
+      }
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  num_threads = (std::min)(GetParallelThreadCount(num_threads), count);
+  if (num_threads <= 1)
+  {
+    worker();
+  }
+  else
+  {
+    ThreadPool pool{num_threads, 1};
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+      pool.WaitForSlot();
+      pool.QueueTask(worker);
+    }
+    pool.WaitForIdle();
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+// As ParallelFor, but work is called as work(i, result) and each result is
+// then passed to sink(i, std::move(result)) in order of i. The sink is only
+// ever called by one thread at a time, and results are released as soon as
+// everything before them has been sunk. Results which finish out of order
+// have to be held until then, so a worker won't start an item more than a
+// few items per thread ahead of the next one to be sunk, otherwise a single
+// slow item could leave most of the results in memory. An exception thrown
+// by sink is handled the same way as one thrown by work.
+template <typename Result, typename WorkFunc, typename SinkFunc>
+void ParallelForOrdered(std::size_t count,
+                        std::size_t num_threads,
+                        WorkFunc work,
+                        SinkFunc sink)
+{
+  std::size_t const window = GetParallelThreadCount(num_threads) * 4;
+  std::mutex mutex;
+  std::condition_variable sunk_condition;
+  bool failed = false;
+  std::size_t next_sink = 0;
+  std::map<std::size_t, Result> pending;
+
+  auto const ordered_work = [&](std::size_t i) {
+    std::unique_lock<std::mutex> lock{mutex};
+    sunk_condition.wait(
+      lock, [&]() { return failed || i - next_sink < window; });
+    if (failed)
+    {
+      return;
+    }
+    lock.unlock();
+
+    Result result{};
+    work(i, result);
+
+    lock.lock();
+    if (i != next_sink)
+    {
+      pending.emplace(i, std::move(result));
+      return;
+    }
+
+    sink(i, std::move(result));
+    for (++next_sink;; ++next_sink)
+    {
+      auto const iter = pending.find(next_sink);
+      if (iter == std::end(pending))
+      {
+        break;
+      }
+      sink(next_sink, std::move(iter->second));
+      pending.erase(iter);
+    }
+    lock.unlock();
+    sunk_condition.notify_all();
+  };
+
+  // The item a waiting worker depends on may belong to a worker which has
+  // thrown, so wake everyone up to give up rather than wait forever.
+  ParallelFor(count, num_threads, [&](std::size_t i) {
+    try
+    {
+      ordered_work(i);
+    }
+    catch (...)
+    {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        failed = true;
+      }
+      sunk_condition.notify_all();
+      throw;
+    }
+  });
+}
 }
 }
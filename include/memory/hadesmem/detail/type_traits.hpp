@@ -6,7 +6,10 @@
 #include <type_traits>
 
 #include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/detail/winternl.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
 namespace hadesmem
 {
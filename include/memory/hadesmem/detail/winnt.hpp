@@ -0,0 +1,503 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+// On Windows this simply pulls in the SDK headers. Elsewhere it provides the
+// subset of the Win32 base types and PE structures required by the portable
+// components (PeLib in buffer mode, the scanning and pattern engines, etc.).
+// Layouts must match the SDK exactly, so sizes are checked below.
+
+#if defined(_WIN32)
+
+#include <windows.h>
+#include <winnt.h>
+
+#else // #if defined(_WIN32)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <unistd.h>
+
+using BYTE = std::uint8_t;
+using UCHAR = std::uint8_t;
+using CHAR = char;
+using WORD = std::uint16_t;
+using USHORT = std::uint16_t;
+using SHORT = std::int16_t;
+using DWORD = std::uint32_t;
+using ULONG = std::uint32_t;
+using LONG = std::int32_t;
+using BOOL = std::int32_t;
+using DWORD32 = std::uint32_t;
+using DWORD64 = std::uint64_t;
+using ULONGLONG = std::uint64_t;
+using LONGLONG = std::int64_t;
+using DWORD_PTR = std::uintptr_t;
+using ULONG_PTR = std::uintptr_t;
+using LONG_PTR = std::intptr_t;
+using SIZE_T = std::size_t;
+using HRESULT = std::int32_t;
+using NTSTATUS = std::int32_t;
+using PVOID = void*;
+using LPVOID = void*;
+using LPCVOID = void const*;
+using PBYTE = BYTE*;
+using PWORD = WORD*;
+using PDWORD = DWORD*;
+using HANDLE = void*;
+using HMODULE = struct HINSTANCE__*;
+using FARPROC = std::intptr_t (*)();
+
+#if !defined(FALSE)
+#define FALSE 0
+#endif
+
+#if !defined(TRUE)
+#define TRUE 1
+#endif
+
+#define ZeroMemory(destination, length) std::memset((destination), 0, (length))
+
+#define MEM_COMMIT 0x1000
+#define MEM_RESERVE 0x2000
+#define MEM_FREE 0x10000
+#define MEM_PRIVATE 0x20000
+#define MEM_MAPPED 0x40000
+#define MEM_IMAGE 0x1000000
+
+#define PAGE_NOACCESS 0x01
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define PAGE_WRITECOPY 0x08
+#define PAGE_EXECUTE 0x10
+#define PAGE_EXECUTE_READ 0x20
+#define PAGE_EXECUTE_READWRITE 0x40
+#define PAGE_EXECUTE_WRITECOPY 0x80
+#define PAGE_GUARD 0x100
+#define PAGE_NOCACHE 0x200
+#define PAGE_WRITECOMBINE 0x400
+
+struct MEMORY_BASIC_INFORMATION
+{
+  PVOID BaseAddress;
+  PVOID AllocationBase;
+  DWORD AllocationProtect;
+  SIZE_T RegionSize;
+  DWORD State;
+  DWORD Protect;
+  DWORD Type;
+};
+
+using PMEMORY_BASIC_INFORMATION = MEMORY_BASIC_INFORMATION*;
+
+#define IMAGE_DOS_SIGNATURE 0x5A4D
+#define IMAGE_NT_SIGNATURE 0x00004550
+
+#define IMAGE_NT_OPTIONAL_HDR32_MAGIC 0x10b
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC 0x20b
+
+#define IMAGE_FILE_MACHINE_I386 0x014c
+#define IMAGE_FILE_MACHINE_AMD64 0x8664
+
+#define IMAGE_FILE_RELOCS_STRIPPED 0x0001
+#define IMAGE_FILE_EXECUTABLE_IMAGE 0x0002
+#define IMAGE_FILE_DLL 0x2000
+
+#define IMAGE_NUMBEROF_DIRECTORY_ENTRIES 16
+#define IMAGE_SIZEOF_SHORT_NAME 8
+
+#define IMAGE_DIRECTORY_ENTRY_EXPORT 0
+#define IMAGE_DIRECTORY_ENTRY_IMPORT 1
+#define IMAGE_DIRECTORY_ENTRY_RESOURCE 2
+#define IMAGE_DIRECTORY_ENTRY_EXCEPTION 3
+#define IMAGE_DIRECTORY_ENTRY_SECURITY 4
+#define IMAGE_DIRECTORY_ENTRY_BASERELOC 5
+#define IMAGE_DIRECTORY_ENTRY_DEBUG 6
+#define IMAGE_DIRECTORY_ENTRY_ARCHITECTURE 7
+#define IMAGE_DIRECTORY_ENTRY_GLOBALPTR 8
+#define IMAGE_DIRECTORY_ENTRY_TLS 9
+#define IMAGE_DIRECTORY_ENTRY_LOAD_CONFIG 10
+#define IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT 11
+#define IMAGE_DIRECTORY_ENTRY_IAT 12
+#define IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT 13
+#define IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR 14
+
+#define IMAGE_SCN_CNT_CODE 0x00000020
+#define IMAGE_SCN_CNT_INITIALIZED_DATA 0x00000040
+#define IMAGE_SCN_CNT_UNINITIALIZED_DATA 0x00000080
+#define IMAGE_SCN_MEM_DISCARDABLE 0x02000000
+#define IMAGE_SCN_MEM_SHARED 0x10000000
+#define IMAGE_SCN_MEM_EXECUTE 0x20000000
+#define IMAGE_SCN_MEM_READ 0x40000000
+#define IMAGE_SCN_MEM_WRITE 0x80000000
+
+#define IMAGE_REL_BASED_ABSOLUTE 0
+#define IMAGE_REL_BASED_HIGH 1
+#define IMAGE_REL_BASED_LOW 2
+#define IMAGE_REL_BASED_HIGHLOW 3
+#define IMAGE_REL_BASED_HIGHADJ 4
+#define IMAGE_REL_BASED_DIR64 10
+
+#define IMAGE_ORDINAL_FLAG32 0x80000000U
+#define IMAGE_ORDINAL_FLAG64 0x8000000000000000ULL
+#define IMAGE_ORDINAL32(Ordinal) ((Ordinal)&0xffff)
+#define IMAGE_ORDINAL64(Ordinal) ((Ordinal)&0xffff)
+#define IMAGE_SNAP_BY_ORDINAL32(Ordinal) (((Ordinal)&IMAGE_ORDINAL_FLAG32) != 0)
+#define IMAGE_SNAP_BY_ORDINAL64(Ordinal) (((Ordinal)&IMAGE_ORDINAL_FLAG64) != 0)
+
+#pragma pack(push, 2)
+
+struct IMAGE_DOS_HEADER
+{
+  WORD e_magic;
+  WORD e_cblp;
+  WORD e_cp;
+  WORD e_crlc;
+  WORD e_cparhdr;
+  WORD e_minalloc;
+  WORD e_maxalloc;
+  WORD e_ss;
+  WORD e_sp;
+  WORD e_csum;
+  WORD e_ip;
+  WORD e_cs;
+  WORD e_lfarlc;
+  WORD e_ovno;
+  WORD e_res[4];
+  WORD e_oemid;
+  WORD e_oeminfo;
+  WORD e_res2[10];
+  LONG e_lfanew;
+};
+
+#pragma pack(pop)
+
+#pragma pack(push, 4)
+
+struct IMAGE_FILE_HEADER
+{
+  WORD Machine;
+  WORD NumberOfSections;
+  DWORD TimeDateStamp;
+  DWORD PointerToSymbolTable;
+  DWORD NumberOfSymbols;
+  WORD SizeOfOptionalHeader;
+  WORD Characteristics;
+};
+
+struct IMAGE_DATA_DIRECTORY
+{
+  DWORD VirtualAddress;
+  DWORD Size;
+};
+
+struct IMAGE_OPTIONAL_HEADER32
+{
+  WORD Magic;
+  BYTE MajorLinkerVersion;
+  BYTE MinorLinkerVersion;
+  DWORD SizeOfCode;
+  DWORD SizeOfInitializedData;
+  DWORD SizeOfUninitializedData;
+  DWORD AddressOfEntryPoint;
+  DWORD BaseOfCode;
+  DWORD BaseOfData;
+  DWORD ImageBase;
+  DWORD SectionAlignment;
+  DWORD FileAlignment;
+  WORD MajorOperatingSystemVersion;
+  WORD MinorOperatingSystemVersion;
+  WORD MajorImageVersion;
+  WORD MinorImageVersion;
+  WORD MajorSubsystemVersion;
+  WORD MinorSubsystemVersion;
+  DWORD Win32VersionValue;
+  DWORD SizeOfImage;
+  DWORD SizeOfHeaders;
+  DWORD CheckSum;
+  WORD Subsystem;
+  WORD DllCharacteristics;
+  DWORD SizeOfStackReserve;
+  DWORD SizeOfStackCommit;
+  DWORD SizeOfHeapReserve;
+  DWORD SizeOfHeapCommit;
+  DWORD LoaderFlags;
+  DWORD NumberOfRvaAndSizes;
+  IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+};
+
+struct IMAGE_OPTIONAL_HEADER64
+{
+  WORD Magic;
+  BYTE MajorLinkerVersion;
+  BYTE MinorLinkerVersion;
+  DWORD SizeOfCode;
+  DWORD SizeOfInitializedData;
+  DWORD SizeOfUninitializedData;
+  DWORD AddressOfEntryPoint;
+  DWORD BaseOfCode;
+  ULONGLONG ImageBase;
+  DWORD SectionAlignment;
+  DWORD FileAlignment;
+  WORD MajorOperatingSystemVersion;
+  WORD MinorOperatingSystemVersion;
+  WORD MajorImageVersion;
+  WORD MinorImageVersion;
+  WORD MajorSubsystemVersion;
+  WORD MinorSubsystemVersion;
+  DWORD Win32VersionValue;
+  DWORD SizeOfImage;
+  DWORD SizeOfHeaders;
+  DWORD CheckSum;
+  WORD Subsystem;
+  WORD DllCharacteristics;
+  ULONGLONG SizeOfStackReserve;
+  ULONGLONG SizeOfStackCommit;
+  ULONGLONG SizeOfHeapReserve;
+  ULONGLONG SizeOfHeapCommit;
+  DWORD LoaderFlags;
+  DWORD NumberOfRvaAndSizes;
+  IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+};
+
+struct IMAGE_NT_HEADERS32
+{
+  DWORD Signature;
+  IMAGE_FILE_HEADER FileHeader;
+  IMAGE_OPTIONAL_HEADER32 OptionalHeader;
+};
+
+struct IMAGE_NT_HEADERS64
+{
+  DWORD Signature;
+  IMAGE_FILE_HEADER FileHeader;
+  IMAGE_OPTIONAL_HEADER64 OptionalHeader;
+};
+
+struct IMAGE_SECTION_HEADER
+{
+  BYTE Name[IMAGE_SIZEOF_SHORT_NAME];
+  union
+  {
+    DWORD PhysicalAddress;
+    DWORD VirtualSize;
+  } Misc;
+  DWORD VirtualAddress;
+  DWORD SizeOfRawData;
+  DWORD PointerToRawData;
+  DWORD PointerToRelocations;
+  DWORD PointerToLinenumbers;
+  WORD NumberOfRelocations;
+  WORD NumberOfLinenumbers;
+  DWORD Characteristics;
+};
+
+struct IMAGE_EXPORT_DIRECTORY
+{
+  DWORD Characteristics;
+  DWORD TimeDateStamp;
+  WORD MajorVersion;
+  WORD MinorVersion;
+  DWORD Name;
+  DWORD Base;
+  DWORD NumberOfFunctions;
+  DWORD NumberOfNames;
+  DWORD AddressOfFunctions;
+  DWORD AddressOfNames;
+  DWORD AddressOfNameOrdinals;
+};
+
+struct IMAGE_IMPORT_DESCRIPTOR
+{
+  union
+  {
+    DWORD Characteristics;
+    DWORD OriginalFirstThunk;
+  };
+  DWORD TimeDateStamp;
+  DWORD ForwarderChain;
+  DWORD Name;
+  DWORD FirstThunk;
+};
+
+struct IMAGE_IMPORT_BY_NAME
+{
+  WORD Hint;
+  CHAR Name[1];
+};
+
+struct IMAGE_THUNK_DATA32
+{
+  union
+  {
+    DWORD ForwarderString;
+    DWORD Function;
+    DWORD Ordinal;
+    DWORD AddressOfData;
+  } u1;
+};
+
+struct IMAGE_BASE_RELOCATION
+{
+  DWORD VirtualAddress;
+  DWORD SizeOfBlock;
+};
+
+struct IMAGE_TLS_DIRECTORY32
+{
+  DWORD StartAddressOfRawData;
+  DWORD EndAddressOfRawData;
+  DWORD AddressOfIndex;
+  DWORD AddressOfCallBacks;
+  DWORD SizeOfZeroFill;
+  union
+  {
+    DWORD Characteristics;
+    struct
+    {
+      DWORD Reserved0 : 20;
+      DWORD Alignment : 4;
+      DWORD Reserved1 : 8;
+    };
+  };
+};
+
+struct IMAGE_BOUND_IMPORT_DESCRIPTOR
+{
+  DWORD TimeDateStamp;
+  WORD OffsetModuleName;
+  WORD NumberOfModuleForwarderRefs;
+};
+
+struct IMAGE_BOUND_FORWARDER_REF
+{
+  DWORD TimeDateStamp;
+  WORD OffsetModuleName;
+  WORD Reserved;
+};
+
+#pragma pack(pop)
+
+#pragma pack(push, 8)
+
+struct IMAGE_THUNK_DATA64
+{
+  union
+  {
+    ULONGLONG ForwarderString;
+    ULONGLONG Function;
+    ULONGLONG Ordinal;
+    ULONGLONG AddressOfData;
+  } u1;
+};
+
+struct IMAGE_TLS_DIRECTORY64
+{
+  ULONGLONG StartAddressOfRawData;
+  ULONGLONG EndAddressOfRawData;
+  ULONGLONG AddressOfIndex;
+  ULONGLONG AddressOfCallBacks;
+  DWORD SizeOfZeroFill;
+  union
+  {
+    DWORD Characteristics;
+    struct
+    {
+      DWORD Reserved0 : 20;
+      DWORD Alignment : 4;
+      DWORD Reserved1 : 8;
+    };
+  };
+};
+
+#pragma pack(pop)
+
+using PIMAGE_DOS_HEADER = IMAGE_DOS_HEADER*;
+using PIMAGE_FILE_HEADER = IMAGE_FILE_HEADER*;
+using PIMAGE_DATA_DIRECTORY = IMAGE_DATA_DIRECTORY*;
+using PIMAGE_OPTIONAL_HEADER32 = IMAGE_OPTIONAL_HEADER32*;
+using PIMAGE_OPTIONAL_HEADER64 = IMAGE_OPTIONAL_HEADER64*;
+using PIMAGE_NT_HEADERS32 = IMAGE_NT_HEADERS32*;
+using PIMAGE_NT_HEADERS64 = IMAGE_NT_HEADERS64*;
+using PIMAGE_SECTION_HEADER = IMAGE_SECTION_HEADER*;
+using PIMAGE_EXPORT_DIRECTORY = IMAGE_EXPORT_DIRECTORY*;
+using PIMAGE_IMPORT_DESCRIPTOR = IMAGE_IMPORT_DESCRIPTOR*;
+using PIMAGE_IMPORT_BY_NAME = IMAGE_IMPORT_BY_NAME*;
+using PIMAGE_THUNK_DATA32 = IMAGE_THUNK_DATA32*;
+using PIMAGE_THUNK_DATA64 = IMAGE_THUNK_DATA64*;
+using PIMAGE_BASE_RELOCATION = IMAGE_BASE_RELOCATION*;
+using PIMAGE_TLS_DIRECTORY32 = IMAGE_TLS_DIRECTORY32*;
+using PIMAGE_TLS_DIRECTORY64 = IMAGE_TLS_DIRECTORY64*;
+using PIMAGE_BOUND_IMPORT_DESCRIPTOR = IMAGE_BOUND_IMPORT_DESCRIPTOR*;
+using PIMAGE_BOUND_FORWARDER_REF = IMAGE_BOUND_FORWARDER_REF*;
+
+#if defined(__x86_64__)
+using IMAGE_NT_HEADERS = IMAGE_NT_HEADERS64;
+using IMAGE_OPTIONAL_HEADER = IMAGE_OPTIONAL_HEADER64;
+using IMAGE_THUNK_DATA = IMAGE_THUNK_DATA64;
+using IMAGE_TLS_DIRECTORY = IMAGE_TLS_DIRECTORY64;
+#define IMAGE_ORDINAL_FLAG IMAGE_ORDINAL_FLAG64
+#define IMAGE_NT_OPTIONAL_HDR_MAGIC IMAGE_NT_OPTIONAL_HDR64_MAGIC
+#else // #if defined(__x86_64__)
+using IMAGE_NT_HEADERS = IMAGE_NT_HEADERS32;
+using IMAGE_OPTIONAL_HEADER = IMAGE_OPTIONAL_HEADER32;
+using IMAGE_THUNK_DATA = IMAGE_THUNK_DATA32;
+using IMAGE_TLS_DIRECTORY = IMAGE_TLS_DIRECTORY32;
+#define IMAGE_ORDINAL_FLAG IMAGE_ORDINAL_FLAG32
+#define IMAGE_NT_OPTIONAL_HDR_MAGIC IMAGE_NT_OPTIONAL_HDR32_MAGIC
+#endif // #if defined(__x86_64__)
+
+using PIMAGE_NT_HEADERS = IMAGE_NT_HEADERS*;
+
+static_assert(sizeof(IMAGE_DOS_HEADER) == 64, "Invalid IMAGE_DOS_HEADER.");
+static_assert(sizeof(IMAGE_FILE_HEADER) == 20, "Invalid IMAGE_FILE_HEADER.");
+static_assert(sizeof(IMAGE_OPTIONAL_HEADER32) == 224,
+              "Invalid IMAGE_OPTIONAL_HEADER32.");
+static_assert(sizeof(IMAGE_OPTIONAL_HEADER64) == 240,
+              "Invalid IMAGE_OPTIONAL_HEADER64.");
+static_assert(sizeof(IMAGE_NT_HEADERS32) == 248, "Invalid IMAGE_NT_HEADERS32.");
+static_assert(sizeof(IMAGE_NT_HEADERS64) == 264, "Invalid IMAGE_NT_HEADERS64.");
+static_assert(sizeof(IMAGE_SECTION_HEADER) == 40,
+              "Invalid IMAGE_SECTION_HEADER.");
+static_assert(sizeof(IMAGE_EXPORT_DIRECTORY) == 40,
+              "Invalid IMAGE_EXPORT_DIRECTORY.");
+static_assert(sizeof(IMAGE_IMPORT_DESCRIPTOR) == 20,
+              "Invalid IMAGE_IMPORT_DESCRIPTOR.");
+static_assert(sizeof(IMAGE_THUNK_DATA32) == 4, "Invalid IMAGE_THUNK_DATA32.");
+static_assert(sizeof(IMAGE_THUNK_DATA64) == 8, "Invalid IMAGE_THUNK_DATA64.");
+static_assert(sizeof(IMAGE_BASE_RELOCATION) == 8,
+              "Invalid IMAGE_BASE_RELOCATION.");
+static_assert(sizeof(IMAGE_TLS_DIRECTORY32) == 24,
+              "Invalid IMAGE_TLS_DIRECTORY32.");
+static_assert(sizeof(IMAGE_TLS_DIRECTORY64) == 40,
+              "Invalid IMAGE_TLS_DIRECTORY64.");
+static_assert(sizeof(IMAGE_BOUND_IMPORT_DESCRIPTOR) == 8,
+              "Invalid IMAGE_BOUND_IMPORT_DESCRIPTOR.");
+static_assert(sizeof(IMAGE_BOUND_FORWARDER_REF) == 8,
+              "Invalid IMAGE_BOUND_FORWARDER_REF.");
+
+#endif // #if defined(_WIN32)
+
+namespace hadesmem
+{
+namespace detail
+{
+#if !defined(_WIN32)
+using WCHAR = wchar_t;
+#endif // #if !defined(_WIN32)
+
+// Lets the code which is shared between platforms (e.g. the PeLib tests) get
+// an id for a Process without depending on the rest of the Win32 API.
+inline DWORD GetCurrentProcessId() noexcept
+{
+#if defined(_WIN32)
+  return ::GetCurrentProcessId();
+#else  // #if defined(_WIN32)
+  return static_cast<DWORD>(::getpid());
+#endif // #if defined(_WIN32)
+}
+}
+}
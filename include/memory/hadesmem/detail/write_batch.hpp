@@ -0,0 +1,121 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+struct WriteBatchEntry
+{
+  std::uintptr_t address;
+  std::vector<std::uint8_t> data;
+};
+
+struct WriteBatchRun
+{
+  std::uintptr_t address;
+  std::vector<std::uint8_t> data;
+  std::vector<std::uint8_t> orig;
+};
+
+// Merges overlapping or touching writes into contiguous runs, sorted by
+// address. Where writes overlap, the one added last wins.
+inline std::vector<WriteBatchRun>
+  MakeWriteRuns(std::vector<WriteBatchEntry> const& entries)
+{
+  std::vector<std::size_t> sorted;
+  sorted.reserve(entries.size());
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    if (!entries[i].data.empty())
+    {
+      sorted.push_back(i);
+    }
+  }
+
+  std::stable_sort(std::begin(sorted),
+                   std::end(sorted),
+                   [&](std::size_t lhs, std::size_t rhs) {
+                     return entries[lhs].address < entries[rhs].address;
+                   });
+
+  std::vector<WriteBatchRun> runs;
+  std::vector<std::size_t> members;
+  for (std::size_t i = 0; i < sorted.size();)
+  {
+    std::uintptr_t const beg = entries[sorted[i]].address;
+    std::uintptr_t end = beg + entries[sorted[i]].data.size();
+
+    std::size_t j = i + 1;
+    for (; j < sorted.size() && entries[sorted[j]].address <= end; ++j)
+    {
+      end = (std::max)(
+        end, entries[sorted[j]].address + entries[sorted[j]].data.size());
+    }
+
+    // The union of the members is contiguous, so every byte of the run is
+    // covered by at least one of them. Copy them in the order they were added
+    // so that later writes win.
+    members.assign(std::begin(sorted) + i, std::begin(sorted) + j);
+    std::sort(std::begin(members), std::end(members));
+
+    WriteBatchRun run;
+    run.address = beg;
+    run.data.resize(static_cast<std::size_t>(end - beg));
+    for (auto const m : members)
+    {
+      std::memcpy(&run.data[entries[m].address - beg],
+                  entries[m].data.data(),
+                  entries[m].data.size());
+    }
+    runs.emplace_back(std::move(run));
+
+    i = j;
+  }
+
+  return runs;
+}
+
+// Returns the minimal set of [beg, end) ranges of whole pages covering the
+// runs, sorted by address. Runs must be sorted (see MakeWriteRuns).
+inline std::vector<std::pair<std::uintptr_t, std::uintptr_t>>
+  GetWriteRunPages(std::vector<WriteBatchRun> const& runs,
+                   std::size_t page_size)
+{
+  HADESMEM_DETAIL_ASSERT(page_size && !(page_size & (page_size - 1)));
+
+  std::vector<std::pair<std::uintptr_t, std::uintptr_t>> pages;
+  for (auto const& run : runs)
+  {
+    HADESMEM_DETAIL_ASSERT(!run.data.empty());
+
+    std::uintptr_t const beg = run.address & ~(page_size - 1);
+    std::uintptr_t const end =
+      (run.address + run.data.size() + page_size - 1) & ~(page_size - 1);
+    if (!pages.empty() && beg <= pages.back().second)
+    {
+      HADESMEM_DETAIL_ASSERT(beg >= pages.back().first);
+      pages.back().second = (std::max)(pages.back().second, end);
+    }
+    else
+    {
+      pages.emplace_back(beg, end);
+    }
+  }
+
+  return pages;
+}
+}
+}
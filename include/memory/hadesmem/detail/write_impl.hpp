@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 #include <windows.h>
 
@@ -17,6 +18,17 @@
 
 namespace hadesmem
 {
+struct WriteFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    // Skip querying the region and go straight to WriteProcessMemory, falling
+    // back to the normal path only if that fails.
+    kAssumeAccessible = 1 << 0
+  };
+};
+
 namespace detail
 {
 inline void WriteUnchecked(Process const& process,
@@ -34,52 +46,88 @@ inline void WriteUnchecked(Process const& process,
       bytes_written != len)
   {
     DWORD const last_error = ::GetLastError();
+    // The cached region info may be stale, so don't trust it next time.
+    InvalidateRegionCache(process, address, len);
     HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                     << ErrorString{"WriteProcessMemory failed."}
                                     << ErrorCodeWinLast{last_error});
   }
 }
 
+inline bool TryWriteUnchecked(Process const& process,
+                              PVOID address,
+                              LPCVOID data,
+                              std::size_t len) noexcept
+{
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+  HADESMEM_DETAIL_ASSERT(data != nullptr);
+  HADESMEM_DETAIL_ASSERT(len != 0);
+
+  SIZE_T bytes_written = 0;
+  return ::WriteProcessMemory(
+           process.GetHandle(), address, data, len, &bytes_written) &&
+         bytes_written == len;
+}
+
 inline void WriteImpl(Process const& process,
                       PVOID address,
                       LPCVOID data,
-                      std::size_t len)
+                      std::size_t len,
+                      std::uint32_t flags = WriteFlags::kNone)
 {
   HADESMEM_DETAIL_ASSERT(address != nullptr);
   HADESMEM_DETAIL_ASSERT(data != nullptr);
   HADESMEM_DETAIL_ASSERT(len != 0);
 
-  for (;;)
+  if (!!(flags & WriteFlags::kAssumeAccessible) &&
+      TryWriteUnchecked(process, address, data, len))
   {
-    ProtectGuard protect_guard{process, address, ProtectGuardType::kWrite};
+    return;
+  }
 
+  bool allow_fast_path = true;
+  for (;;)
+  {
     MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
-    void* const region_next =
-      static_cast<std::uint8_t*>(mbi.BaseAddress) + mbi.RegionSize;
 
     void* const address_end = static_cast<std::uint8_t*>(address) + len;
-    if (address_end <= region_next)
-    {
-      WriteUnchecked(process, address, data, len);
+    void* const region_next =
+      static_cast<std::uint8_t*>(mbi.BaseAddress) + mbi.RegionSize;
 
-      protect_guard.Restore();
+    std::size_t const len_cur =
+      (address_end <= region_next)
+        ? len
+        : reinterpret_cast<std::uintptr_t>(region_next) -
+            reinterpret_cast<std::uintptr_t>(address);
 
-      return;
+    if (allow_fast_path &&
+        CanAccessWithoutGuard(mbi, ProtectGuardType::kWrite))
+    {
+      if (!TryWriteUnchecked(process, address, data, len_cur))
+      {
+        // Our view of the region may be stale (e.g. it came from the region
+        // cache), so query it again and retry through ProtectGuard.
+        InvalidateRegionCache(process, address, len_cur);
+        allow_fast_path = false;
+        continue;
+      }
     }
     else
     {
-      std::size_t const len_new =
-        reinterpret_cast<std::uintptr_t>(region_next) -
-        reinterpret_cast<std::uintptr_t>(address);
-
-      WriteUnchecked(process, address, data, len_new);
-
+      ProtectGuard protect_guard{process, mbi, ProtectGuardType::kWrite};
+      WriteUnchecked(process, address, data, len_cur);
       protect_guard.Restore();
+    }
 
-      address = static_cast<std::uint8_t*>(address) + len_new;
-      data = static_cast<std::uint8_t const*>(data) + len_new;
-      len -= len_new;
+    if (len_cur == len)
+    {
+      return;
     }
+
+    address = static_cast<std::uint8_t*>(address) + len_cur;
+    data = static_cast<std::uint8_t const*>(data) + len_cur;
+    len -= len_cur;
+    allow_fast_path = true;
   }
 }
 
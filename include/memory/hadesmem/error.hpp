@@ -5,16 +5,18 @@
 
 #include <exception>
 
+#include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <windows.h>
 #include <winnt.h>
 #include <winternl.h>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/exception/all.hpp>
 #include <hadesmem/detail/warning_disable_suffix.hpp>
 
-#include <hadesmem/config.hpp>
-
 // TODO: Remove Boost.Exception dependency.
 
 // TODO: Add stack trace support (debug mode only?).
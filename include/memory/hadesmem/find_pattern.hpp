@@ -4,11 +4,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <limits>
 #include <locale>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -23,15 +27,21 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/detail/find_raw_multi.hpp>
+#include <hadesmem/detail/pattern_database.hpp>
 #include <hadesmem/detail/pugixml_helpers.hpp>
 #include <hadesmem/detail/smart_handle.hpp>
 #include <hadesmem/detail/static_assert.hpp>
 #include <hadesmem/detail/str_conv.hpp>
+#include <hadesmem/detail/thread_pool.hpp>
 #include <hadesmem/detail/to_upper_ordinal.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/find_procedure.hpp>
+#include <hadesmem/memory_source.hpp>
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/pelib/dos_header.hpp>
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
@@ -43,8 +53,6 @@
 // TODO: Standalone app/example for FindPattern. For dumping results,
 // experimenting with patterns, automatically generating new patterns, etc.
 
-// TODO: Support nibble wildcards. (e.g. FF D? EB)
-
 // TODO: Handle the case where after resolving a pattern, the result lives
 // outside the module (the heap, a different module, etc) and we want to use
 // that result as the starting address for a different pattern. Example: Using a
@@ -147,59 +155,6 @@ inline void* Rel(Process const& process,
   }
 }
 
-struct PatternDataByte
-{
-  std::uint8_t data;
-  bool wildcard;
-};
-
-inline std::vector<PatternDataByte> ConvertData(std::wstring const& data)
-{
-  HADESMEM_DETAIL_ASSERT(!data.empty());
-
-  std::wstring const data_trimmed{
-    data.substr(0, data.find_last_not_of(L" \n\r\t") + 1)};
-
-  HADESMEM_DETAIL_ASSERT(!data_trimmed.empty());
-
-  std::wistringstream data_str{data_trimmed};
-  data_str.imbue(std::locale::classic());
-  std::vector<PatternDataByte> data_real;
-  do
-  {
-    std::wstring data_cur_str;
-    if (!(data_str >> data_cur_str))
-    {
-      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                      << ErrorString{"Data parsing failed."});
-    }
-
-    bool const is_wildcard = (data_cur_str == L"??");
-    std::uint32_t current = 0U;
-    if (!is_wildcard)
-    {
-      std::wistringstream conv{data_cur_str};
-      conv.imbue(std::locale::classic());
-      if (!(conv >> std::hex >> current))
-      {
-        HADESMEM_DETAIL_THROW_EXCEPTION(
-          Error{} << ErrorString{"Data conversion failed."});
-      }
-
-      if (current > static_cast<std::uint8_t>(-1))
-      {
-        HADESMEM_DETAIL_THROW_EXCEPTION(Error()
-                                        << ErrorString("Invalid data."));
-      }
-    }
-
-    data_real.emplace_back(
-      PatternDataByte{static_cast<std::uint8_t>(current), is_wildcard});
-  } while (!data_str.eof());
-
-  return data_real;
-}
-
 template <typename NeedleIterator>
 void* FindRaw(Process const& process,
               std::uint8_t* s_beg,
@@ -207,29 +162,7 @@ void* FindRaw(Process const& process,
               NeedleIterator n_beg,
               NeedleIterator n_end)
 {
-  HADESMEM_DETAIL_ASSERT(s_beg < s_end);
-
-  std::ptrdiff_t const mem_size = s_end - s_beg;
-  std::vector<std::uint8_t> const haystack{ReadVector<std::uint8_t>(
-    process, s_beg, static_cast<std::size_t>(mem_size))};
-
-  auto const h_beg = std::begin(haystack);
-  auto const h_end = std::end(haystack);
-  auto const iter =
-    std::search(h_beg,
-                h_end,
-                n_beg,
-                n_end,
-                [](std::uint8_t h_cur, detail::PatternDataByte const& n_cur) {
-                  return n_cur.wildcard || h_cur == n_cur.data;
-                });
-
-  if (iter != h_end)
-  {
-    return s_beg + std::distance(h_beg, iter);
-  }
-
-  return nullptr;
+  return FindRaw(ProcessMemorySource{process}, s_beg, s_end, n_beg, n_end);
 }
 
 struct ModuleRegionInfo
@@ -338,7 +271,7 @@ void* Find(Process const& process,
 
 template <typename NeedleIterator>
 void* Find(Process const& process,
-           ModuleRegionInfo const& mod_info,
+           std::pair<std::uint8_t*, std::uint8_t*> const& region,
            NeedleIterator n_beg,
            NeedleIterator n_end,
            std::uint32_t flags,
@@ -347,19 +280,12 @@ void* Find(Process const& process,
 {
   HADESMEM_DETAIL_ASSERT(n_beg != n_end);
 
-  bool const scan_data_secs = !!(flags & PatternFlags::kScanData);
-  auto const& scan_regions =
-    scan_data_secs ? mod_info.data_regions : mod_info.code_regions;
-  for (auto const& region : scan_regions)
+  if (void* const address = Find(process, region, start, n_beg, n_end))
   {
-    if (void* const address = Find(process, region, start, n_beg, n_end))
-    {
-      return !!(flags & PatternFlags::kRelativeAddress)
-               ? static_cast<std::uint8_t*>(address) -
-                   reinterpret_cast<std::uintptr_t>(
-                     mod_info.module->GetHandle())
-               : address;
-    }
+    return !!(flags & PatternFlags::kRelativeAddress)
+             ? static_cast<std::uint8_t*>(address) -
+                 reinterpret_cast<std::uintptr_t>(region.first)
+             : address;
   }
 
   if (!!(flags & PatternFlags::kThrowOnUnmatch))
@@ -372,61 +298,394 @@ void* Find(Process const& process,
 
   return nullptr;
 }
+}
 
-template <typename NeedleIterator>
-void* Find(Process const& process,
-           std::pair<std::uint8_t*, std::uint8_t*> const& region,
-           NeedleIterator n_beg,
-           NeedleIterator n_end,
-           std::uint32_t flags,
-           void* start,
-           std::wstring const* name)
+// The code and data regions of a module, resolved once, along with a snapshot
+// of their contents. Any number of calls to Find (including ones which start
+// part way through the module) can be served by the same context, whereas each
+// call taking a module name has to look up the module, parse its headers and
+// read its sections again.
+//
+// Each region is read the first time it is searched, and is never read again,
+// so changes made to the module after that (e.g. by patching its code) are not
+// seen. Construct a new context to pick them up. Safe to share between threads.
+class PatternScanContext
 {
-  HADESMEM_DETAIL_ASSERT(n_beg != n_end);
+public:
+  explicit PatternScanContext(Process const& process,
+                              std::wstring const& module)
+    : process_{&process},
+      mod_info_{detail::GetModuleInfo(process, module)},
+      buffers_{std::make_unique<RegionBuffer[]>(
+        mod_info_.code_regions.size() + mod_info_.data_regions.size())}
+  {
+  }
 
-  if (void* const address = Find(process, region, start, n_beg, n_end))
+  explicit PatternScanContext(Process const&& process,
+                              std::wstring const& module) = delete;
+
+  Process const& GetProcess() const noexcept
   {
-    return !!(flags & PatternFlags::kRelativeAddress)
-             ? static_cast<std::uint8_t*>(address) -
-                 reinterpret_cast<std::uintptr_t>(region.first)
-             : address;
+    return *process_;
   }
 
-  if (!!(flags & PatternFlags::kThrowOnUnmatch))
+  Module const& GetModule() const noexcept
   {
-    auto const name_narrow = name ? WideCharToMultiByte(*name) : std::string();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"Could not match pattern."}
-                                    << ErrorStringOther{name_narrow});
+    return *mod_info_.module;
   }
 
-  return nullptr;
+  std::vector<detail::ModuleRegionInfo::ScanRegion> const&
+    GetRegions(bool data_regions) const noexcept
+  {
+    return data_regions ? mod_info_.data_regions : mod_info_.code_regions;
+  }
+
+  // Returns the contents of GetRegions(data_regions)[index], reading them on
+  // first use.
+  std::vector<std::uint8_t> const& GetRegionData(bool data_regions,
+                                                 std::size_t index) const
+  {
+    auto const& region = GetRegions(data_regions)[index];
+    auto& buffer =
+      buffers_[data_regions ? mod_info_.code_regions.size() + index : index];
+    std::call_once(buffer.once, [&]() {
+      buffer.data = ReadVector<std::uint8_t>(
+        *process_,
+        region.first,
+        static_cast<std::size_t>(region.second - region.first));
+    });
+    return buffer.data;
+  }
+
+private:
+  struct RegionBuffer
+  {
+    std::once_flag once;
+    std::vector<std::uint8_t> data;
+  };
+
+  Process const* process_;
+  detail::ModuleRegionInfo mod_info_;
+  std::unique_ptr<RegionBuffer[]> buffers_;
+};
+
+namespace detail
+{
+struct PatternRequest
+{
+  CompiledPattern pattern;
+  std::uint32_t flags;
+  void* start;
+  std::wstring const* name;
+};
+
+// Sections are split into chunks of this size when they're searched on more
+// than one thread.
+std::size_t const kPatternSearchChunkSize = 0x40000;
+
+// Bumped whenever the format of the pattern cache (see FindPattern) changes,
+// so that caches saved by older versions are ignored.
+std::uint32_t const kPatternCacheVersion = 2;
+
+// Searches a module for many patterns at once. Each section is split into
+// chunks which can be searched in any order (or concurrently), where each
+// chunk overlaps the next by the length of the longest pattern minus one, so
+// that matches which straddle them are found, but only reports the matches
+// which start within it. The result for a pattern is its match in the first
+// chunk to have one, which is the same match as searching the whole sections
+// in order would find.
+class PatternSearch
+{
+public:
+  explicit PatternSearch(PatternScanContext const& context,
+                         std::vector<PatternRequest> requests,
+                         std::size_t chunk_size)
+    : context_{&context}, requests_(std::move(requests))
+  {
+    HADESMEM_DETAIL_ASSERT(chunk_size);
+
+    std::size_t max_len = 0;
+    for (auto const& request : requests_)
+    {
+      finder_.Add(request.pattern);
+      max_len = (std::max)(max_len, request.pattern.value.size());
+    }
+    overlap_ = max_len ? max_len - 1 : 0;
+
+    AddRegions(false, chunk_size);
+    AddRegions(true, chunk_size);
+
+    first_chunk_ =
+      std::make_unique<std::atomic<std::size_t>[]>(requests_.size());
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      first_chunk_[i] = kNoPatternMatch;
+    }
+    chunk_results_.resize(chunks_.size());
+  }
+
+  std::size_t GetNumChunks() const noexcept
+  {
+    return chunks_.size();
+  }
+
+  // Safe to call concurrently for different chunks. A pattern which has
+  // already matched in an earlier chunk is skipped, as is the whole chunk
+  // (without reading it) if that leaves nothing to search for.
+  void SearchChunk(std::size_t index)
+  {
+    auto const& chunk = chunks_[index];
+    auto const& region_begins = begins_[chunk.begins];
+    std::vector<std::size_t> begins(requests_.size(), kNoPatternMatch);
+    bool any = false;
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      std::size_t const beg = region_begins[i];
+      if (beg == kNoPatternMatch || beg >= chunk.end ||
+          first_chunk_[i] < index)
+      {
+        continue;
+      }
+
+      begins[i] = beg > chunk.beg ? beg - chunk.beg : 0;
+      any = true;
+    }
+
+    if (!any)
+    {
+      return;
+    }
+
+    auto const& haystack =
+      context_->GetRegionData(chunk.data_region, chunk.region);
+    std::size_t const end = (std::min)(chunk.end + overlap_, haystack.size());
+    auto& offsets = chunk_results_[index];
+    finder_.FindFirst(
+      haystack.data() + chunk.beg, end - chunk.beg, begins, offsets);
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      if (offsets[i] == kNoPatternMatch ||
+          offsets[i] >= chunk.end - chunk.beg)
+      {
+        offsets[i] = kNoPatternMatch;
+        continue;
+      }
+
+      offsets[i] += chunk.beg;
+      std::size_t first = first_chunk_[i];
+      while (index < first &&
+             !first_chunk_[i].compare_exchange_weak(first, index))
+      {
+      }
+    }
+  }
+
+  // Applies the flags to the matches, once every chunk has been searched.
+  std::vector<void*> GetResults() const
+  {
+    auto const base =
+      reinterpret_cast<std::uintptr_t>(context_->GetModule().GetHandle());
+    std::vector<void*> results(requests_.size());
+    for (std::size_t i = 0; i < requests_.size(); ++i)
+    {
+      auto const& request = requests_[i];
+      std::size_t const first = first_chunk_[i];
+      if (first != kNoPatternMatch)
+      {
+        auto const& chunk = chunks_[first];
+        std::uint8_t* const address =
+          context_->GetRegions(chunk.data_region)[chunk.region].first +
+          chunk_results_[first][i];
+        results[i] = !!(request.flags & PatternFlags::kRelativeAddress)
+                       ? address - base
+                       : address;
+      }
+      else if (!!(request.flags & PatternFlags::kThrowOnUnmatch))
+      {
+        auto const name_narrow =
+          request.name ? WideCharToMultiByte(*request.name) : std::string();
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Could not match pattern."}
+                  << ErrorStringOther{name_narrow});
+      }
+    }
+
+    return results;
+  }
+
+private:
+  struct Chunk
+  {
+    bool data_region;
+    std::size_t region;
+    // Index into begins_.
+    std::size_t begins;
+    std::size_t beg;
+    std::size_t end;
+  };
+
+  void AddRegions(bool data_regions, std::size_t chunk_size)
+  {
+    auto const& regions = context_->GetRegions(data_regions);
+    for (std::size_t i = 0; i < regions.size(); ++i)
+    {
+      std::uint8_t* const s_beg = regions[i].first;
+      std::uint8_t* const s_end = regions[i].second;
+      std::vector<std::size_t> begins(requests_.size(), kNoPatternMatch);
+      for (std::size_t j = 0; j < requests_.size(); ++j)
+      {
+        auto const& request = requests_[j];
+        if (!!(request.flags & PatternFlags::kScanData) != data_regions)
+        {
+          continue;
+        }
+
+        // Same rules for the start address as Find.
+        if (request.start)
+        {
+          if (request.start < s_beg || request.start >= s_end)
+          {
+            continue;
+          }
+
+          if (static_cast<std::uint8_t*>(request.start) + 1 == s_end)
+          {
+            HADESMEM_DETAIL_THROW_EXCEPTION(
+              Error() << ErrorString("Invalid start address."));
+          }
+
+          begins[j] = static_cast<std::size_t>(
+            static_cast<std::uint8_t*>(request.start) + 1 - s_beg);
+        }
+        else
+        {
+          begins[j] = 0;
+        }
+      }
+
+      std::size_t const size = static_cast<std::size_t>(s_end - s_beg);
+      for (std::size_t beg = 0; beg < size; beg += chunk_size)
+      {
+        std::size_t const end =
+          chunk_size < size - beg ? beg + chunk_size : size;
+        chunks_.emplace_back(Chunk{data_regions, i, begins_.size(), beg, end});
+      }
+      begins_.emplace_back(std::move(begins));
+    }
+  }
+
+  PatternScanContext const* context_;
+  std::vector<PatternRequest> requests_;
+  MultiPatternFinder finder_;
+  std::size_t overlap_{0};
+  std::vector<Chunk> chunks_;
+  // The offset to search each region from for each pattern, or
+  // kNoPatternMatch if the pattern isn't searched for in that region.
+  std::vector<std::vector<std::size_t>> begins_;
+  // The earliest chunk each pattern has matched in.
+  std::unique_ptr<std::atomic<std::size_t>[]> first_chunk_;
+  // The matches found by each chunk, as offsets into the region. Each chunk
+  // only writes to its own, so no locking is needed.
+  std::vector<std::vector<std::size_t>> chunk_results_;
+};
+
+// Searches every chunk of every search on up to num_threads threads (see
+// ParallelFor).
+inline void SearchAll(std::vector<PatternSearch>& searches,
+                      std::size_t num_threads)
+{
+  std::vector<std::pair<std::size_t, std::size_t>> tasks;
+  for (std::size_t i = 0; i < searches.size(); ++i)
+  {
+    for (std::size_t j = 0; j < searches[i].GetNumChunks(); ++j)
+    {
+      tasks.emplace_back(i, j);
+    }
+  }
+
+  ParallelFor(tasks.size(), num_threads, [&](std::size_t i) {
+    searches[tasks[i].first].SearchChunk(tasks[i].second);
+  });
+}
+
+// Equivalent to calling Find for each request in turn, but each section is
+// scanned once for all of them.
+inline std::vector<void*> FindMany(PatternScanContext const& context,
+                                   std::vector<PatternRequest> requests)
+{
+  PatternSearch search{
+    context, std::move(requests), (std::numeric_limits<std::size_t>::max)()};
+  for (std::size_t i = 0; i < search.GetNumChunks(); ++i)
+  {
+    search.SearchChunk(i);
+  }
+  return search.GetResults();
 }
 }
 
-inline void* Find(Process const& process,
-                  std::wstring const& module,
-                  std::wstring const& data,
+namespace detail
+{
+inline void* Find(PatternScanContext const& context,
+                  CompiledPattern pattern,
                   std::uint32_t flags,
                   std::uintptr_t start,
-                  std::wstring const* name = nullptr)
+                  std::wstring const* name)
 {
   HADESMEM_DETAIL_ASSERT(
     !(flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL)));
 
-  auto const mod_info = detail::GetModuleInfo(process, module);
-  auto const needle = detail::ConvertData(data);
   void* const start_abs =
     start
-      ? reinterpret_cast<std::uint8_t*>(mod_info.module->GetHandle()) + start
+      ? reinterpret_cast<std::uint8_t*>(context.GetModule().GetHandle()) + start
       : nullptr;
-  return detail::Find(process,
-                      mod_info,
-                      std::begin(needle),
-                      std::end(needle),
-                      flags,
-                      start_abs,
-                      name);
+  std::vector<PatternRequest> requests;
+  requests.emplace_back(
+    PatternRequest{std::move(pattern), flags, start_abs, name});
+  return FindMany(context, std::move(requests)).front();
+}
+}
+
+inline void* Find(PatternScanContext const& context,
+                  std::wstring const& data,
+                  std::uint32_t flags,
+                  std::uintptr_t start,
+                  std::wstring const* name = nullptr)
+{
+  auto const needle = detail::ConvertData(data);
+  auto pattern = detail::CompilePattern(std::begin(needle), std::end(needle));
+  return detail::Find(context, std::move(pattern), flags, start, name);
+}
+
+template <std::size_t N>
+void* Find(PatternScanContext const& context,
+           PatternLiteral<N> const& pattern,
+           std::uint32_t flags,
+           std::uintptr_t start,
+           std::wstring const* name = nullptr)
+{
+  return detail::Find(
+    context, detail::CompilePattern(pattern), flags, start, name);
+}
+
+inline void* Find(Process const& process,
+                  std::wstring const& module,
+                  std::wstring const& data,
+                  std::uint32_t flags,
+                  std::uintptr_t start,
+                  std::wstring const* name = nullptr)
+{
+  return Find(PatternScanContext{process, module}, data, flags, start, name);
+}
+
+template <std::size_t N>
+void* Find(Process const& process,
+           std::wstring const& module,
+           PatternLiteral<N> const& pattern,
+           std::uint32_t flags,
+           std::uintptr_t start,
+           std::wstring const* name = nullptr)
+{
+  return Find(PatternScanContext{process, module}, pattern, flags, start, name);
 }
 
 inline void* Find(Process const& process,
@@ -478,30 +737,383 @@ inline void* FindInFile(Process const& process,
                                     << ErrorCodeWinLast{last_error});
   }
 
-  detail::SmartHandle const file_mapping{::CreateFileMappingW(
-    file.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr)};
-  if (!file_mapping.IsValid())
-  {
-    DWORD const last_error = ::GetLastError();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"CreateFileMappingW failed."}
-                                    << ErrorCodeWinLast{last_error});
+  detail::SmartHandle const file_mapping{::CreateFileMappingW(
+    file.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr)};
+  if (!file_mapping.IsValid())
+  {
+    DWORD const last_error = ::GetLastError();
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                    << ErrorString{"CreateFileMappingW failed."}
+                                    << ErrorCodeWinLast{last_error});
+  }
+
+  detail::SmartMappedFileHandle const file_view{
+    ::MapViewOfFile(file_mapping.GetHandle(), FILE_MAP_READ, 0, 0, 0)};
+  if (!file_view.IsValid())
+  {
+    DWORD const last_error = ::GetLastError();
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                    << ErrorString{"MapViewOfFile failed."}
+                                    << ErrorCodeWinLast{last_error});
+  }
+
+  auto const base = file_view.GetHandle();
+  auto const size = detail::GetModuleRegionSize(process, base);
+  return Find(process, base, size, data, flags, start, name);
+}
+
+namespace detail
+{
+struct PatternInfo
+{
+  std::wstring name;
+  std::wstring data;
+  std::wstring start;
+  std::wstring start_rva;
+  std::wstring start_export;
+  std::uint32_t flags;
+};
+
+struct PatternInfoFull
+{
+  PatternInfo pattern;
+  std::vector<PatternDatabaseManipulator> manipulators;
+};
+
+struct FindPatternInfo
+{
+  std::uint32_t flags;
+  std::vector<PatternInfoFull> patterns;
+};
+
+inline std::uint32_t ReadPatternFlags(pugi::xml_node const& node)
+{
+  std::uint32_t flags = PatternFlags::kNone;
+  for (auto const& flag : node.children(L"Flag"))
+  {
+    auto const flag_name = pugixml::GetAttributeValue(flag, L"Name");
+
+    if (flag_name == L"None")
+    {
+      flags |= PatternFlags::kNone;
+    }
+    else if (flag_name == L"ThrowOnUnmatch")
+    {
+      flags |= PatternFlags::kThrowOnUnmatch;
+    }
+    else if (flag_name == L"RelativeAddress")
+    {
+      flags |= PatternFlags::kRelativeAddress;
+    }
+    else if (flag_name == L"ScanData")
+    {
+      flags |= PatternFlags::kScanData;
+    }
+    else
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Unknown 'Flag' value."});
+    }
+  }
+
+  return flags;
+}
+
+inline std::map<std::wstring, FindPatternInfo>
+  ReadPatternsFromXml(pugi::xml_document const& doc)
+{
+  auto const hadesmem_root = doc.child(L"HadesMem");
+  if (!hadesmem_root)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Failed to find 'HadesMem' root node."});
+  }
+
+  std::map<std::wstring, FindPatternInfo> pattern_infos_full;
+  for (auto const& find_pattern_node : hadesmem_root.children(L"FindPattern"))
+  {
+    auto const module_name =
+      ToUpperOrdinal(pugixml::GetOptionalAttributeValue(
+        find_pattern_node, L"Module"));
+
+    std::uint32_t const flags = ReadPatternFlags(find_pattern_node);
+
+    std::vector<PatternInfoFull> pattern_infos;
+
+    for (auto const& pattern : find_pattern_node.children(L"Pattern"))
+    {
+      auto const pattern_name =
+        pugixml::GetAttributeValue(pattern, L"Name");
+
+      auto const pattern_data =
+        pugixml::GetAttributeValue(pattern, L"Data");
+
+      auto const pattern_start =
+        pugixml::GetOptionalAttributeValue(pattern, L"Start");
+
+      auto const pattern_start_rva =
+        pugixml::GetOptionalAttributeValue(pattern, L"StartRVA");
+
+      auto const pattern_start_export =
+        pugixml::GetOptionalAttributeValue(pattern, L"StartExport");
+
+      std::uint32_t const pattern_flags = ReadPatternFlags(pattern);
+
+      PatternInfo pattern_info{pattern_name,
+                               pattern_data,
+                               pattern_start,
+                               pattern_start_rva,
+                               pattern_start_export,
+                               pattern_flags};
+
+      std::vector<PatternDatabaseManipulator> pattern_manips;
+
+      for (auto const& manipulator : pattern.children(L"Manipulator"))
+      {
+        auto const manipulator_name =
+          pugixml::GetAttributeValue(manipulator, L"Name");
+
+        PatternDatabaseOp op = PatternDatabaseOp::kAdd;
+        if (manipulator_name == L"Add")
+        {
+          op = PatternDatabaseOp::kAdd;
+        }
+        else if (manipulator_name == L"Sub")
+        {
+          op = PatternDatabaseOp::kSub;
+        }
+        else if (manipulator_name == L"Rel")
+        {
+          op = PatternDatabaseOp::kRel;
+        }
+        else if (manipulator_name == L"Lea")
+        {
+          op = PatternDatabaseOp::kLea;
+        }
+        else if (manipulator_name == L"And")
+        {
+          op = PatternDatabaseOp::kAnd;
+        }
+        else
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Unknown value for 'Name' attribute for "
+                                   "'Manipulator' node."});
+        }
+
+        auto const manipulator_operand1 = manipulator.attribute(L"Operand1");
+        bool const has_operand1 = !!manipulator_operand1;
+        std::uintptr_t const operand1 =
+          has_operand1 ? HexStrToPtr(manipulator_operand1.value()) : 0U;
+
+        auto const manipulator_operand2 = manipulator.attribute(L"Operand2");
+        bool const has_operand2 = !!manipulator_operand2;
+        std::uintptr_t const operand2 =
+          has_operand2 ? HexStrToPtr(manipulator_operand2.value()) : 0U;
+
+        std::uint32_t const num_operands = GetPatternDatabaseNumOperands(op);
+        if (has_operand1 != (num_operands > 0) ||
+            has_operand2 != (num_operands > 1))
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Invalid manipulator operands."}
+                    << ErrorStringOther{WideCharToMultiByte(manipulator_name)});
+        }
+
+        pattern_manips.emplace_back(
+          PatternDatabaseManipulator{static_cast<std::uint32_t>(op),
+                                     num_operands,
+                                     operand1,
+                                     operand2});
+      }
+
+      pattern_infos.emplace_back(
+        PatternInfoFull{pattern_info, pattern_manips});
+    }
+
+    HADESMEM_DETAIL_ASSERT(pattern_infos_full.find(module_name) ==
+                           std::end(pattern_infos_full));
+    pattern_infos_full[module_name] = {flags, pattern_infos};
+  }
+
+  return pattern_infos_full;
+}
+
+inline void LoadPatternXml(pugi::xml_document& doc,
+                           std::wstring const& pattern_file,
+                           bool in_memory_file)
+{
+  auto const load_result = in_memory_file
+                             ? doc.load(pattern_file.c_str())
+                             : doc.load_file(pattern_file.c_str());
+  if (!load_result)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Loading XML file failed."}
+              << ErrorCodeOther{static_cast<DWORD_PTR>(load_result.status)}
+              << ErrorStringOther{load_result.description()});
+  }
+}
+
+// A pattern which starts at another pattern has to wait until that one is
+// resolved, so the patterns are resolved in waves, where each wave only
+// depends on earlier ones and is found in a single pass over each section.
+// The pattern a start refers to is the last one with that name before it in
+// the file.
+inline std::vector<std::uint8_t> CompilePatternDatabase(
+  std::map<std::wstring, FindPatternInfo> const& pattern_infos_full)
+{
+  PatternDatabaseWriter writer;
+  for (auto const& patterns_info_full_pair : pattern_infos_full)
+  {
+    auto const& info = patterns_info_full_pair.second;
+    std::vector<PatternDatabasePattern> records(info.patterns.size());
+    std::uint32_t num_waves = 0;
+    std::map<std::wstring, std::size_t> names;
+    for (std::size_t i = 0; i < info.patterns.size(); ++i)
+    {
+      auto const& pattern = info.patterns[i].pattern;
+      auto& record = records[i];
+      record.flags = info.flags | pattern.flags;
+      if (!pattern.start_rva.empty())
+      {
+        record.start_type =
+          static_cast<std::uint32_t>(PatternDatabaseStart::kRva);
+        record.start = HexStrToPtr(pattern.start_rva);
+      }
+      else if (!pattern.start_export.empty())
+      {
+        if (pattern.start_export[0] == '#' && pattern.start_export.size() > 1U)
+        {
+          record.start_type =
+            static_cast<std::uint32_t>(PatternDatabaseStart::kExportOrdinal);
+          record.start = StrToNum<WORD>(pattern.start_export.substr(1));
+        }
+        else
+        {
+          record.start_type =
+            static_cast<std::uint32_t>(PatternDatabaseStart::kExportName);
+        }
+      }
+      else if (!pattern.start.empty())
+      {
+        auto const iter = names.find(pattern.start);
+        if (iter == std::end(names))
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Invalid pattern name."});
+        }
+
+        record.start_type =
+          static_cast<std::uint32_t>(PatternDatabaseStart::kPattern);
+        record.start = iter->second;
+        record.wave = records[iter->second].wave + 1;
+      }
+
+      num_waves = (std::max)(num_waves, record.wave + 1);
+      names[pattern.name] = i;
+    }
+
+    writer.AddModule(patterns_info_full_pair.first, num_waves);
+    for (std::size_t i = 0; i < info.patterns.size(); ++i)
+    {
+      auto const& p = info.patterns[i];
+      auto const needle = ConvertData(p.pattern.data);
+      writer.AddPattern(p.pattern.name,
+                        CompilePattern(std::begin(needle), std::end(needle)),
+                        records[i],
+                        p.pattern.start_export,
+                        p.manipulators);
+    }
+  }
+
+  return writer.GetData();
+}
+}
+
+// Compiles a pattern file (the same as FindPattern takes) to a pattern
+// database, which FindPattern can then use without any parsing. See
+// hadesmem/detail/pattern_database.hpp for the format.
+inline std::vector<std::uint8_t>
+  CompilePatternFile(std::wstring const& pattern_file, bool in_memory_file)
+{
+  pugi::xml_document doc;
+  detail::LoadPatternXml(doc, pattern_file, in_memory_file);
+  return detail::CompilePatternDatabase(detail::ReadPatternsFromXml(doc));
+}
+
+// A pattern database (see CompilePatternFile), either mapped from a file or
+// in memory. It's checked when it's opened, but never copied or parsed.
+class PatternDatabase
+{
+public:
+  // The data must be 8 byte aligned, and outlive the object.
+  explicit PatternDatabase(void const* data, std::size_t size)
+    : view_{data, size}
+  {
+  }
+
+  explicit PatternDatabase(std::wstring const& path)
+  {
+    file_ = ::CreateFileW(path.c_str(),
+                          GENERIC_READ,
+                          FILE_SHARE_READ,
+                          nullptr,
+                          OPEN_EXISTING,
+                          0,
+                          nullptr);
+    if (!file_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"CreateFileW failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!::GetFileSizeEx(file_.GetHandle(), &file_size))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"GetFileSizeEx failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    file_mapping_ = ::CreateFileMappingW(
+      file_.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file_mapping_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"CreateFileMappingW failed."}
+                << ErrorCodeWinLast{last_error});
+    }
+
+    file_view_ =
+      ::MapViewOfFile(file_mapping_.GetHandle(), FILE_MAP_READ, 0, 0, 0);
+    if (!file_view_.IsValid())
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"MapViewOfFile failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    view_ = detail::PatternDatabaseView{
+      file_view_.GetHandle(), static_cast<std::size_t>(file_size.QuadPart)};
   }
 
-  detail::SmartMappedFileHandle const file_view{
-    ::MapViewOfFile(file_mapping.GetHandle(), FILE_MAP_READ, 0, 0, 0)};
-  if (!file_view.IsValid())
+  detail::PatternDatabaseView const& GetView() const noexcept
   {
-    DWORD const last_error = ::GetLastError();
-    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                    << ErrorString{"MapViewOfFile failed."}
-                                    << ErrorCodeWinLast{last_error});
+    return view_;
   }
 
-  auto const base = file_view.GetHandle();
-  auto const size = detail::GetModuleRegionSize(process, base);
-  return Find(process, base, size, data, flags, start, name);
-}
+private:
+  detail::SmartFileHandle file_;
+  detail::SmartHandle file_mapping_;
+  detail::SmartMappedFileHandle file_view_;
+  detail::PatternDatabaseView view_;
+};
 
 class Pattern
 {
@@ -708,27 +1320,64 @@ private:
   std::map<std::wstring, PatternMap> map_;
 };
 
+// Patterns are resolved on up to num_threads threads, where zero means one
+// per hardware thread. The results are the same no matter how many threads
+// are used.
+//
+// If cache_path is given, the matches for each module are saved to that file
+// (replacing anything else in it), and are loaded from it instead of scanning
+// when the module's headers and its patterns are the same as when they were
+// saved. Each cached match is checked against the pattern before it's used,
+// and if any of them don't match the module is scanned again. Manipulators
+// are always applied afresh, as their results can depend on the state of the
+// process.
+//
+// A pattern file is compiled to a pattern database before the patterns are
+// resolved, so where the same patterns are used many times (or the cost of
+// parsing matters) they can be compiled ahead of time with
+// CompilePatternFile and loaded from a PatternDatabase instead.
 class FindPattern
 {
 public:
   explicit FindPattern(Process const& process,
                        std::wstring const& pattern_file,
-                       bool in_memory_file)
-    : process_{&process}, find_pattern_datas_{}
-  {
-    if (in_memory_file)
-    {
-      LoadPatternFileMemory(pattern_file);
-    }
-    else
-    {
-      LoadPatternFile(pattern_file);
-    }
+                       bool in_memory_file,
+                       std::size_t num_threads = 1,
+                       std::wstring const& cache_path = std::wstring{})
+    : process_{&process},
+      num_threads_{num_threads},
+      cache_path_{cache_path},
+      find_pattern_datas_{}
+  {
+    auto const database = CompilePatternFile(pattern_file, in_memory_file);
+    LoadPatternDatabase(
+      detail::PatternDatabaseView{database.data(), database.size()});
+  }
+
+  explicit FindPattern(
+    Process const&& process,
+    std::wstring const& pattern,
+    bool in_memory_file,
+    std::size_t num_threads = 1,
+    std::wstring const& cache_path = std::wstring{}) = delete;
+
+  explicit FindPattern(Process const& process,
+                       PatternDatabase const& database,
+                       std::size_t num_threads = 1,
+                       std::wstring const& cache_path = std::wstring{})
+    : process_{&process},
+      num_threads_{num_threads},
+      cache_path_{cache_path},
+      find_pattern_datas_{}
+  {
+    LoadPatternDatabase(database.GetView());
   }
 
-  explicit FindPattern(Process const&& process,
-                       std::wstring const& pattern,
-                       bool in_memory_file) = delete;
+  explicit FindPattern(
+    Process const&& process,
+    PatternDatabase const& database,
+    std::size_t num_threads = 1,
+    std::wstring const& cache_path = std::wstring{}) = delete;
 
   ModuleMap const& GetModuleMap() const noexcept
   {
@@ -765,402 +1414,557 @@ public:
   }
 
 private:
-  void LoadPatternFile(std::wstring const& path)
+  Pattern LookupEx(std::wstring const& module, std::wstring const& name) const
   {
-    pugi::xml_document doc;
-    auto const load_result = doc.load_file(path.c_str());
-    if (!load_result)
+    auto const& pattern_map = GetPatternMap(module);
+    try
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(
-        Error{} << ErrorString{"Loading XML file failed."}
-                << ErrorCodeOther{static_cast<DWORD_PTR>(load_result.status)}
-                << ErrorStringOther{load_result.description()});
+      return pattern_map.at(name);
+    }
+    catch (std::out_of_range const&)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid pattern name."});
+    }
+  }
+
+
+  void* ApplyManipulators(void* address,
+                          std::uintptr_t base,
+                          detail::PatternDatabaseView const& database,
+                          detail::PatternDatabasePattern const& pattern) const
+  {
+    std::uint32_t const flags = pattern.flags;
+    for (std::size_t i = 0; i < pattern.num_manipulators; ++i)
+    {
+      auto const& m = database.GetManipulator(pattern, i);
+      auto const operand1 = static_cast<std::uintptr_t>(m.operand1);
+      auto const operand2 = static_cast<std::uintptr_t>(m.operand2);
+      switch (static_cast<detail::PatternDatabaseOp>(m.op))
+      {
+      case detail::PatternDatabaseOp::kAdd:
+        address = detail::Add(*process_, base, address, flags, operand1);
+
+        break;
+
+      case detail::PatternDatabaseOp::kSub:
+        address = detail::Sub(*process_, base, address, flags, operand1);
+
+        break;
+
+      case detail::PatternDatabaseOp::kRel:
+        address =
+          detail::Rel(*process_, base, address, flags, operand1, operand2);
+
+        break;
+
+      case detail::PatternDatabaseOp::kLea:
+        address = detail::Lea(*process_, base, address, flags);
+
+        break;
+
+      case detail::PatternDatabaseOp::kAnd:
+        address = detail::And(*process_, base, address, flags, operand1);
+
+        break;
+
+      default:
+        HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                        << ErrorString{"Unknown manipulator."});
+
+        break;
+      }
     }
 
-    LoadPatternFileImpl(doc);
+    return address;
   }
 
-  void LoadPatternFileMemory(std::wstring const& data)
+  std::uintptr_t GetStartRvaFromPattern(std::uintptr_t base,
+                                        Pattern const& start_pattern) const
   {
-    pugi::xml_document doc;
-    auto const load_result = doc.load(data.c_str());
-    if (!load_result)
+    auto start_rva =
+      reinterpret_cast<std::uintptr_t>(start_pattern.GetAddress());
+    if (!(start_pattern.GetFlags() & PatternFlags::kRelativeAddress))
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(
-        Error{} << ErrorString{"Loading XML file failed."}
-                << ErrorCodeOther{static_cast<DWORD_PTR>(load_result.status)}
-                << ErrorStringOther{load_result.description()});
+      start_rva -= base;
     }
 
-    LoadPatternFileImpl(doc);
+    return start_rva;
   }
 
-  Pattern LookupEx(std::wstring const& module, std::wstring const& name) const
+  std::uintptr_t
+    GetStartRvaFromExport(Module const& module,
+                          detail::PatternDatabaseView const& database,
+                          detail::PatternDatabasePattern const& pattern) const
   {
-    auto const& pattern_map = GetPatternMap(module);
-    try
+    std::uintptr_t start_rva = 0U;
+    auto const ordinal = static_cast<std::uint32_t>(
+      detail::PatternDatabaseStart::kExportOrdinal);
+    if (pattern.start_type == ordinal)
     {
-      return pattern_map.at(name);
+      start_rva = reinterpret_cast<std::uintptr_t>(
+        FindProcedure(*process_, module, static_cast<WORD>(pattern.start)));
     }
-    catch (std::out_of_range const&)
+    else
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                      << ErrorString{"Invalid pattern name."});
+      auto const name = database.GetString(
+        static_cast<std::uint32_t>(pattern.start), pattern.start_length);
+      start_rva = reinterpret_cast<std::uintptr_t>(
+        FindProcedure(*process_, module, detail::WideCharToMultiByte(name)));
     }
+
+    return start_rva - reinterpret_cast<std::uintptr_t>(module.GetHandle());
   }
 
-  struct PatternInfo
+  // Identifies a build of a module and the patterns for it, as far as the
+  // pattern cache is concerned.
+  struct ModuleIdentity
   {
+    DWORD time_date_stamp;
+    DWORD size_of_image;
+    DWORD check_sum;
+    std::uint64_t patterns_hash;
+  };
+
+  struct ModulePatterns
+  {
+    detail::PatternDatabaseModule const* info;
     std::wstring name;
-    std::wstring data;
-    std::wstring start;
-    std::wstring start_rva;
-    std::wstring start_export;
-    std::uint32_t flags;
+    std::vector<std::wstring> names;
+    // The patterns in the wave being resolved.
+    std::vector<std::size_t> indices;
+    // The matches before the manipulators are applied, and the patterns after.
+    std::vector<void*> matches;
+    std::vector<Pattern> patterns;
+    ModuleIdentity identity;
+    // Whether the matches were loaded from the cache.
+    bool cached;
   };
 
-  struct ManipInfo
+  ModulePatterns
+    GetModulePatterns(detail::PatternDatabaseView const& database,
+                      detail::PatternDatabaseModule const& info) const
+  {
+    ModulePatterns module{&info,
+                          detail::ToUpperOrdinal(database.GetName(info)),
+                          {},
+                          {},
+                          std::vector<void*>(info.num_patterns),
+                          std::vector<Pattern>(info.num_patterns),
+                          ModuleIdentity{},
+                          false};
+    for (std::size_t i = 0; i < info.num_patterns; ++i)
+    {
+      auto const& p = database.GetPattern(info, i);
+      if (p.flags & ~(PatternFlags::kInvalidFlagMaxValue - 1UL))
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Invalid pattern database."});
+      }
+
+      module.names.emplace_back(database.GetName(p));
+    }
+
+    return module;
+  }
+
+  std::vector<detail::PatternRequest>
+    GetWaveRequests(PatternScanContext const& context,
+                    detail::PatternDatabaseView const& database,
+                    ModulePatterns& module,
+                    std::size_t wave) const
+  {
+    auto const base =
+      reinterpret_cast<std::uintptr_t>(context.GetModule().GetHandle());
+    module.indices.clear();
+    std::vector<detail::PatternRequest> requests;
+    for (std::size_t i = 0; i < module.info->num_patterns; ++i)
+    {
+      auto const& p = database.GetPattern(*module.info, i);
+      if (p.wave != wave)
+      {
+        continue;
+      }
+
+      std::uintptr_t const start_rva = [&]() -> std::uintptr_t {
+        switch (static_cast<detail::PatternDatabaseStart>(p.start_type))
+        {
+        case detail::PatternDatabaseStart::kRva:
+          return static_cast<std::uintptr_t>(p.start);
+        case detail::PatternDatabaseStart::kExportName:
+        case detail::PatternDatabaseStart::kExportOrdinal:
+          return GetStartRvaFromExport(context.GetModule(), database, p);
+        case detail::PatternDatabaseStart::kPattern:
+          return GetStartRvaFromPattern(
+            base, module.patterns[static_cast<std::size_t>(p.start)]);
+        default:
+          return 0U;
+        }
+      }();
+
+      void* const start_abs =
+        start_rva ? reinterpret_cast<std::uint8_t*>(base) + start_rva
+                  : nullptr;
+      module.indices.push_back(i);
+      requests.emplace_back(detail::PatternRequest{
+        database.GetCompiledPattern(p), p.flags, start_abs, &module.names[i]});
+    }
+
+    return requests;
+  }
+
+  static void HashBytes(std::uint64_t& hash, void const* data, std::size_t size)
   {
-    enum class Manipulator
+    auto const bytes = static_cast<std::uint8_t const*>(data);
+    for (std::size_t i = 0; i < size; ++i)
     {
-      kAdd,
-      kSub,
-      kRel,
-      kLea,
-      kAnd
-    };
-
-    Manipulator type;
-    bool has_operand1;
-    std::uintptr_t operand1;
-    bool has_operand2;
-    std::uintptr_t operand2;
-  };
+      hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+  }
 
-  struct PatternInfoFull
+  template <typename T> static void HashValue(std::uint64_t& hash, T value)
   {
-    PatternInfo pattern;
-    std::vector<ManipInfo> manipulators;
-  };
+    HashBytes(hash, &value, sizeof(value));
+  }
 
-  struct FindPatternInfo
+  static void HashString(std::uint64_t& hash, std::wstring const& str)
   {
-    std::uint32_t flags;
-    std::vector<PatternInfoFull> patterns;
-  };
+    HashValue(hash, str.size());
+    HashBytes(hash, str.data(), str.size() * sizeof(wchar_t));
+  }
 
-  std::uint32_t ReadFlags(pugi::xml_node const& node) const
+  // FNV-1a over everything in the pattern database which affects where the
+  // patterns match. The manipulators are left out, as they're applied to the
+  // cached matches anyway.
+  std::uint64_t GetPatternsHash(detail::PatternDatabaseView const& database,
+                                ModulePatterns const& module) const
   {
-    std::uint32_t flags = PatternFlags::kNone;
-    for (auto const& flag : node.children(L"Flag"))
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    HashValue(hash, module.info->num_patterns);
+    for (std::size_t i = 0; i < module.info->num_patterns; ++i)
     {
-      auto const flag_name = detail::pugixml::GetAttributeValue(flag, L"Name");
-
-      if (flag_name == L"None")
-      {
-        flags |= PatternFlags::kNone;
-      }
-      else if (flag_name == L"ThrowOnUnmatch")
+      auto const& p = database.GetPattern(*module.info, i);
+      HashString(hash, module.names[i]);
+      HashValue(hash, p.flags);
+      HashValue(hash, p.length);
+      HashBytes(hash, database.GetValue(p), p.length);
+      HashBytes(hash, database.GetMask(p), p.length);
+      HashValue(hash, p.start_type);
+      if (p.start_type ==
+          static_cast<std::uint32_t>(detail::PatternDatabaseStart::kExportName))
       {
-        flags |= PatternFlags::kThrowOnUnmatch;
-      }
-      else if (flag_name == L"RelativeAddress")
-      {
-        flags |= PatternFlags::kRelativeAddress;
-      }
-      else if (flag_name == L"ScanData")
-      {
-        flags |= PatternFlags::kScanData;
+        HashString(hash,
+                   database.GetString(static_cast<std::uint32_t>(p.start),
+                                      p.start_length));
       }
       else
       {
-        HADESMEM_DETAIL_THROW_EXCEPTION(
-          Error{} << ErrorString{"Unknown 'Flag' value."});
+        HashValue(hash, p.start);
       }
     }
+    return hash;
+  }
 
-    return flags;
+  ModuleIdentity GetModuleIdentity(PatternScanContext const& context,
+                                   detail::PatternDatabaseView const& database,
+                                   ModulePatterns const& module) const
+  {
+    PeFile const pe_file{*process_,
+                         context.GetModule().GetHandle(),
+                         hadesmem::PeFileType::kImage,
+                         0};
+    NtHeaders const nt_headers{*process_, pe_file};
+    return ModuleIdentity{nt_headers.GetTimeDateStamp(),
+                          nt_headers.GetSizeOfImage(),
+                          nt_headers.GetCheckSum(),
+                          GetPatternsHash(database, module)};
   }
 
-  std::map<std::wstring, FindPatternInfo>
-    ReadPatternsFromXml(pugi::xml_document const& doc) const
+  // Checks that a cached match (as an RVA) is still a match for the pattern.
+  bool IsCachedMatchValid(std::uintptr_t base,
+                          ModuleIdentity const& identity,
+                          detail::PatternDatabaseView const& database,
+                          detail::PatternDatabasePattern const& pattern,
+                          std::uintptr_t rva) const
   {
-    auto const hadesmem_root = doc.child(L"HadesMem");
-    if (!hadesmem_root)
+    if (rva > identity.size_of_image ||
+        pattern.length > identity.size_of_image - rva)
     {
-      HADESMEM_DETAIL_THROW_EXCEPTION(
-        Error{} << ErrorString{"Failed to find 'HadesMem' root node."});
+      return false;
     }
 
-    std::map<std::wstring, FindPatternInfo> pattern_infos_full;
-    for (auto const& find_pattern_node : hadesmem_root.children(L"FindPattern"))
+    auto const data = ReadVector<std::uint8_t>(
+      *process_, reinterpret_cast<std::uint8_t*>(base) + rva, pattern.length);
+    auto const value = database.GetValue(pattern);
+    auto const mask = database.GetMask(pattern);
+    for (std::size_t i = 0; i < data.size(); ++i)
     {
-      auto const module_name =
-        detail::ToUpperOrdinal(detail::pugixml::GetOptionalAttributeValue(
-          find_pattern_node, L"Module"));
-
-      std::uint32_t const flags = ReadFlags(find_pattern_node);
-
-      std::vector<PatternInfoFull> pattern_infos;
-
-      for (auto const& pattern : find_pattern_node.children(L"Pattern"))
+      if ((data[i] & mask[i]) != value[i])
       {
-        auto const pattern_name =
-          detail::pugixml::GetAttributeValue(pattern, L"Name");
-
-        auto const pattern_data =
-          detail::pugixml::GetAttributeValue(pattern, L"Data");
-
-        auto const pattern_start =
-          detail::pugixml::GetOptionalAttributeValue(pattern, L"Start");
-
-        auto const pattern_start_rva =
-          detail::pugixml::GetOptionalAttributeValue(pattern, L"StartRVA");
-
-        auto const pattern_start_export =
-          detail::pugixml::GetOptionalAttributeValue(pattern, L"StartExport");
+        return false;
+      }
+    }
 
-        std::uint32_t const pattern_flags = ReadFlags(pattern);
+    return true;
+  }
 
-        PatternInfo pattern_info{pattern_name,
-                                 pattern_data,
-                                 pattern_start,
-                                 pattern_start_rva,
-                                 pattern_start_export,
-                                 pattern_flags};
+  // Loads the matches for a module from the cache, if it has an entry for the
+  // same identity, and every match in it is still valid.
+  bool LoadCachedMatches(pugi::xml_node const& cache,
+                         PatternScanContext const& context,
+                         detail::PatternDatabaseView const& database,
+                         ModulePatterns& module) const
+  {
+    auto const module_node = cache.find_child_by_attribute(
+      L"Module", L"Name", module.name.c_str());
+    auto const& identity = module.identity;
+    if (!module_node ||
+        module_node.attribute(L"TimeDateStamp").value() !=
+          detail::NumToStr<wchar_t>(identity.time_date_stamp, true) ||
+        module_node.attribute(L"SizeOfImage").value() !=
+          detail::NumToStr<wchar_t>(identity.size_of_image, true) ||
+        module_node.attribute(L"CheckSum").value() !=
+          detail::NumToStr<wchar_t>(identity.check_sum, true) ||
+        module_node.attribute(L"PatternsHash").value() !=
+          detail::NumToStr<wchar_t>(identity.patterns_hash, true))
+    {
+      return false;
+    }
 
-        std::vector<ManipInfo> pattern_manips;
+    auto const base =
+      reinterpret_cast<std::uintptr_t>(context.GetModule().GetHandle());
+    std::size_t i = 0;
+    for (auto const& pattern_node : module_node.children(L"Pattern"))
+    {
+      if (i == module.names.size() ||
+          module.names[i] != pattern_node.attribute(L"Name").value())
+      {
+        return false;
+      }
 
-        for (auto const& manipulator : pattern.children(L"Manipulator"))
+      auto const rva_attr = pattern_node.attribute(L"Rva");
+      if (rva_attr)
+      {
+        auto const& p = database.GetPattern(*module.info, i);
+        auto const rva = detail::HexStrToPtr(rva_attr.value());
+        if (!IsCachedMatchValid(base, identity, database, p, rva))
         {
-          auto const manipulator_name =
-            detail::pugixml::GetAttributeValue(manipulator, L"Name");
-
-          ManipInfo::Manipulator type = ManipInfo::Manipulator::kAdd;
-          if (manipulator_name == L"Add")
-          {
-            type = ManipInfo::Manipulator::kAdd;
-          }
-          else if (manipulator_name == L"Sub")
-          {
-            type = ManipInfo::Manipulator::kSub;
-          }
-          else if (manipulator_name == L"Rel")
-          {
-            type = ManipInfo::Manipulator::kRel;
-          }
-          else if (manipulator_name == L"Lea")
-          {
-            type = ManipInfo::Manipulator::kLea;
-          }
-          else if (manipulator_name == L"And")
-          {
-            type = ManipInfo::Manipulator::kAnd;
-          }
-          else
-          {
-            HADESMEM_DETAIL_THROW_EXCEPTION(
-              Error{} << ErrorString{"Unknown value for 'Name' attribute for "
-                                     "'Manipulator' node."});
-          }
-
-          auto const manipulator_operand1 = manipulator.attribute(L"Operand1");
-          bool const has_operand1 = !!manipulator_operand1;
-          std::uintptr_t const operand1 =
-            has_operand1 ? detail::HexStrToPtr(manipulator_operand1.value())
-                         : 0U;
-
-          auto const manipulator_operand2 = manipulator.attribute(L"Operand2");
-          bool const has_operand2 = !!manipulator_operand2;
-          std::uintptr_t const operand2 =
-            has_operand2 ? detail::HexStrToPtr(manipulator_operand2.value())
-                         : 0U;
-
-          pattern_manips.emplace_back(
-            ManipInfo{type, has_operand1, operand1, has_operand2, operand2});
+          return false;
         }
 
-        pattern_infos.emplace_back(
-          PatternInfoFull{pattern_info, pattern_manips});
+        module.matches[i] = reinterpret_cast<void*>(
+          !!(p.flags & PatternFlags::kRelativeAddress) ? rva : base + rva);
+      }
+      else
+      {
+        module.matches[i] = nullptr;
       }
 
-      HADESMEM_DETAIL_ASSERT(pattern_infos_full.find(module_name) ==
-                             std::end(pattern_infos_full));
-      pattern_infos_full[module_name] = {flags, pattern_infos};
+      ++i;
     }
 
-    return pattern_infos_full;
+    return i == module.names.size();
   }
 
-  void* ApplyManipulators(void* address,
-                          std::uint32_t flags,
-                          std::uintptr_t base,
-                          std::vector<ManipInfo> const& manip_list) const
-  {
-    for (auto const& m : manip_list)
+  void SavePatternCache(std::vector<PatternScanContext> const& contexts,
+                        detail::PatternDatabaseView const& database,
+                        std::vector<ModulePatterns> const& modules) const
+  {
+    pugi::xml_document cache;
+    auto cache_node =
+      cache.append_child(L"HadesMem").append_child(L"PatternCache");
+    cache_node.append_attribute(L"Version")
+      .set_value(
+        detail::NumToStr<wchar_t>(detail::kPatternCacheVersion).c_str());
+    for (std::size_t i = 0; i < modules.size(); ++i)
     {
-      switch (m.type)
+      auto const& module = modules[i];
+      auto const& identity = module.identity;
+      auto module_node = cache_node.append_child(L"Module");
+      module_node.append_attribute(L"Name").set_value(module.name.c_str());
+      module_node.append_attribute(L"TimeDateStamp")
+        .set_value(
+          detail::NumToStr<wchar_t>(identity.time_date_stamp, true).c_str());
+      module_node.append_attribute(L"SizeOfImage")
+        .set_value(
+          detail::NumToStr<wchar_t>(identity.size_of_image, true).c_str());
+      module_node.append_attribute(L"CheckSum")
+        .set_value(
+          detail::NumToStr<wchar_t>(identity.check_sum, true).c_str());
+      module_node.append_attribute(L"PatternsHash")
+        .set_value(
+          detail::NumToStr<wchar_t>(identity.patterns_hash, true).c_str());
+
+      auto const base = reinterpret_cast<std::uintptr_t>(
+        contexts[i].GetModule().GetHandle());
+      for (std::size_t j = 0; j < module.names.size(); ++j)
       {
-      case ManipInfo::Manipulator::kAdd:
-        if (!m.has_operand1 || m.has_operand2)
+        auto pattern_node = module_node.append_child(L"Pattern");
+        pattern_node.append_attribute(L"Name").set_value(
+          module.names[j].c_str());
+        if (module.matches[j])
         {
-          HADESMEM_DETAIL_THROW_EXCEPTION(
-            Error{} << ErrorString{"Invalid manipulator operands for 'Add'."});
-        }
-
-        address = detail::Add(*process_, base, address, flags, m.operand1);
-
-        break;
+          auto const& p = database.GetPattern(*module.info, j);
+          auto rva = reinterpret_cast<std::uintptr_t>(module.matches[j]);
+          if (!(p.flags & PatternFlags::kRelativeAddress))
+          {
+            rva -= base;
+          }
 
-      case ManipInfo::Manipulator::kSub:
-        if (!m.has_operand1 || m.has_operand2)
-        {
-          HADESMEM_DETAIL_THROW_EXCEPTION(
-            Error{} << ErrorString{"Invalid manipulator operands for 'Sub'."});
+          pattern_node.append_attribute(L"Rva").set_value(
+            detail::NumToStr<wchar_t>(rva, true).c_str());
         }
+      }
+    }
 
-        address = detail::Sub(*process_, base, address, flags, m.operand1);
+    // The results are still good if the cache can't be saved, so this isn't
+    // an error.
+    if (!cache.save_file(cache_path_.c_str()))
+    {
+      HADESMEM_DETAIL_TRACE_A("Failed to save pattern cache.");
+    }
+  }
 
-        break;
+  // Sets a pattern to a match (from the cache or a search), after applying
+  // its manipulators.
+  void SetPattern(detail::PatternDatabaseView const& database,
+                  ModulePatterns& module,
+                  std::uintptr_t base,
+                  std::size_t index,
+                  void* match) const
+  {
+    auto const& p = database.GetPattern(*module.info, index);
+    void* address = match;
+    if (address)
+    {
+      address = ApplyManipulators(address, base, database, p);
+    }
 
-      case ManipInfo::Manipulator::kRel:
-        if (!m.has_operand1 || !m.has_operand2)
-        {
-          HADESMEM_DETAIL_THROW_EXCEPTION(
-            Error{} << ErrorString{"Invalid manipulator operands for 'Rel'."});
-        }
+    module.matches[index] = match;
+    module.patterns[index] = Pattern{address, p.flags};
+  }
 
-        address =
-          detail::Rel(*process_, base, address, flags, m.operand1, m.operand2);
+  void LoadPatternDatabase(detail::PatternDatabaseView const& database)
+  {
+    // A missing or malformed cache is treated as an empty one.
+    pugi::xml_document cache;
+    if (!cache_path_.empty())
+    {
+      cache.load_file(cache_path_.c_str());
+    }
 
-        break;
+    auto const cache_node = cache.child(L"HadesMem").child(L"PatternCache");
+    bool const cache_valid =
+      cache_node.attribute(L"Version").value() ==
+      detail::NumToStr<wchar_t>(detail::kPatternCacheVersion);
+    std::vector<PatternScanContext> contexts;
+    std::vector<ModulePatterns> modules;
+    // The modules which weren't in the cache, and have to be searched.
+    std::vector<std::size_t> searched;
+    std::size_t num_waves = 0;
+    for (std::size_t i = 0; i < database.GetNumModules(); ++i)
+    {
+      auto const& info = database.GetModule(i);
+      modules.emplace_back(GetModulePatterns(database, info));
+      auto& module = modules.back();
+      contexts.emplace_back(*process_, module.name);
+      if (!cache_path_.empty())
+      {
+        module.identity = GetModuleIdentity(contexts.back(), database, module);
+      }
 
-      case ManipInfo::Manipulator::kLea:
-        if (m.has_operand1 || m.has_operand2)
+      if (cache_valid)
+      {
+        // E.g. if a cached match is no longer readable.
+        try
         {
-          HADESMEM_DETAIL_THROW_EXCEPTION(
-            Error{} << ErrorString{"Invalid manipulator operands for 'Lea'."});
+          module.cached =
+            LoadCachedMatches(cache_node, contexts.back(), database, module);
         }
-
-        address = detail::Lea(*process_, base, address, flags);
-
-        break;
-
-      case ManipInfo::Manipulator::kAnd:
-        if (!m.has_operand1 || m.has_operand2)
+        catch (Error const&)
         {
-          HADESMEM_DETAIL_THROW_EXCEPTION(
-            Error{} << ErrorString{"Invalid manipulator operands for 'And'."});
+          HADESMEM_DETAIL_TRACE_A(
+            boost::current_exception_diagnostic_information().c_str());
         }
+      }
 
-        address = detail::And(*process_, base, address, flags, m.operand1);
-
-        break;
-
-      default:
-        HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
-                                        << ErrorString{"Unknown manipulator."});
-
-        break;
+      if (!module.cached)
+      {
+        searched.push_back(i);
+        num_waves = (std::max<std::size_t>)(num_waves, info.num_waves);
       }
     }
 
-    return address;
-  }
-
-  std::uintptr_t GetStartRvaFromPattern(std::wstring const& module,
-                                        std::uintptr_t base,
-                                        std::wstring const& start) const
-  {
-    std::uintptr_t start_rva = 0U;
-    if (!start.empty())
+    // Each wave is resolved for every module at once, so that with more than
+    // one thread the sections of all of the modules are searched in parallel.
+    // Splitting the sections into chunks only pays off when there's more
+    // than one thread to search them.
+    std::size_t const chunk_size = num_threads_ == 1
+                                     ? (std::numeric_limits<std::size_t>::max)()
+                                     : detail::kPatternSearchChunkSize;
+    for (std::size_t wave = 0; wave < num_waves; ++wave)
     {
-      Pattern const start_pattern = LookupEx(module, start);
-      start_rva = reinterpret_cast<std::uintptr_t>(start_pattern.GetAddress());
-      if (!(start_pattern.GetFlags() & PatternFlags::kRelativeAddress))
+      std::vector<detail::PatternSearch> searches;
+      for (auto const i : searched)
       {
-        start_rva -= base;
+        searches.emplace_back(contexts[i],
+                              GetWaveRequests(
+                                contexts[i], database, modules[i], wave),
+                              chunk_size);
       }
-    }
 
-    return start_rva;
-  }
+      detail::SearchAll(searches, num_threads_);
 
-  std::uintptr_t GetStartRvaFromExport(Module const& module,
-                                       std::wstring const& start) const
-  {
-    std::uintptr_t start_rva = 0U;
-    if (!start.empty())
-    {
-      if (start[0] == '#' && start.size() > 1U)
+      for (std::size_t k = 0; k < searched.size(); ++k)
       {
-        auto const ordinal_str = start.substr(1);
-        start_rva = reinterpret_cast<std::uintptr_t>(FindProcedure(
-          *process_, module, detail::StrToNum<WORD>(ordinal_str)));
+        auto const i = searched[k];
+        auto& module = modules[i];
+        auto const base = reinterpret_cast<std::uintptr_t>(
+          contexts[i].GetModule().GetHandle());
+        auto const addresses = searches[k].GetResults();
+        for (std::size_t j = 0; j < module.indices.size(); ++j)
+        {
+          SetPattern(
+            database, module, base, module.indices[j], addresses[j]);
+        }
       }
-      else
+    }
+
+    // The cached matches don't depend on each other, so the manipulators can
+    // be applied in any order.
+    for (std::size_t i = 0; i < modules.size(); ++i)
+    {
+      auto& module = modules[i];
+      if (!module.cached)
       {
-        start_rva = reinterpret_cast<std::uintptr_t>(
-          FindProcedure(*process_, module, detail::WideCharToMultiByte(start)));
+        continue;
       }
 
-      start_rva -= reinterpret_cast<std::uintptr_t>(module.GetHandle());
+      auto const base = reinterpret_cast<std::uintptr_t>(
+        contexts[i].GetModule().GetHandle());
+      for (std::size_t j = 0; j < module.patterns.size(); ++j)
+      {
+        SetPattern(database, module, base, j, module.matches[j]);
+      }
     }
 
-    return start_rva;
-  }
+    if (!cache_path_.empty() && !searched.empty())
+    {
+      SavePatternCache(contexts, database, modules);
+    }
 
-  void LoadPatternFileImpl(pugi::xml_document const& doc)
-  {
-    auto const patterns_info_full_list = ReadPatternsFromXml(doc);
-    for (auto const& patterns_info_full_pair : patterns_info_full_list)
+    for (auto const& module : modules)
     {
-      HADESMEM_DETAIL_ASSERT(
-        find_pattern_datas_.find(patterns_info_full_pair.first) ==
-        std::end(find_pattern_datas_));
-
-      auto const mod_info =
-        detail::GetModuleInfo(*process_, patterns_info_full_pair.first);
-      auto const base =
-        reinterpret_cast<std::uintptr_t>(mod_info.module->GetHandle());
-      auto const& module = patterns_info_full_pair.first;
-      auto const& patterns_info_full = patterns_info_full_pair.second;
-      auto const& pattern_infos = patterns_info_full.patterns;
-      for (auto const& p : pattern_infos)
+      for (std::size_t i = 0; i < module.patterns.size(); ++i)
       {
-        std::uint32_t const flags = patterns_info_full.flags | p.pattern.flags;
-        void* address = nullptr;
-        std::uintptr_t const start_rva = [&]() -> std::uintptr_t {
-          if (!p.pattern.start_rva.empty())
-          {
-            return detail::HexStrToPtr(p.pattern.start_rva);
-          }
-          else if (!p.pattern.start_export.empty())
-          {
-            return GetStartRvaFromExport(*mod_info.module,
-                                         p.pattern.start_export);
-          }
-          else
-          {
-            return GetStartRvaFromPattern(module, base, p.pattern.start);
-          }
-        }();
-
-        address = ::hadesmem::Find(
-          *process_, module, p.pattern.data, flags, start_rva, &p.pattern.name);
-
-        if (address)
-        {
-          address = ApplyManipulators(address, flags, base, p.manipulators);
-        }
-
-        find_pattern_datas_[patterns_info_full_pair.first][p.pattern.name] =
-          Pattern{address, flags};
+        find_pattern_datas_[module.name][module.names[i]] = module.patterns[i];
       }
     }
   }
 
   Process const* process_;
+  std::size_t num_threads_;
+  std::wstring cache_path_;
   ModuleMap find_pattern_datas_;
 };
 }
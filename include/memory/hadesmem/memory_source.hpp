@@ -0,0 +1,595 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <locale>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <windows.h>
+
+#include <hadesmem/detail/query_region.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/write_impl.hpp>
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <cerrno>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <hadesmem/detail/posix_file.hpp>
+#include <hadesmem/detail/winnt.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+// A memory source is anything which provides the following operations, and is
+// what the algorithms which only need to read (or write) memory and look at
+// the layout of an address space are written against, so that they can run
+// against a remote process, our own process, a snapshot or a file, and on
+// platforms other than Windows.
+//
+//   void Read(void* address, void* data, std::size_t len) const;
+//   void Write(void* address, void const* data, std::size_t len) const;
+//   MEMORY_BASIC_INFORMATION Query(void const* address) const;
+//   std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const;
+//
+// Read and Write throw on failure. Query has the same semantics as
+// VirtualQueryEx (including reporting free regions). GetRegions returns every
+// region which isn't free, in ascending order of address.
+
+// TODO: Template FindPattern and PatternScanContext, the PeLib walkers and the
+// dumper's import scan on a memory source too. For now they still require a
+// Process (or a PeFile backed by a buffer in our own address space).
+
+// TODO: Cache the parsed /proc/<pid>/maps (similar to RegionCache) so that
+// Query isn't so expensive.
+
+namespace hadesmem
+{
+namespace detail
+{
+inline bool IsRegionReadable(MEMORY_BASIC_INFORMATION const& mbi) noexcept
+{
+  DWORD const read_prot = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY |
+                          PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE |
+                          PAGE_EXECUTE_WRITECOPY;
+  return mbi.State == MEM_COMMIT && !!(mbi.Protect & read_prot) &&
+         !(mbi.Protect & PAGE_GUARD);
+}
+
+template <typename T, typename MemorySource>
+T SourceRead(MemorySource const& source, void* address)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+  T data;
+  source.Read(address, std::addressof(data), sizeof(T));
+  return data;
+}
+
+template <typename T, typename MemorySource>
+std::vector<T> SourceReadVector(MemorySource const& source,
+                                void* address,
+                                std::size_t count)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_default_constructible<T>::value);
+
+  if (!count)
+  {
+    return {};
+  }
+
+  std::vector<T> data(count);
+  source.Read(address, data.data(), sizeof(T) * count);
+  return data;
+}
+
+template <typename T, typename MemorySource>
+void SourceWrite(MemorySource const& source, void* address, T const& data)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+  source.Write(address, std::addressof(data), sizeof(T));
+}
+
+inline MEMORY_BASIC_INFORMATION
+  MakeFreeRegion(std::uintptr_t beg, std::uintptr_t end) noexcept
+{
+  MEMORY_BASIC_INFORMATION mbi{};
+  mbi.BaseAddress = reinterpret_cast<PVOID>(beg);
+  mbi.RegionSize = static_cast<SIZE_T>(end - beg);
+  mbi.State = MEM_FREE;
+  mbi.Protect = PAGE_NOACCESS;
+  return mbi;
+}
+
+// Finds the region containing the address in a sorted list of non-free
+// regions, synthesizing a free region for any gap.
+inline MEMORY_BASIC_INFORMATION
+  QueryRegionList(std::vector<MEMORY_BASIC_INFORMATION> const& regions,
+                  void const* address)
+{
+  auto const addr = reinterpret_cast<std::uintptr_t>(address);
+  auto const iter = std::upper_bound(
+    std::begin(regions),
+    std::end(regions),
+    addr,
+    [](std::uintptr_t a, MEMORY_BASIC_INFORMATION const& mbi) {
+      return a < reinterpret_cast<std::uintptr_t>(mbi.BaseAddress) +
+                   mbi.RegionSize;
+    });
+
+  std::uintptr_t const free_end =
+    iter == std::end(regions)
+      ? UINTPTR_MAX
+      : reinterpret_cast<std::uintptr_t>(iter->BaseAddress);
+  if (iter != std::end(regions) && addr >= free_end)
+  {
+    return *iter;
+  }
+
+  std::uintptr_t const free_beg =
+    iter == std::begin(regions)
+      ? 0
+      : reinterpret_cast<std::uintptr_t>(std::prev(iter)->BaseAddress) +
+          std::prev(iter)->RegionSize;
+  return MakeFreeRegion(free_beg, free_end);
+}
+
+// Parses the format of /proc/<pid>/maps. File backed mappings are reported as
+// MEM_MAPPED and anonymous ones as MEM_PRIVATE. Mappings with no access at all
+// are almost always reservations (e.g. guard regions between thread stacks or
+// address space reserved by a JIT) so they're reported as MEM_RESERVE.
+inline std::vector<MEMORY_BASIC_INFORMATION> ParseProcMaps(std::istream& maps)
+{
+  std::vector<MEMORY_BASIC_INFORMATION> regions;
+  std::string line;
+  while (std::getline(maps, line))
+  {
+    if (line.empty())
+    {
+      continue;
+    }
+
+    std::istringstream line_str{line};
+    line_str.imbue(std::locale::classic());
+    std::uintptr_t beg = 0;
+    std::uintptr_t end = 0;
+    char dash = 0;
+    std::string perms;
+    std::string offset;
+    std::string dev;
+    std::uint64_t inode = 0;
+    if (!(line_str >> std::hex >> beg >> dash >> end >> perms >> offset >>
+          dev >> std::dec >> inode) ||
+        dash != '-' || end <= beg || perms.size() < 4)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Invalid memory map entry."});
+    }
+
+    bool const r = perms[0] == 'r';
+    bool const w = perms[1] == 'w';
+    bool const x = perms[2] == 'x';
+    bool const shared = perms[3] == 's';
+
+    MEMORY_BASIC_INFORMATION mbi{};
+    mbi.BaseAddress = reinterpret_cast<PVOID>(beg);
+    mbi.AllocationBase = mbi.BaseAddress;
+    mbi.RegionSize = static_cast<SIZE_T>(end - beg);
+    mbi.State = (r || w || x) ? MEM_COMMIT : MEM_RESERVE;
+    if (mbi.State == MEM_COMMIT)
+    {
+      if (x)
+      {
+        mbi.Protect = w ? (shared ? PAGE_EXECUTE_READWRITE
+                                  : PAGE_EXECUTE_WRITECOPY)
+                        : (r ? PAGE_EXECUTE_READ : PAGE_EXECUTE);
+      }
+      else
+      {
+        mbi.Protect =
+          w ? (shared ? PAGE_READWRITE : PAGE_WRITECOPY) : PAGE_READONLY;
+      }
+
+      // Private writable anonymous memory is plain old read-write memory.
+      if (mbi.Protect == PAGE_WRITECOPY && !inode)
+      {
+        mbi.Protect = PAGE_READWRITE;
+      }
+      else if (mbi.Protect == PAGE_EXECUTE_WRITECOPY && !inode)
+      {
+        mbi.Protect = PAGE_EXECUTE_READWRITE;
+      }
+    }
+    mbi.AllocationProtect = mbi.Protect;
+    mbi.Type = inode ? MEM_MAPPED : MEM_PRIVATE;
+
+    // The [vsyscall] page is reported but can't actually be read through
+    // /proc/<pid>/mem, so pretend it doesn't exist.
+    if (line.find("[vsyscall]") != std::string::npos)
+    {
+      continue;
+    }
+
+    regions.push_back(mbi);
+  }
+
+  std::sort(std::begin(regions),
+            std::end(regions),
+            [](MEMORY_BASIC_INFORMATION const& lhs,
+               MEMORY_BASIC_INFORMATION const& rhs) {
+              return lhs.BaseAddress < rhs.BaseAddress;
+            });
+
+  return regions;
+}
+
+#if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+inline std::vector<MEMORY_BASIC_INFORMATION>
+  ReadProcMaps(std::string const& pid_str)
+{
+  std::ifstream maps{"/proc/" + pid_str + "/maps"};
+  if (!maps)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Failed to open memory map."}
+              << ErrorCodeOther{static_cast<DWORD_PTR>(errno)});
+  }
+
+  return ParseProcMaps(maps);
+}
+
+#endif // #if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+// A flat buffer in our own address space, optionally presented at a different
+// base address. Useful for running the same algorithms over a snapshot of
+// remote memory (addressed by the original addresses) or a file on disk.
+class BufferMemorySource
+{
+public:
+  BufferMemorySource(void* data, std::size_t size, void* base = nullptr)
+    : data_{static_cast<std::uint8_t*>(data)},
+      size_{size},
+      base_{reinterpret_cast<std::uintptr_t>(base ? base : data)},
+      writable_{true}
+  {
+    HADESMEM_DETAIL_ASSERT(data_ != nullptr);
+  }
+
+  BufferMemorySource(void const* data, std::size_t size, void* base = nullptr)
+    : BufferMemorySource{const_cast<void*>(data), size, base}
+  {
+    writable_ = false;
+  }
+
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    std::memcpy(data, Translate(address, len), len);
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    if (!writable_)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Attempt to write to read-only buffer."});
+    }
+
+    std::memcpy(Translate(address, len), data, len);
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address) const
+  {
+    return detail::QueryRegionList(GetRegions(), address);
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+    MEMORY_BASIC_INFORMATION mbi{};
+    mbi.BaseAddress = reinterpret_cast<PVOID>(base_);
+    mbi.AllocationBase = mbi.BaseAddress;
+    mbi.RegionSize = size_;
+    mbi.State = MEM_COMMIT;
+    mbi.Protect = writable_ ? PAGE_READWRITE : PAGE_READONLY;
+    mbi.AllocationProtect = mbi.Protect;
+    mbi.Type = MEM_PRIVATE;
+    return {mbi};
+  }
+
+  void* GetBase() const noexcept
+  {
+    return reinterpret_cast<void*>(base_);
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return size_;
+  }
+
+private:
+  std::uint8_t* Translate(void const* address, std::size_t len) const
+  {
+    auto const addr = reinterpret_cast<std::uintptr_t>(address);
+    if (addr < base_ || addr - base_ > size_ || len > size_ - (addr - base_))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Attempt to access outside of buffer."});
+    }
+
+    return data_ + (addr - base_);
+  }
+
+  std::uint8_t* data_;
+  std::size_t size_;
+  std::uintptr_t base_;
+  bool writable_;
+};
+
+// Our own address space. Reads and writes are a plain memcpy with no system
+// calls or protection changes, so the caller must ensure the memory is
+// accessible (e.g. by checking Query first) in the same way as ReadUnsafe.
+// Intended for code which is injected into the target (e.g. Cerberus plugins).
+class LocalMemorySource
+{
+public:
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    HADESMEM_DETAIL_ASSERT(len ? address != nullptr : true);
+
+    std::memcpy(data, address, len);
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    HADESMEM_DETAIL_ASSERT(len ? address != nullptr : true);
+
+    std::memcpy(address, data, len);
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address) const
+  {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+    MEMORY_BASIC_INFORMATION mbi{};
+    if (::VirtualQuery(address, &mbi, sizeof(mbi)) != sizeof(mbi))
+    {
+      DWORD const last_error = ::GetLastError();
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"VirtualQuery failed."}
+                                      << ErrorCodeWinLast{last_error});
+    }
+
+    return mbi;
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+    return detail::QueryRegionList(GetRegions(), address);
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+    std::vector<MEMORY_BASIC_INFORMATION> regions;
+    MEMORY_BASIC_INFORMATION mbi{};
+    for (auto p = static_cast<std::uint8_t const*>(nullptr);
+         ::VirtualQuery(p, &mbi, sizeof(mbi)) == sizeof(mbi);
+         p = static_cast<std::uint8_t const*>(mbi.BaseAddress) +
+             mbi.RegionSize)
+    {
+      if (mbi.State != MEM_FREE)
+      {
+        regions.push_back(mbi);
+      }
+    }
+
+    return regions;
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+    return detail::ReadProcMaps("self");
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  }
+};
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+// A (usually remote) process, through the same APIs as Read, Write and
+// RegionList. Honours the region cache of the process, if any.
+class ProcessMemorySource
+{
+public:
+  explicit ProcessMemorySource(Process const& process) noexcept
+    : process_{&process}
+  {
+  }
+
+  explicit ProcessMemorySource(Process const&& process) = delete;
+
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    detail::ReadImpl(*process_, address, data, len);
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    detail::WriteImpl(*process_, address, data, len);
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address) const
+  {
+    return detail::Query(*process_, address);
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+    std::vector<MEMORY_BASIC_INFORMATION> regions;
+    auto p = static_cast<std::uint8_t const*>(nullptr);
+    for (;;)
+    {
+      MEMORY_BASIC_INFORMATION mbi{};
+      try
+      {
+        mbi = detail::Query(*process_, p);
+      }
+      catch (Error const& e)
+      {
+        // VirtualQueryEx fails with ERROR_INVALID_PARAMETER once we're past
+        // the end of the user address space (see RegionIterator).
+        auto const last_error_ptr = boost::get_error_info<ErrorCodeWinLast>(e);
+        if (!last_error_ptr || *last_error_ptr != ERROR_INVALID_PARAMETER)
+        {
+          throw;
+        }
+
+        break;
+      }
+
+      if (mbi.State != MEM_FREE)
+      {
+        regions.push_back(mbi);
+      }
+
+      p = static_cast<std::uint8_t const*>(mbi.BaseAddress) + mbi.RegionSize;
+    }
+
+    return regions;
+  }
+
+  Process const& GetProcess() const noexcept
+  {
+    return *process_;
+  }
+
+private:
+  Process const* process_;
+};
+
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+// Another process on Linux, through /proc/<pid>/mem and /proc/<pid>/maps.
+// Requires ptrace access to the target (e.g. same user and a permissive
+// kernel.yama.ptrace_scope, or CAP_SYS_PTRACE). Writes additionally require
+// the file to be writable, otherwise the source is read-only.
+class ProcMemorySource
+{
+public:
+  explicit ProcMemorySource(Process const& process)
+    : pid_str_{std::to_string(process.GetId())}, file_{Open(pid_str_)}
+  {
+  }
+
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    auto out = static_cast<std::uint8_t*>(data);
+    auto offset = reinterpret_cast<std::uintptr_t>(address);
+    while (len)
+    {
+      ssize_t const num_read = ::pread(file_->GetHandle(),
+                                       out,
+                                       len,
+                                       static_cast<off_t>(offset));
+      if (num_read <= 0)
+      {
+        int const last_error = num_read ? errno : EIO;
+        if (last_error == EINTR)
+        {
+          continue;
+        }
+
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Failed to read memory."}
+                  << ErrorCodeOther{static_cast<DWORD_PTR>(last_error)});
+      }
+
+      out += num_read;
+      offset += static_cast<std::uintptr_t>(num_read);
+      len -= static_cast<std::size_t>(num_read);
+    }
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    auto in = static_cast<std::uint8_t const*>(data);
+    auto offset = reinterpret_cast<std::uintptr_t>(address);
+    while (len)
+    {
+      ssize_t const num_written = ::pwrite(file_->GetHandle(),
+                                           in,
+                                           len,
+                                           static_cast<off_t>(offset));
+      if (num_written <= 0)
+      {
+        int const last_error = num_written ? errno : EIO;
+        if (last_error == EINTR)
+        {
+          continue;
+        }
+
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Failed to write memory."}
+                  << ErrorCodeOther{static_cast<DWORD_PTR>(last_error)});
+      }
+
+      in += num_written;
+      offset += static_cast<std::uintptr_t>(num_written);
+      len -= static_cast<std::size_t>(num_written);
+    }
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address) const
+  {
+    return detail::QueryRegionList(GetRegions(), address);
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+    return detail::ReadProcMaps(pid_str_);
+  }
+
+private:
+  static std::shared_ptr<detail::PosixFile> Open(std::string const& pid_str)
+  {
+    std::string const path = "/proc/" + pid_str + "/mem";
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1)
+    {
+      fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    if (fd == -1)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Failed to open process memory."}
+                << ErrorCodeOther{static_cast<DWORD_PTR>(errno)});
+    }
+
+    return std::make_shared<detail::PosixFile>(fd);
+  }
+
+  std::string pid_str_;
+  std::shared_ptr<detail::PosixFile> file_;
+};
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
@@ -0,0 +1,418 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/find_terminator.hpp>
+
+// TODO: Add an optional read-ahead so that sequential walks (e.g. an import
+// thunk list) fetch the next page before it's needed.
+
+namespace hadesmem
+{
+// Local copy of remote memory at page granularity, with LRU eviction once the
+// budget is reached. Misses on consecutive pages are coalesced into a single
+// fetch. See CachedProcessView for the typical way to use this, or
+// PeFile::SetPageCache to speed up walking the structures of a live image.
+//
+// Nothing is detected automatically. Writes made through hadesmem while using
+// the cache are reflected (see Update and Invalidate), but the user is
+// responsible for calling NewEpoch whenever the target may have changed its
+// memory (e.g. after resuming it).
+//
+// Thread-safe. Fetches are performed without holding the lock.
+class PageCache
+{
+public:
+  static std::size_t const kDefaultPageSize = 0x1000;
+
+  static std::size_t const kDefaultBudget = 0x400000;
+
+  PageCache() : PageCache{kDefaultBudget}
+  {
+  }
+
+  // Budget is in bytes, and is rounded down to a whole number of pages (but
+  // is always at least one page).
+  explicit PageCache(std::size_t budget,
+                     std::size_t page_size = kDefaultPageSize)
+    : page_size_{page_size},
+      max_pages_{(std::max)(budget / page_size, static_cast<std::size_t>(1))}
+  {
+    HADESMEM_DETAIL_ASSERT(page_size_ && !(page_size_ & (page_size_ - 1)));
+  }
+
+  PageCache(PageCache const& other) = delete;
+
+  PageCache& operator=(PageCache const& other) = delete;
+
+  // FetchFunc must be callable as void(void* address, void* data, std::size_t
+  // len) and throw on failure. It is only called on a cache miss, always with
+  // a page aligned address and a length which is a multiple of the page size.
+  template <typename FetchFunc>
+  void Read(void const* address, void* data, std::size_t len, FetchFunc fetch)
+  {
+    HADESMEM_DETAIL_ASSERT(len ? address != nullptr && data != nullptr : true);
+
+    auto const beg = reinterpret_cast<std::uintptr_t>(address);
+    auto const end = beg + len;
+    auto out = static_cast<std::uint8_t*>(data);
+
+    std::uintptr_t page = AlignDown(beg);
+    std::vector<std::uint8_t> buf;
+    while (page < end)
+    {
+      std::uintptr_t run_end = page;
+      std::uint64_t generation = 0;
+
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        // Serve as many pages as possible from the cache.
+        for (; page < end; page += page_size_)
+        {
+          auto const iter = pages_.find(page);
+          if (iter == std::end(pages_))
+          {
+            break;
+          }
+
+          lru_.splice(std::begin(lru_), lru_, iter->second);
+          CopyOut(page, iter->second->data.data(), beg, end, out);
+          ++hits_;
+        }
+
+        if (page >= end)
+        {
+          break;
+        }
+
+        // Find the run of missing pages which can be fetched in one go.
+        for (run_end = page + page_size_; run_end < end;
+             run_end += page_size_)
+        {
+          if (pages_.find(run_end) != std::end(pages_))
+          {
+            break;
+          }
+        }
+
+        misses_ += (run_end - page) / page_size_;
+        ++fetches_;
+        generation = generation_;
+      }
+
+      // Protection is page granular, so if any part of the run is unreadable
+      // then so is part of the requested range and there's no point retrying
+      // the pages individually.
+      std::size_t const run_len = static_cast<std::size_t>(run_end - page);
+      buf.resize(run_len);
+      fetch(reinterpret_cast<void*>(page), buf.data(), run_len);
+
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        for (std::size_t i = 0; i < run_len; i += page_size_)
+        {
+          CopyOut(page + i, &buf[i], beg, end, out);
+
+          // Discard the data if there was an invalidation while we were
+          // fetching, because it may have been read before the change.
+          if (generation == generation_)
+          {
+            InsertUnlocked(page + i, &buf[i]);
+          }
+        }
+      }
+
+      page = run_end;
+    }
+  }
+
+  // Reads a zero terminated string a page at a time, so the read never
+  // touches a page past the one containing the terminator. If upper_bound is
+  // non-null the string is also terminated there (same as ReadStringBounded).
+  template <typename CharT, typename FetchFunc>
+  std::basic_string<CharT> ReadString(void const* address,
+                                      FetchFunc fetch,
+                                      void const* upper_bound = nullptr)
+  {
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    std::basic_string<CharT> data;
+    std::vector<CharT> buf;
+    auto p = static_cast<std::uint8_t const*>(address);
+    for (;;)
+    {
+      auto const ptr = reinterpret_cast<std::uintptr_t>(p);
+      std::size_t len = (std::max)(
+        static_cast<std::size_t>(AlignDown(ptr) + page_size_ - ptr),
+        sizeof(CharT));
+      if (upper_bound)
+      {
+        auto const bound = reinterpret_cast<std::uintptr_t>(upper_bound);
+        len = ptr < bound
+                ? (std::min)(len, static_cast<std::size_t>(bound - ptr))
+                : 0;
+      }
+      std::size_t const count = len / sizeof(CharT);
+      if (!count)
+      {
+        return data;
+      }
+      buf.resize(count);
+      Read(p, buf.data(), count * sizeof(CharT), fetch);
+
+      auto const terminator =
+        detail::FindTerminator(buf.data(), buf.data() + count);
+      data.append(buf.data(), terminator);
+      if (terminator != buf.data() + count)
+      {
+        return data;
+      }
+
+      p += count * sizeof(CharT);
+    }
+  }
+
+  // Patches any cached pages overlapping the range with the given data. Used
+  // to implement write-through after a successful write to the target.
+  void Update(void const* address, void const* data, std::size_t len)
+  {
+    auto const beg = reinterpret_cast<std::uintptr_t>(address);
+    auto const end = beg + len;
+    auto const in = static_cast<std::uint8_t const*>(data);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    ForEachCachedPageUnlocked(beg, end, [&](std::uintptr_t page) {
+      auto const copy_beg = (std::max)(page, beg);
+      auto const copy_end = (std::min)(page + page_size_, end);
+      std::memcpy(&pages_[page]->data[copy_beg - page],
+                  in + (copy_beg - beg),
+                  static_cast<std::size_t>(copy_end - copy_beg));
+    });
+
+    ++generation_;
+  }
+
+  void Invalidate()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    ClearUnlocked();
+    ++generation_;
+  }
+
+  void Invalidate(void const* address, std::size_t len)
+  {
+    auto const beg = reinterpret_cast<std::uintptr_t>(address);
+    auto const end = beg + (len ? len : 1);
+    auto const last = end < beg ? UINTPTR_MAX : end;
+
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    ForEachCachedPageUnlocked(beg, last, [&](std::uintptr_t page) {
+      auto const iter = pages_.find(page);
+      free_.splice(std::begin(free_), lru_, iter->second);
+      pages_.erase(iter);
+    });
+
+    ++generation_;
+  }
+
+  // Drops all cached data. Intended to be called whenever the target may have
+  // changed (e.g. once per 'frame' of a tool which polls the target).
+  void NewEpoch()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    ClearUnlocked();
+    ++generation_;
+    ++epoch_;
+  }
+
+  std::size_t GetPageSize() const noexcept
+  {
+    return page_size_;
+  }
+
+  std::size_t GetBudget() const noexcept
+  {
+    return max_pages_ * page_size_;
+  }
+
+  std::uint64_t GetEpoch() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return epoch_;
+  }
+
+  // Counted in pages.
+  std::uint64_t GetHits() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return hits_;
+  }
+
+  // Counted in pages.
+  std::uint64_t GetMisses() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return misses_;
+  }
+
+  std::uint64_t GetFetches() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return fetches_;
+  }
+
+  std::uint64_t GetEvictions() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return evictions_;
+  }
+
+  // Number of cached pages.
+  std::size_t GetSize() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return pages_.size();
+  }
+
+private:
+  struct Page
+  {
+    std::uintptr_t base;
+    std::vector<std::uint8_t> data;
+  };
+
+  std::uintptr_t AlignDown(std::uintptr_t address) const noexcept
+  {
+    return address & ~(static_cast<std::uintptr_t>(page_size_) - 1);
+  }
+
+  void CopyOut(std::uintptr_t page,
+               std::uint8_t const* page_data,
+               std::uintptr_t beg,
+               std::uintptr_t end,
+               std::uint8_t* out) const
+  {
+    auto const copy_beg = (std::max)(page, beg);
+    auto const copy_end = (std::min)(page + page_size_, end);
+    std::memcpy(out + (copy_beg - beg),
+                page_data + (copy_beg - page),
+                static_cast<std::size_t>(copy_end - copy_beg));
+  }
+
+  // Calls func with the base of every cached page overlapping [beg, end).
+  // Removing the current page from within func is allowed.
+  template <typename Func>
+  void ForEachCachedPageUnlocked(std::uintptr_t beg,
+                                 std::uintptr_t end,
+                                 Func func)
+  {
+    std::uintptr_t const first = AlignDown(beg);
+    if ((end - first) / page_size_ <= pages_.size())
+    {
+      for (std::uintptr_t page = first; page < end; page += page_size_)
+      {
+        if (pages_.find(page) != std::end(pages_))
+        {
+          func(page);
+        }
+
+        // Guard against wrapping at the top of the address space.
+        if (page + page_size_ < page)
+        {
+          break;
+        }
+      }
+    }
+    else
+    {
+      // The range is larger than the cache, so it's cheaper to check every
+      // cached page instead.
+      std::vector<std::uintptr_t> matches;
+      for (auto const& page : lru_)
+      {
+        if (page.base + page_size_ > beg && page.base < end)
+        {
+          matches.push_back(page.base);
+        }
+      }
+
+      for (auto const page : matches)
+      {
+        func(page);
+      }
+    }
+  }
+
+  void InsertUnlocked(std::uintptr_t page, std::uint8_t const* page_data)
+  {
+    auto const iter = pages_.find(page);
+    if (iter != std::end(pages_))
+    {
+      std::memcpy(iter->second->data.data(), page_data, page_size_);
+      lru_.splice(std::begin(lru_), lru_, iter->second);
+      return;
+    }
+
+    if (pages_.size() >= max_pages_)
+    {
+      auto const victim = std::prev(std::end(lru_));
+      pages_.erase(victim->base);
+      free_.splice(std::begin(free_), lru_, victim);
+      ++evictions_;
+    }
+
+    // Recycle the buffer of an evicted or invalidated page if possible.
+    if (free_.empty())
+    {
+      lru_.push_front(Page{page, std::vector<std::uint8_t>(page_size_)});
+    }
+    else
+    {
+      lru_.splice(std::begin(lru_), free_, std::begin(free_));
+      lru_.front().base = page;
+    }
+
+    std::memcpy(lru_.front().data.data(), page_data, page_size_);
+    pages_[page] = std::begin(lru_);
+  }
+
+  void ClearUnlocked()
+  {
+    pages_.clear();
+    free_.splice(std::begin(free_), lru_);
+  }
+
+  mutable std::mutex mutex_;
+  std::size_t page_size_;
+  std::size_t max_pages_;
+  std::list<Page> lru_;
+  std::list<Page> free_;
+  std::unordered_map<std::uintptr_t, std::list<Page>::iterator> pages_;
+  std::uint64_t generation_{};
+  std::uint64_t epoch_{};
+  std::uint64_t hits_{};
+  std::uint64_t misses_{};
+  std::uint64_t fetches_{};
+  std::uint64_t evictions_{};
+};
+}
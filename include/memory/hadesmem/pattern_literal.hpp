@@ -0,0 +1,245 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/error.hpp>
+
+// Patterns which are known at compile time, e.g.
+//
+//   constexpr auto pattern = HADESMEM_PATTERN("8D 8D 40 FF ?? ?? 3? 1D");
+//
+// The pattern is checked when the code is compiled, and a malformed pattern
+// fails the build. The rest of the parsing, including choosing the bytes to
+// search for first (see detail::CompiledPattern), is also done then if the
+// result is constexpr, so nothing is left to do at runtime.
+//
+// The syntax is the same as for patterns given as strings (see
+// detail::ConvertData), except that each byte must be one or two hex digits,
+// "??", or one hex digit and one '?'.
+//
+// The parsing is done with C++11 constexpr functions (a single return
+// statement, and recursion instead of loops) so that it works with compilers
+// which don't support relaxed constexpr.
+
+namespace hadesmem
+{
+template <std::size_t N> struct PatternLiteral
+{
+  std::array<detail::PatternDataByte, N> bytes;
+  std::size_t anchor;
+  std::size_t check;
+};
+
+namespace detail
+{
+// Deliberately not constexpr, so that a call which is reached while a
+// pattern literal is being evaluated at compile time is an error.
+template <typename T> T InvalidPatternLiteral()
+{
+  HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                  << ErrorString{"Invalid pattern literal."});
+}
+
+constexpr bool IsPatternLiteralSpace(char c) noexcept
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Returns the value of a hex digit, 16 for a wildcard, or -1 if neither.
+constexpr int GetPatternLiteralNibble(char c) noexcept
+{
+  return c >= '0' && c <= '9'
+           ? c - '0'
+           : c >= 'a' && c <= 'f'
+               ? c - 'a' + 10
+               : c >= 'A' && c <= 'F' ? c - 'A' + 10 : c == '?' ? 16 : -1;
+}
+
+constexpr std::size_t SkipPatternLiteralSpace(char const* s,
+                                              std::size_t i) noexcept
+{
+  return IsPatternLiteralSpace(s[i]) ? SkipPatternLiteralSpace(s, i + 1) : i;
+}
+
+constexpr std::size_t GetPatternLiteralTokenEnd(char const* s,
+                                                std::size_t i) noexcept
+{
+  return s[i] == '\0' || IsPatternLiteralSpace(s[i])
+           ? i
+           : GetPatternLiteralTokenEnd(s, i + 1);
+}
+
+constexpr bool IsPatternLiteralToken(char const* s,
+                                     std::size_t i,
+                                     std::size_t len) noexcept
+{
+  return len == 1 ? GetPatternLiteralNibble(s[i]) >= 0 &&
+                      GetPatternLiteralNibble(s[i]) < 16
+                  : len == 2 && GetPatternLiteralNibble(s[i]) >= 0 &&
+                      GetPatternLiteralNibble(s[i + 1]) >= 0;
+}
+
+constexpr PatternDataByte MakePatternLiteralByte(int hi, int lo) noexcept
+{
+  return PatternDataByte{
+    static_cast<std::uint8_t>((hi == 16 ? 0 : hi << 4) | (lo == 16 ? 0 : lo)),
+    static_cast<std::uint8_t>((hi == 16 ? 0 : 0xF0) | (lo == 16 ? 0 : 0x0F))};
+}
+
+constexpr PatternDataByte ParsePatternLiteralToken(char const* s,
+                                                   std::size_t i,
+                                                   std::size_t len)
+{
+  return !IsPatternLiteralToken(s, i, len)
+           ? InvalidPatternLiteral<PatternDataByte>()
+           : len == 1 ? MakePatternLiteralByte(0, GetPatternLiteralNibble(s[i]))
+                      : MakePatternLiteralByte(
+                          GetPatternLiteralNibble(s[i]),
+                          GetPatternLiteralNibble(s[i + 1]));
+}
+
+constexpr PatternDataByte ParsePatternLiteralToken(char const* s,
+                                                   std::size_t i)
+{
+  return ParsePatternLiteralToken(s, i, GetPatternLiteralTokenEnd(s, i) - i);
+}
+
+// Returns the offset of the byte after the one at i.
+constexpr std::size_t GetNextPatternLiteralToken(char const* s,
+                                                 std::size_t i) noexcept
+{
+  return SkipPatternLiteralSpace(s, GetPatternLiteralTokenEnd(s, i));
+}
+
+constexpr std::size_t CountPatternLiteralTokens(char const* s, std::size_t i)
+{
+  return s[i] == '\0'
+           ? 0
+           : !IsPatternLiteralToken(s, i, GetPatternLiteralTokenEnd(s, i) - i)
+               ? InvalidPatternLiteral<std::size_t>()
+               : 1 + CountPatternLiteralTokens(
+                       s, GetNextPatternLiteralToken(s, i));
+}
+
+// Checks every byte of the pattern, so using the result as a template
+// argument is enough to reject a malformed pattern at compile time.
+constexpr std::size_t CountPatternLiteralBytes(char const* s)
+{
+  return CountPatternLiteralTokens(s, SkipPatternLiteralSpace(s, 0));
+}
+
+// Returns the offset of the k-th byte from the one at i.
+constexpr std::size_t FindPatternLiteralToken(char const* s,
+                                              std::size_t i,
+                                              std::size_t k) noexcept
+{
+  return k == 0 ? i : FindPatternLiteralToken(
+                        s, GetNextPatternLiteralToken(s, i), k - 1);
+}
+
+constexpr PatternDataByte GetPatternLiteralByte(char const* s, std::size_t k)
+{
+  return ParsePatternLiteralToken(
+    s, FindPatternLiteralToken(s, SkipPatternLiteralSpace(s, 0), k));
+}
+
+// The same as GetPatternByteFrequency, for the masks a pattern literal can
+// have other than zero.
+constexpr std::uint32_t GetPatternLiteralFrequency(PatternDataByte b,
+                                                   std::uint32_t n = 0)
+{
+  return b.mask == 0xFF
+           ? kCodeByteFrequency[b.value]
+           : n == 16 ? 0
+                     : kCodeByteFrequency[b.value |
+                                          (b.mask == 0xF0 ? n : n << 4)] +
+                         GetPatternLiteralFrequency(b, n + 1);
+}
+
+// Returns the offset of the least common byte from k onwards (or best, if
+// that's less common), skipping wildcards and the byte at exclude. Ties go to
+// the earliest byte, the same as CompilePattern.
+constexpr std::size_t FindPatternLiteralRarest(char const* s,
+                                               std::size_t n,
+                                               std::size_t k,
+                                               std::size_t exclude,
+                                               std::size_t best)
+{
+  return k == n
+           ? best
+           : FindPatternLiteralRarest(
+               s,
+               n,
+               k + 1,
+               exclude,
+               k != exclude && GetPatternLiteralByte(s, k).mask &&
+                   (best == kNoPatternMatch ||
+                    GetPatternLiteralFrequency(GetPatternLiteralByte(s, k)) <
+                      GetPatternLiteralFrequency(
+                        GetPatternLiteralByte(s, best)))
+                 ? k
+                 : best);
+}
+
+constexpr std::size_t GetPatternLiteralAnchor(char const* s, std::size_t n)
+{
+  return FindPatternLiteralRarest(
+    s, n, 0, kNoPatternMatch, kNoPatternMatch);
+}
+
+constexpr std::size_t GetPatternLiteralCheck(char const* s,
+                                             std::size_t n,
+                                             std::size_t anchor)
+{
+  return FindPatternLiteralRarest(s, n, 0, anchor, kNoPatternMatch) ==
+             kNoPatternMatch
+           ? anchor
+           : FindPatternLiteralRarest(s, n, 0, anchor, kNoPatternMatch);
+}
+
+template <std::size_t N, std::size_t... I>
+constexpr PatternLiteral<N> MakePatternLiteralImpl(char const* s,
+                                                   std::index_sequence<I...>)
+{
+  return PatternLiteral<N>{{{GetPatternLiteralByte(s, I)...}},
+                           GetPatternLiteralAnchor(s, N),
+                           GetPatternLiteralCheck(
+                             s, N, GetPatternLiteralAnchor(s, N))};
+}
+
+template <std::size_t N>
+constexpr PatternLiteral<N> MakePatternLiteral(char const* s)
+{
+  static_assert(N != 0, "Empty pattern literal.");
+  return MakePatternLiteralImpl<N>(s, std::make_index_sequence<N>{});
+}
+
+template <std::size_t N>
+CompiledPattern CompilePattern(PatternLiteral<N> const& literal)
+{
+  CompiledPattern pattern;
+  pattern.value.reserve(N);
+  pattern.mask.reserve(N);
+  for (auto const& b : literal.bytes)
+  {
+    pattern.value.push_back(b.value);
+    pattern.mask.push_back(b.mask);
+  }
+  pattern.anchor = literal.anchor;
+  pattern.check = literal.check;
+  return pattern;
+}
+}
+}
+
+#define HADESMEM_PATTERN(str)                                                  \
+  ::hadesmem::detail::MakePatternLiteral<                                      \
+    ::hadesmem::detail::CountPatternLiteralBytes(str)>(str)
@@ -11,8 +11,7 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
@@ -21,8 +20,6 @@
 #include <hadesmem/pelib/import_dir.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Add tests.
 
@@ -103,12 +100,13 @@ public:
 
   void UpdateRead()
   {
-    data_ = Read<IMAGE_BOUND_IMPORT_DESCRIPTOR>(*process_, base_);
+    data_ = detail::PeRead<IMAGE_BOUND_IMPORT_DESCRIPTOR>(
+      *process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   DWORD GetTimeDateStamp() const
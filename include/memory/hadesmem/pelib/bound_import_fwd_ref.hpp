@@ -10,15 +10,12 @@
 #include <ostream>
 #include <string>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Add tests.
 
@@ -68,12 +65,13 @@ public:
 
   void UpdateRead()
   {
-    data_ = Read<IMAGE_BOUND_FORWARDER_REF>(*process_, base_);
+    data_ = detail::PeRead<IMAGE_BOUND_FORWARDER_REF>(
+      *process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   DWORD GetTimeDateStamp() const
@@ -7,7 +7,7 @@
 #include <memory>
 #include <utility>
 
-#include <windows.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
@@ -17,7 +17,6 @@
 #include <hadesmem/pelib/bound_import_fwd_ref.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
 
 // TODO: Add tests.
 
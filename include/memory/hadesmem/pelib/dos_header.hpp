@@ -11,15 +11,12 @@
 #include <ostream>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 namespace hadesmem
 {
@@ -27,7 +24,9 @@ class DosHeader
 {
 public:
   explicit DosHeader(Process const& process, PeFile const& pe_file)
-    : process_{&process}, base_{static_cast<std::uint8_t*>(pe_file.GetBase())}
+    : process_{&process},
+      pe_file_{&pe_file},
+      base_{static_cast<std::uint8_t*>(pe_file.GetBase())}
   {
     UpdateRead();
 
@@ -61,12 +60,12 @@ public:
 
   void UpdateRead()
   {
-    data_ = Read<IMAGE_DOS_HEADER>(*process_, base_);
+    data_ = detail::PeRead<IMAGE_DOS_HEADER>(*process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   WORD GetMagic() const
@@ -270,6 +269,7 @@ public:
 
 private:
   Process const* process_;
+  PeFile const* pe_file_;
   PBYTE base_;
   IMAGE_DOS_HEADER data_ = IMAGE_DOS_HEADER{};
 };
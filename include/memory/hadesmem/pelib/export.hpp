@@ -12,8 +12,7 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/str_conv.hpp>
@@ -22,8 +21,6 @@
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Ensure we properly support data exports. http://bit.ly/1Lu548u
 
@@ -66,16 +63,16 @@ public:
       if (ptr_ordinals && ptr_names)
       {
         std::vector<WORD> const name_ordinals =
-          ReadVector<WORD>(process, ptr_ordinals, num_names);
+          detail::PeReadVector<WORD>(process, pe_file, ptr_ordinals, num_names);
         auto const name_ord_iter = std::find(
           std::begin(name_ordinals), std::end(name_ordinals), ordinal_number_);
         if (name_ord_iter != std::end(name_ordinals))
         {
           by_name_ = true;
+          auto const name_idx =
+            std::distance(std::begin(name_ordinals), name_ord_iter);
           DWORD const name_rva =
-            Read<DWORD>(process,
-                        ptr_names + std::distance(std::begin(name_ordinals),
-                                                  name_ord_iter));
+            detail::PeRead<DWORD>(process, pe_file, ptr_names + name_idx);
           name_ = detail::CheckedReadString<char>(
             process, pe_file, RvaToVa(process, pe_file, name_rva));
         }
@@ -90,7 +87,7 @@ public:
         Error{} << ErrorString{"AddressOfFunctions invalid."});
     }
     rva_ptr_ = reinterpret_cast<DWORD*>(ptr_functions + ordinal_number_);
-    DWORD const func_rva = Read<DWORD>(process, rva_ptr_);
+    DWORD const func_rva = detail::PeRead<DWORD>(process, pe_file, rva_ptr_);
 
     NtHeaders const nt_headers{process, pe_file};
 
@@ -11,16 +11,13 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Support adding new exports.
 
@@ -67,12 +64,12 @@ public:
 
   void UpdateRead()
   {
-    data_ = Read<IMAGE_EXPORT_DIRECTORY>(*process_, base_);
+    data_ = detail::PeRead<IMAGE_EXPORT_DIRECTORY>(*process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   DWORD GetCharacteristics() const
@@ -180,8 +177,8 @@ public:
         Error{} << ErrorString{"Export dir has no name. Cannot overwrite."});
     }
 
-    std::string const current_name =
-      ReadString<char>(*process_, RvaToVa(*process_, *pe_file_, name_rva));
+    std::string const current_name = detail::PeReadString<char>(
+      *process_, *pe_file_, RvaToVa(*process_, *pe_file_, name_rva));
 
     if (name.size() > current_name.size())
     {
@@ -189,7 +186,8 @@ public:
         Error{} << ErrorString{"Cannot overwrite name with longer string."});
     }
 
-    WriteString(*process_, RvaToVa(*process_, *pe_file_, name_rva), name);
+    detail::PeWriteString(
+      *process_, *pe_file_, RvaToVa(*process_, *pe_file_, name_rva), name);
   }
 
   void SetOrdinalBase(DWORD base)
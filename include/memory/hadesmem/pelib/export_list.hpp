@@ -7,7 +7,7 @@
 #include <memory>
 #include <utility>
 
-#include <windows.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
@@ -17,7 +17,6 @@
 #include <hadesmem/pelib/export_dir.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
 
 // TODO: Support using forward iterators via binary search.
 
@@ -96,7 +95,9 @@ public:
       DWORD const num_funcs = export_dir.GetNumberOfFunctions();
 
       for (; ((ordinal_number + ordinal_base) >= ordinal_base) &&
-             !Read<DWORD>(*impl_->process_, ptr_functions + ordinal_number) &&
+             !detail::PeRead<DWORD>(*impl_->process_,
+                                    *impl_->pe_file_,
+                                    ptr_functions + ordinal_number) &&
              ordinal_number < num_funcs;
            ++ordinal_number)
       {
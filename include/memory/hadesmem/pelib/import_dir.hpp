@@ -11,8 +11,7 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
@@ -20,8 +19,6 @@
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/pelib/tls_dir.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Support adding new import descriptors and import thunks.
 
@@ -82,8 +79,8 @@ public:
         {
           auto const offset = sizeof(DWORD) * (i + 1);
           auto const len = sizeof(IMAGE_IMPORT_DESCRIPTOR) - offset;
-          auto const buf =
-            ReadVector<std::uint8_t>(*process_, desc_raw_beg, len);
+          auto const buf = detail::PeReadVector<std::uint8_t>(
+            *process_, *pe_file_, desc_raw_beg, len);
           auto const data_beg =
             reinterpret_cast<std::uint8_t*>(&data_) + offset;
           ::ZeroMemory(&data_, sizeof(data_));
@@ -123,12 +120,13 @@ public:
   // we're reading garbage.
   void UpdateRead()
   {
-    data_ = Read<IMAGE_IMPORT_DESCRIPTOR>(*process_, base_);
+    data_ =
+      detail::PeRead<IMAGE_IMPORT_DESCRIPTOR>(*process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   // Check for virtual descriptor overlap trick.
@@ -250,8 +248,8 @@ public:
   // the existing one.
   void SetName(std::string const& name)
   {
-    DWORD name_rva =
-      Read<DWORD>(*process_, base_ + offsetof(IMAGE_IMPORT_DESCRIPTOR, Name));
+    DWORD name_rva = detail::PeRead<DWORD>(
+      *process_, *pe_file_, base_ + offsetof(IMAGE_IMPORT_DESCRIPTOR, Name));
     if (!name_rva)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
@@ -265,7 +263,8 @@ public:
                                       << ErrorString{"Name VA is null."});
     }
 
-    std::string const cur_name = ReadString<char>(*process_, name_ptr);
+    std::string const cur_name =
+      detail::PeReadString<char>(*process_, *pe_file_, name_ptr);
 
     if (name.size() > cur_name.size())
     {
@@ -273,7 +272,7 @@ public:
         Error{} << ErrorString{"New name longer than existing name."});
     }
 
-    return WriteString(*process_, name_ptr, name);
+    return detail::PeWriteString(*process_, *pe_file_, name_ptr, name);
   }
 
   void SetFirstThunk(DWORD first_thunk)
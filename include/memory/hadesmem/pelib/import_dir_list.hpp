@@ -7,7 +7,7 @@
 #include <memory>
 #include <utility>
 
-#include <windows.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
@@ -16,7 +16,6 @@
 #include <hadesmem/pelib/import_dir.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
 
 namespace hadesmem
 {
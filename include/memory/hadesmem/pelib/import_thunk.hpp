@@ -10,8 +10,7 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
@@ -19,8 +18,6 @@
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 namespace hadesmem
 {
@@ -58,11 +55,13 @@ public:
   {
     if (pe_file_->Is64())
     {
-      data_64_ = Read<IMAGE_THUNK_DATA64>(*process_, base_);
+      data_64_ =
+        detail::PeRead<IMAGE_THUNK_DATA64>(*process_, *pe_file_, base_);
     }
     else
     {
-      data_32_ = Read<IMAGE_THUNK_DATA32>(*process_, base_);
+      data_32_ =
+        detail::PeRead<IMAGE_THUNK_DATA32>(*process_, *pe_file_, base_);
     }
   }
 
@@ -70,11 +69,11 @@ public:
   {
     if (pe_file_->Is64())
     {
-      Write(*process_, base_, data_64_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_64_);
     }
     else
     {
-      Write(*process_, base_, data_32_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_32_);
     }
   }
 
@@ -161,8 +160,8 @@ public:
       HADESMEM_DETAIL_THROW_EXCEPTION(
         Error{} << ErrorString{"Invalid import name and hint."});
     }
-    return Read<WORD>(*process_,
-                      name_import + offsetof(IMAGE_IMPORT_BY_NAME, Hint));
+    return detail::PeRead<WORD>(
+      *process_, *pe_file_, name_import + offsetof(IMAGE_IMPORT_BY_NAME, Hint));
   }
 
   std::string GetName() const
@@ -222,8 +221,10 @@ public:
   {
     std::uint8_t* const name_import = static_cast<PBYTE>(
       RvaToVa(*process_, *pe_file_, static_cast<DWORD>(GetAddressOfData())));
-    return Write(
-      *process_, name_import + offsetof(IMAGE_IMPORT_BY_NAME, Hint), hint);
+    return detail::PeWrite(*process_,
+                           *pe_file_,
+                           name_import + offsetof(IMAGE_IMPORT_BY_NAME, Hint),
+                           hint);
   }
 
 private:
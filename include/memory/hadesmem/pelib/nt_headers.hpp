@@ -12,8 +12,7 @@
 #include <ostream>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
@@ -21,8 +20,6 @@
 #include <hadesmem/pelib/dos_header.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 namespace hadesmem
 {
@@ -74,11 +71,13 @@ public:
   {
     if (pe_file_->Is64())
     {
-      data_64_ = Read<IMAGE_NT_HEADERS64>(*process_, base_);
+      data_64_ =
+        detail::PeRead<IMAGE_NT_HEADERS64>(*process_, *pe_file_, base_);
     }
     else
     {
-      data_32_ = Read<IMAGE_NT_HEADERS32>(*process_, base_);
+      data_32_ =
+        detail::PeRead<IMAGE_NT_HEADERS32>(*process_, *pe_file_, base_);
     }
   }
 
@@ -86,11 +85,11 @@ public:
   {
     if (pe_file_->Is64())
     {
-      Write(*process_, base_, data_64_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_64_);
     }
     else
     {
-      Write(*process_, base_, data_32_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_32_);
     }
   }
 
@@ -579,7 +578,7 @@ public:
   DWORD GetNumberOfRvaAndSizesClamped() const
   {
     DWORD const num_rvas_and_sizes = GetNumberOfRvaAndSizes();
-    return (std::min)(num_rvas_and_sizes, 0x10UL);
+    return (std::min<DWORD>)(num_rvas_and_sizes, 0x10UL);
   }
 
   DWORD GetDataDirectoryVirtualAddress(PeDataDir data_dir) const
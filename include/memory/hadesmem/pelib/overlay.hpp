@@ -12,8 +12,7 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
@@ -22,8 +21,6 @@
 #include <hadesmem/pelib/section.hpp>
 #include <hadesmem/pelib/section_list.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 namespace hadesmem
 {
@@ -111,12 +108,13 @@ public:
 
   void UpdateRead()
   {
-    data_ = ReadVector<std::uint8_t>(*process_, base_, size_);
+    data_ =
+      detail::PeReadVector<std::uint8_t>(*process_, *pe_file_, base_, size_);
   }
 
   void UpdateWrite()
   {
-    WriteVector(*process_, base_, data_);
+    detail::PeWriteRaw(*process_, *pe_file_, base_, data_.data(), data_.size());
   }
 
   std::vector<std::uint8_t> Get() const
@@ -3,25 +3,37 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iosfwd>
+#include <limits>
 #include <memory>
 #include <ostream>
+#include <string>
+#include <type_traits>
 #include <utility>
-
-#include <windows.h>
-#include <winnt.h>
+#include <vector>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
-#include <hadesmem/detail/region_alloc_size.hpp>
+#include <hadesmem/detail/find_terminator.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/winnt.hpp>
 #include <hadesmem/error.hpp>
-#include <hadesmem/module.hpp>
+#include <hadesmem/page_cache.hpp>
 #include <hadesmem/process.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/cached_process_view.hpp>
+#include <hadesmem/detail/region_alloc_size.hpp>
+#include <hadesmem/module.hpp>
 #include <hadesmem/region.hpp>
 #include <hadesmem/region_list.hpp>
 #include <hadesmem/read.hpp>
+#include <hadesmem/write.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
 // TODO: Add proper regression tests for PeLib. This will require running
 // against a known sample set with reference data to compare to.
@@ -40,11 +52,10 @@
 // pretty sure it's different in some cases... Add warning in Dump for this and
 // run a full scan.
 
-// TODO: Decouple PeLib from Process so we can operate directly on
-// files/memory/etc. Need some sort of abstraction to replace Process (and the
-// accompanying calls to Read/Write/etc.). Dependency on hadesmem APIs in
-// general should be removed, as ideally we could make the PeFile code
-// OS-independent as all we're doing is parsing files.
+// TODO: Finish decoupling PeLib from Process. PeFileBacking::kBuffer lets us
+// operate directly on files/memory in our own address space (and on non-Windows
+// platforms), but the Process parameter is still threaded through every type
+// even though it is unused in that mode.
 
 // TODO: Move to an attribute based system for warning on malformed or
 // suspicious files. Also important for testing, so we can ensure certain
@@ -109,25 +120,49 @@ enum class PeFileType
   kData
 };
 
+// kProcess reads the file out of the target process using the memory APIs.
+// kBuffer means the file lives in a contiguous buffer in our own address space
+// (a file read into memory, a mapped view, a copy of a remote image, etc.) so
+// every access is a plain bounds-checked copy instead, and accesses outside the
+// buffer throw rather than silently reading whatever happens to be mapped
+// there. kBuffer is the only mode supported on non-Windows platforms.
+enum class PeFileBacking
+{
+  kProcess,
+  kBuffer
+};
+
+class PeFile;
+
+namespace detail
+{
+template <typename T>
+T PeRead(Process const& process, PeFile const& pe_file, void* address);
+}
+
 class PeFile
 {
 public:
   explicit PeFile(Process const& process,
                   void* address,
                   PeFileType type,
-                  DWORD size)
+                  DWORD size,
+                  PeFileBacking backing = PeFileBacking::kProcess)
     : process_{&process},
       base_{static_cast<std::uint8_t*>(address)},
       type_{type},
-      size_{size}
+      size_{size},
+      backing_{backing}
   {
     HADESMEM_DETAIL_ASSERT(base_ != 0);
-    if (type == PeFileType::kData && !size)
+    if ((type == PeFileType::kData || backing == PeFileBacking::kBuffer) &&
+        !size)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                       << ErrorString{"Invalid file size."});
     }
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
     if (type == PeFileType::kImage && !size)
     {
       try
@@ -144,6 +179,13 @@ public:
         size_ = static_cast<DWORD>(module_region_size);
       }
     }
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+    if (backing != PeFileBacking::kBuffer)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Unsupported PE file backing."});
+    }
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
     // Not erroring out anywhere here in order to retain back-compat.
     // TODO: Do this properly as part of the rewrite.
@@ -152,13 +194,17 @@ public:
       if (size_ > sizeof(IMAGE_DOS_HEADER))
       {
         auto const nt_hdrs_ofs =
-          Read<IMAGE_DOS_HEADER>(process, address).e_lfanew;
+          detail::PeRead<IMAGE_DOS_HEADER>(process, *this, address).e_lfanew;
         if (size_ >= nt_hdrs_ofs + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER))
         {
-          auto const nt_hdrs = Read<IMAGE_NT_HEADERS>(
-            process, static_cast<std::uint8_t*>(address) + nt_hdrs_ofs);
-          if (nt_hdrs.Signature == IMAGE_NT_SIGNATURE &&
-              nt_hdrs.FileHeader.Machine == IMAGE_FILE_MACHINE_AMD64)
+          auto const nt_hdrs_ptr =
+            static_cast<std::uint8_t*>(address) + nt_hdrs_ofs;
+          auto const signature =
+            detail::PeRead<DWORD>(process, *this, nt_hdrs_ptr);
+          auto const file_hdr = detail::PeRead<IMAGE_FILE_HEADER>(
+            process, *this, nt_hdrs_ptr + sizeof(DWORD));
+          if (signature == IMAGE_NT_SIGNATURE &&
+              file_hdr.Machine == IMAGE_FILE_MACHINE_AMD64)
           {
             is_64_ = true;
           }
@@ -173,7 +219,8 @@ public:
   explicit PeFile(Process const&& process,
                   void* address,
                   PeFileType type,
-                  DWORD size) = delete;
+                  DWORD size,
+                  PeFileBacking backing = PeFileBacking::kProcess) = delete;
 
   PVOID GetBase() const noexcept
   {
@@ -190,17 +237,38 @@ public:
     return size_;
   }
 
+  PeFileBacking GetBacking() const noexcept
+  {
+    return backing_;
+  }
+
   bool Is64() const noexcept
   {
     return is_64_;
   }
 
+  // Optional cache used for all reads (and writes) of a process backed file.
+  // The PE structures of a live image are small and read over and over again,
+  // so this avoids most of the calls to ReadProcessMemory. Shared between
+  // copies, which includes the copies held by the other pelib types.
+  void SetPageCache(std::shared_ptr<PageCache> page_cache) noexcept
+  {
+    page_cache_ = std::move(page_cache);
+  }
+
+  PageCache* GetPageCache() const noexcept
+  {
+    return page_cache_.get();
+  }
+
 private:
   Process const* process_;
   PBYTE base_;
   PeFileType type_;
   DWORD size_;
+  PeFileBacking backing_;
   bool is_64_{false};
+  std::shared_ptr<PageCache> page_cache_;
 };
 
 inline bool operator==(PeFile const& lhs, PeFile const& rhs) noexcept
@@ -249,6 +317,200 @@ inline std::wostream& operator<<(std::wostream& lhs, PeFile const& rhs)
   return lhs;
 }
 
+namespace detail
+{
+inline bool IsInPeBuffer(PeFile const& pe_file,
+                         void const* address,
+                         std::size_t len) noexcept
+{
+  auto const beg = reinterpret_cast<std::uintptr_t>(pe_file.GetBase());
+  auto const end = beg + pe_file.GetSize();
+  auto const ptr = reinterpret_cast<std::uintptr_t>(address);
+  return ptr >= beg && ptr <= end && len <= end - ptr;
+}
+
+inline void PeReadRaw(Process const& process,
+                      PeFile const& pe_file,
+                      void* address,
+                      void* data,
+                      std::size_t len)
+{
+  if (pe_file.GetBacking() == PeFileBacking::kBuffer)
+  {
+    if (!IsInPeBuffer(pe_file, address, len))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Attempt to read outside of PE file buffer."});
+    }
+
+    std::memcpy(data, address, len);
+    return;
+  }
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  if (auto const page_cache = pe_file.GetPageCache())
+  {
+    ReadCached(process, *page_cache, address, data, len);
+    return;
+  }
+
+  ReadImpl(process, address, data, len);
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  (void)process;
+  HADESMEM_DETAIL_THROW_EXCEPTION(
+    Error{} << ErrorString{"Unsupported PE file backing."});
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+inline void PeWriteRaw(Process const& process,
+                       PeFile const& pe_file,
+                       void* address,
+                       void const* data,
+                       std::size_t len)
+{
+  if (pe_file.GetBacking() == PeFileBacking::kBuffer)
+  {
+    if (!IsInPeBuffer(pe_file, address, len))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Attempt to write outside of PE file buffer."});
+    }
+
+    std::memcpy(address, data, len);
+    return;
+  }
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  if (auto const page_cache = pe_file.GetPageCache())
+  {
+    WriteCached(process, *page_cache, address, data, len, true);
+    return;
+  }
+
+  WriteImpl(process, address, data, len);
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  (void)process;
+  HADESMEM_DETAIL_THROW_EXCEPTION(
+    Error{} << ErrorString{"Unsupported PE file backing."});
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+template <typename T>
+T PeRead(Process const& process, PeFile const& pe_file, void* address)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivial<T>::value);
+
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+  T data;
+  PeReadRaw(process, pe_file, address, std::addressof(data), sizeof(data));
+  return data;
+}
+
+template <typename T>
+std::vector<T> PeReadVector(Process const& process,
+                            PeFile const& pe_file,
+                            void* address,
+                            std::size_t count)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivial<T>::value);
+
+  HADESMEM_DETAIL_ASSERT(count ? address != nullptr : true);
+
+  if (!count)
+  {
+    return {};
+  }
+
+  if (count > (std::numeric_limits<std::size_t>::max)() / sizeof(T))
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                    << ErrorString{"Invalid element count."});
+  }
+
+  std::vector<T> data(count);
+  PeReadRaw(process, pe_file, address, data.data(), sizeof(T) * count);
+  return data;
+}
+
+template <typename T>
+void PeWrite(Process const& process,
+             PeFile const& pe_file,
+             void* address,
+             T const& data)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivial<T>::value);
+
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+  PeWriteRaw(process, pe_file, address, std::addressof(data), sizeof(data));
+}
+
+// Strings in a buffer backed file are terminated by the end of the buffer if no
+// terminator is found first (same as ReadStringBounded). If upper_bound is
+// non-null the string is also terminated there.
+template <typename CharT>
+std::basic_string<CharT> PeReadString(Process const& process,
+                                      PeFile const& pe_file,
+                                      void* address,
+                                      void* upper_bound = nullptr)
+{
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+  if (pe_file.GetBacking() == PeFileBacking::kBuffer)
+  {
+    if (!IsInPeBuffer(pe_file, address, 0))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Attempt to read outside of PE file buffer."});
+    }
+
+    auto file_end =
+      static_cast<std::uint8_t*>(pe_file.GetBase()) + pe_file.GetSize();
+    if (upper_bound && upper_bound < file_end)
+    {
+      file_end = static_cast<std::uint8_t*>(upper_bound);
+    }
+    auto const len =
+      address < file_end
+        ? static_cast<std::size_t>(file_end -
+                                   static_cast<std::uint8_t*>(address)) /
+            sizeof(CharT)
+        : 0;
+    auto const beg = static_cast<CharT const*>(address);
+    return std::basic_string<CharT>(beg,
+                                    detail::FindTerminator(beg, beg + len));
+  }
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  if (auto const page_cache = pe_file.GetPageCache())
+  {
+    return ReadStringCached<CharT>(process, *page_cache, address, upper_bound);
+  }
+
+  return upper_bound ? ReadStringBounded<CharT>(process, address, upper_bound)
+                     : ReadString<CharT>(process, address);
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  (void)process;
+  HADESMEM_DETAIL_THROW_EXCEPTION(
+    Error{} << ErrorString{"Unsupported PE file backing."});
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+template <typename CharT>
+void PeWriteString(Process const& process,
+                   PeFile const& pe_file,
+                   void* address,
+                   std::basic_string<CharT> const& data)
+{
+  PeWriteRaw(process,
+             pe_file,
+             address,
+             data.c_str(),
+             (data.size() + 1) * sizeof(CharT));
+}
+}
+
 // TODO: Add sample files for all the corner cases we're handling, and ensure it
 // is correct, so we can add regression tests.
 // TODO: Find a better name for this functions? It's slightly confusing...
@@ -276,7 +538,8 @@ inline PVOID RvaToVa(Process const& process,
       return nullptr;
     }
 
-    IMAGE_DOS_HEADER dos_header = Read<IMAGE_DOS_HEADER>(process, base);
+    IMAGE_DOS_HEADER dos_header =
+      detail::PeRead<IMAGE_DOS_HEADER>(process, pe_file, base);
     if (dos_header.e_magic != IMAGE_DOS_SIGNATURE)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
@@ -284,25 +547,29 @@ inline PVOID RvaToVa(Process const& process,
     }
 
     BYTE* ptr_nt_headers = base + dos_header.e_lfanew;
-    if (Read<DWORD>(process, ptr_nt_headers) != IMAGE_NT_SIGNATURE)
+    if (detail::PeRead<DWORD>(process, pe_file, ptr_nt_headers) !=
+        IMAGE_NT_SIGNATURE)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                       << ErrorString{"Invalid NT headers."});
     }
 
-    auto const file_header =
-      Read<IMAGE_FILE_HEADER>(process, ptr_nt_headers + sizeof(DWORD));
+    auto const file_header = detail::PeRead<IMAGE_FILE_HEADER>(
+      process, pe_file, ptr_nt_headers + sizeof(DWORD));
 
     auto const optional_header_32 =
       pe_file.Is64()
         ? IMAGE_OPTIONAL_HEADER32{}
-        : Read<IMAGE_OPTIONAL_HEADER32>(process,
-                                        ptr_nt_headers + sizeof(DWORD) +
-                                          sizeof(IMAGE_FILE_HEADER));
+        : detail::PeRead<IMAGE_OPTIONAL_HEADER32>(
+            process,
+            pe_file,
+            ptr_nt_headers + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER));
     auto const optional_header_64 =
       pe_file.Is64()
-        ? Read<IMAGE_OPTIONAL_HEADER64>(
-            process, ptr_nt_headers + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER))
+        ? detail::PeRead<IMAGE_OPTIONAL_HEADER64>(
+            process,
+            pe_file,
+            ptr_nt_headers + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER))
         : IMAGE_OPTIONAL_HEADER64{};
 
     DWORD const size_of_headers = pe_file.Is64()
@@ -387,8 +654,8 @@ inline PVOID RvaToVa(Process const& process,
         return nullptr;
       }
 
-      auto const section_header =
-        Read<IMAGE_SECTION_HEADER>(process, ptr_section_header);
+      auto const section_header = detail::PeRead<IMAGE_SECTION_HEADER>(
+        process, pe_file, ptr_section_header);
 
       DWORD const virtual_beg = section_header.VirtualAddress;
       DWORD const virtual_size = section_header.Misc.VirtualSize;
@@ -504,7 +771,8 @@ inline DWORD FileOffsetToRva(Process const& process,
 
   if (type == PeFileType::kData)
   {
-    IMAGE_DOS_HEADER dos_header = Read<IMAGE_DOS_HEADER>(process, base);
+    IMAGE_DOS_HEADER dos_header =
+      detail::PeRead<IMAGE_DOS_HEADER>(process, pe_file, base);
     if (dos_header.e_magic != IMAGE_DOS_SIGNATURE)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
@@ -512,14 +780,15 @@ inline DWORD FileOffsetToRva(Process const& process,
     }
 
     BYTE* ptr_nt_headers = base + dos_header.e_lfanew;
-    if (Read<DWORD>(process, ptr_nt_headers) != IMAGE_NT_SIGNATURE)
+    if (detail::PeRead<DWORD>(process, pe_file, ptr_nt_headers) !=
+        IMAGE_NT_SIGNATURE)
     {
       HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
                                       << ErrorString{"Invalid NT headers."});
     }
 
-    auto const file_header =
-      Read<IMAGE_FILE_HEADER>(process, ptr_nt_headers + sizeof(DWORD));
+    auto const file_header = detail::PeRead<IMAGE_FILE_HEADER>(
+      process, pe_file, ptr_nt_headers + sizeof(DWORD));
 
     auto ptr_section_header = reinterpret_cast<PIMAGE_SECTION_HEADER>(
       ptr_nt_headers + offsetof(IMAGE_NT_HEADERS, OptionalHeader) +
@@ -528,8 +797,8 @@ inline DWORD FileOffsetToRva(Process const& process,
     WORD num_sections = file_header.NumberOfSections;
     for (WORD i = 0; i < num_sections; ++i)
     {
-      auto const section_header =
-        Read<IMAGE_SECTION_HEADER>(process, ptr_section_header);
+      auto const section_header = detail::PeRead<IMAGE_SECTION_HEADER>(
+        process, pe_file, ptr_section_header);
 
       DWORD const raw_beg = section_header.PointerToRawData;
       DWORD const raw_size = section_header.SizeOfRawData;
@@ -567,12 +836,24 @@ std::basic_string<CharT> CheckedReadString(Process const& process,
                                            PeFile const& pe_file,
                                            void* address)
 {
-  if (pe_file.GetType() == PeFileType::kImage)
+  if (pe_file.GetBacking() == PeFileBacking::kBuffer)
   {
-    // TODO: Extra bounds checking to ensure we don't read outside the image in
-    // the case that we're reading a string at the end of the file which is not
-    // null terminated, and we're on a region boundary.
-    return ReadString<CharT>(process, address);
+    // Handles EOF termination for both images and data files.
+    return PeReadString<CharT>(process, pe_file, address);
+  }
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  else if (pe_file.GetType() == PeFileType::kImage)
+  {
+    // Don't run off the end of the image if the last string in it isn't
+    // terminated and the following region happens to be readable.
+    void* const image_end =
+      static_cast<std::uint8_t*>(pe_file.GetBase()) + pe_file.GetSize();
+    return PeReadString<CharT>(process,
+                               pe_file,
+                               address,
+                               pe_file.GetSize() && address < image_end
+                                 ? image_end
+                                 : nullptr);
   }
   else if (pe_file.GetType() == PeFileType::kData)
   {
@@ -586,6 +867,7 @@ std::basic_string<CharT> CheckedReadString(Process const& process,
     // Sample: maxsecXP.exe (Corkami PE Corpus)
     return ReadStringBounded<CharT>(process, address, file_end);
   }
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   else
   {
     HADESMEM_DETAIL_ASSERT(false);
@@ -9,15 +9,12 @@
 #include <ostream>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Add tests.
 
@@ -55,7 +52,8 @@ public:
 
   void UpdateRead()
   {
-    auto const data_tmp = Read<std::uint16_t>(*process_, base_);
+    auto const data_tmp =
+      detail::PeRead<std::uint16_t>(*process_, *pe_file_, base_);
     type_ = static_cast<std::uint8_t>(data_tmp >> 12);
     offset_ = data_tmp & 0x0FFF;
   }
@@ -65,7 +63,7 @@ public:
     auto const data_tmp =
       static_cast<std::uint16_t>(static_cast<std::uint32_t>(offset_) |
                                  (static_cast<std::uint32_t>(type_) << 12));
-    Write(*process_, base_, data_tmp);
+    detail::PeWrite(*process_, *pe_file_, base_, data_tmp);
   }
 
   std::uint8_t GetType() const noexcept
@@ -7,16 +7,13 @@
 #include <ostream>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: Add tests.
 
@@ -59,12 +56,12 @@ public:
 
   void UpdateRead()
   {
-    data_ = Read<IMAGE_BASE_RELOCATION>(*process_, base_);
+    data_ = detail::PeRead<IMAGE_BASE_RELOCATION>(*process_, *pe_file_, base_);
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   DWORD GetVirtualAddress() const noexcept
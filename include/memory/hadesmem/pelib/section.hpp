@@ -12,16 +12,13 @@
 #include <string>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 // TODO: In the case that PointerToRawData lies outside the file, the Windows PE
 // loader considers both it and SizeOfRawData to be zero (which will result in
@@ -94,13 +91,13 @@ public:
     }
     else
     {
-      data_ = Read<IMAGE_SECTION_HEADER>(*process_, base_);
+      data_ = detail::PeRead<IMAGE_SECTION_HEADER>(*process_, *pe_file_, base_);
     }
   }
 
   void UpdateWrite()
   {
-    Write(*process_, base_, data_);
+    detail::PeWrite(*process_, *pe_file_, base_, data_);
   }
 
   // TODO: Don't truncate.
@@ -12,16 +12,13 @@
 #include <vector>
 #include <utility>
 
-#include <windows.h>
-#include <winnt.h>
+#include <hadesmem/detail/winnt.hpp>
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
-#include <hadesmem/read.hpp>
-#include <hadesmem/write.hpp>
 
 namespace hadesmem
 {
@@ -62,11 +59,13 @@ public:
   {
     if (pe_file_->Is64())
     {
-      data_64_ = Read<IMAGE_TLS_DIRECTORY64>(*process_, base_);
+      data_64_ =
+        detail::PeRead<IMAGE_TLS_DIRECTORY64>(*process_, *pe_file_, base_);
     }
     else
     {
-      data_32_ = Read<IMAGE_TLS_DIRECTORY32>(*process_, base_);
+      data_32_ =
+        detail::PeRead<IMAGE_TLS_DIRECTORY32>(*process_, *pe_file_, base_);
     }
   }
 
@@ -74,11 +73,11 @@ public:
   {
     if (pe_file_->Is64())
     {
-      Write(*process_, base_, data_64_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_64_);
     }
     else
     {
-      Write(*process_, base_, data_32_);
+      detail::PeWrite(*process_, *pe_file_, base_, data_32_);
     }
   }
 
@@ -257,8 +256,10 @@ private:
         Error{} << ErrorString{"TLS callbacks are invalid."});
     }
 
-    for (auto callback = Read<T>(*process_, callbacks_raw); callback;
-         callback = Read<T>(*process_, ++callbacks_raw))
+    for (auto callback =
+           detail::PeRead<T>(*process_, *pe_file_, callbacks_raw);
+         callback;
+         callback = detail::PeRead<T>(*process_, *pe_file_, ++callbacks_raw))
     {
       *callbacks++ = static_cast<ULONGLONG>(callback) - image_base;
     }
@@ -0,0 +1,807 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scanner.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/module.hpp>
+#include <hadesmem/module_list.hpp>
+#include <hadesmem/process.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace hadesmem
+{
+struct PointerScanOptions
+{
+  // Regions which are searched for pointers, and the number of threads used
+  // to search them. Pointers may point to any readable region. The alignment
+  // defaults to the pointer size.
+  ScanOptions scan;
+  // Size of a pointer in the target (e.g. 4 for a WoW64 process).
+  std::size_t pointer_size{sizeof(void*)};
+  // Maximum number of pointers to follow from a static base to the target.
+  std::size_t max_depth{5};
+  // Maximum offset added to each pointer.
+  std::size_t max_offset{0x1000};
+  // The search stops once this many paths have been found.
+  std::size_t max_results{0x100000};
+};
+
+// A module (or any other range) whose address can be found again in a later
+// run of the target, so a pointer stored inside it is a usable starting point
+// for a path.
+struct PointerScanBase
+{
+  std::wstring name;
+  std::uintptr_t base;
+  std::size_t size;
+};
+
+// [name + module_offset] + offsets[0] ... + offsets[N - 1], where [x] means
+// the pointer stored at x.
+struct PointerPath
+{
+  std::wstring module;
+  std::uintptr_t module_offset;
+  std::vector<std::uintptr_t> offsets;
+};
+
+namespace detail
+{
+struct PointerMapEntry
+{
+  std::uintptr_t pointee;
+  std::uintptr_t location;
+};
+
+inline bool operator<(PointerMapEntry const& lhs,
+                      PointerMapEntry const& rhs) noexcept
+{
+  return lhs.pointee < rhs.pointee ||
+         (lhs.pointee == rhs.pointee && lhs.location < rhs.location);
+}
+
+typedef std::pair<std::uintptr_t, std::uintptr_t> PointerRange;
+
+// Sorted, merged list of the readable ranges. Only values which point into
+// one of these are considered to be pointers.
+inline std::vector<PointerRange>
+  GetReadableRanges(std::vector<MEMORY_BASIC_INFORMATION> const& regions)
+{
+  std::vector<PointerRange> ranges;
+  for (auto const& mbi : regions)
+  {
+    if (!IsRegionReadable(mbi))
+    {
+      continue;
+    }
+
+    auto const beg = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+    auto const end = beg + mbi.RegionSize;
+    if (!ranges.empty() && ranges.back().second == beg)
+    {
+      ranges.back().second = end;
+    }
+    else
+    {
+      ranges.emplace_back(beg, end);
+    }
+  }
+  std::sort(std::begin(ranges), std::end(ranges));
+  return ranges;
+}
+
+inline bool IsInRanges(std::vector<PointerRange> const& ranges,
+                       std::uintptr_t address) noexcept
+{
+  auto const iter = std::upper_bound(
+    std::begin(ranges),
+    std::end(ranges),
+    address,
+    [](std::uintptr_t lhs, PointerRange const& rhs) {
+      return lhs < rhs.first;
+    });
+  return iter != std::begin(ranges) && address < (iter - 1)->second;
+}
+
+// Appends every pointer in the chunk (at the given alignment) to out, sorted.
+template <typename PointerT>
+void ScanChunkPointers(ScanChunk const& chunk,
+                       std::uint8_t const* data,
+                       std::size_t alignment,
+                       std::vector<PointerRange> const& ranges,
+                       std::vector<PointerMapEntry>& out)
+{
+  if (chunk.read_len < sizeof(PointerT))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(PointerT) + 1);
+  for (std::size_t i = rem ? alignment - rem : 0; i < last; i += alignment)
+  {
+    PointerT value;
+    std::memcpy(&value, data + i, sizeof(value));
+    if (value > (std::numeric_limits<std::uintptr_t>::max)())
+    {
+      continue;
+    }
+
+    auto const pointee = static_cast<std::uintptr_t>(value);
+    if (IsInRanges(ranges, pointee))
+    {
+      out.push_back(PointerMapEntry{pointee, chunk.address + i});
+    }
+  }
+
+  std::sort(std::begin(out), std::end(out));
+}
+
+template <typename MemorySource>
+std::uintptr_t ReadPointer(MemorySource const& source,
+                           std::uintptr_t address,
+                           std::size_t pointer_size)
+{
+  if (pointer_size == sizeof(std::uint32_t))
+  {
+    return SourceRead<std::uint32_t>(source, reinterpret_cast<void*>(address));
+  }
+
+  return static_cast<std::uintptr_t>(
+    SourceRead<std::uint64_t>(source, reinterpret_cast<void*>(address)));
+}
+
+inline PointerScanBase const*
+  FindPointerScanBase(std::vector<PointerScanBase> const& bases,
+                      std::uintptr_t address) noexcept
+{
+  for (auto const& base : bases)
+  {
+    if (address >= base.base && address - base.base < base.size)
+    {
+      return &base;
+    }
+  }
+  return nullptr;
+}
+
+// "HDMPTRS1"
+std::uint64_t const kPointerScanResultsMagic = 0x3153525450444D48ULL;
+
+template <typename T> void WritePod(std::ostream& out, T const& value)
+{
+  out.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+template <typename T> T ReadPod(std::istream& in)
+{
+  T value{};
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(
+      Error{} << ErrorString{"Unexpected end of pointer scan results."});
+  }
+  return value;
+}
+}
+
+// A reverse pointer map: every pointer in the scanned regions, sorted by the
+// address it points to, so that all pointers to a range can be found with a
+// binary search. Built once (see PointerScanner::BuildMap) and searched as
+// many times as needed.
+class PointerMap
+{
+public:
+  typedef std::vector<detail::PointerMapEntry>::const_iterator const_iterator;
+
+  PointerMap() = default;
+
+  PointerMap(std::vector<detail::PointerMapEntry>&& entries,
+             std::size_t pointer_size)
+    : entries_(std::move(entries)), pointer_size_{pointer_size}
+  {
+    HADESMEM_DETAIL_ASSERT(
+      std::is_sorted(std::begin(entries_), std::end(entries_)));
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return entries_.size();
+  }
+
+  std::size_t GetPointerSize() const noexcept
+  {
+    return pointer_size_;
+  }
+
+  std::vector<detail::PointerMapEntry> const& GetEntries() const noexcept
+  {
+    return entries_;
+  }
+
+  // All pointers which point into [beg, end], sorted by pointee.
+  std::pair<const_iterator, const_iterator>
+    FindPointersTo(std::uintptr_t beg, std::uintptr_t end) const noexcept
+  {
+    auto const compare = [](detail::PointerMapEntry const& lhs,
+                            std::uintptr_t rhs) { return lhs.pointee < rhs; };
+    auto const first =
+      std::lower_bound(std::begin(entries_), std::end(entries_), beg, compare);
+    auto const last = std::upper_bound(
+      first,
+      std::end(entries_),
+      end,
+      [](std::uintptr_t lhs, detail::PointerMapEntry const& rhs) {
+        return lhs < rhs.pointee;
+      });
+    return std::make_pair(first, last);
+  }
+
+private:
+  std::vector<detail::PointerMapEntry> entries_;
+  std::size_t pointer_size_{sizeof(void*)};
+};
+
+// The paths found by a pointer scan. Module names are only stored once, and
+// each path takes 16 bytes plus 4 bytes per offset.
+class PointerScanResults
+{
+public:
+  explicit PointerScanResults(std::size_t pointer_size = sizeof(void*))
+    : pointer_size_{pointer_size}
+  {
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return entries_.size();
+  }
+
+  bool IsEmpty() const noexcept
+  {
+    return entries_.empty();
+  }
+
+  std::size_t GetPointerSize() const noexcept
+  {
+    return pointer_size_;
+  }
+
+  void Add(PointerPath const& path)
+  {
+    if (path.module_offset > (std::numeric_limits<std::uint32_t>::max)() ||
+        offsets_.size() + path.offsets.size() >
+          (std::numeric_limits<std::uint32_t>::max)())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Pointer path is too large to store."});
+    }
+
+    Entry entry{};
+    entry.module = GetModuleIndex(path.module);
+    entry.module_offset = static_cast<std::uint32_t>(path.module_offset);
+    entry.first_offset = static_cast<std::uint32_t>(offsets_.size());
+    entry.depth = static_cast<std::uint32_t>(path.offsets.size());
+    for (auto const offset : path.offsets)
+    {
+      if (offset > (std::numeric_limits<std::uint32_t>::max)())
+      {
+        offsets_.resize(entry.first_offset);
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Pointer path offset is too large."});
+      }
+      offsets_.push_back(static_cast<std::uint32_t>(offset));
+    }
+    entries_.push_back(entry);
+  }
+
+  PointerPath GetPath(std::size_t index) const
+  {
+    HADESMEM_DETAIL_ASSERT(index < entries_.size());
+
+    auto const& entry = entries_[index];
+    PointerPath path;
+    path.module = modules_[entry.module];
+    path.module_offset = entry.module_offset;
+    auto const beg = std::begin(offsets_) + entry.first_offset;
+    path.offsets.assign(beg, beg + entry.depth);
+    return path;
+  }
+
+  void Save(std::ostream& out) const
+  {
+    detail::WritePod(out, detail::kPointerScanResultsMagic);
+    detail::WritePod(out, static_cast<std::uint32_t>(pointer_size_));
+    detail::WritePod(out, static_cast<std::uint64_t>(modules_.size()));
+    for (auto const& module : modules_)
+    {
+      detail::WritePod(out, static_cast<std::uint64_t>(module.size()));
+      for (auto const c : module)
+      {
+        detail::WritePod(out, static_cast<std::uint32_t>(c));
+      }
+    }
+    detail::WritePod(out, static_cast<std::uint64_t>(entries_.size()));
+    out.write(reinterpret_cast<char const*>(entries_.data()),
+              entries_.size() * sizeof(Entry));
+    detail::WritePod(out, static_cast<std::uint64_t>(offsets_.size()));
+    out.write(reinterpret_cast<char const*>(offsets_.data()),
+              offsets_.size() * sizeof(std::uint32_t));
+
+    if (!out)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Failed to write pointer scan results."});
+    }
+  }
+
+  static PointerScanResults Load(std::istream& in)
+  {
+    if (detail::ReadPod<std::uint64_t>(in) != detail::kPointerScanResultsMagic)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Invalid pointer scan results."});
+    }
+
+    PointerScanResults results{detail::ReadPod<std::uint32_t>(in)};
+    auto const num_modules = detail::ReadPod<std::uint64_t>(in);
+    for (std::uint64_t i = 0; i < num_modules; ++i)
+    {
+      auto const len = detail::ReadPod<std::uint64_t>(in);
+      std::wstring module;
+      for (std::uint64_t j = 0; j < len; ++j)
+      {
+        module.push_back(
+          static_cast<wchar_t>(detail::ReadPod<std::uint32_t>(in)));
+      }
+      results.modules_.push_back(std::move(module));
+    }
+
+    auto const num_entries = detail::ReadPod<std::uint64_t>(in);
+    for (std::uint64_t i = 0; i < num_entries; ++i)
+    {
+      results.entries_.push_back(detail::ReadPod<Entry>(in));
+    }
+
+    auto const num_offsets = detail::ReadPod<std::uint64_t>(in);
+    for (std::uint64_t i = 0; i < num_offsets; ++i)
+    {
+      results.offsets_.push_back(detail::ReadPod<std::uint32_t>(in));
+    }
+
+    for (auto const& entry : results.entries_)
+    {
+      if (entry.module >= results.modules_.size() ||
+          static_cast<std::uint64_t>(entry.first_offset) + entry.depth >
+            results.offsets_.size())
+      {
+        HADESMEM_DETAIL_THROW_EXCEPTION(
+          Error{} << ErrorString{"Invalid pointer scan results."});
+      }
+    }
+
+    return results;
+  }
+
+private:
+  struct Entry
+  {
+    std::uint32_t module;
+    std::uint32_t module_offset;
+    std::uint32_t first_offset;
+    std::uint32_t depth;
+  };
+
+  std::uint32_t GetModuleIndex(std::wstring const& module)
+  {
+    auto const iter =
+      std::find(std::begin(modules_), std::end(modules_), module);
+    if (iter != std::end(modules_))
+    {
+      return static_cast<std::uint32_t>(iter - std::begin(modules_));
+    }
+
+    modules_.push_back(module);
+    return static_cast<std::uint32_t>(modules_.size() - 1);
+  }
+
+  std::size_t pointer_size_;
+  std::vector<std::wstring> modules_;
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> offsets_;
+};
+
+// Finds paths of pointers from static bases (typically modules) to a target
+// address, so that the target can be found again after the target process
+// is restarted (or the game is patched).
+//
+// BuildMap does one parallel pass over the scanned regions and builds the
+// reverse pointer map. FindPaths then does a breadth-first search backwards
+// from the target. Each level looks up every pointer which points at most
+// max_offset bytes before an address on the current level, in parallel. A
+// pointer stored inside a base ends a path. Any other pointer becomes an
+// address on the next level, unless it was already reached by a shorter
+// path. Every shortest path is reported.
+//
+// For a remote process on Windows use ProcessMemorySource and
+// GetPointerScanBases.
+template <typename MemorySource> class PointerScanner
+{
+public:
+  explicit PointerScanner(MemorySource const& source,
+                          PointerScanOptions const& options =
+                            PointerScanOptions{})
+    : source_{&source}, options_(options)
+  {
+    if (options_.pointer_size != sizeof(std::uint32_t) &&
+        options_.pointer_size != sizeof(std::uint64_t))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid pointer size."});
+    }
+
+    if (!options_.scan.chunk_size)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid chunk size."});
+    }
+
+    if (options_.max_offset > (std::numeric_limits<std::uint32_t>::max)())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid max offset."});
+    }
+  }
+
+  explicit PointerScanner(MemorySource const&& source,
+                          PointerScanOptions const& options =
+                            PointerScanOptions{}) = delete;
+
+  PointerScanOptions const& GetOptions() const noexcept
+  {
+    return options_;
+  }
+
+  PointerMap BuildMap() const
+  {
+    std::size_t const pointer_size = options_.pointer_size;
+    std::size_t const alignment =
+      options_.scan.alignment ? options_.scan.alignment : pointer_size;
+    auto const all_regions = source_->GetRegions();
+    auto const ranges = detail::GetReadableRanges(all_regions);
+    auto const chunks = detail::MakeScanChunks(
+      detail::FilterScanRegions(all_regions, options_.scan),
+      options_.scan.chunk_size,
+      pointer_size - 1);
+    std::size_t const num_threads = detail::GetScanThreadCount(options_.scan);
+
+    // Each chunk is sorted by the worker which scanned it, leaving a set of
+    // sorted runs which are then merged pairwise (also in parallel).
+    std::vector<detail::PointerMapEntry> entries;
+    std::vector<std::size_t> runs{0};
+    detail::ParallelScanChunksOrdered<std::vector<detail::PointerMapEntry>>(
+      *source_,
+      chunks,
+      num_threads,
+      [&](detail::ScanChunk const& chunk,
+          std::uint8_t const* data,
+          std::vector<detail::PointerMapEntry>& out) {
+        if (pointer_size == sizeof(std::uint32_t))
+        {
+          detail::ScanChunkPointers<std::uint32_t>(
+            chunk, data, alignment, ranges, out);
+        }
+        else
+        {
+          detail::ScanChunkPointers<std::uint64_t>(
+            chunk, data, alignment, ranges, out);
+        }
+      },
+      [&](std::size_t /*i*/, std::vector<detail::PointerMapEntry>&& out) {
+        if (!out.empty())
+        {
+          entries.insert(std::end(entries), std::begin(out), std::end(out));
+          runs.push_back(entries.size());
+        }
+      });
+
+    while (runs.size() > 2)
+    {
+      std::size_t const num_pairs = (runs.size() - 1) / 2;
+      detail::ParallelForOrdered<bool>(
+        num_pairs,
+        num_threads,
+        [&](std::size_t i, bool& /*out*/) {
+          auto const beg = std::begin(entries);
+          std::inplace_merge(beg + runs[i * 2],
+                             beg + runs[i * 2 + 1],
+                             beg + runs[i * 2 + 2]);
+        },
+        [](std::size_t /*i*/, bool /*out*/) {});
+
+      std::vector<std::size_t> merged;
+      for (std::size_t i = 0; i < runs.size(); i += 2)
+      {
+        merged.push_back(runs[i]);
+      }
+      if (merged.back() != runs.back())
+      {
+        merged.push_back(runs.back());
+      }
+      runs = std::move(merged);
+    }
+
+    return PointerMap{std::move(entries), pointer_size};
+  }
+
+  PointerScanResults FindPaths(PointerMap const& map,
+                               std::vector<PointerScanBase> const& bases,
+                               void const* target) const
+  {
+    if (map.GetPointerSize() != options_.pointer_size)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Pointer size does not match map."});
+    }
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<Root> roots;
+    std::unordered_map<std::uintptr_t, std::uint32_t> visited;
+
+    nodes.push_back(
+      Node{reinterpret_cast<std::uintptr_t>(target), 0, kInvalidIndex});
+    visited.emplace(nodes[0].address, 0);
+
+    std::vector<std::uint32_t> frontier{0};
+    std::size_t const kSliceSize = 0x400;
+    for (std::uint32_t depth = 0;
+         depth < options_.max_depth && !frontier.empty();
+         ++depth)
+    {
+      // Workers only see a copy of the frontier, because the sink appends
+      // to the node list while they're running.
+      std::vector<std::uintptr_t> addresses;
+      addresses.reserve(frontier.size());
+      for (auto const n : frontier)
+      {
+        addresses.push_back(nodes[n].address);
+      }
+
+      std::vector<std::uint32_t> next_frontier;
+      detail::ParallelForOrdered<std::vector<Found>>(
+        (frontier.size() + kSliceSize - 1) / kSliceSize,
+        detail::GetScanThreadCount(options_.scan),
+        [&](std::size_t slice, std::vector<Found>& out) {
+          std::size_t const beg = slice * kSliceSize;
+          std::size_t const end = (std::min)(beg + kSliceSize, frontier.size());
+          for (std::size_t i = beg; i < end; ++i)
+          {
+            std::uintptr_t const address = addresses[i];
+            std::uintptr_t const lowest =
+              address - (std::min)(address, options_.max_offset);
+            auto const range = map.FindPointersTo(lowest, address);
+            for (auto iter = range.first; iter != range.second; ++iter)
+            {
+              out.push_back(
+                Found{iter->location,
+                      frontier[i],
+                      static_cast<std::uint32_t>(address - iter->pointee)});
+            }
+          }
+        },
+        [&](std::size_t /*slice*/, std::vector<Found>&& found) {
+          for (auto const& f : found)
+          {
+            if (detail::FindPointerScanBase(bases, f.location))
+            {
+              roots.push_back(Root{f.location, f.child, f.offset});
+              continue;
+            }
+
+            if (depth + 1 >= options_.max_depth)
+            {
+              continue;
+            }
+
+            auto const iter = visited.find(f.location);
+            std::uint32_t n = 0;
+            if (iter == std::end(visited))
+            {
+              n = static_cast<std::uint32_t>(nodes.size());
+              nodes.push_back(Node{f.location, depth + 1, kInvalidIndex});
+              visited.emplace(f.location, n);
+              next_frontier.push_back(n);
+            }
+            else if (nodes[iter->second].depth == depth + 1)
+            {
+              n = iter->second;
+            }
+            else
+            {
+              // Already reached by a shorter path.
+              continue;
+            }
+
+            edges.push_back(Edge{f.child, f.offset, nodes[n].first_edge});
+            nodes[n].first_edge = static_cast<std::uint32_t>(edges.size() - 1);
+          }
+        });
+
+      frontier = std::move(next_frontier);
+    }
+
+    PointerScanResults results{options_.pointer_size};
+    std::vector<std::uintptr_t> offsets;
+    for (auto const& root : roots)
+    {
+      if (results.GetSize() >= options_.max_results)
+      {
+        break;
+      }
+
+      auto const base = detail::FindPointerScanBase(bases, root.location);
+      PointerPath path;
+      path.module = base->name;
+      path.module_offset = root.location - base->base;
+      offsets.assign(1, root.offset);
+      AddPaths(nodes, edges, root.child, path, offsets, results);
+    }
+
+    return results;
+  }
+
+  // Follows a path in the current run of the target. Returns zero if any of
+  // the pointers along the way can't be read, or the module isn't in bases.
+  std::uintptr_t Resolve(PointerPath const& path,
+                         std::vector<PointerScanBase> const& bases) const
+  {
+    auto const base = std::find_if(
+      std::begin(bases), std::end(bases), [&](PointerScanBase const& b) {
+        return b.name == path.module;
+      });
+    if (base == std::end(bases) || path.offsets.empty())
+    {
+      return 0;
+    }
+
+    std::uintptr_t address = base->base + path.module_offset;
+    try
+    {
+      for (auto const offset : path.offsets)
+      {
+        address =
+          detail::ReadPointer(*source_, address, options_.pointer_size) +
+          offset;
+      }
+    }
+    catch (Error const&)
+    {
+      return 0;
+    }
+
+    return address;
+  }
+
+  // Returns the paths which still lead to the target, e.g. in a new run of
+  // the target process with a different address space layout.
+  PointerScanResults Revalidate(PointerScanResults const& results,
+                                std::vector<PointerScanBase> const& bases,
+                                void const* target) const
+  {
+    PointerScanResults valid{results.GetPointerSize()};
+    for (std::size_t i = 0; i < results.GetSize(); ++i)
+    {
+      auto const path = results.GetPath(i);
+      if (Resolve(path, bases) == reinterpret_cast<std::uintptr_t>(target))
+      {
+        valid.Add(path);
+      }
+    }
+    return valid;
+  }
+
+private:
+  static std::uint32_t const kInvalidIndex =
+    (std::numeric_limits<std::uint32_t>::max)();
+
+  struct Node
+  {
+    std::uintptr_t address;
+    std::uint32_t depth;
+    std::uint32_t first_edge;
+  };
+
+  // An edge from a pointer to the node it points (just before) at.
+  struct Edge
+  {
+    std::uint32_t child;
+    std::uint32_t offset;
+    std::uint32_t next;
+  };
+
+  struct Root
+  {
+    std::uintptr_t location;
+    std::uint32_t child;
+    std::uint32_t offset;
+  };
+
+  struct Found
+  {
+    std::uintptr_t location;
+    std::uint32_t child;
+    std::uint32_t offset;
+  };
+
+  void AddPaths(std::vector<Node> const& nodes,
+                std::vector<Edge> const& edges,
+                std::uint32_t n,
+                PointerPath& path,
+                std::vector<std::uintptr_t>& offsets,
+                PointerScanResults& results) const
+  {
+    if (results.GetSize() >= options_.max_results)
+    {
+      return;
+    }
+
+    if (!nodes[n].depth)
+    {
+      path.offsets.assign(std::begin(offsets), std::end(offsets));
+      results.Add(path);
+      return;
+    }
+
+    for (auto e = nodes[n].first_edge; e != kInvalidIndex; e = edges[e].next)
+    {
+      offsets.push_back(edges[e].offset);
+      AddPaths(nodes, edges, edges[e].child, path, offsets, results);
+      offsets.pop_back();
+    }
+  }
+
+  MemorySource const* source_;
+  PointerScanOptions options_;
+};
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+// Every module in the process, for use as the bases of a pointer scan.
+inline std::vector<PointerScanBase> GetPointerScanBases(Process const& process)
+{
+  std::vector<PointerScanBase> bases;
+  ModuleList const modules{process};
+  for (auto const& module : modules)
+  {
+    bases.push_back(
+      PointerScanBase{module.GetName(),
+                      reinterpret_cast<std::uintptr_t>(module.GetHandle()),
+                      module.GetSize()});
+  }
+  return bases;
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
@@ -9,14 +9,19 @@
 #include <utility>
 #include <vector>
 
+#include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <windows.h>
 
-#include <hadesmem/config.hpp>
 #include <hadesmem/detail/assert.hpp>
 #include <hadesmem/detail/smart_handle.hpp>
 #include <hadesmem/detail/trace.hpp>
 #include <hadesmem/detail/winapi.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 #include <hadesmem/error.hpp>
+#include <hadesmem/region_cache.hpp>
 
 // TODO: Process should keep track of its access mask (beginning with the least
 // amount of access possible - i.e. PROCESS_QUERY_LIMITED_INFORMATION). When a
@@ -37,6 +42,8 @@
 
 namespace hadesmem
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 class Process
 {
 public:
@@ -47,7 +54,8 @@ public:
 
   Process(Process const& other)
     : handle_{DuplicateHandle(other.id_, other.handle_.GetHandle())},
-      id_{other.id_}
+      id_{other.id_},
+      region_cache_{other.region_cache_}
   {
   }
 
@@ -59,8 +67,10 @@ public:
     return *this;
   }
 
-  Process(Process&& other) noexcept : handle_{std::move(other.handle_)},
-                                      id_{other.id_}
+  Process(Process&& other) noexcept
+    : handle_{std::move(other.handle_)},
+      id_{other.id_},
+      region_cache_{std::move(other.region_cache_)}
   {
     other.id_ = 0;
   }
@@ -71,6 +81,7 @@ public:
 
     handle_ = std::move(other.handle_);
     id_ = other.id_;
+    region_cache_ = std::move(other.region_cache_);
 
     other.id_ = 0;
 
@@ -92,6 +103,17 @@ public:
     return handle_.GetHandle();
   }
 
+  // Opt-in. Copies of a Process share the same cache. Pass nullptr to detach.
+  void SetRegionCache(std::shared_ptr<RegionCache> region_cache) noexcept
+  {
+    region_cache_ = std::move(region_cache);
+  }
+
+  RegionCache* GetRegionCache() const noexcept
+  {
+    return region_cache_.get();
+  }
+
   void Cleanup()
   {
     if (id_ != ::GetCurrentProcessId())
@@ -104,6 +126,7 @@ public:
     }
 
     id_ = 0;
+    region_cache_.reset();
   }
 
 private:
@@ -155,8 +178,37 @@ private:
 
   detail::SmartHandle handle_;
   DWORD id_;
+  std::shared_ptr<RegionCache> region_cache_;
+};
+
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+// Outside of Windows a Process is currently just an identifier. It allows the
+// components which can operate on data in our own address space (e.g. PeLib
+// with PeFileBacking::kBuffer) to keep the same interface on all platforms.
+class Process
+{
+public:
+  explicit Process(DWORD id) noexcept : id_{id}
+  {
+  }
+
+  DWORD GetId() const noexcept
+  {
+    return id_;
+  }
+
+  void Cleanup() noexcept
+  {
+    id_ = 0;
+  }
+
+private:
+  DWORD id_;
 };
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 inline bool operator==(Process const& lhs, Process const& rhs) noexcept
 {
   return lhs.GetId() == rhs.GetId();
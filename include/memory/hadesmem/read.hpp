@@ -5,6 +5,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iterator>
 #include <memory>
@@ -15,13 +16,16 @@
 #include <windows.h>
 
 #include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/find_terminator.hpp>
 #include <hadesmem/detail/protect_guard.hpp>
 #include <hadesmem/detail/query_region.hpp>
+#include <hadesmem/detail/read_batch.hpp>
 #include <hadesmem/detail/read_impl.hpp>
 #include <hadesmem/detail/static_assert.hpp>
 #include <hadesmem/detail/type_traits.hpp>
 #include <hadesmem/error.hpp>
 #include <hadesmem/protect.hpp>
+#include <hadesmem/region_cache.hpp>
 
 namespace hadesmem
 {
@@ -32,6 +36,9 @@ template <typename T> struct ReadStringTraits
   // 4KB default chunk size
   static std::size_t const kChunkLen = 0x1000;
 };
+
+// Upper limit for the geometric chunk growth in ReadStringEx.
+std::size_t const kReadStringMaxChunkBytes = 0x40000;
 }
 
 template <typename T> inline T Read(Process const& process, PVOID address)
@@ -41,6 +48,14 @@ template <typename T> inline T Read(Process const& process, PVOID address)
   return detail::ReadImpl<T>(process, address);
 }
 
+template <typename T>
+inline T ReadEx(Process const& process, PVOID address, std::uint32_t flags)
+{
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+  return detail::ReadImpl<T>(process, address, flags);
+}
+
 template <typename T> inline T ReadUnsafe(Process const& process, PVOID address)
 {
   HADESMEM_DETAIL_ASSERT(address != nullptr);
@@ -97,12 +112,23 @@ void ReadStringEx(Process const& process,
 
   HADESMEM_DETAIL_ASSERT(chunk_len != 0);
 
+  // Most strings are short, so the first read stops at the end of the page
+  // (or chunk_len, whichever comes first). Every following read doubles in
+  // size so that long strings still only take a handful of reads. Chunks are
+  // clipped to page boundaries where possible so that we don't touch pages
+  // past the one containing the terminator.
+  std::size_t const page_size = detail::GetPageSize();
+  std::size_t chunk_len_bytes = chunk_len * sizeof(T);
+  std::vector<T> buf;
+
   for (;;)
   {
-    detail::ProtectGuard protect_guard{
-      process, address, detail::ProtectGuardType::kRead};
-
+    // Construct the guard from the region info rather than the address, so
+    // we only query once per region. The guard is a no-op if the region is
+    // already readable.
     MEMORY_BASIC_INFORMATION const mbi = detail::Query(process, address);
+    detail::ProtectGuard protect_guard{
+      process, mbi, detail::ProtectGuardType::kRead};
     PVOID const region_next_real =
       static_cast<PBYTE>(mbi.BaseAddress) + mbi.RegionSize;
     void* const region_next = upper_bound
@@ -112,25 +138,37 @@ void ReadStringEx(Process const& process,
     T* cur = static_cast<T*>(address);
     while (cur + 1 <= region_next)
     {
-      std::size_t const len_to_end = reinterpret_cast<DWORD_PTR>(region_next) -
-                                     reinterpret_cast<DWORD_PTR>(cur);
-      std::size_t const buf_len_bytes =
-        (std::min)(chunk_len * sizeof(T), len_to_end);
-      std::size_t const buf_len = buf_len_bytes / sizeof(T);
+      auto const cur_addr = reinterpret_cast<DWORD_PTR>(cur);
+      std::size_t const len_to_end =
+        reinterpret_cast<DWORD_PTR>(region_next) - cur_addr;
+      DWORD_PTR chunk_end =
+        cur_addr + (std::min)(chunk_len_bytes, len_to_end);
+      DWORD_PTR const chunk_end_page = chunk_end & ~(page_size - 1);
+      if (chunk_end_page >= cur_addr + sizeof(T))
+      {
+        chunk_end = chunk_end_page;
+      }
+      std::size_t const buf_len = (chunk_end - cur_addr) / sizeof(T);
 
-      std::vector<T> buf(buf_len);
-      detail::ReadUnchecked(process, cur, buf.data(), buf.size() * sizeof(T));
+      buf.resize(buf_len);
+      detail::ReadUnchecked(process, cur, buf.data(), buf_len * sizeof(T));
 
-      auto const iter = std::find(std::begin(buf), std::end(buf), T());
-      std::copy(std::begin(buf), iter, data);
+      auto const iter =
+        detail::FindTerminator(buf.data(), buf.data() + buf_len);
+      std::copy(buf.data(), iter, data);
 
-      if (iter != std::end(buf) || region_next == upper_bound)
+      if (iter != buf.data() + buf_len)
       {
         protect_guard.Restore();
         return;
       }
 
       cur += buf_len;
+      if (chunk_len_bytes < detail::kReadStringMaxChunkBytes)
+      {
+        chunk_len_bytes =
+          (std::min)(chunk_len_bytes * 2, detail::kReadStringMaxChunkBytes);
+      }
     }
 
     address = region_next;
@@ -184,7 +222,7 @@ template <typename T, typename OutputIterator>
 void ReadString(Process const& process, PVOID address, OutputIterator data)
 {
   return ReadStringEx<T>(
-    process, address, data, detail::ReadStringTraits<T>::kChunkLen);
+    process, address, data, detail::ReadStringTraits<T>::kChunkLen, nullptr);
 }
 
 template <typename T,
@@ -265,4 +303,37 @@ inline void ReadVector(Process const& process,
 
   return ReadVectorEx<T>(process, address, count, out, ReadFlags::kNone);
 }
+
+// Performs many small reads at once. Requests which are adjacent, or within
+// merge_gap bytes of each other in the same region, are coalesced into a
+// single read and then scattered back out to their destinations. If a merged
+// read fails its requests are retried individually, so the semantics are the
+// same as calling ReadImpl for each request. Returns the number of reads
+// actually performed.
+inline std::size_t
+  ReadBatch(Process const& process,
+            ReadRequest const* requests,
+            std::size_t count,
+            std::size_t merge_gap = detail::kReadBatchDefaultMergeGap,
+            std::uint32_t flags = ReadFlags::kNone)
+{
+  return detail::ReadBatchImpl(
+    requests,
+    count,
+    merge_gap,
+    [&](void* address, void* data, std::size_t len) {
+      detail::ReadImpl(process, address, data, len, flags);
+    },
+    [&](void const* address) { return detail::Query(process, address); });
+}
+
+inline std::size_t
+  ReadBatch(Process const& process,
+            std::vector<ReadRequest> const& requests,
+            std::size_t merge_gap = detail::kReadBatchDefaultMergeGap,
+            std::uint32_t flags = ReadFlags::kNone)
+{
+  return ReadBatch(
+    process, requests.data(), requests.size(), merge_gap, flags);
+}
 }
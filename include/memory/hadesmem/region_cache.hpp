@@ -0,0 +1,225 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <windows.h>
+
+#include <hadesmem/detail/winapi.hpp>
+#else // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <unistd.h>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include <hadesmem/detail/assert.hpp>
+
+// TODO: Optionally bound the number of cached entries. In practice the number
+// of regions in a process is small enough (low thousands) that it hasn't been
+// necessary yet.
+
+// TODO: Investigate subscribing to some sort of change notification (e.g. a
+// driver callback or hooking the relevant APIs in the target) so we can
+// invalidate precisely rather than relying on the user to start a new epoch.
+
+namespace hadesmem
+{
+namespace detail
+{
+inline std::size_t GetPageSize()
+{
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  return GetSystemInfo().dwPageSize;
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+}
+
+// Caches the results of VirtualQueryEx for a single process so that repeated
+// reads and writes to the same regions don't each pay for a syscall. Once
+// attached to a Process (see Process::SetRegionCache) it is consulted by
+// detail::Query, and therefore by Read, Write, ProtectGuard, etc.
+//
+// Changes made through hadesmem (Protect, Alloc, Free) and failed reads/writes
+// invalidate the affected ranges automatically. Changes made by the target
+// itself or by anyone else are not detected, so the user is responsible for
+// calling NewEpoch (or Invalidate) at appropriate points, such as after
+// resuming the target.
+//
+// Thread-safe. The underlying query is performed without holding the lock.
+class RegionCache
+{
+public:
+  RegionCache() : RegionCache{detail::GetPageSize()}
+  {
+  }
+
+  explicit RegionCache(std::size_t page_size) : page_size_{page_size}
+  {
+    HADESMEM_DETAIL_ASSERT(page_size_ && !(page_size_ & (page_size_ - 1)));
+  }
+
+  RegionCache(RegionCache const& other) = delete;
+
+  RegionCache& operator=(RegionCache const& other) = delete;
+
+  // QueryFunc must be callable as MEMORY_BASIC_INFORMATION(LPCVOID) and have
+  // the same semantics as VirtualQueryEx. It is only called on a cache miss.
+  template <typename QueryFunc>
+  MEMORY_BASIC_INFORMATION Query(LPCVOID address, QueryFunc query)
+  {
+    std::uint64_t generation = 0;
+
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+
+      MEMORY_BASIC_INFORMATION mbi;
+      if (LookupUnlocked(address, mbi))
+      {
+        ++hits_;
+        return mbi;
+      }
+
+      ++misses_;
+      generation = generation_;
+    }
+
+    MEMORY_BASIC_INFORMATION const mbi = query(address);
+
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+
+      // Discard the result if there was an invalidation while we were
+      // querying, because it may have been computed before the change.
+      if (generation == generation_)
+      {
+        InsertUnlocked(mbi);
+      }
+    }
+
+    return mbi;
+  }
+
+  void Invalidate()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    regions_.clear();
+    ++generation_;
+  }
+
+  void Invalidate(LPCVOID address, std::size_t size)
+  {
+    auto const beg = reinterpret_cast<std::uintptr_t>(address);
+    auto const end = beg + (size ? size : 1);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    EraseOverlappingUnlocked(beg, end < beg ? UINTPTR_MAX : end);
+    ++generation_;
+  }
+
+  // Drops all cached data. Intended to be called whenever the target may have
+  // changed its address space (e.g. once per 'frame' of a scan or after the
+  // target has been resumed).
+  void NewEpoch()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    regions_.clear();
+    ++generation_;
+    ++epoch_;
+  }
+
+  std::uint64_t GetEpoch() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return epoch_;
+  }
+
+  std::uint64_t GetHits() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return hits_;
+  }
+
+  std::uint64_t GetMisses() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return misses_;
+  }
+
+  std::size_t GetSize() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return regions_.size();
+  }
+
+private:
+  struct Entry
+  {
+    std::uintptr_t base;
+    MEMORY_BASIC_INFORMATION mbi;
+  };
+
+  bool LookupUnlocked(LPCVOID address, MEMORY_BASIC_INFORMATION& mbi) const
+  {
+    auto const addr = reinterpret_cast<std::uintptr_t>(address);
+
+    // Entries are keyed by the end of the region, so the first entry with an
+    // end past the address is the only one which can contain it.
+    auto const iter = regions_.upper_bound(addr);
+    if (iter == std::end(regions_) || iter->second.base > addr)
+    {
+      return false;
+    }
+
+    // Mimic VirtualQueryEx, which reports the region starting from the page
+    // containing the address rather than from the start of the region.
+    auto const page = addr & ~(static_cast<std::uintptr_t>(page_size_) - 1);
+    auto const base = page > iter->second.base ? page : iter->second.base;
+    mbi = iter->second.mbi;
+    mbi.BaseAddress = reinterpret_cast<PVOID>(base);
+    mbi.RegionSize = static_cast<SIZE_T>(iter->first - base);
+    return true;
+  }
+
+  void InsertUnlocked(MEMORY_BASIC_INFORMATION const& mbi)
+  {
+    auto const beg = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+    auto const end = beg + mbi.RegionSize;
+    if (end <= beg)
+    {
+      return;
+    }
+
+    EraseOverlappingUnlocked(beg, end);
+    regions_[end] = Entry{beg, mbi};
+  }
+
+  void EraseOverlappingUnlocked(std::uintptr_t beg, std::uintptr_t end)
+  {
+    auto iter = regions_.upper_bound(beg);
+    while (iter != std::end(regions_) && iter->second.base < end)
+    {
+      iter = regions_.erase(iter);
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::size_t page_size_;
+  std::map<std::uintptr_t, Entry> regions_;
+  std::uint64_t generation_{};
+  std::uint64_t epoch_{};
+  std::uint64_t hits_{};
+  std::uint64_t misses_{};
+};
+}
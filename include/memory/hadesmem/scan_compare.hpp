@@ -0,0 +1,46 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <hadesmem/config.hpp>
+
+namespace hadesmem
+{
+enum class ScanCompareType
+{
+  kEqual,
+  kNotEqual,
+  kLess,
+  kGreater,
+  // In [value, upper].
+  kBetween,
+  // Within epsilon of value. Intended for floating point types, where exact
+  // comparisons rarely find anything useful.
+  kApprox
+};
+
+enum class ScanEpsilonType
+{
+  // |x - value| <= epsilon.
+  kAbsolute,
+  // |x - value| <= epsilon * max(|x|, |value|). Scales with the magnitude of
+  // the values, so e.g. 1e-5 works equally well for coordinates and for
+  // health.
+  kRelative
+};
+
+// A comparison against every value in the scanned memory. NaN never
+// compares equal, less, greater, between or approximately equal to anything
+// (and is always not equal).
+template <typename T> struct ScanCompare
+{
+  ScanCompareType type{ScanCompareType::kEqual};
+  T value{};
+  // Only used by kBetween.
+  T upper{};
+  // Only used by kApprox.
+  T epsilon{};
+  ScanEpsilonType epsilon_type{ScanEpsilonType::kAbsolute};
+};
+}
@@ -0,0 +1,261 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/compare_kernels.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/scan_compare.hpp>
+
+namespace hadesmem
+{
+enum class ScanGroupOrder
+{
+  // The values may be in any order.
+  kAny,
+  // The values must be in the order they were added, e.g. the fields of a
+  // struct.
+  kOrdered
+};
+
+struct ScanGroupMatch
+{
+  // Lowest address of the group.
+  void* address;
+  // Address of each value, in the order they were added to the group.
+  std::vector<void*> values;
+};
+
+namespace detail
+{
+struct ScanGroupValue
+{
+  std::size_t size;
+  std::size_t alignment;
+  // Compares count values, stride bytes apart, and sets a bit in the mask
+  // for each one which matches (see CompareValues).
+  std::function<void(std::uint8_t const* data,
+                     std::size_t count,
+                     std::size_t stride,
+                     std::uint64_t* mask)>
+    compare;
+};
+}
+
+// A set of values which must all be found within a window of memory, e.g.
+// several known fields of a struct. See Scanner::GroupScan.
+class ScanGroup
+{
+public:
+  explicit ScanGroup(std::size_t window,
+                     ScanGroupOrder order = ScanGroupOrder::kAny)
+    : window_{window}, order_{order}
+  {
+  }
+
+  template <typename T> ScanGroup& Add(T value)
+  {
+    ScanCompare<T> cmp;
+    cmp.value = value;
+    return Add(cmp);
+  }
+
+  // Values may also be any other comparison, e.g. a float within an epsilon
+  // or an integer within a range.
+  template <typename T> ScanGroup& Add(ScanCompare<T> const& cmp)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    values_.push_back(detail::ScanGroupValue{
+      sizeof(T),
+      alignof(T),
+      [cmp](std::uint8_t const* data,
+            std::size_t count,
+            std::size_t stride,
+            std::uint64_t* mask) {
+        detail::CompareValues(data, count, stride, cmp, mask);
+      }});
+    return *this;
+  }
+
+  std::size_t GetWindow() const noexcept
+  {
+    return window_;
+  }
+
+  ScanGroupOrder GetOrder() const noexcept
+  {
+    return order_;
+  }
+
+  std::vector<detail::ScanGroupValue> const& GetValues() const noexcept
+  {
+    return values_;
+  }
+
+private:
+  std::size_t window_;
+  ScanGroupOrder order_;
+  std::vector<detail::ScanGroupValue> values_;
+};
+
+namespace detail
+{
+// Appends the offset of every match for the value which starts in [beg,
+// last) of data (at the given alignment, relative to address). The whole of
+// a value starting at last - 1 must be readable.
+inline void FindScanGroupValue(ScanGroupValue const& value,
+                               std::size_t alignment,
+                               std::uintptr_t address,
+                               std::uint8_t const* data,
+                               std::size_t beg,
+                               std::size_t last,
+                               std::vector<std::size_t>& out,
+                               std::vector<std::uint64_t>& mask)
+{
+  HADESMEM_DETAIL_ASSERT(alignment != 0);
+
+  std::size_t const rem = (address + beg) % alignment;
+  std::size_t const first = beg + (rem ? alignment - rem : 0);
+  if (first >= last)
+  {
+    return;
+  }
+
+  std::size_t const count = (last - first + alignment - 1) / alignment;
+  mask.resize(GetCompareMaskWords(count));
+  value.compare(data + first, count, alignment, mask.data());
+  for (std::size_t w = 0; w < mask.size(); ++w)
+  {
+    for (std::uint64_t m = mask[w]; m; m &= m - 1)
+    {
+      out.push_back(first + (w * 64 + CountTrailingZeros64(m)) * alignment);
+    }
+  }
+}
+
+// Places the rest of a group around an anchor with a depth first search over
+// the candidates for each value. Values with the fewest candidates are
+// placed first, and every placement narrows the range the remaining values
+// can be in, so in practice very little of the search space is visited.
+class ScanGroupMatcher
+{
+public:
+  ScanGroupMatcher(ScanGroup const& group,
+                   std::size_t anchor,
+                   std::vector<std::vector<std::size_t>> const& candidates)
+    : values_(group.GetValues()),
+      window_{group.GetWindow()},
+      ordered_{group.GetOrder() == ScanGroupOrder::kOrdered},
+      anchor_{anchor},
+      candidates_(candidates),
+      offsets_(values_.size())
+  {
+    for (std::size_t i = 0; i < values_.size(); ++i)
+    {
+      if (i != anchor_)
+      {
+        search_order_.push_back(i);
+      }
+    }
+    std::stable_sort(
+      std::begin(search_order_),
+      std::end(search_order_),
+      [&](std::size_t a, std::size_t b) {
+        return candidates_[a].size() < candidates_[b].size();
+      });
+  }
+
+  // On success the offset of each value is available from GetOffsets.
+  bool Match(std::size_t anchor_offset)
+  {
+    offsets_[anchor_] = anchor_offset;
+    return Match(0, anchor_offset, anchor_offset + values_[anchor_].size);
+  }
+
+  std::vector<std::size_t> const& GetOffsets() const noexcept
+  {
+    return offsets_;
+  }
+
+private:
+  // The placed values span [lo, hi).
+  bool Match(std::size_t depth, std::size_t lo, std::size_t hi)
+  {
+    if (depth == search_order_.size())
+    {
+      return true;
+    }
+
+    std::size_t const index = search_order_[depth];
+    std::size_t const size = values_[index].size;
+    auto const& candidates = candidates_[index];
+    std::size_t const min_offset = hi > window_ ? hi - window_ : 0;
+    for (auto iter = std::lower_bound(
+           std::begin(candidates), std::end(candidates), min_offset);
+         iter != std::end(candidates) && *iter + size <= lo + window_;
+         ++iter)
+    {
+      if (CanPlace(depth, index, *iter))
+      {
+        offsets_[index] = *iter;
+        if (Match(depth + 1,
+                  (std::min)(lo, *iter),
+                  (std::max)(hi, *iter + size)))
+        {
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Values may not overlap, and must be in order if the group is ordered.
+  bool CanPlace(std::size_t depth, std::size_t index, std::size_t offset) const
+  {
+    std::size_t const end = offset + values_[index].size;
+    auto const check = [&](std::size_t other) {
+      std::size_t const other_beg = offsets_[other];
+      std::size_t const other_end = other_beg + values_[other].size;
+      if (ordered_)
+      {
+        return other < index ? other_end <= offset : end <= other_beg;
+      }
+      return other_end <= offset || end <= other_beg;
+    };
+
+    if (!check(anchor_))
+    {
+      return false;
+    }
+    for (std::size_t i = 0; i < depth; ++i)
+    {
+      if (!check(search_order_[i]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<ScanGroupValue> const& values_;
+  std::size_t window_;
+  bool ordered_;
+  std::size_t anchor_;
+  std::vector<std::vector<std::size_t>> const& candidates_;
+  std::vector<std::size_t> search_order_;
+  std::vector<std::size_t> offsets_;
+};
+}
+}
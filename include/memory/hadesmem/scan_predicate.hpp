@@ -0,0 +1,111 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+
+namespace hadesmem
+{
+// A run of consecutive values passed to a batch predicate (see
+// Scanner::ScanIfBatch). Mirrors the parts of std::span that a predicate
+// needs.
+template <typename T> class ScanSpan
+{
+public:
+  ScanSpan(T* data, std::size_t size) noexcept : data_{data}, size_{size}
+  {
+  }
+
+  T* data() const noexcept
+  {
+    return data_;
+  }
+
+  std::size_t size() const noexcept
+  {
+    return size_;
+  }
+
+  T* begin() const noexcept
+  {
+    return data_;
+  }
+
+  T* end() const noexcept
+  {
+    return data_ + size_;
+  }
+
+  T& operator[](std::size_t i) const noexcept
+  {
+    HADESMEM_DETAIL_ASSERT(i < size_);
+    return data_[i];
+  }
+
+private:
+  T* data_;
+  std::size_t size_;
+};
+
+// One bit per value of a ScanSpan, set by a batch predicate for each value
+// which matches. Every bit is clear when the predicate is called, and the
+// words can be written directly (e.g. from a movemask), in which case bits
+// past the end of the span are ignored.
+class ScanBitmask
+{
+public:
+  ScanBitmask(std::uint64_t* words, std::size_t size) noexcept
+    : words_{words}, size_{size}
+  {
+  }
+
+  void Set(std::size_t i) noexcept
+  {
+    HADESMEM_DETAIL_ASSERT(i < size_);
+    words_[i / 64] |= 1ULL << (i % 64);
+  }
+
+  bool Test(std::size_t i) const noexcept
+  {
+    HADESMEM_DETAIL_ASSERT(i < size_);
+    return !!(words_[i / 64] & (1ULL << (i % 64)));
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return size_;
+  }
+
+  std::uint64_t* GetWords() const noexcept
+  {
+    return words_;
+  }
+
+  std::size_t GetNumWords() const noexcept
+  {
+    return (size_ + 63) / 64;
+  }
+
+private:
+  std::uint64_t* words_;
+  std::size_t size_;
+};
+
+namespace detail
+{
+// Number of values passed to each call of a batch predicate.
+std::size_t const kScanBatchSize = 0x1000;
+
+// Marks a predicate as a batch predicate, so that the scan functions pick
+// the batch overloads.
+template <typename Pred> struct ScanBatchPredicate
+{
+  Pred pred;
+};
+}
+}
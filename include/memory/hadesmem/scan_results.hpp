@@ -0,0 +1,491 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/mapped_file.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/error.hpp>
+
+namespace hadesmem
+{
+// How a next scan compares the current value at each previous result (or
+// each snapshotted value).
+enum class ScanNextType
+{
+  // Equal to the value passed to the scan.
+  kEqual,
+  // Not equal to the previous value.
+  kChanged,
+  // Equal to the previous value.
+  kUnchanged,
+  // Greater than the previous value.
+  kIncreased,
+  // Less than the previous value.
+  kDecreased,
+  // Exactly the value passed to the scan more than the previous value.
+  kIncreasedBy,
+  // Exactly the value passed to the scan less than the previous value.
+  kDecreasedBy
+};
+
+namespace detail
+{
+template <typename T>
+bool CompareScanNext(ScanNextType type, T cur, T prev, T value) noexcept
+{
+  switch (type)
+  {
+  case ScanNextType::kEqual:
+    return cur == value;
+  case ScanNextType::kChanged:
+    return cur != prev;
+  case ScanNextType::kUnchanged:
+    return cur == prev;
+  case ScanNextType::kIncreased:
+    return cur > prev;
+  case ScanNextType::kDecreased:
+    return cur < prev;
+  case ScanNextType::kIncreasedBy:
+    return cur == static_cast<T>(prev + value);
+  case ScanNextType::kDecreasedBy:
+    return cur == static_cast<T>(prev - value);
+  default:
+    HADESMEM_DETAIL_ASSERT(false);
+    return false;
+  }
+}
+
+// How the addresses of the matches in a block are stored. All addresses are
+// stored as slot indices, where slot N is at base + N * alignment.
+enum class ScanBlockEncoding : std::uint8_t
+{
+  // One bit per slot. Best for dense blocks with scattered matches.
+  kBitmap,
+  // Varint delta from the previous match. Best for sparse blocks.
+  kDelta,
+  // Varint (gap, length) pairs for runs of consecutive slots. Best for long
+  // runs (e.g. a scan for zero over freshly allocated memory).
+  kRanges
+};
+
+struct ScanBlockFlags
+{
+  enum : std::uint8_t
+  {
+    kNone = 0,
+    // Every match has the same value, so it's only stored once.
+    kUniformValue = 1 << 0
+  };
+};
+
+struct ScanBlockHeader
+{
+  std::uintptr_t base;
+  std::uint64_t offset;
+  std::uint32_t size;
+  std::uint32_t num_slots;
+  std::uint32_t count;
+  ScanBlockEncoding encoding;
+  std::uint8_t flags;
+};
+
+// An encoded block which hasn't been added to a set yet.
+struct ScanBlock
+{
+  ScanBlockHeader header;
+  std::vector<std::uint8_t> data;
+};
+
+inline std::size_t GetVarintSize(std::uint64_t value) noexcept
+{
+  std::size_t size = 1;
+  while (value >= 0x80)
+  {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+inline void PutVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+inline std::uint64_t GetVarint(std::uint8_t const*& p) noexcept
+{
+  std::uint64_t value = 0;
+  for (unsigned int shift = 0;; shift += 7)
+  {
+    std::uint8_t const b = *p++;
+    value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+    if (!(b & 0x80))
+    {
+      return value;
+    }
+  }
+}
+
+// Encodes the matches in a block. Slots must be sorted, unique and less than
+// num_slots. If value_size is non-zero, values must point to an array of
+// slots.size() values of that size, in the same order as the slots. The
+// smallest of the three address encodings is chosen.
+inline ScanBlock EncodeScanBlock(std::uintptr_t base,
+                                 std::uint32_t num_slots,
+                                 std::vector<std::uint32_t> const& slots,
+                                 void const* values,
+                                 std::size_t value_size)
+{
+  HADESMEM_DETAIL_ASSERT(value_size ? values != nullptr || slots.empty()
+                                    : true);
+
+  std::size_t const bitmap_size = (num_slots + 7) / 8;
+  std::size_t delta_size = 0;
+  std::size_t ranges_size = 0;
+  std::uint32_t prev = 0;
+  for (std::size_t i = 0; i < slots.size();)
+  {
+    std::size_t j = i + 1;
+    while (j < slots.size() && slots[j] == slots[j - 1] + 1)
+    {
+      ++j;
+    }
+    ranges_size += GetVarintSize(slots[i] - prev) + GetVarintSize(j - i);
+    for (std::size_t k = i; k < j; ++k)
+    {
+      delta_size += GetVarintSize(slots[k] - (k ? slots[k - 1] : 0));
+    }
+    prev = slots[j - 1] + 1;
+    i = j;
+  }
+
+  ScanBlock block{};
+  block.header.base = base;
+  block.header.num_slots = num_slots;
+  block.header.count = static_cast<std::uint32_t>(slots.size());
+
+  auto& out = block.data;
+  if (ranges_size <= delta_size && ranges_size <= bitmap_size)
+  {
+    block.header.encoding = ScanBlockEncoding::kRanges;
+    out.reserve(ranges_size);
+    prev = 0;
+    for (std::size_t i = 0; i < slots.size();)
+    {
+      std::size_t j = i + 1;
+      while (j < slots.size() && slots[j] == slots[j - 1] + 1)
+      {
+        ++j;
+      }
+      PutVarint(out, slots[i] - prev);
+      PutVarint(out, j - i);
+      prev = slots[j - 1] + 1;
+      i = j;
+    }
+  }
+  else if (delta_size <= bitmap_size)
+  {
+    block.header.encoding = ScanBlockEncoding::kDelta;
+    out.reserve(delta_size);
+    for (std::size_t k = 0; k < slots.size(); ++k)
+    {
+      PutVarint(out, slots[k] - (k ? slots[k - 1] : 0));
+    }
+  }
+  else
+  {
+    block.header.encoding = ScanBlockEncoding::kBitmap;
+    out.resize(bitmap_size);
+    for (auto const slot : slots)
+    {
+      out[slot / 8] |= static_cast<std::uint8_t>(1 << (slot % 8));
+    }
+  }
+
+  if (value_size && !slots.empty())
+  {
+    auto const v = static_cast<std::uint8_t const*>(values);
+    bool uniform = true;
+    for (std::size_t k = 1; k < slots.size() && uniform; ++k)
+    {
+      uniform = !std::memcmp(v, v + k * value_size, value_size);
+    }
+    if (uniform)
+    {
+      block.header.flags |= ScanBlockFlags::kUniformValue;
+      out.insert(std::end(out), v, v + value_size);
+    }
+    else
+    {
+      out.insert(std::end(out), v, v + slots.size() * value_size);
+    }
+  }
+
+  block.header.size = static_cast<std::uint32_t>(out.size());
+  return block;
+}
+
+// Calls func(std::uint32_t slot, void const* value) for each match in the
+// block, in ascending order. The value is null if the set has no values.
+template <typename Func>
+void DecodeScanBlock(ScanBlockHeader const& header,
+                     std::uint8_t const* data,
+                     std::size_t value_size,
+                     Func func)
+{
+  if (!header.count)
+  {
+    return;
+  }
+
+  bool const uniform = !!(header.flags & ScanBlockFlags::kUniformValue);
+  std::size_t const values_size =
+    value_size ? (uniform ? value_size : header.count * value_size) : 0;
+  std::uint8_t const* const values = data + header.size - values_size;
+  auto const get_value = [&](std::size_t k) -> void const* {
+    return value_size ? values + (uniform ? 0 : k * value_size) : nullptr;
+  };
+
+  std::size_t k = 0;
+  std::uint8_t const* p = data;
+  switch (header.encoding)
+  {
+  case ScanBlockEncoding::kBitmap:
+    for (std::uint32_t i = 0; i < (header.num_slots + 7) / 8; ++i)
+    {
+      for (std::uint32_t b = data[i]; b; b &= b - 1)
+      {
+        func(i * 8 + CountTrailingZeros(b), get_value(k++));
+      }
+    }
+    break;
+
+  case ScanBlockEncoding::kDelta:
+  {
+    std::uint32_t slot = 0;
+    for (; k < header.count;)
+    {
+      slot += static_cast<std::uint32_t>(GetVarint(p));
+      func(slot, get_value(k++));
+    }
+    break;
+  }
+
+  case ScanBlockEncoding::kRanges:
+  {
+    std::uint32_t slot = 0;
+    while (k < header.count)
+    {
+      slot += static_cast<std::uint32_t>(GetVarint(p));
+      auto const len = static_cast<std::uint32_t>(GetVarint(p));
+      for (std::uint32_t i = 0; i < len; ++i)
+      {
+        func(slot++, get_value(k++));
+      }
+    }
+    break;
+  }
+
+  default:
+    HADESMEM_DETAIL_ASSERT(false);
+  }
+}
+}
+
+// The results of a scan (see Scanner), stored compactly enough that a first
+// scan with hundreds of millions of matches doesn't exhaust RAM.
+//
+// Matches are stored in blocks (one per scanned chunk), and each block picks
+// whichever of a bitmap, a delta encoded list or a list of ranges is smallest.
+// Optionally the value at each match is stored too, which is what allows a
+// later scan to compare against it (e.g. 'changed' or 'increased'). Once the
+// encoded data exceeds the memory budget it is moved to a memory mapped
+// temporary file, and further blocks are appended there.
+//
+// Sets are move only. Keeping the set from each pass around is enough to
+// provide scan history and undo.
+class ScanResultSet
+{
+public:
+  static std::size_t const kDefaultBudget = 0x10000000;
+
+  explicit ScanResultSet(std::size_t alignment = 1,
+                         std::size_t value_size = 0,
+                         std::size_t budget = kDefaultBudget)
+    : alignment_{alignment}, value_size_{value_size}, budget_{budget}
+  {
+    HADESMEM_DETAIL_ASSERT(alignment_ != 0);
+  }
+
+  ScanResultSet(ScanResultSet const& other) = delete;
+
+  ScanResultSet& operator=(ScanResultSet const& other) = delete;
+
+  ScanResultSet(ScanResultSet&& other) = default;
+
+  ScanResultSet& operator=(ScanResultSet&& other) = default;
+
+  std::size_t GetAlignment() const noexcept
+  {
+    return alignment_;
+  }
+
+  std::size_t GetValueSize() const noexcept
+  {
+    return value_size_;
+  }
+
+  std::uint64_t GetCount() const noexcept
+  {
+    return count_;
+  }
+
+  bool IsEmpty() const noexcept
+  {
+    return !count_;
+  }
+
+  // Size of the encoded addresses and values, excluding the block index.
+  std::uint64_t GetStorageSize() const noexcept
+  {
+    return used_;
+  }
+
+  bool IsSpilled() const noexcept
+  {
+    return !!file_;
+  }
+
+  std::vector<detail::ScanBlockHeader> const& GetBlocks() const noexcept
+  {
+    return blocks_;
+  }
+
+  std::uint8_t const* GetBlockData(detail::ScanBlockHeader const& header) const
+    noexcept
+  {
+    return GetStorage() + header.offset;
+  }
+
+  // Blocks must be appended in ascending order of address, and must not
+  // overlap.
+  void Append(detail::ScanBlock&& block)
+  {
+    if (!block.header.count)
+    {
+      return;
+    }
+
+    HADESMEM_DETAIL_ASSERT(blocks_.empty() ||
+                           block.header.base > blocks_.back().base);
+
+    std::size_t const size = block.data.size();
+    Reserve(used_ + size);
+    std::memcpy(GetStorage() + used_, block.data.data(), size);
+
+    block.header.offset = used_;
+    blocks_.push_back(block.header);
+    used_ += size;
+    count_ += block.header.count;
+  }
+
+  // Calls func(void* address, void const* value) for each match in
+  // ascending order of address, without materializing the whole set. The
+  // value is null if the set has no values.
+  template <typename Func> void ForEach(Func func) const
+  {
+    for (auto const& header : blocks_)
+    {
+      detail::DecodeScanBlock(
+        header,
+        GetBlockData(header),
+        value_size_,
+        [&](std::uint32_t slot, void const* value) {
+          func(reinterpret_cast<void*>(header.base + slot * alignment_),
+               value);
+        });
+    }
+  }
+
+  // Only suitable for small sets.
+  std::vector<void*> GetAddresses() const
+  {
+    std::vector<void*> addresses;
+    addresses.reserve(static_cast<std::size_t>(count_));
+    ForEach(
+      [&](void* address, void const* /*value*/) {
+        addresses.push_back(address);
+      });
+    return addresses;
+  }
+
+private:
+  std::uint8_t* GetStorage() const noexcept
+  {
+    return file_ ? file_->GetData()
+                 : const_cast<std::uint8_t*>(memory_.data());
+  }
+
+  void Reserve(std::uint64_t size)
+  {
+    if (!file_ && size <= budget_)
+    {
+      if (memory_.size() < size)
+      {
+        auto const new_size = (std::min)(
+          (std::max)(size, used_ * 2), static_cast<std::uint64_t>(budget_));
+        memory_.resize(static_cast<std::size_t>(new_size));
+      }
+      return;
+    }
+
+    if (file_ && file_->GetSize() >= size)
+    {
+      return;
+    }
+
+    auto const new_size =
+      static_cast<std::size_t>((std::max)(size, used_ * 2));
+    if (!file_)
+    {
+      file_ = std::make_unique<detail::MappedFile>(new_size);
+      if (used_)
+      {
+        std::memcpy(file_->GetData(), memory_.data(),
+                    static_cast<std::size_t>(used_));
+      }
+      std::vector<std::uint8_t>().swap(memory_);
+    }
+    else
+    {
+      file_->Resize(new_size);
+    }
+  }
+
+  std::size_t alignment_;
+  std::size_t value_size_;
+  std::size_t budget_;
+  std::uint64_t count_{0};
+  std::uint64_t used_{0};
+  std::vector<detail::ScanBlockHeader> blocks_;
+  std::vector<std::uint8_t> memory_;
+  std::unique_ptr<detail::MappedFile> file_;
+};
+}
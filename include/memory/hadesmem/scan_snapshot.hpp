@@ -0,0 +1,324 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/mapped_file.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/scan_results.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Granularity of everything stored in the snapshot file, so that data which
+// is never written (chunks which couldn't be read, masks which were never
+// needed) stays a hole in the sparse file.
+std::size_t const kScanSnapshotAlignment = 0x1000;
+
+struct ScanSnapshotChunk
+{
+  std::uintptr_t address;
+  std::size_t read_len;
+  // Address of the first slot (the first aligned value in the chunk).
+  std::uintptr_t base;
+  std::uint32_t num_slots;
+  std::uint64_t data_offset;
+  std::uint64_t mask_offset;
+  // Number of slots which are still candidates.
+  std::uint64_t count;
+  // Every slot is a candidate, and the mask has never been written.
+  bool full;
+};
+
+inline std::uint64_t AlignScanSnapshotOffset(std::uint64_t offset) noexcept
+{
+  return (offset + kScanSnapshotAlignment - 1) &
+         ~static_cast<std::uint64_t>(kScanSnapshotAlignment - 1);
+}
+
+inline std::size_t GetScanSnapshotMaskWords(std::uint32_t num_slots) noexcept
+{
+  return (static_cast<std::size_t>(num_slots) + 63) / 64;
+}
+
+inline unsigned int PopCount(std::uint64_t v) noexcept
+{
+  v = v - ((v >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<unsigned int>((v * 0x0101010101010101ULL) >> 56);
+}
+
+// Compares the live copy of a chunk against the snapshot one mask word (64
+// slots) at a time. All 64 slots of a word are compared unconditionally and
+// the result is ANDed with the mask, so the inner loop has no branches
+// (other than the comparison itself) and can be vectorized. Words with no
+// candidates left are skipped entirely.
+template <typename T, typename Pred>
+std::uint64_t CompareScanSnapshotChunk(ScanSnapshotChunk const& chunk,
+                                       std::uint8_t const* live,
+                                       std::uint8_t const* snap,
+                                       std::uint64_t* mask,
+                                       std::size_t alignment,
+                                       Pred pred)
+{
+  std::size_t const first = chunk.base - chunk.address;
+  std::size_t const num_words = GetScanSnapshotMaskWords(chunk.num_slots);
+  std::uint64_t count = 0;
+  for (std::size_t w = 0; w < num_words; ++w)
+  {
+    std::size_t const num_bits =
+      (std::min)(static_cast<std::size_t>(chunk.num_slots) - w * 64,
+                 static_cast<std::size_t>(64));
+    std::uint64_t m = chunk.full ? ~0ULL : mask[w];
+    if (num_bits < 64)
+    {
+      m &= (1ULL << num_bits) - 1;
+    }
+
+    if (m)
+    {
+      std::uint64_t bits = 0;
+      std::size_t offset = first + w * 64 * alignment;
+      for (std::size_t b = 0; b < num_bits; ++b, offset += alignment)
+      {
+        T cur;
+        T prev;
+        std::memcpy(&cur, live + offset, sizeof(T));
+        std::memcpy(&prev, snap + offset, sizeof(T));
+        bits |= static_cast<std::uint64_t>(pred(cur, prev)) << b;
+      }
+      m &= bits;
+    }
+
+    mask[w] = m;
+    count += PopCount(m);
+  }
+
+  return count;
+}
+
+template <typename T>
+std::uint64_t CompareScanSnapshotChunk(ScanSnapshotChunk const& chunk,
+                                       std::uint8_t const* live,
+                                       std::uint8_t const* snap,
+                                       std::uint64_t* mask,
+                                       std::size_t alignment,
+                                       ScanNextType type,
+                                       T value)
+{
+  // Dispatched once per chunk rather than once per value.
+  switch (type)
+  {
+  case ScanNextType::kEqual:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [value](T cur, T /*prev*/) {
+        return cur == value;
+      });
+  case ScanNextType::kChanged:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [](T cur, T prev) {
+        return cur != prev;
+      });
+  case ScanNextType::kUnchanged:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [](T cur, T prev) {
+        return cur == prev;
+      });
+  case ScanNextType::kIncreased:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [](T cur, T prev) {
+        return cur > prev;
+      });
+  case ScanNextType::kDecreased:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [](T cur, T prev) {
+        return cur < prev;
+      });
+  default:
+    return CompareScanSnapshotChunk<T>(
+      chunk, live, snap, mask, alignment, [type, value](T cur, T prev) {
+        return CompareScanNext(type, cur, prev, value);
+      });
+  }
+}
+}
+
+// A copy of every scanned chunk (see Scanner::TakeSnapshot), used for scans
+// where the initial value is unknown. Each pass (see Scanner::NextScan)
+// compares the live memory against the snapshot, clears the candidate bit of
+// each value which doesn't pass, and then overwrites the snapshot with the
+// live memory so that the next pass compares against the latest values.
+//
+// The snapshot is stored in a sparse memory mapped temporary file rather than
+// in RAM, because the selected regions of a 64-bit target can easily be
+// larger than the physical memory of the machine. Candidate masks are only
+// written once a chunk has been compared, and chunks which no longer have any
+// candidates are never touched again.
+//
+// Once the number of candidates is small enough, use ToResultSet and continue
+// with the ScanResultSet overload of NextScan.
+class ScanSnapshot
+{
+public:
+  ScanSnapshot(std::vector<detail::ScanSnapshotChunk> chunks,
+               std::size_t alignment,
+               std::size_t value_size)
+    : chunks_(std::move(chunks)),
+      alignment_{alignment},
+      value_size_{value_size}
+  {
+    HADESMEM_DETAIL_ASSERT(alignment_ != 0);
+
+    std::uint64_t offset = 0;
+    for (auto& chunk : chunks_)
+    {
+      chunk.data_offset = offset;
+      offset = detail::AlignScanSnapshotOffset(offset + chunk.read_len);
+      chunk.mask_offset = offset;
+      offset = detail::AlignScanSnapshotOffset(
+        offset + detail::GetScanSnapshotMaskWords(chunk.num_slots) *
+                   sizeof(std::uint64_t));
+    }
+
+    if (offset != static_cast<std::size_t>(offset))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Snapshot is too large to be mapped."});
+    }
+
+    file_ = std::make_unique<detail::MappedFile>(
+      static_cast<std::size_t>(offset), true);
+  }
+
+  ScanSnapshot(ScanSnapshot const& other) = delete;
+
+  ScanSnapshot& operator=(ScanSnapshot const& other) = delete;
+
+  ScanSnapshot(ScanSnapshot&& other) = default;
+
+  ScanSnapshot& operator=(ScanSnapshot&& other) = default;
+
+  std::size_t GetAlignment() const noexcept
+  {
+    return alignment_;
+  }
+
+  std::size_t GetValueSize() const noexcept
+  {
+    return value_size_;
+  }
+
+  // Number of values which are still candidates.
+  std::uint64_t GetCount() const noexcept
+  {
+    std::uint64_t count = 0;
+    for (auto const& chunk : chunks_)
+    {
+      count += chunk.count;
+    }
+    return count;
+  }
+
+  // Size of the snapshot file. Most of it may be sparse.
+  std::size_t GetFileSize() const noexcept
+  {
+    return file_->GetSize();
+  }
+
+  std::vector<detail::ScanSnapshotChunk>& GetChunks() noexcept
+  {
+    return chunks_;
+  }
+
+  std::vector<detail::ScanSnapshotChunk> const& GetChunks() const noexcept
+  {
+    return chunks_;
+  }
+
+  std::uint8_t* GetChunkData(detail::ScanSnapshotChunk const& chunk) const
+    noexcept
+  {
+    return file_->GetData() + chunk.data_offset;
+  }
+
+  std::uint64_t* GetChunkMask(detail::ScanSnapshotChunk const& chunk) const
+    noexcept
+  {
+    return reinterpret_cast<std::uint64_t*>(file_->GetData() +
+                                            chunk.mask_offset);
+  }
+
+  // Calls func(void* address, void const* value) for each candidate in
+  // ascending order of address. The value is the one from the last pass.
+  template <typename Func> void ForEach(Func func) const
+  {
+    for (auto const& chunk : chunks_)
+    {
+      ForEachInChunk(chunk, func);
+    }
+  }
+
+  ScanResultSet
+    ToResultSet(std::size_t budget = ScanResultSet::kDefaultBudget) const
+  {
+    ScanResultSet results{alignment_, value_size_, budget};
+    std::vector<std::uint32_t> slots;
+    std::vector<std::uint8_t> values;
+    for (auto const& chunk : chunks_)
+    {
+      slots.clear();
+      values.clear();
+      ForEachInChunk(chunk, [&](void* address, void const* value) {
+        slots.push_back(static_cast<std::uint32_t>(
+          (reinterpret_cast<std::uintptr_t>(address) - chunk.base) /
+          alignment_));
+        auto const v = static_cast<std::uint8_t const*>(value);
+        values.insert(std::end(values), v, v + value_size_);
+      });
+      results.Append(detail::EncodeScanBlock(
+        chunk.base, chunk.num_slots, slots, values.data(), value_size_));
+    }
+    return results;
+  }
+
+private:
+  template <typename Func>
+  void ForEachInChunk(detail::ScanSnapshotChunk const& chunk,
+                      Func&& func) const
+  {
+    if (!chunk.count)
+    {
+      return;
+    }
+
+    std::uint8_t const* const data =
+      GetChunkData(chunk) + (chunk.base - chunk.address);
+    std::uint64_t const* const mask = GetChunkMask(chunk);
+    for (std::uint32_t slot = 0; slot < chunk.num_slots; ++slot)
+    {
+      if (chunk.full || (mask[slot / 64] >> (slot % 64)) & 1)
+      {
+        func(reinterpret_cast<void*>(chunk.base + slot * alignment_),
+             data + slot * alignment_);
+      }
+    }
+  }
+
+  std::vector<detail::ScanSnapshotChunk> chunks_;
+  std::size_t alignment_;
+  std::size_t value_size_;
+  std::unique_ptr<detail::MappedFile> file_;
+};
+}
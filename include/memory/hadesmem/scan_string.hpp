@@ -0,0 +1,128 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/regex_dfa.hpp>
+#include <hadesmem/error.hpp>
+
+namespace hadesmem
+{
+struct ScanStringOptions
+{
+  // Matches letters in either case (see detail::kCaseFoldRanges for the
+  // scripts which are covered).
+  bool case_insensitive{false};
+  // Treats the pattern as a regex (see detail/regex_dfa.hpp for the syntax)
+  // rather than as a literal string.
+  bool regex{false};
+  // Longest regex match which can be found, in bytes. Longer matches are
+  // missed. The length of a literal string is known, so this is ignored.
+  std::size_t max_length{0x400};
+};
+
+// A string to scan for, compiled to a DFA once up front (see
+// Scanner::ScanString). Narrow patterns are UTF-8 and search for UTF-8 text,
+// wide patterns search for UTF-16 text.
+class ScanStringPattern
+{
+public:
+  explicit ScanStringPattern(std::string const& pattern,
+                             ScanStringOptions const& options = {})
+    : ScanStringPattern{detail::DecodeUtf8(pattern), false, options}
+  {
+  }
+
+  explicit ScanStringPattern(std::wstring const& pattern,
+                             ScanStringOptions const& options = {})
+    : ScanStringPattern{detail::DecodeWide(pattern), true, options}
+  {
+  }
+
+  bool IsWide() const noexcept
+  {
+    return wide_;
+  }
+
+  // Minimum alignment of a match, in bytes.
+  std::size_t GetAlignment() const noexcept
+  {
+    return wide_ ? 2 : 1;
+  }
+
+  std::size_t GetMaxLength() const noexcept
+  {
+    return max_length_;
+  }
+
+  // Finds the end of every match.
+  detail::Dfa const& GetForwardDfa() const noexcept
+  {
+    return forward_;
+  }
+
+  // Finds where a match starts, reading backwards from its end.
+  detail::Dfa const& GetReverseDfa() const noexcept
+  {
+    return reverse_;
+  }
+
+private:
+  ScanStringPattern(std::vector<std::uint32_t> const& pattern,
+                    bool wide,
+                    ScanStringOptions const& options)
+    : wide_{wide}
+  {
+    if (pattern.empty())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Pattern is empty."});
+    }
+
+    auto const root =
+      options.regex
+        ? detail::RegexParser{pattern, options.case_insensitive}.Parse()
+        : detail::MakeRegexLiteralNode(pattern, options.case_insensitive);
+    if (options.regex)
+    {
+      max_length_ = options.max_length;
+    }
+    else
+    {
+      max_length_ = 0;
+      for (auto const& child : root.children)
+      {
+        max_length_ += detail::GetMaxEncodedLength(child.set, wide_);
+      }
+    }
+
+    detail::NfaBuilder forward{wide_, false};
+    std::size_t const forward_start = forward.NewState();
+    std::size_t const forward_accept = forward.Build(root, forward_start);
+    forward_ = detail::BuildDfa(
+      forward.GetStates(), forward_start, forward_accept, true);
+    if (forward_.IsAccept(forward_.start))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Pattern matches an empty string."});
+    }
+
+    detail::NfaBuilder reverse{wide_, true};
+    std::size_t const reverse_start = reverse.NewState();
+    std::size_t const reverse_accept = reverse.Build(root, reverse_start);
+    reverse_ = detail::BuildDfa(
+      reverse.GetStates(), reverse_start, reverse_accept, false);
+  }
+
+  bool wide_;
+  std::size_t max_length_;
+  detail::Dfa forward_;
+  detail::Dfa reverse_;
+};
+}
@@ -3,26 +3,1430 @@
 
 #pragma once
 
-// TODO: Implement this.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/compare_kernels.hpp>
+#include <hadesmem/detail/read_batch.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/thread_pool.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scan_compare.hpp>
+#include <hadesmem/scan_group.hpp>
+#include <hadesmem/scan_predicate.hpp>
+#include <hadesmem/scan_results.hpp>
+#include <hadesmem/scan_snapshot.hpp>
+#include <hadesmem/scan_string.hpp>
+
 // TODO: Use process reflection on Windows 7 + for scanning while process is suspended. (RtlCreateProcessReflection)
 //  Requires extra privileges though Make it optional?
 //  There's newer and better APIs available on W8+. PSS? ProcDump supports them all I think...
 //  PSS doesn't support large pages, so can't be used against e.g.SQL.
 // TODO: Use a file view with a small memory cache rather than consuming large amounts of RAM.
-// TODO: Multi-threaded scanning options.
 // TODO: Wildcard support for vector/string scanning.
-// TODO: Regex support for string scanning.
-// TODO: Memory protection filters(read, write, exec).
-// TODO: Memory type filters(private, mapped, image).
 // TODO: Support pausing target while scanning.
 // TODO: Support injected scanning.
-// TODO: Configurable scan buffer size.
-// TODO: Pointer scanner.
-// TODO: Unknown value scan.
-// TODO: Progressive scan filtering based on either value or criteria.
-// TODO: Scan history and undo.
-// TODO: Support case insensitive string scanning.
 // TODO: Binary scanning.
-// TODO: Custom scanning via user supplied predicate.
-// TODO: Improved floating point support (configurable or 'smart' epsilon).
-// TODO: Group search support.
+// TODO: Values which straddle two regions are never found, even if the
+// regions are adjacent. Is this worth supporting?
+
+namespace hadesmem
+{
+struct ScanTypeFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    kPrivate = 1 << 0,
+    kMapped = 1 << 1,
+    kImage = 1 << 2,
+    kAll = kPrivate | kMapped | kImage
+  };
+};
+
+// Readability is always required, so it isn't a flag.
+struct ScanProtectFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    kWrite = 1 << 0,
+    kExecute = 1 << 1,
+    kCopyOnWrite = 1 << 2
+  };
+};
+
+struct ScanOptions
+{
+  // Region types to scan.
+  std::uint32_t types{ScanTypeFlags::kAll};
+  // Regions must have all of the protection attributes in protect_required
+  // and none of the ones in protect_excluded. E.g. a typical memory editor
+  // scan for game state is protect_required = kWrite, protect_excluded =
+  // kExecute | kCopyOnWrite.
+  std::uint32_t protect_required{ScanProtectFlags::kNone};
+  std::uint32_t protect_excluded{ScanProtectFlags::kNone};
+  // Only scan [start, end). Null means unbounded.
+  void const* start{nullptr};
+  void const* end{nullptr};
+  // Only match values at addresses which are a multiple of this. Zero means
+  // the natural alignment of the type, and one means no alignment at all.
+  std::size_t alignment{0};
+  // Regions are split into chunks of this size which are scanned in
+  // parallel. This is also the size of each worker's scan buffer.
+  std::size_t chunk_size{0x100000};
+  // Zero means one per hardware thread.
+  std::size_t num_threads{0};
+};
+
+namespace detail
+{
+struct ScanChunk
+{
+  std::uintptr_t address;
+  // Values may only start within the first len bytes, but read_len bytes are
+  // read so that values which straddle the end of the chunk are found.
+  std::size_t len;
+  std::size_t read_len;
+};
+
+inline std::uint32_t GetScanProtectFlags(DWORD protect) noexcept
+{
+  std::uint32_t flags = ScanProtectFlags::kNone;
+  if (!!(protect & (PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE |
+                    PAGE_EXECUTE_WRITECOPY)))
+  {
+    flags |= ScanProtectFlags::kWrite;
+  }
+  if (!!(protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE |
+                    PAGE_EXECUTE_WRITECOPY)))
+  {
+    flags |= ScanProtectFlags::kExecute;
+  }
+  if (!!(protect & (PAGE_WRITECOPY | PAGE_EXECUTE_WRITECOPY)))
+  {
+    flags |= ScanProtectFlags::kCopyOnWrite;
+  }
+  return flags;
+}
+
+inline std::uint32_t GetScanTypeFlags(DWORD type) noexcept
+{
+  switch (type)
+  {
+  case MEM_PRIVATE:
+    return ScanTypeFlags::kPrivate;
+  case MEM_MAPPED:
+    return ScanTypeFlags::kMapped;
+  case MEM_IMAGE:
+    return ScanTypeFlags::kImage;
+  default:
+    return ScanTypeFlags::kNone;
+  }
+}
+
+inline bool IsRegionScannable(MEMORY_BASIC_INFORMATION const& mbi,
+                              ScanOptions const& options) noexcept
+{
+  if (!IsRegionReadable(mbi))
+  {
+    return false;
+  }
+
+  if (!(GetScanTypeFlags(mbi.Type) & options.types))
+  {
+    return false;
+  }
+
+  auto const protect = GetScanProtectFlags(mbi.Protect);
+  return (protect & options.protect_required) == options.protect_required &&
+         !(protect & options.protect_excluded);
+}
+
+// Filters the regions and clips them to [options.start, options.end).
+inline std::vector<MEMORY_BASIC_INFORMATION>
+  FilterScanRegions(std::vector<MEMORY_BASIC_INFORMATION> const& regions,
+                    ScanOptions const& options)
+{
+  auto const start = reinterpret_cast<std::uintptr_t>(options.start);
+  auto const end = options.end ? reinterpret_cast<std::uintptr_t>(options.end)
+                               : UINTPTR_MAX;
+
+  std::vector<MEMORY_BASIC_INFORMATION> filtered;
+  for (auto mbi : regions)
+  {
+    if (!IsRegionScannable(mbi, options))
+    {
+      continue;
+    }
+
+    auto beg = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+    auto region_end = beg + mbi.RegionSize;
+    beg = (std::max)(beg, start);
+    region_end = (std::min)(region_end, end);
+    if (beg >= region_end)
+    {
+      continue;
+    }
+
+    mbi.BaseAddress = reinterpret_cast<PVOID>(beg);
+    mbi.RegionSize = static_cast<SIZE_T>(region_end - beg);
+    filtered.push_back(mbi);
+  }
+
+  return filtered;
+}
+
+// Overlap is the number of bytes past the end of each chunk which must also
+// be read (e.g. sizeof(T) - 1 for a scan for values of type T).
+inline std::vector<ScanChunk>
+  MakeScanChunks(std::vector<MEMORY_BASIC_INFORMATION> const& regions,
+                 std::size_t chunk_size,
+                 std::size_t overlap)
+{
+  HADESMEM_DETAIL_ASSERT(chunk_size != 0);
+
+  std::vector<ScanChunk> chunks;
+  for (auto const& mbi : regions)
+  {
+    auto const beg = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+    auto const end = beg + mbi.RegionSize;
+    for (std::uintptr_t cur = beg; cur < end; cur += chunk_size)
+    {
+      auto const len =
+        static_cast<std::size_t>((std::min)(end - cur, chunk_size));
+      auto const read_len =
+        static_cast<std::size_t>((std::min)(end - cur, len + overlap));
+      chunks.push_back(ScanChunk{cur, len, read_len});
+    }
+  }
+
+  return chunks;
+}
+
+// Base address of each region, for chunk functions which need to know whether
+// a chunk is the first of its region. Sorted, because the regions are.
+inline std::vector<std::uintptr_t>
+  GetScanRegionBases(std::vector<MEMORY_BASIC_INFORMATION> const& regions)
+{
+  std::vector<std::uintptr_t> bases;
+  bases.reserve(regions.size());
+  for (auto const& mbi : regions)
+  {
+    bases.push_back(reinterpret_cast<std::uintptr_t>(mbi.BaseAddress));
+  }
+  return bases;
+}
+
+inline std::size_t GetScanThreadCount(ScanOptions const& options) noexcept
+{
+  return GetParallelThreadCount(options.num_threads);
+}
+
+// Hands out reusable buffers so that each thread only needs one, no matter
+// how many work items it ends up processing.
+class ScanBufferPool
+{
+public:
+  std::vector<std::uint8_t> Acquire(std::size_t size)
+  {
+    std::vector<std::uint8_t> buf;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (!buffers_.empty())
+      {
+        buf = std::move(buffers_.back());
+        buffers_.pop_back();
+      }
+    }
+    if (buf.size() < size)
+    {
+      buf.resize(size);
+    }
+    return buf;
+  }
+
+  void Release(std::vector<std::uint8_t>&& buf)
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    buffers_.push_back(std::move(buf));
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<std::vector<std::uint8_t>> buffers_;
+};
+
+// Reads each chunk and passes it to func, which must be callable as
+// void(ScanChunk const& chunk, std::uint8_t const* data, Result& out), then
+// passes the results to sink in the same order as the chunks (see
+// ParallelForOrdered). Chunks which can't be read (e.g. because the region was
+// freed or reprotected since it was enumerated) are skipped, and their result
+// is left default constructed. Anything thrown by func is rethrown.
+template <typename Result,
+          typename MemorySource,
+          typename ChunkFunc,
+          typename SinkFunc>
+void ParallelScanChunksOrdered(MemorySource const& source,
+                               std::vector<ScanChunk> const& chunks,
+                               std::size_t num_threads,
+                               ChunkFunc func,
+                               SinkFunc sink)
+{
+  std::size_t max_read_len = 0;
+  for (auto const& chunk : chunks)
+  {
+    max_read_len = (std::max)(max_read_len, chunk.read_len);
+  }
+
+  ScanBufferPool buffers;
+  auto const work = [&](std::size_t i, Result& out) {
+    auto buf = buffers.Acquire(max_read_len);
+    bool read_ok = true;
+    try
+    {
+      source.Read(reinterpret_cast<void*>(chunks[i].address),
+                  buf.data(),
+                  chunks[i].read_len);
+    }
+    catch (Error const&)
+    {
+      read_ok = false;
+    }
+    if (read_ok)
+    {
+      func(chunks[i], buf.data(), out);
+    }
+    buffers.Release(std::move(buf));
+  };
+
+  ParallelForOrdered<Result>(chunks.size(), num_threads, work, sink);
+}
+
+// As above, but returns all of the results at once.
+template <typename Result, typename MemorySource, typename ChunkFunc>
+std::vector<Result> ParallelScanChunks(MemorySource const& source,
+                                       std::vector<ScanChunk> const& chunks,
+                                       std::size_t num_threads,
+                                       ChunkFunc func)
+{
+  std::vector<Result> results(chunks.size());
+  ParallelScanChunksOrdered<Result>(
+    source, chunks, num_threads, func, [&](std::size_t i, Result&& result) {
+      results[i] = std::move(result);
+    });
+  return results;
+}
+
+// Appends the address of every value in the chunk (at the given alignment)
+// for which pred returns true.
+template <typename T, typename Pred>
+void ScanChunkValues(ScanChunk const& chunk,
+                     std::uint8_t const* data,
+                     std::size_t alignment,
+                     Pred pred,
+                     std::vector<void*>& out)
+{
+  HADESMEM_DETAIL_ASSERT(alignment != 0);
+
+  if (chunk.read_len < sizeof(T))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  for (std::size_t i = rem ? alignment - rem : 0; i < last; i += alignment)
+  {
+    T value;
+    std::memcpy(&value, data + i, sizeof(T));
+    if (pred(value))
+    {
+      out.push_back(reinterpret_cast<void*>(chunk.address + i));
+    }
+  }
+}
+
+// As above, but encodes the matches as a block for a ScanResultSet (with
+// their values).
+template <typename T, typename Pred>
+void ScanChunkValuesToBlock(ScanChunk const& chunk,
+                            std::uint8_t const* data,
+                            std::size_t alignment,
+                            Pred pred,
+                            ScanBlock& out)
+{
+  HADESMEM_DETAIL_ASSERT(alignment != 0);
+
+  if (chunk.read_len < sizeof(T))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const first = rem ? alignment - rem : 0;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  if (first >= last)
+  {
+    return;
+  }
+
+  std::vector<std::uint32_t> slots;
+  std::vector<T> values;
+  for (std::size_t i = first; i < last; i += alignment)
+  {
+    T value;
+    std::memcpy(&value, data + i, sizeof(T));
+    if (pred(value))
+    {
+      slots.push_back(static_cast<std::uint32_t>((i - first) / alignment));
+      values.push_back(value);
+    }
+  }
+
+  auto const num_slots =
+    static_cast<std::uint32_t>((last - first + alignment - 1) / alignment);
+  out = EncodeScanBlock(
+    chunk.address + first, num_slots, slots, values.data(), sizeof(T));
+}
+
+// Calls pred with the values in the chunk (at the given alignment) a batch at
+// a time, and func(i) with the offset into the chunk of each value it sets
+// the bit for, in ascending order. Packed values are passed to pred straight
+// from the buffer, anything else is gathered into a packed copy first.
+template <typename T, typename Pred, typename Func>
+void ForEachChunkBatchMatch(ScanChunk const& chunk,
+                            std::uint8_t const* data,
+                            std::size_t alignment,
+                            Pred& pred,
+                            Func func)
+{
+  HADESMEM_DETAIL_ASSERT(alignment != 0);
+
+  if (chunk.read_len < sizeof(T))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const first = rem ? alignment - rem : 0;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  if (first >= last)
+  {
+    return;
+  }
+
+  std::size_t const count = (last - first + alignment - 1) / alignment;
+  bool const packed =
+    alignment == sizeof(T) &&
+    reinterpret_cast<std::uintptr_t>(data + first) % alignof(T) == 0;
+  std::vector<T> gathered;
+  std::vector<std::uint64_t> mask(GetCompareMaskWords(kScanBatchSize));
+  for (std::size_t beg = 0; beg < count; beg += kScanBatchSize)
+  {
+    std::size_t const n = (std::min)(kScanBatchSize, count - beg);
+    std::uint8_t const* const batch = data + first + beg * alignment;
+    T const* values = reinterpret_cast<T const*>(batch);
+    if (!packed)
+    {
+      gathered.resize(n);
+      for (std::size_t j = 0; j < n; ++j)
+      {
+        std::memcpy(&gathered[j], batch + j * alignment, sizeof(T));
+      }
+      values = gathered.data();
+    }
+
+    std::fill(std::begin(mask), std::end(mask), 0);
+    ScanBitmask bits{mask.data(), n};
+    pred(ScanSpan<T const>{values, n}, bits);
+
+    std::size_t const num_words = bits.GetNumWords();
+    for (std::size_t w = 0; w < num_words; ++w)
+    {
+      std::uint64_t m = mask[w];
+      if (w + 1 == num_words && n % 64)
+      {
+        m &= (1ULL << (n % 64)) - 1;
+      }
+      for (; m; m &= m - 1)
+      {
+        func(first + (beg + w * 64 + CountTrailingZeros64(m)) * alignment);
+      }
+    }
+  }
+}
+
+template <typename T, typename Pred>
+void ScanChunkValues(ScanChunk const& chunk,
+                     std::uint8_t const* data,
+                     std::size_t alignment,
+                     ScanBatchPredicate<Pred> pred,
+                     std::vector<void*>& out)
+{
+  ForEachChunkBatchMatch<T>(
+    chunk, data, alignment, pred.pred, [&](std::size_t i) {
+      out.push_back(reinterpret_cast<void*>(chunk.address + i));
+    });
+}
+
+template <typename T, typename Pred>
+void ScanChunkValuesToBlock(ScanChunk const& chunk,
+                            std::uint8_t const* data,
+                            std::size_t alignment,
+                            ScanBatchPredicate<Pred> pred,
+                            ScanBlock& out)
+{
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const first = rem ? alignment - rem : 0;
+  std::vector<std::uint32_t> slots;
+  std::vector<T> values;
+  ForEachChunkBatchMatch<T>(
+    chunk, data, alignment, pred.pred, [&](std::size_t i) {
+      T value;
+      std::memcpy(&value, data + i, sizeof(T));
+      slots.push_back(static_cast<std::uint32_t>((i - first) / alignment));
+      values.push_back(value);
+    });
+  if (slots.empty())
+  {
+    return;
+  }
+
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  auto const num_slots =
+    static_cast<std::uint32_t>((last - first + alignment - 1) / alignment);
+  out = EncodeScanBlock(
+    chunk.address + first, num_slots, slots, values.data(), sizeof(T));
+}
+
+// Same as ScanChunkValues, but the values are compared with the vectorized
+// kernels (see compare_kernels.hpp). Calls func(i) with the offset into the
+// chunk of each match, in ascending order.
+template <typename T, typename Func>
+void CompareChunkValues(ScanChunk const& chunk,
+                        std::uint8_t const* data,
+                        std::size_t alignment,
+                        ScanCompare<T> const& cmp,
+                        Func func)
+{
+  HADESMEM_DETAIL_ASSERT(alignment != 0);
+
+  if (chunk.read_len < sizeof(T))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const first = rem ? alignment - rem : 0;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  if (first >= last)
+  {
+    return;
+  }
+
+  std::size_t const count = (last - first + alignment - 1) / alignment;
+  std::vector<std::uint64_t> mask(GetCompareMaskWords(count));
+  CompareValues(data + first, count, alignment, cmp, mask.data());
+  for (std::size_t w = 0; w < mask.size(); ++w)
+  {
+    for (std::uint64_t m = mask[w]; m; m &= m - 1)
+    {
+      func(first + (w * 64 + CountTrailingZeros64(m)) * alignment);
+    }
+  }
+}
+
+template <typename T>
+void ScanChunkCompare(ScanChunk const& chunk,
+                      std::uint8_t const* data,
+                      std::size_t alignment,
+                      ScanCompare<T> const& cmp,
+                      std::vector<void*>& out)
+{
+  CompareChunkValues(chunk, data, alignment, cmp, [&](std::size_t i) {
+    out.push_back(reinterpret_cast<void*>(chunk.address + i));
+  });
+}
+
+template <typename T>
+void ScanChunkCompareToBlock(ScanChunk const& chunk,
+                             std::uint8_t const* data,
+                             std::size_t alignment,
+                             ScanCompare<T> const& cmp,
+                             ScanBlock& out)
+{
+  if (chunk.read_len < sizeof(T))
+  {
+    return;
+  }
+
+  std::size_t const rem = chunk.address % alignment;
+  std::size_t const first = rem ? alignment - rem : 0;
+  std::size_t const last =
+    (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+  if (first >= last)
+  {
+    return;
+  }
+
+  std::vector<std::uint32_t> slots;
+  std::vector<T> values;
+  CompareChunkValues(chunk, data, alignment, cmp, [&](std::size_t i) {
+    T value;
+    std::memcpy(&value, data + i, sizeof(T));
+    slots.push_back(static_cast<std::uint32_t>((i - first) / alignment));
+    values.push_back(value);
+  });
+
+  auto const num_slots =
+    static_cast<std::uint32_t>((last - first + alignment - 1) / alignment);
+  out = EncodeScanBlock(
+    chunk.address + first, num_slots, slots, values.data(), sizeof(T));
+}
+
+// Chunks sampled to choose the anchor of a group scan, and the number of
+// bytes read from each.
+std::size_t const kScanGroupNumSamples = 8;
+std::size_t const kScanGroupSampleSize = 0x10000;
+
+// Finds every group (see Scanner::GroupScan) whose anchor value starts in
+// the part of the chunk it owns. Chunks overlap by twice the window, and each
+// one owns the anchors which start in [window, len + window) (or [0, len +
+// window) for the first chunk of a region), so that the whole neighbourhood
+// of every anchor it owns has been read.
+inline void ScanChunkGroup(ScanChunk const& chunk,
+                           std::uint8_t const* data,
+                           bool first_in_region,
+                           ScanGroup const& group,
+                           std::vector<std::size_t> const& alignments,
+                           std::size_t anchor,
+                           std::vector<ScanGroupMatch>& out)
+{
+  auto const& values = group.GetValues();
+  std::size_t const window = group.GetWindow();
+  std::size_t const anchor_size = values[anchor].size;
+  if (chunk.read_len < anchor_size)
+  {
+    return;
+  }
+
+  std::size_t const own_beg = first_in_region ? 0 : window;
+  std::size_t const own_end =
+    (std::min)(chunk.len + window, chunk.read_len - anchor_size + 1);
+  std::vector<std::size_t> anchors;
+  std::vector<std::uint64_t> mask;
+  FindScanGroupValue(values[anchor],
+                     alignments[anchor],
+                     chunk.address,
+                     data,
+                     own_beg,
+                     own_end,
+                     anchors,
+                     mask);
+  if (anchors.empty())
+  {
+    return;
+  }
+
+  // Each of the other values is only searched for once per chunk, over the
+  // neighbourhoods of all of the anchors.
+  std::size_t const span_beg = anchors.front() + anchor_size > window
+                                 ? anchors.front() + anchor_size - window
+                                 : 0;
+  std::size_t const span_end =
+    (std::min)(chunk.read_len, anchors.back() + window);
+  std::vector<std::vector<std::size_t>> candidates(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    if (i != anchor && span_end >= values[i].size)
+    {
+      FindScanGroupValue(values[i],
+                         alignments[i],
+                         chunk.address,
+                         data,
+                         span_beg,
+                         span_end - values[i].size + 1,
+                         candidates[i],
+                         mask);
+    }
+  }
+
+  ScanGroupMatcher matcher{group, anchor, candidates};
+  for (auto const offset : anchors)
+  {
+    if (matcher.Match(offset))
+    {
+      auto const& offsets = matcher.GetOffsets();
+      ScanGroupMatch match;
+      match.address = reinterpret_cast<void*>(
+        chunk.address +
+        *std::min_element(std::begin(offsets), std::end(offsets)));
+      for (auto const o : offsets)
+      {
+        match.values.push_back(reinterpret_cast<void*>(chunk.address + o));
+      }
+      out.push_back(std::move(match));
+    }
+  }
+}
+
+// Reads backwards from the end of a match (at end, in data) to find where the
+// longest match ending there starts, looking back at most max_length bytes.
+// Returns kNoStringMatchStart if there is no match with a start at the given
+// alignment.
+std::size_t const kNoStringMatchStart = static_cast<std::size_t>(-1);
+
+inline std::size_t FindStringMatchStart(Dfa const& reverse,
+                                        std::uint8_t const* data,
+                                        std::size_t end,
+                                        std::size_t max_length,
+                                        std::uintptr_t address,
+                                        std::size_t alignment)
+{
+  std::size_t const lim = end > max_length ? end - max_length : 0;
+  std::size_t start = kNoStringMatchStart;
+  std::uint32_t state = reverse.start;
+  for (std::size_t i = end; i > lim; --i)
+  {
+    state = reverse.Next(state, data[i - 1]);
+    if (!state)
+    {
+      break;
+    }
+    if (reverse.IsAccept(state) && (address + i - 1) % alignment == 0)
+    {
+      start = i - 1;
+    }
+  }
+  return start;
+}
+
+// Finds the start of every match of the pattern which ends in the part of
+// the chunk it owns, in a single pass of the pattern's DFA. Chunks overlap by
+// the pattern's maximum length, and each one owns the ends in (max_length,
+// len + max_length] (or from 0 for the first chunk of a region). No match is
+// longer than that, so the DFA has seen the whole of every match it owns by
+// the time it reaches the end, and its state there is the same as if it had
+// carried on from the previous chunk.
+inline void ScanChunkString(ScanChunk const& chunk,
+                            std::uint8_t const* data,
+                            bool first_in_region,
+                            ScanStringPattern const& pattern,
+                            std::size_t alignment,
+                            std::vector<void*>& out)
+{
+  auto const& forward = pattern.GetForwardDfa();
+  auto const& reverse = pattern.GetReverseDfa();
+  std::size_t const max_length = pattern.GetMaxLength();
+  std::size_t const own_beg = first_in_region ? 0 : max_length;
+  std::size_t const own_end =
+    (std::min)(chunk.read_len, chunk.len + max_length);
+
+  std::vector<std::size_t> starts;
+  std::uint32_t state = forward.start;
+  for (std::size_t i = 0; i < own_end; ++i)
+  {
+    state = forward.Next(state, data[i]);
+    if (forward.IsAccept(state) && i >= own_beg)
+    {
+      std::size_t const start = FindStringMatchStart(
+        reverse, data, i + 1, max_length, chunk.address, alignment);
+      // A repeat can end a match at every byte, all with the same start.
+      if (start != kNoStringMatchStart &&
+          (starts.empty() || starts.back() != start))
+      {
+        starts.push_back(start);
+      }
+    }
+  }
+
+  std::sort(std::begin(starts), std::end(starts));
+  starts.erase(std::unique(std::begin(starts), std::end(starts)),
+               std::end(starts));
+  for (auto const start : starts)
+  {
+    out.push_back(reinterpret_cast<void*>(chunk.address + start));
+  }
+}
+
+// Re-reads every match in a block of a previous set and re-encodes the ones
+// which still pass. Matches close enough together in the same region are read
+// at once (see read_batch.hpp), and a group which can't be read is dropped.
+// Regions is the source's region list, which is used to find the region each
+// match is in rather than querying the source (which can be expensive).
+template <typename T, typename MemorySource>
+ScanBlock RescanBlock(MemorySource const& source,
+                      std::vector<MEMORY_BASIC_INFORMATION> const& regions,
+                      ScanResultSet const& prev,
+                      ScanBlockHeader const& header,
+                      ScanNextType type,
+                      T value,
+                      std::vector<std::uint8_t>& buf)
+{
+  std::vector<std::uint32_t> old_slots;
+  std::vector<T> old_values;
+  old_slots.reserve(header.count);
+  old_values.reserve(header.count);
+  DecodeScanBlock(header,
+                  prev.GetBlockData(header),
+                  sizeof(T),
+                  [&](std::uint32_t slot, void const* v) {
+                    T old_value;
+                    std::memcpy(&old_value, v, sizeof(T));
+                    old_slots.push_back(slot);
+                    old_values.push_back(old_value);
+                  });
+
+  std::size_t const alignment = prev.GetAlignment();
+  auto const get_address = [&](std::size_t k) {
+    return header.base + old_slots[k] * alignment;
+  };
+
+  std::vector<std::uint32_t> slots;
+  std::vector<T> values;
+  std::uintptr_t region_beg = 0;
+  std::uintptr_t region_end = 0;
+  auto const query = [&](void const* address) {
+    return QueryRegionList(regions, address);
+  };
+  for (std::size_t k = 0; k < old_slots.size();)
+  {
+    std::uintptr_t const beg = get_address(k);
+    std::uintptr_t end = beg + sizeof(T);
+    std::size_t j = k + 1;
+    for (; j < old_slots.size(); ++j)
+    {
+      std::uintptr_t const next = get_address(j);
+      if (next > end && (next - end > kReadBatchDefaultMergeGap ||
+                         !CanMergeReadGap(
+                           end, next, region_beg, region_end, query)))
+      {
+        break;
+      }
+      end = next + sizeof(T);
+    }
+
+    buf.resize((std::max)(buf.size(), end - beg));
+    try
+    {
+      source.Read(reinterpret_cast<void*>(beg), buf.data(), end - beg);
+    }
+    catch (Error const&)
+    {
+      k = j;
+      continue;
+    }
+
+    for (; k < j; ++k)
+    {
+      T cur;
+      std::memcpy(&cur, buf.data() + (get_address(k) - beg), sizeof(T));
+      if (CompareScanNext(type, cur, old_values[k], value))
+      {
+        slots.push_back(old_slots[k]);
+        values.push_back(cur);
+      }
+    }
+  }
+
+  return EncodeScanBlock(
+    header.base, header.num_slots, slots, values.data(), sizeof(T));
+}
+
+inline std::vector<void*>
+  FlattenScanResults(std::vector<std::vector<void*>> const& results)
+{
+  std::size_t total = 0;
+  for (auto const& r : results)
+  {
+    total += r.size();
+  }
+
+  std::vector<void*> flat;
+  flat.reserve(total);
+  for (auto const& r : results)
+  {
+    flat.insert(std::end(flat), std::begin(r), std::end(r));
+  }
+
+  return flat;
+}
+}
+
+// Scans the address space behind a memory source (see memory_source.hpp) for
+// values, splitting the regions which pass the filters into chunks and
+// scanning those in parallel. Results are sorted by address.
+//
+// For a remote process on Windows use ProcessMemorySource (which enumerates
+// the regions with RegionList). BufferMemorySource and ProcMemorySource allow
+// the same scans to be run against a snapshot or on Linux.
+template <typename MemorySource> class Scanner
+{
+public:
+  explicit Scanner(MemorySource const& source,
+                   ScanOptions const& options = ScanOptions{})
+    : source_{&source}, options_(options)
+  {
+    if (!options_.chunk_size)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Invalid chunk size."});
+    }
+  }
+
+  explicit Scanner(MemorySource const&& source,
+                   ScanOptions const& options = ScanOptions{}) = delete;
+
+  MemorySource const& GetSource() const noexcept
+  {
+    return *source_;
+  }
+
+  ScanOptions const& GetOptions() const noexcept
+  {
+    return options_;
+  }
+
+  // The regions which will be scanned, clipped to the range in the options.
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+    return detail::FilterScanRegions(source_->GetRegions(), options_);
+  }
+
+  // Finds every exact match for a value of an integral or floating point
+  // type. Floating point values are compared with ==, so 0.0 matches -0.0
+  // and NaN never matches.
+  template <typename T> std::vector<void*> ScanExact(T value) const
+  {
+    ScanCompare<T> cmp;
+    cmp.value = value;
+    return Scan(cmp);
+  }
+
+  // Finds every value of an integral or floating point type which passes a
+  // comparison (e.g. a range, or approximately equal to a float). The values
+  // are compared with vectorized kernels.
+  template <typename T> std::vector<void*> Scan(ScanCompare<T> const& cmp) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : alignof(T);
+    auto const chunks = detail::MakeScanChunks(
+      GetRegions(), options_.chunk_size, sizeof(T) - 1);
+    auto const results = detail::ParallelScanChunks<std::vector<void*>>(
+      *source_,
+      chunks,
+      detail::GetScanThreadCount(options_),
+      [&](detail::ScanChunk const& chunk,
+          std::uint8_t const* data,
+          std::vector<void*>& out) {
+        detail::ScanChunkCompare<T>(chunk, data, alignment, cmp, out);
+      });
+    return detail::FlattenScanResults(results);
+  }
+
+  // Same as ScanExact, but the results are returned as a compact set which
+  // also stores the value at each match, for use with NextScan.
+  template <typename T>
+  ScanResultSet FirstScan(T value,
+                          std::size_t budget = ScanResultSet::kDefaultBudget)
+    const
+  {
+    ScanCompare<T> cmp;
+    cmp.value = value;
+    return FirstScan(cmp, budget);
+  }
+
+  template <typename T>
+  ScanResultSet FirstScan(ScanCompare<T> const& cmp,
+                          std::size_t budget = ScanResultSet::kDefaultBudget)
+    const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : alignof(T);
+    auto const chunks = detail::MakeScanChunks(
+      GetRegions(), options_.chunk_size, sizeof(T) - 1);
+    ScanResultSet results{alignment, sizeof(T), budget};
+    detail::ParallelScanChunksOrdered<detail::ScanBlock>(
+      *source_,
+      chunks,
+      detail::GetScanThreadCount(options_),
+      [&](detail::ScanChunk const& chunk,
+          std::uint8_t const* data,
+          detail::ScanBlock& out) {
+        detail::ScanChunkCompareToBlock<T>(chunk, data, alignment, cmp, out);
+      },
+      [&](std::size_t /*i*/, detail::ScanBlock&& block) {
+        results.Append(std::move(block));
+      });
+    return results;
+  }
+
+  // Finds every value of type T (any trivially copyable type, e.g. a struct
+  // with a few known fields) for which pred(T const&) returns true. The
+  // predicate is a template parameter, so it's inlined into the scan loop.
+  // It's called concurrently from every scan thread.
+  template <typename T, typename Pred>
+  std::vector<void*> ScanIf(Pred&& pred) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+
+    return ScanValues<T>(std::forward<Pred>(pred));
+  }
+
+  // Same as ScanIf, but pred(ScanSpan<T const>, ScanBitmask&) is given up to
+  // detail::kScanBatchSize values at a time and sets a bit for each one which
+  // matches, so that it can be vectorized.
+  template <typename T, typename Pred>
+  std::vector<void*> ScanIfBatch(Pred&& pred) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+
+    return ScanValues<T>(detail::ScanBatchPredicate<std::decay_t<Pred>>{
+      std::forward<Pred>(pred)});
+  }
+
+  // Same as ScanIf and ScanIfBatch, but the results are returned as a compact
+  // set for use with NextScan.
+  template <typename T, typename Pred>
+  ScanResultSet FirstScanIf(Pred&& pred,
+                            std::size_t budget = ScanResultSet::kDefaultBudget)
+    const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+
+    return ScanValuesToSet<T>(std::forward<Pred>(pred), budget);
+  }
+
+  template <typename T, typename Pred>
+  ScanResultSet
+    FirstScanIfBatch(Pred&& pred,
+                     std::size_t budget = ScanResultSet::kDefaultBudget) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+
+    return ScanValuesToSet<T>(
+      detail::ScanBatchPredicate<std::decay_t<Pred>>{std::forward<Pred>(pred)},
+      budget);
+  }
+
+  // Narrows down the results of a previous scan by re-reading the value at
+  // each one. Value is only used by kEqual, kIncreasedBy and kDecreasedBy.
+  // The previous set is left untouched, so keeping it around is enough to
+  // undo a scan. Blocks are rescanned in parallel and streamed straight into
+  // the new set.
+  template <typename T>
+  ScanResultSet NextScan(ScanResultSet const& prev,
+                         ScanNextType type,
+                         T value = T(),
+                         std::size_t budget = ScanResultSet::kDefaultBudget)
+    const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    if (prev.GetValueSize() != sizeof(T))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Value size does not match previous scan."});
+    }
+
+    ScanResultSet results{prev.GetAlignment(), sizeof(T), budget};
+    auto const& blocks = prev.GetBlocks();
+    auto const regions = source_->GetRegions();
+    detail::ScanBufferPool buffers;
+    detail::ParallelForOrdered<detail::ScanBlock>(
+      blocks.size(),
+      detail::GetScanThreadCount(options_),
+      [&](std::size_t i, detail::ScanBlock& out) {
+        auto buf = buffers.Acquire(0);
+        out = detail::RescanBlock<T>(
+          *source_, regions, prev, blocks[i], type, value, buf);
+        buffers.Release(std::move(buf));
+      },
+      [&](std::size_t /*i*/, detail::ScanBlock&& block) {
+        results.Append(std::move(block));
+      });
+    return results;
+  }
+
+  // Finds every place where all of the values in a group are within the
+  // group's window of each other, in one pass. The rarest value (estimated
+  // from a sample of the scanned memory) is used as an anchor, and the
+  // others are only searched for around each anchor. Matches are sorted by
+  // address, and there is one for each occurrence of the anchor which fits
+  // a group (the first placement of the other values which is found, trying
+  // lower addresses first). Identical groups are only returned once.
+  std::vector<ScanGroupMatch> GroupScan(ScanGroup const& group) const
+  {
+    auto const& values = group.GetValues();
+    if (values.empty())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                      << ErrorString{"Group is empty."});
+    }
+
+    std::size_t total_size = 0;
+    std::vector<std::size_t> alignments;
+    for (auto const& value : values)
+    {
+      total_size += value.size;
+      alignments.push_back(options_.alignment ? options_.alignment
+                                              : value.alignment);
+    }
+    if (total_size > group.GetWindow())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Window is too small for the group."});
+    }
+
+    auto const regions = GetRegions();
+    auto const region_bases = detail::GetScanRegionBases(regions);
+    auto const chunks = detail::MakeScanChunks(
+      regions, options_.chunk_size, group.GetWindow() * 2);
+    std::size_t const anchor = ChooseGroupAnchor(group, alignments, chunks);
+
+    auto const results =
+      detail::ParallelScanChunks<std::vector<ScanGroupMatch>>(
+        *source_,
+        chunks,
+        detail::GetScanThreadCount(options_),
+        [&](detail::ScanChunk const& chunk,
+            std::uint8_t const* data,
+            std::vector<ScanGroupMatch>& out) {
+          bool const first_in_region = std::binary_search(
+            std::begin(region_bases), std::end(region_bases), chunk.address);
+          detail::ScanChunkGroup(
+            chunk, data, first_in_region, group, alignments, anchor, out);
+        });
+
+    // Sort by the set of addresses in each group (so by the lowest address
+    // first), and drop groups which were found from more than one occurrence
+    // of the anchor. That happens when the anchor's value is in the group more
+    // than once.
+    std::vector<ScanGroupMatch> found;
+    for (auto const& result : results)
+    {
+      found.insert(std::end(found), std::begin(result), std::end(result));
+    }
+    std::vector<std::pair<std::vector<void*>, std::size_t>> keys;
+    for (std::size_t i = 0; i < found.size(); ++i)
+    {
+      auto key = found[i].values;
+      std::sort(std::begin(key), std::end(key));
+      keys.emplace_back(std::move(key), i);
+    }
+    std::sort(std::begin(keys), std::end(keys));
+
+    std::vector<ScanGroupMatch> matches;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+      if (!i || keys[i].first != keys[i - 1].first)
+      {
+        matches.push_back(std::move(found[keys[i].second]));
+      }
+    }
+    return matches;
+  }
+
+  // Finds every string which matches the pattern (see ScanStringPattern).
+  // Returns the address each match starts at, sorted. For a regex, every
+  // byte a match ends at gives the earliest start of a match ending there,
+  // so a repeat like "a+" is found once at the start of a run, not once per
+  // byte of it.
+  std::vector<void*> ScanString(ScanStringPattern const& pattern) const
+  {
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : pattern.GetAlignment();
+    auto const regions = GetRegions();
+    auto const region_bases = detail::GetScanRegionBases(regions);
+    auto const chunks = detail::MakeScanChunks(
+      regions, options_.chunk_size, pattern.GetMaxLength());
+
+    auto results = detail::FlattenScanResults(
+      detail::ParallelScanChunks<std::vector<void*>>(
+        *source_,
+        chunks,
+        detail::GetScanThreadCount(options_),
+        [&](detail::ScanChunk const& chunk,
+            std::uint8_t const* data,
+            std::vector<void*>& out) {
+          bool const first_in_region = std::binary_search(
+            std::begin(region_bases), std::end(region_bases), chunk.address);
+          detail::ScanChunkString(
+            chunk, data, first_in_region, pattern, alignment, out);
+        }));
+
+    // A match which starts in one chunk can also end in the next.
+    std::sort(std::begin(results), std::end(results));
+    results.erase(std::unique(std::begin(results), std::end(results)),
+                  std::end(results));
+    return results;
+  }
+
+  std::vector<void*> ScanString(std::string const& str,
+                                ScanStringOptions const& options = {}) const
+  {
+    return ScanString(ScanStringPattern{str, options});
+  }
+
+  std::vector<void*> ScanString(std::wstring const& str,
+                                ScanStringOptions const& options = {}) const
+  {
+    return ScanString(ScanStringPattern{str, options});
+  }
+
+  // Starts a scan for a value whose initial value is unknown, by copying
+  // every value of type T in the scanned regions to a snapshot (see
+  // ScanSnapshot). Every value starts out as a candidate.
+  template <typename T> ScanSnapshot TakeSnapshot() const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : alignof(T);
+    auto const chunks = detail::MakeScanChunks(
+      GetRegions(), options_.chunk_size, sizeof(T) - 1);
+
+    std::vector<detail::ScanSnapshotChunk> snapshot_chunks;
+    snapshot_chunks.reserve(chunks.size());
+    for (auto const& chunk : chunks)
+    {
+      std::size_t const rem = chunk.address % alignment;
+      std::size_t const first = rem ? alignment - rem : 0;
+      std::size_t const last =
+        chunk.read_len < sizeof(T)
+          ? 0
+          : (std::min)(chunk.len, chunk.read_len - sizeof(T) + 1);
+      detail::ScanSnapshotChunk snapshot_chunk{};
+      snapshot_chunk.address = chunk.address;
+      snapshot_chunk.read_len = chunk.read_len;
+      snapshot_chunk.base = chunk.address + first;
+      snapshot_chunk.num_slots =
+        last > first ? static_cast<std::uint32_t>(
+                         (last - first + alignment - 1) / alignment)
+                     : 0;
+      snapshot_chunks.push_back(snapshot_chunk);
+    }
+
+    ScanSnapshot snapshot{std::move(snapshot_chunks), alignment, sizeof(T)};
+    auto& snapshot_chunks_ref = snapshot.GetChunks();
+    detail::ParallelForOrdered<bool>(
+      snapshot_chunks_ref.size(),
+      detail::GetScanThreadCount(options_),
+      [&](std::size_t i, bool& /*out*/) {
+        auto& chunk = snapshot_chunks_ref[i];
+        try
+        {
+          // Read straight into the file, there's no need for a buffer.
+          source_->Read(reinterpret_cast<void*>(chunk.address),
+                        snapshot.GetChunkData(chunk),
+                        chunk.read_len);
+        }
+        catch (Error const&)
+        {
+          return;
+        }
+        chunk.count = chunk.num_slots;
+        chunk.full = true;
+      },
+      [](std::size_t /*i*/, bool /*result*/) {});
+    return snapshot;
+  }
+
+  // Narrows down the candidates in a snapshot by comparing the live value
+  // at each one against the snapshot, then updates the snapshot in place.
+  // Value is only used by kEqual, kIncreasedBy and kDecreasedBy. Chunks which
+  // can no longer be read lose all of their candidates.
+  template <typename T>
+  void NextScan(ScanSnapshot& snapshot, ScanNextType type, T value = T())
+    const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(std::is_arithmetic<T>::value);
+
+    if (snapshot.GetValueSize() != sizeof(T))
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Value size does not match snapshot."});
+    }
+
+    auto& chunks = snapshot.GetChunks();
+    detail::ScanBufferPool buffers;
+    detail::ParallelForOrdered<bool>(
+      chunks.size(),
+      detail::GetScanThreadCount(options_),
+      [&](std::size_t i, bool& /*out*/) {
+        auto& chunk = chunks[i];
+        if (!chunk.count)
+        {
+          return;
+        }
+
+        auto buf = buffers.Acquire(chunk.read_len);
+        std::uint8_t* const data = snapshot.GetChunkData(chunk);
+        try
+        {
+          source_->Read(
+            reinterpret_cast<void*>(chunk.address), buf.data(), chunk.read_len);
+          chunk.count =
+            detail::CompareScanSnapshotChunk<T>(chunk,
+                                                buf.data(),
+                                                data,
+                                                snapshot.GetChunkMask(chunk),
+                                                snapshot.GetAlignment(),
+                                                type,
+                                                value);
+          std::memcpy(data, buf.data(), chunk.read_len);
+        }
+        catch (Error const&)
+        {
+          chunk.count = 0;
+        }
+        chunk.full = false;
+        buffers.Release(std::move(buf));
+      },
+      [](std::size_t /*i*/, bool /*result*/) {});
+  }
+
+private:
+  // Counts the matches for each value of the group in a few evenly spaced
+  // samples of the chunks, and returns the index of the rarest one. If
+  // nothing could be sampled the largest value is used instead, as wider
+  // values tend to be rarer.
+  std::size_t
+    ChooseGroupAnchor(ScanGroup const& group,
+                      std::vector<std::size_t> const& alignments,
+                      std::vector<detail::ScanChunk> const& chunks) const
+  {
+    auto const& values = group.GetValues();
+    std::vector<std::size_t> hits(values.size());
+    bool sampled = false;
+    std::size_t const num_samples =
+      (std::min)(chunks.size(), detail::kScanGroupNumSamples);
+    std::vector<std::uint8_t> buf;
+    std::vector<std::size_t> offsets;
+    std::vector<std::uint64_t> mask;
+    for (std::size_t i = 0; i < num_samples; ++i)
+    {
+      auto const& chunk = chunks[i * chunks.size() / num_samples];
+      std::size_t const len =
+        (std::min)(chunk.read_len, detail::kScanGroupSampleSize);
+      buf.resize(len);
+      try
+      {
+        source_->Read(reinterpret_cast<void*>(chunk.address), buf.data(), len);
+      }
+      catch (Error const&)
+      {
+        continue;
+      }
+
+      sampled = true;
+      for (std::size_t j = 0; j < values.size(); ++j)
+      {
+        if (len >= values[j].size)
+        {
+          offsets.clear();
+          detail::FindScanGroupValue(values[j],
+                                     alignments[j],
+                                     chunk.address,
+                                     buf.data(),
+                                     0,
+                                     len - values[j].size + 1,
+                                     offsets,
+                                     mask);
+          hits[j] += offsets.size();
+        }
+      }
+    }
+
+    std::size_t anchor = 0;
+    for (std::size_t j = 1; j < values.size(); ++j)
+    {
+      if (sampled ? hits[j] < hits[anchor]
+                  : values[j].size > values[anchor].size)
+      {
+        anchor = j;
+      }
+    }
+    return anchor;
+  }
+
+  template <typename T, typename Pred>
+  std::vector<void*> ScanValues(Pred pred) const
+  {
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : alignof(T);
+    auto const chunks = detail::MakeScanChunks(
+      GetRegions(), options_.chunk_size, sizeof(T) - 1);
+    auto const results = detail::ParallelScanChunks<std::vector<void*>>(
+      *source_,
+      chunks,
+      detail::GetScanThreadCount(options_),
+      [&](detail::ScanChunk const& chunk,
+          std::uint8_t const* data,
+          std::vector<void*>& out) {
+        detail::ScanChunkValues<T>(chunk, data, alignment, pred, out);
+      });
+    return detail::FlattenScanResults(results);
+  }
+
+  template <typename T, typename Pred>
+  ScanResultSet ScanValuesToSet(Pred pred, std::size_t budget) const
+  {
+    std::size_t const alignment =
+      options_.alignment ? options_.alignment : alignof(T);
+    auto const chunks = detail::MakeScanChunks(
+      GetRegions(), options_.chunk_size, sizeof(T) - 1);
+    ScanResultSet results{alignment, sizeof(T), budget};
+    detail::ParallelScanChunksOrdered<detail::ScanBlock>(
+      *source_,
+      chunks,
+      detail::GetScanThreadCount(options_),
+      [&](detail::ScanChunk const& chunk,
+          std::uint8_t const* data,
+          detail::ScanBlock& out) {
+        detail::ScanChunkValuesToBlock<T>(chunk, data, alignment, pred, out);
+      },
+      [&](std::size_t /*i*/, detail::ScanBlock&& block) {
+        results.Append(std::move(block));
+      });
+    return results;
+  }
+
+  MemorySource const* source_;
+  ScanOptions options_;
+};
+
+template <typename T, typename MemorySource, typename Pred>
+std::vector<void*> ScanIf(Scanner<MemorySource> const& scanner, Pred&& pred)
+{
+  return scanner.template ScanIf<T>(std::forward<Pred>(pred));
+}
+
+template <typename T, typename MemorySource, typename Pred>
+std::vector<void*> ScanIfBatch(Scanner<MemorySource> const& scanner,
+                               Pred&& pred)
+{
+  return scanner.template ScanIfBatch<T>(std::forward<Pred>(pred));
+}
+}
@@ -0,0 +1,544 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/spsc_queue.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/detail/write_batch.hpp>
+#include <hadesmem/error.hpp>
+
+namespace hadesmem
+{
+namespace detail
+{
+// Largest value which can be watched or frozen.
+std::size_t const kWatchMaxValueSize = 16;
+
+std::size_t const kWatchPageSize = 0x1000;
+}
+
+typedef std::size_t WatchId;
+
+enum class WatchEventType
+{
+  // The value changed since the last poll.
+  kChanged,
+  // The value could no longer be read (reported once, until a read succeeds
+  // again).
+  kReadFailed,
+  // A frozen value could not be written back (reported once, until a write
+  // succeeds again).
+  kWriteFailed
+};
+
+struct WatchEvent
+{
+  WatchEventType type;
+  WatchId id;
+  void* address;
+  std::size_t size;
+  // Only valid for kChanged.
+  std::uint8_t old_value[detail::kWatchMaxValueSize];
+  std::uint8_t new_value[detail::kWatchMaxValueSize];
+
+  template <typename T> T GetOldValue() const
+  {
+    return GetValue<T>(old_value);
+  }
+
+  template <typename T> T GetNewValue() const
+  {
+    return GetValue<T>(new_value);
+  }
+
+private:
+  template <typename T> T GetValue(std::uint8_t const* value) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_ASSERT(sizeof(T) == size);
+
+    T out;
+    std::memcpy(&out, value, sizeof(T));
+    return out;
+  }
+};
+
+struct WatchListOptions
+{
+  // Time between polls when polling in the background (see Start).
+  std::chrono::milliseconds interval{std::chrono::milliseconds{100}};
+  // Maximum number of pages read by a single poll. Zero means every page. A
+  // long list is polled a slice at a time, round robin, so that no poll takes
+  // much longer than any other.
+  std::size_t max_pages_per_poll{0};
+  // Events which are produced while the queue is full are dropped (and
+  // counted in WatchListStats).
+  std::size_t queue_capacity{0x1000};
+};
+
+struct WatchListStats
+{
+  std::size_t polls;
+  std::size_t reads;
+  std::size_t writes;
+  std::size_t dropped_events;
+};
+
+namespace detail
+{
+struct WatchEntry
+{
+  WatchId id;
+  std::uintptr_t address;
+  std::size_t size;
+  bool frozen;
+  bool has_value;
+  bool read_failed;
+  bool write_failed;
+  std::uint8_t value[kWatchMaxValueSize];
+  std::uint8_t freeze_value[kWatchMaxValueSize];
+  std::function<void(WatchEvent const&)> callback;
+};
+
+// Entries whose values start in the same page, which are polled with a
+// single read of [beg, end).
+struct WatchPage
+{
+  std::uintptr_t beg;
+  std::uintptr_t end;
+  std::vector<WatchEntry*> entries;
+};
+}
+
+// Watches and freezes thousands of values in a memory source (see
+// memory_source.hpp, e.g. ProcessMemorySource for a remote process) at once.
+// Each poll reads every page which holds an entry with a single read,
+// reports the values which changed as events, and writes back any frozen
+// values which differ, merging adjacent ones into a single write.
+//
+// Events are delivered through a lock-free queue, so a UI thread can drain
+// them (PopEvent or DispatchEvents) without ever waiting on a poll in
+// progress. Only one thread may consume events at a time. Entries may be
+// added and removed from any thread.
+template <typename MemorySource> class WatchList
+{
+public:
+  explicit WatchList(MemorySource const& source,
+                     WatchListOptions const& options = WatchListOptions{})
+    : source_{&source}, options_(options), events_{options.queue_capacity}
+  {
+  }
+
+  explicit WatchList(MemorySource const&& source,
+                     WatchListOptions const& options = WatchListOptions{}) =
+    delete;
+
+  WatchList(WatchList const&) = delete;
+
+  WatchList& operator=(WatchList const&) = delete;
+
+  ~WatchList()
+  {
+    Stop();
+  }
+
+  // Reports changes to the value with events.
+  template <typename T> WatchId Watch(void* address)
+  {
+    return Add<T>(address, false, T{}, nullptr);
+  }
+
+  // Same as above, and also calls callback with each event for the value
+  // from DispatchEvents.
+  template <typename T>
+  WatchId Watch(void* address, std::function<void(WatchEvent const&)> callback)
+  {
+    return Add<T>(address, false, T{}, std::move(callback));
+  }
+
+  // Writes value back whenever the memory is found to hold anything else.
+  template <typename T> WatchId Freeze(void* address, T const& value)
+  {
+    return Add<T>(address, true, value, nullptr);
+  }
+
+  void Remove(WatchId id)
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (entries_.erase(id))
+    {
+      dirty_ = true;
+    }
+  }
+
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    entries_.clear();
+    dirty_ = true;
+  }
+
+  std::size_t GetSize() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return entries_.size();
+  }
+
+  // Gets the value read by the last poll of the entry. Returns false if it
+  // hasn't been read yet.
+  template <typename T> bool GetValue(WatchId id, T& value) const
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto const iter = entries_.find(id);
+    if (iter == std::end(entries_) || !iter->second.has_value)
+    {
+      return false;
+    }
+    HADESMEM_DETAIL_ASSERT(iter->second.size == sizeof(T));
+    std::memcpy(&value, iter->second.value, sizeof(T));
+    return true;
+  }
+
+  // Polls the next slice of pages (every page unless
+  // WatchListOptions::max_pages_per_poll is set). Returns the number of pages
+  // polled.
+  std::size_t Poll()
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (dirty_)
+    {
+      BuildPages();
+    }
+
+    std::size_t const count =
+      options_.max_pages_per_poll
+        ? (std::min)(options_.max_pages_per_poll, pages_.size())
+        : pages_.size();
+    std::vector<detail::WatchEntry*> writes;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      PollPage(pages_[next_page_], writes);
+      next_page_ = (next_page_ + 1) % pages_.size();
+    }
+    WriteFrozen(writes);
+
+    ++stats_.polls;
+    return count;
+  }
+
+  // Consumer only.
+  bool PopEvent(WatchEvent& event)
+  {
+    return events_.TryPop(event);
+  }
+
+  // Pops every queued event and calls the callback of its entry (if it has
+  // one, and hasn't been removed). Consumer only. Returns the number of
+  // events popped.
+  std::size_t DispatchEvents()
+  {
+    std::size_t count = 0;
+    WatchEvent event;
+    while (events_.TryPop(event))
+    {
+      ++count;
+      std::function<void(WatchEvent const&)> callback;
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto const iter = entries_.find(event.id);
+        if (iter != std::end(entries_))
+        {
+          callback = iter->second.callback;
+        }
+      }
+
+      // Called without the lock held, so that the callback can add or remove
+      // entries.
+      if (callback)
+      {
+        callback(event);
+      }
+    }
+    return count;
+  }
+
+  // Polls on a background thread, every WatchListOptions::interval, until
+  // Stop is called.
+  void Start()
+  {
+    std::lock_guard<std::mutex> lock{thread_mutex_};
+    if (thread_.joinable())
+    {
+      return;
+    }
+
+    stop_ = false;
+    thread_ = std::thread{[this]() { Run(); }};
+  }
+
+  void Stop()
+  {
+    std::lock_guard<std::mutex> lock{thread_mutex_};
+    if (!thread_.joinable())
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> stop_lock{stop_mutex_};
+      stop_ = true;
+    }
+    stop_condition_.notify_all();
+    thread_.join();
+  }
+
+  WatchListStats GetStats() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return stats_;
+  }
+
+private:
+  template <typename T>
+  WatchId Add(void* address,
+              bool frozen,
+              T const& freeze_value,
+              std::function<void(WatchEvent const&)> callback)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+    HADESMEM_DETAIL_STATIC_ASSERT(sizeof(T) <= detail::kWatchMaxValueSize);
+
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+    detail::WatchEntry entry{};
+    entry.address = reinterpret_cast<std::uintptr_t>(address);
+    entry.size = sizeof(T);
+    entry.frozen = frozen;
+    std::memcpy(entry.freeze_value, &freeze_value, sizeof(T));
+    entry.callback = std::move(callback);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    entry.id = next_id_++;
+    WatchId const id = entry.id;
+    entries_.emplace(id, std::move(entry));
+    dirty_ = true;
+    return id;
+  }
+
+  void BuildPages()
+  {
+    std::vector<detail::WatchEntry*> sorted;
+    sorted.reserve(entries_.size());
+    for (auto& e : entries_)
+    {
+      sorted.push_back(&e.second);
+    }
+    std::sort(std::begin(sorted),
+              std::end(sorted),
+              [](detail::WatchEntry const* lhs, detail::WatchEntry const* rhs) {
+                return lhs->address < rhs->address;
+              });
+
+    pages_.clear();
+    for (auto const e : sorted)
+    {
+      std::uintptr_t const page = e->address / detail::kWatchPageSize;
+      if (pages_.empty() ||
+          pages_.back().beg / detail::kWatchPageSize != page)
+      {
+        pages_.push_back(detail::WatchPage{e->address, e->address, {}});
+      }
+      auto& cur = pages_.back();
+      cur.end = (std::max)(cur.end, e->address + e->size);
+      cur.entries.push_back(e);
+    }
+
+    next_page_ = 0;
+    dirty_ = false;
+  }
+
+  // Appends the frozen entries which need to be written back to writes.
+  void PollPage(detail::WatchPage const& page,
+                std::vector<detail::WatchEntry*>& writes)
+  {
+    buf_.resize(static_cast<std::size_t>(page.end - page.beg));
+    try
+    {
+      ++stats_.reads;
+      source_->Read(
+        reinterpret_cast<void*>(page.beg), buf_.data(), buf_.size());
+    }
+    catch (...)
+    {
+      for (auto const e : page.entries)
+      {
+        if (!e->read_failed)
+        {
+          e->read_failed = true;
+          Push(*e, WatchEventType::kReadFailed, nullptr);
+        }
+      }
+      return;
+    }
+
+    for (auto const e : page.entries)
+    {
+      e->read_failed = false;
+      std::uint8_t const* const data = &buf_[e->address - page.beg];
+      if (e->frozen)
+      {
+        if (std::memcmp(data, e->freeze_value, e->size))
+        {
+          writes.push_back(e);
+        }
+        std::memcpy(e->value, e->freeze_value, e->size);
+        e->has_value = true;
+        continue;
+      }
+
+      if (e->has_value && std::memcmp(data, e->value, e->size))
+      {
+        Push(*e, WatchEventType::kChanged, data);
+      }
+      std::memcpy(e->value, data, e->size);
+      e->has_value = true;
+    }
+  }
+
+  // Writes back the frozen values, merging adjacent ones into a single
+  // write (see MakeWriteRuns).
+  void WriteFrozen(std::vector<detail::WatchEntry*>& writes)
+  {
+    if (writes.empty())
+    {
+      return;
+    }
+
+    std::sort(std::begin(writes),
+              std::end(writes),
+              [](detail::WatchEntry const* lhs, detail::WatchEntry const* rhs) {
+                return lhs->address < rhs->address;
+              });
+    std::vector<detail::WriteBatchEntry> batch;
+    batch.reserve(writes.size());
+    for (auto const e : writes)
+    {
+      batch.push_back(detail::WriteBatchEntry{
+        e->address,
+        std::vector<std::uint8_t>(e->freeze_value, e->freeze_value + e->size)});
+    }
+
+    // The runs are sorted too, so each entry belongs to the first run which
+    // hasn't ended before it.
+    auto const runs = detail::MakeWriteRuns(batch);
+    std::size_t next = 0;
+    for (auto const& run : runs)
+    {
+      bool ok = true;
+      try
+      {
+        ++stats_.writes;
+        source_->Write(reinterpret_cast<void*>(run.address),
+                       run.data.data(),
+                       run.data.size());
+      }
+      catch (...)
+      {
+        ok = false;
+      }
+
+      std::uintptr_t const run_end = run.address + run.data.size();
+      for (; next < writes.size() && writes[next]->address < run_end; ++next)
+      {
+        auto const e = writes[next];
+        if (!ok && !e->write_failed)
+        {
+          Push(*e, WatchEventType::kWriteFailed, nullptr);
+        }
+        e->write_failed = !ok;
+      }
+    }
+  }
+
+  void Push(detail::WatchEntry const& e,
+            WatchEventType type,
+            std::uint8_t const* new_value)
+  {
+    WatchEvent event{};
+    event.type = type;
+    event.id = e.id;
+    event.address = reinterpret_cast<void*>(e.address);
+    event.size = e.size;
+    if (new_value)
+    {
+      std::memcpy(event.old_value, e.value, e.size);
+      std::memcpy(event.new_value, new_value, e.size);
+    }
+    if (!events_.TryPush(event))
+    {
+      ++stats_.dropped_events;
+    }
+  }
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock{stop_mutex_};
+    while (!stop_)
+    {
+      lock.unlock();
+      try
+      {
+        Poll();
+      }
+      catch (...)
+      {
+        // Read and write failures are handled per entry, so this is running
+        // out of memory in BuildPages, MakeWriteRuns or when resizing the
+        // read buffer. Give up on this poll and try again next time.
+      }
+      lock.lock();
+      stop_condition_.wait_for(lock, options_.interval, [this]() {
+        return stop_;
+      });
+    }
+  }
+
+  MemorySource const* source_;
+  WatchListOptions options_;
+  // Guards everything below except for the queue and the thread.
+  mutable std::mutex mutex_;
+  std::map<WatchId, detail::WatchEntry> entries_;
+  WatchId next_id_{0};
+  bool dirty_{false};
+  std::vector<detail::WatchPage> pages_;
+  std::size_t next_page_{0};
+  std::vector<std::uint8_t> buf_;
+  WatchListStats stats_{};
+  detail::SpscQueue<WatchEvent> events_;
+  std::mutex thread_mutex_;
+  std::thread thread_;
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_{false};
+};
+}
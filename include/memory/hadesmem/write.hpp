@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 
 #include <type_traits>
 
@@ -28,6 +29,19 @@ inline void Write(Process const& process, PVOID address, T const& data)
   detail::WriteImpl(process, address, data);
 }
 
+template <typename T>
+inline void WriteEx(Process const& process,
+                    PVOID address,
+                    T const& data,
+                    std::uint32_t flags)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+
+  detail::WriteImpl(process, address, std::addressof(data), sizeof(T), flags);
+}
+
 template <typename T>
 inline void
   Write(Process const& process, PVOID address, T const* ptr, std::size_t count)
@@ -96,4 +110,19 @@ inline void WriteVector(Process const& process,
   std::size_t const raw_size = data.size() * sizeof(T);
   detail::WriteImpl(process, address, data.data(), raw_size);
 }
+
+template <typename T, typename Alloc = std::allocator<T>>
+inline void WriteVectorEx(Process const& process,
+                          PVOID address,
+                          std::vector<T, Alloc> const& data,
+                          std::uint32_t flags)
+{
+  HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+  HADESMEM_DETAIL_ASSERT(address != nullptr);
+  HADESMEM_DETAIL_ASSERT(!data.empty());
+
+  std::size_t const raw_size = data.size() * sizeof(T);
+  detail::WriteImpl(process, address, data.data(), raw_size, flags);
+}
 }
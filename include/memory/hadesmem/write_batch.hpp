@@ -0,0 +1,399 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+#include <hadesmem/detail/assert.hpp>
+#include <hadesmem/detail/protect_region.hpp>
+#include <hadesmem/detail/query_region.hpp>
+#include <hadesmem/detail/read_impl.hpp>
+#include <hadesmem/detail/static_assert.hpp>
+#include <hadesmem/detail/thread_aux.hpp>
+#include <hadesmem/detail/trace.hpp>
+#include <hadesmem/detail/type_traits.hpp>
+#include <hadesmem/detail/write_batch.hpp>
+#include <hadesmem/detail/write_impl.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/flush.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/region_cache.hpp>
+#include <hadesmem/thread.hpp>
+#include <hadesmem/thread_helpers.hpp>
+#include <hadesmem/thread_list.hpp>
+
+namespace hadesmem
+{
+struct WriteBatchFlags
+{
+  enum : std::uint32_t
+  {
+    kNone = 0,
+    // Suspend all other threads in the target for the duration of the batch.
+    kSuspend = 1 << 0,
+    // Fail if another thread is currently executing any of the targets.
+    // Requires kSuspend to be meaningful.
+    kVerifyThreads = 1 << 1,
+    // Flush the instruction cache for each contiguous range written.
+    kFlushInstructionCache = 1 << 2,
+    // Same guarantees as PatchRaw::Apply.
+    kDefault = kSuspend | kVerifyThreads | kFlushInstructionCache
+  };
+};
+
+// Number of expensive operations performed by the last Apply or Revert.
+struct WriteBatchStats
+{
+  std::size_t suspensions;
+  std::size_t protect_changes;
+  std::size_t writes;
+  std::size_t flushes;
+};
+
+// Collects many writes (typically code patches) and applies them as a single
+// transaction. Writes are merged into contiguous runs, and the whole batch is
+// applied with one SuspendedProcess, at most one protection change (and
+// restore) per page, one WriteProcessMemory and one FlushInstructionCache per
+// run. If anything fails the runs which were already written are rolled back
+// before the error is propagated.
+//
+// Applying N patches individually via PatchRaw::Apply instead suspends and
+// resumes every thread in the target N times.
+//
+// Unlike PatchRaw the writes are not undone on destruction, call Revert to
+// restore the original bytes.
+class WriteBatch
+{
+public:
+  explicit WriteBatch(Process const& process) : process_{&process}
+  {
+  }
+
+  explicit WriteBatch(Process const&& process) = delete;
+
+  WriteBatch& Add(void* address, void const* data, std::size_t len)
+  {
+    HADESMEM_DETAIL_ASSERT(address != nullptr);
+    HADESMEM_DETAIL_ASSERT(len ? data != nullptr : true);
+
+    if (applied_)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        Error{} << ErrorString{"Cannot add to a batch which is applied."});
+    }
+
+    auto const beg = static_cast<std::uint8_t const*>(data);
+    entries_.push_back(detail::WriteBatchEntry{
+      reinterpret_cast<std::uintptr_t>(address),
+      std::vector<std::uint8_t>(beg, beg + len)});
+
+    return *this;
+  }
+
+  WriteBatch& Add(void* address, std::vector<std::uint8_t> const& data)
+  {
+    return Add(address, data.data(), data.size());
+  }
+
+  template <typename T> WriteBatch& Add(void* address, T const& data)
+  {
+    HADESMEM_DETAIL_STATIC_ASSERT(detail::IsTriviallyCopyable<T>::value);
+
+    return Add(address, std::addressof(data), sizeof(T));
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return entries_.size();
+  }
+
+  bool IsApplied() const noexcept
+  {
+    return applied_;
+  }
+
+  WriteBatchStats Apply(std::uint32_t flags = WriteBatchFlags::kDefault)
+  {
+    if (applied_)
+    {
+      return WriteBatchStats{};
+    }
+
+    runs_ = detail::MakeWriteRuns(entries_);
+    return Commit(flags, false);
+  }
+
+  WriteBatchStats Revert(std::uint32_t flags = WriteBatchFlags::kDefault)
+  {
+    if (!applied_)
+    {
+      return WriteBatchStats{};
+    }
+
+    auto const stats = Commit(flags, true);
+    runs_.clear();
+    return stats;
+  }
+
+private:
+  struct ProtectedRange
+  {
+    MEMORY_BASIC_INFORMATION mbi;
+    DWORD old_protect;
+  };
+
+  WriteBatchStats Commit(std::uint32_t flags, bool revert)
+  {
+    WriteBatchStats stats{};
+
+    if (runs_.empty())
+    {
+      return stats;
+    }
+
+    std::unique_ptr<SuspendedProcess> suspended_process;
+    if (!!(flags & WriteBatchFlags::kSuspend))
+    {
+      suspended_process =
+        std::make_unique<SuspendedProcess>(process_->GetId());
+      ++stats.suspensions;
+    }
+
+    if (!!(flags & WriteBatchFlags::kVerifyThreads))
+    {
+      VerifyThreads();
+    }
+
+    std::vector<ProtectedRange> protected_ranges;
+    std::size_t num_written = 0;
+    try
+    {
+      if (!revert)
+      {
+        // Done up front so that there's nothing to roll back if any of the
+        // targets can't be read.
+        for (auto& run : runs_)
+        {
+          run.orig.resize(run.data.size());
+          detail::ReadImpl(
+            *process_, ToPtr(run.address), run.orig.data(), run.orig.size());
+        }
+      }
+
+      MakeWritable(protected_ranges, stats);
+
+      for (auto const& run : runs_)
+      {
+        auto const& data = revert ? run.orig : run.data;
+        ++num_written;
+        ++stats.writes;
+        detail::WriteUnchecked(
+          *process_, ToPtr(run.address), data.data(), data.size());
+      }
+
+      if (!!(flags & WriteBatchFlags::kFlushInstructionCache))
+      {
+        for (auto const& run : runs_)
+        {
+          FlushInstructionCache(
+            *process_, ToPtr(run.address), run.data.size());
+          ++stats.flushes;
+        }
+      }
+    }
+    catch (...)
+    {
+      // The last write attempted may have partially succeeded, so it is
+      // rolled back too.
+      Rollback(num_written, revert);
+      RestoreProtectionUnchecked(protected_ranges, stats);
+      throw;
+    }
+
+    // The target is now in the new state even if restoring the protection
+    // fails, so record that first to keep Apply and Revert usable.
+    applied_ = !revert;
+
+    RestoreProtection(protected_ranges, stats);
+
+    return stats;
+  }
+
+  void VerifyThreads() const
+  {
+    // Only get the context of each thread once, no matter how many runs there
+    // are. Runs are sorted, so we only need to check the last run starting at
+    // or before the IP.
+    ThreadList const threads{process_->GetId()};
+    for (auto const& thread_entry : threads)
+    {
+      if (thread_entry.GetId() == ::GetCurrentThreadId())
+      {
+        continue;
+      }
+
+      Thread const thread{thread_entry.GetId()};
+      auto const context = GetThreadContext(thread, CONTEXT_CONTROL);
+      auto const ip =
+        static_cast<std::uintptr_t>(detail::GetThreadContextIp(context));
+      auto const iter = std::upper_bound(
+        std::begin(runs_),
+        std::end(runs_),
+        ip,
+        [](std::uintptr_t lhs, detail::WriteBatchRun const& rhs) {
+          return lhs < rhs.address;
+        });
+      if (iter != std::begin(runs_))
+      {
+        auto const& run = *(iter - 1);
+        if (ip < run.address + run.data.size())
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{}
+            << ErrorString{"Thread is currently executing patch target."});
+        }
+      }
+    }
+  }
+
+  void MakeWritable(std::vector<ProtectedRange>& protected_ranges,
+                    WriteBatchStats& stats) const
+  {
+    auto const pages =
+      detail::GetWriteRunPages(runs_, detail::GetPageSize());
+    for (auto const& range : pages)
+    {
+      // A range of pages may span multiple regions with different
+      // protections, and VirtualProtectEx only reports the old protection
+      // of the first page, so each region is handled separately.
+      for (std::uintptr_t cur = range.first; cur < range.second;)
+      {
+        MEMORY_BASIC_INFORMATION mbi = detail::Query(*process_, ToPtr(cur));
+        auto const region_end =
+          reinterpret_cast<std::uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+        auto const end = (std::min)(region_end, range.second);
+
+        if (mbi.State != MEM_COMMIT)
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{"Attempt to write to uncommitted memory."});
+        }
+
+        if (IsBadProtect(mbi))
+        {
+          HADESMEM_DETAIL_THROW_EXCEPTION(
+            Error{} << ErrorString{
+              "Attempt to access page with a 'bad' protection mask."});
+        }
+
+        if (!CanWrite(mbi))
+        {
+          mbi.BaseAddress = ToPtr(cur);
+          mbi.RegionSize = static_cast<SIZE_T>(end - cur);
+          ++stats.protect_changes;
+          DWORD old_protect = 0;
+          try
+          {
+            old_protect =
+              detail::Protect(*process_, mbi, PAGE_EXECUTE_READWRITE);
+          }
+          catch (...)
+          {
+            // Try and fall back to PAGE_READWRITE because we might not be
+            // allowed to set EXECUTE.
+            ++stats.protect_changes;
+            old_protect = detail::Protect(*process_, mbi, PAGE_READWRITE);
+          }
+          protected_ranges.push_back(ProtectedRange{mbi, old_protect});
+        }
+
+        cur = end;
+      }
+    }
+  }
+
+  void RestoreProtection(std::vector<ProtectedRange>& protected_ranges,
+                         WriteBatchStats& stats) const
+  {
+    // Keep going on failure so that as much as possible is restored, then
+    // report the first error.
+    std::exception_ptr error;
+    for (auto const& range : protected_ranges)
+    {
+      try
+      {
+        ++stats.protect_changes;
+        detail::Protect(*process_, range.mbi, range.old_protect);
+      }
+      catch (...)
+      {
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+    }
+    protected_ranges.clear();
+
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+
+  void
+    RestoreProtectionUnchecked(std::vector<ProtectedRange>& protected_ranges,
+                               WriteBatchStats& stats) const noexcept
+  {
+    try
+    {
+      RestoreProtection(protected_ranges, stats);
+    }
+    catch (...)
+    {
+      // WARNING: Protection is not restored if 'RestoreProtection' fails.
+      HADESMEM_DETAIL_TRACE_A(
+        boost::current_exception_diagnostic_information().c_str());
+      HADESMEM_DETAIL_ASSERT(false);
+    }
+  }
+
+  void Rollback(std::size_t num_written, bool revert) const noexcept
+  {
+    for (std::size_t i = 0; i < num_written; ++i)
+    {
+      auto const& run = runs_[i];
+      auto const& data = revert ? run.data : run.orig;
+      if (!detail::TryWriteUnchecked(
+            *process_, ToPtr(run.address), data.data(), data.size()))
+      {
+        // WARNING: Target is left partially written.
+        HADESMEM_DETAIL_TRACE_FORMAT_A(
+          "WARNING! Failed to roll back write. Address: [%p].",
+          ToPtr(run.address));
+        HADESMEM_DETAIL_ASSERT(false);
+      }
+    }
+  }
+
+  static void* ToPtr(std::uintptr_t address) noexcept
+  {
+    return reinterpret_cast<void*>(address);
+  }
+
+  Process const* process_;
+  bool applied_{false};
+  std::vector<detail::WriteBatchEntry> entries_;
+  std::vector<detail::WriteBatchRun> runs_;
+};
+}
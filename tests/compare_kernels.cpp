@@ -0,0 +1,263 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/compare_kernels.hpp>
+#include <hadesmem/detail/compare_kernels.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scan_compare.hpp>
+#include <hadesmem/scanner.hpp>
+
+namespace
+{
+std::vector<hadesmem::detail::SimdLevel> GetTestSimdLevels()
+{
+  std::vector<hadesmem::detail::SimdLevel> levels{
+    hadesmem::detail::SimdLevel::kScalar};
+  auto const best = hadesmem::detail::GetSimdLevel();
+  if (best >= hadesmem::detail::SimdLevel::kSse2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kSse2);
+  }
+  if (best >= hadesmem::detail::SimdLevel::kAvx2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kAvx2);
+  }
+  return levels;
+}
+
+// Checks every instruction set against a plain loop, for every comparison
+// and for packed, overlapping and sparse strides.
+template <typename T>
+void TestCompare(std::vector<std::uint8_t> const& buf,
+                 hadesmem::ScanCompare<T> const& cmp)
+{
+  hadesmem::ScanCompare<T> scalar_cmp{cmp};
+  if (std::is_integral<T>::value &&
+      cmp.type == hadesmem::ScanCompareType::kApprox)
+  {
+    scalar_cmp = hadesmem::detail::NormalizeScanCompare(cmp, std::true_type{});
+  }
+
+  std::size_t const strides[] = {1, 2, sizeof(T), sizeof(T) + 4, 3};
+  for (auto const stride : strides)
+  {
+    std::size_t const count = (buf.size() - sizeof(T)) / stride + 1;
+    std::vector<std::uint64_t> expected(
+      hadesmem::detail::GetCompareMaskWords(count));
+    hadesmem::detail::WithScalarComparePred(scalar_cmp, [&](auto pred) {
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        T x;
+        std::memcpy(&x, &buf[i * stride], sizeof(T));
+        if (pred(x))
+        {
+          expected[i / 64] |= 1ULL << (i % 64);
+        }
+      }
+    });
+
+    for (auto const level : GetTestSimdLevels())
+    {
+      std::vector<std::uint64_t> mask(expected.size(), 0xCCCCCCCCCCCCCCCCULL);
+      hadesmem::detail::CompareValues(
+        buf.data(), count, stride, cmp, mask.data(), level);
+      BOOST_TEST(mask == expected);
+    }
+  }
+}
+
+template <typename T>
+void TestCompareType(std::vector<std::uint8_t> const& buf)
+{
+  // Pick the operands from the buffer itself so that there are some hits.
+  T a;
+  T b;
+  std::memcpy(&a, &buf[40], sizeof(T));
+  std::memcpy(&b, &buf[200], sizeof(T));
+
+  hadesmem::ScanCompare<T> cmp;
+  cmp.value = a;
+  cmp.type = hadesmem::ScanCompareType::kEqual;
+  TestCompare(buf, cmp);
+  cmp.type = hadesmem::ScanCompareType::kNotEqual;
+  TestCompare(buf, cmp);
+  cmp.type = hadesmem::ScanCompareType::kLess;
+  TestCompare(buf, cmp);
+  cmp.type = hadesmem::ScanCompareType::kGreater;
+  TestCompare(buf, cmp);
+  cmp.type = hadesmem::ScanCompareType::kBetween;
+  cmp.value = a < b ? a : b;
+  cmp.upper = a < b ? b : a;
+  TestCompare(buf, cmp);
+  cmp.type = hadesmem::ScanCompareType::kApprox;
+  cmp.value = a;
+  cmp.epsilon = static_cast<T>(3);
+  TestCompare(buf, cmp);
+  cmp.epsilon_type = hadesmem::ScanEpsilonType::kRelative;
+  cmp.epsilon = static_cast<T>(std::is_integral<T>::value ? 1 : 0.001);
+  TestCompare(buf, cmp);
+  // Saturated bounds for integers.
+  cmp.epsilon_type = hadesmem::ScanEpsilonType::kAbsolute;
+  cmp.value = (std::numeric_limits<T>::max)();
+  TestCompare(buf, cmp);
+  cmp.value = (std::numeric_limits<T>::lowest)();
+  TestCompare(buf, cmp);
+}
+}
+
+void TestCompareKernels()
+{
+  // Random bytes, with runs of a few values so that the integer compares
+  // have plenty of hits.
+  std::mt19937 rng{1234};
+  std::vector<std::uint8_t> buf(0x1000 + 13);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+  {
+    buf[i] = static_cast<std::uint8_t>(rng() % 4 ? rng() : i % 3);
+  }
+
+  TestCompareType<std::int8_t>(buf);
+  TestCompareType<std::uint8_t>(buf);
+  TestCompareType<std::int16_t>(buf);
+  TestCompareType<std::uint16_t>(buf);
+  TestCompareType<std::int32_t>(buf);
+  TestCompareType<std::uint32_t>(buf);
+  TestCompareType<std::int64_t>(buf);
+  TestCompareType<std::uint64_t>(buf);
+
+  // Floats with near-misses, signed zeros, infinities and NaNs.
+  std::vector<float> floats(0x400 + 5);
+  std::vector<double> doubles(0x200 + 7);
+  for (std::size_t i = 0; i < floats.size(); ++i)
+  {
+    float const special[] = {0.0f,
+                             -0.0f,
+                             std::numeric_limits<float>::infinity(),
+                             -std::numeric_limits<float>::infinity(),
+                             std::numeric_limits<float>::quiet_NaN()};
+    floats[i] = i % 7 == 0
+                  ? special[i % 5]
+                  : 100.0f + static_cast<float>(rng() % 2000) / 1000.0f;
+  }
+  for (std::size_t i = 0; i < doubles.size(); ++i)
+  {
+    double const special[] = {0.0,
+                              -0.0,
+                              std::numeric_limits<double>::infinity(),
+                              -std::numeric_limits<double>::infinity(),
+                              std::numeric_limits<double>::quiet_NaN()};
+    doubles[i] = i % 7 == 0
+                   ? special[i % 5]
+                   : -50.0 + static_cast<double>(rng() % 2000) / 1000.0;
+  }
+  std::vector<std::uint8_t> float_buf(floats.size() * sizeof(float));
+  std::memcpy(float_buf.data(), floats.data(), float_buf.size());
+  std::vector<std::uint8_t> double_buf(doubles.size() * sizeof(double));
+  std::memcpy(double_buf.data(), doubles.data(), double_buf.size());
+  TestCompareType<float>(float_buf);
+  TestCompareType<double>(double_buf);
+}
+
+void TestCompareFloat()
+{
+  std::vector<float> const values{1.0f,
+                                  1.00001f,
+                                  0.99999f,
+                                  1.1f,
+                                  -1.0f,
+                                  std::numeric_limits<float>::quiet_NaN(),
+                                  1000.0f,
+                                  1000.01f};
+  auto const data = reinterpret_cast<std::uint8_t const*>(values.data());
+
+  for (auto const level : GetTestSimdLevels())
+  {
+    hadesmem::ScanCompare<float> cmp;
+    cmp.type = hadesmem::ScanCompareType::kApprox;
+    cmp.value = 1.0f;
+    cmp.epsilon = 0.0001f;
+    std::uint64_t mask = 0;
+    hadesmem::detail::CompareValues(
+      data, values.size(), sizeof(float), cmp, &mask, level);
+    BOOST_TEST_EQ(mask, 0x7ULL);
+
+    // A relative epsilon scales with the value.
+    cmp.value = 1000.0f;
+    cmp.epsilon_type = hadesmem::ScanEpsilonType::kRelative;
+    cmp.epsilon = 0.00002f;
+    hadesmem::detail::CompareValues(
+      data, values.size(), sizeof(float), cmp, &mask, level);
+    BOOST_TEST_EQ(mask, 0xC0ULL);
+
+    // NaN is only ever not equal.
+    cmp.type = hadesmem::ScanCompareType::kNotEqual;
+    cmp.value = 1.0f;
+    hadesmem::detail::CompareValues(
+      data, values.size(), sizeof(float), cmp, &mask, level);
+    BOOST_TEST_EQ(mask, 0xFEULL);
+  }
+}
+
+void TestScanCompare()
+{
+  std::vector<float> buf(0x4000);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+  {
+    buf[i] = static_cast<float>(i % 100);
+  }
+  buf[4642] = 42.001f;
+  hadesmem::BufferMemorySource const source{buf.data(),
+                                            buf.size() * sizeof(buf[0])};
+
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x1000;
+  options.num_threads = 2;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  BOOST_TEST_EQ(scanner.ScanExact(42.001f).size(), 1U);
+
+  hadesmem::ScanCompare<float> cmp;
+  cmp.type = hadesmem::ScanCompareType::kApprox;
+  cmp.value = 42.0f;
+  cmp.epsilon = 0.01f;
+  auto const approx = scanner.Scan(cmp);
+  BOOST_TEST_EQ(approx.size(), buf.size() / 100 + 1);
+
+  cmp.type = hadesmem::ScanCompareType::kBetween;
+  cmp.value = 10.0f;
+  cmp.upper = 19.0f;
+  auto const results = scanner.FirstScan(cmp);
+  BOOST_TEST_EQ(results.GetCount(), (buf.size() / 100 + 1) * 10);
+  std::size_t checked = 0;
+  results.ForEach([&](void* address, void const* value) {
+    float v;
+    std::memcpy(&v, value, sizeof(v));
+    BOOST_TEST(v >= 10.0f && v <= 19.0f);
+    BOOST_TEST_EQ(*static_cast<float const*>(address), v);
+    ++checked;
+  });
+  BOOST_TEST_EQ(checked, results.GetCount());
+}
+
+int main()
+{
+  TestCompareKernels();
+  TestCompareFloat();
+  TestScanCompare();
+  return boost::report_errors();
+}
@@ -4,13 +4,18 @@
 #include <hadesmem/find_pattern.hpp>
 #include <hadesmem/find_pattern.hpp>
 
+#include <string>
+#include <vector>
+
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
 #include <hadesmem/detail/warning_disable_suffix.hpp>
 
 #include <hadesmem/config.hpp>
+#include <hadesmem/detail/filesystem.hpp>
 #include <hadesmem/detail/self_path.hpp>
 #include <hadesmem/error.hpp>
+#include <hadesmem/pattern_literal.hpp>
 #include <hadesmem/process.hpp>
 
 // TODO: Clean up, expand, fix, etc these tests.
@@ -81,6 +86,41 @@ void TestFindPattern()
                    0U),
     hadesmem::Error);
 
+  // A context gives the same results as looking up the module every time.
+  hadesmem::PatternScanContext const context{process, L""};
+  BOOST_TEST_EQ(
+    hadesmem::Find(context, L"90", hadesmem::PatternFlags::kNone, 0U), nop);
+  BOOST_TEST_EQ(
+    hadesmem::Find(context,
+                   L"90",
+                   hadesmem::PatternFlags::kNone,
+                   reinterpret_cast<std::uintptr_t>(nop) - process_base),
+    nop_second);
+  BOOST_TEST_EQ(hadesmem::Find(context,
+                               L"46 ?? 6E 64 50 61 74 74 65 72 6E",
+                               hadesmem::PatternFlags::kScanData,
+                               0U),
+                find_pattern_string);
+  BOOST_TEST_THROWS(
+    hadesmem::Find(context,
+                   L"11 22 33 44 55 66 77 88 99 AA BB CC DD EE FF",
+                   hadesmem::PatternFlags::kThrowOnUnmatch,
+                   0U),
+    hadesmem::Error);
+
+  // Pattern literals are parsed at compile time, but find the same things.
+  constexpr auto kNopPattern = HADESMEM_PATTERN("90");
+  BOOST_TEST_EQ(
+    hadesmem::Find(context, kNopPattern, hadesmem::PatternFlags::kNone, 0U),
+    nop);
+  BOOST_TEST_EQ(hadesmem::Find(process,
+                               L"",
+                               kNopPattern,
+                               hadesmem::PatternFlags::kNone,
+                               reinterpret_cast<std::uintptr_t>(nop) -
+                                 process_base),
+                nop_second);
+
   HMODULE const ntdll_mod = ::GetModuleHandleW(L"ntdll");
   BOOST_TEST_NE(ntdll_mod, static_cast<HMODULE>(nullptr));
   std::uintptr_t const ntdll_base = reinterpret_cast<std::uintptr_t>(ntdll_mod);
@@ -138,6 +178,62 @@ void TestFindPattern()
 )";
   hadesmem::FindPattern find_pattern{process, pattern_file_data, true};
   find_pattern = hadesmem::FindPattern{process, pattern_file_data, true};
+
+  // Resolving the patterns in parallel gives the same results.
+  hadesmem::FindPattern const find_pattern_parallel{
+    process, pattern_file_data, true, 4};
+  BOOST_TEST(find_pattern_parallel == find_pattern);
+
+  // Saving the matches to a cache and loading them from it gives the same
+  // results.
+  std::vector<wchar_t> temp_path(MAX_PATH + 1);
+  BOOST_TEST_NE(::GetTempPathW(static_cast<DWORD>(temp_path.size()),
+                               temp_path.data()),
+                0UL);
+  std::wstring const cache_path =
+    temp_path.data() + std::wstring{L"hadesmem_find_pattern_cache.xml"};
+  ::DeleteFileW(cache_path.c_str());
+  hadesmem::FindPattern const find_pattern_save{
+    process, pattern_file_data, true, 1, cache_path};
+  BOOST_TEST(find_pattern_save == find_pattern);
+  hadesmem::FindPattern const find_pattern_load{
+    process, pattern_file_data, true, 1, cache_path};
+  BOOST_TEST(find_pattern_load == find_pattern);
+
+  // A cached match which no longer matches is found again.
+  pugi::xml_document cache;
+  BOOST_TEST(!!cache.load_file(cache_path.c_str()));
+  auto const nop_other_node =
+    cache.child(L"HadesMem")
+      .child(L"PatternCache")
+      .find_child_by_attribute(L"Module", L"Name", L"")
+      .find_child_by_attribute(L"Pattern", L"Name", L"Nop Other");
+  BOOST_TEST(nop_other_node.attribute(L"Rva").set_value(L"0"));
+  BOOST_TEST(cache.save_file(cache_path.c_str()));
+  hadesmem::FindPattern const find_pattern_stale{
+    process, pattern_file_data, true, 1, cache_path};
+  BOOST_TEST(find_pattern_stale == find_pattern);
+  ::DeleteFileW(cache_path.c_str());
+
+  // Compiling the patterns to a database first gives the same results,
+  // whether it's in memory or mapped from a file.
+  auto const database = hadesmem::CompilePatternFile(pattern_file_data, true);
+  hadesmem::FindPattern const find_pattern_database{
+    process, hadesmem::PatternDatabase{database.data(), database.size()}};
+  BOOST_TEST(find_pattern_database == find_pattern);
+  std::wstring const database_path =
+    temp_path.data() + std::wstring{L"hadesmem_find_pattern_database.bin"};
+  hadesmem::detail::BufferToFile(
+    database_path,
+    database.data(),
+    static_cast<std::streamsize>(database.size()));
+  {
+    hadesmem::PatternDatabase const database_file{database_path};
+    hadesmem::FindPattern const find_pattern_database_file{
+      process, database_file, 4};
+    BOOST_TEST(find_pattern_database_file == find_pattern);
+  }
+  ::DeleteFileW(database_path.c_str());
   BOOST_TEST_EQ(find_pattern.GetModuleMap().size(), 2UL);
   BOOST_TEST_EQ(find_pattern.GetPatternMap(L"").size(), 5UL);
 
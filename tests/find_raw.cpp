@@ -0,0 +1,212 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/simd.hpp>
+#include <hadesmem/error.hpp>
+
+namespace
+{
+// A small alphabet with both nibbles in use, and masks for every kind of
+// wildcard.
+std::uint8_t const kAlphabet[] = {0x00, 0x01, 0x10, 0x11};
+std::uint8_t const kMasks[] = {0x00, 0x0F, 0xF0, 0xFF, 0xFF, 0xFF};
+
+std::vector<hadesmem::detail::SimdLevel> GetSimdLevels()
+{
+  std::vector<hadesmem::detail::SimdLevel> levels{
+    hadesmem::detail::SimdLevel::kScalar};
+  auto const best = hadesmem::detail::GetSimdLevel();
+  if (best >= hadesmem::detail::SimdLevel::kSse2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kSse2);
+  }
+  if (best >= hadesmem::detail::SimdLevel::kAvx2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kAvx2);
+  }
+  return levels;
+}
+
+std::size_t FindSlow(std::vector<std::uint8_t> const& haystack,
+                     std::vector<hadesmem::detail::PatternDataByte> const& n)
+{
+  auto const iter =
+    std::search(std::begin(haystack),
+                std::end(haystack),
+                std::begin(n),
+                std::end(n),
+                [](std::uint8_t h_cur,
+                   hadesmem::detail::PatternDataByte const& n_cur) {
+                  return (h_cur & n_cur.mask) == n_cur.value;
+                });
+  return iter == std::end(haystack)
+           ? hadesmem::detail::kNoPatternMatch
+           : static_cast<std::size_t>(iter - std::begin(haystack));
+}
+}
+
+void TestConvertData()
+{
+  auto const needle = hadesmem::detail::ConvertData(L"FF D? ?b ?? 0");
+  std::uint8_t const values[] = {0xFF, 0xD0, 0x0B, 0x00, 0x00};
+  std::uint8_t const masks[] = {0xFF, 0xF0, 0x0F, 0x00, 0xFF};
+  BOOST_TEST_EQ(needle.size(), 5U);
+  for (std::size_t i = 0; i < needle.size() && i < 5; ++i)
+  {
+    BOOST_TEST_EQ(needle[i].value, values[i]);
+    BOOST_TEST_EQ(needle[i].mask, masks[i]);
+  }
+
+  BOOST_TEST_THROWS(hadesmem::detail::ConvertData(L"FF ???"),
+                    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::detail::ConvertData(L"G? FF"), hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::detail::ConvertData(L"?"), hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::detail::ConvertData(L"100"), hadesmem::Error);
+}
+
+void TestCompilePattern()
+{
+  // 0x00, 0x48 and 0x8B are all common in code, so 0x3D is the anchor and
+  // 0x8B (the least common of the rest) is checked next.
+  auto const needle = hadesmem::detail::ConvertData(L"00 48 ?? 8B 3D 00");
+  auto const pattern =
+    hadesmem::detail::CompilePattern(std::begin(needle), std::end(needle));
+  std::vector<std::uint8_t> const value = {0x00, 0x48, 0x00, 0x8B, 0x3D, 0x00};
+  std::vector<std::uint8_t> const mask = {0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF};
+  BOOST_TEST(pattern.value == value);
+  BOOST_TEST(pattern.mask == mask);
+  BOOST_TEST_EQ(pattern.anchor, 4U);
+  BOOST_TEST_EQ(pattern.check, 3U);
+
+  auto const single = hadesmem::detail::ConvertData(L"?? E8 ??");
+  auto const single_pattern =
+    hadesmem::detail::CompilePattern(std::begin(single), std::end(single));
+  BOOST_TEST_EQ(single_pattern.anchor, 1U);
+  BOOST_TEST_EQ(single_pattern.check, 1U);
+
+  auto const wildcards = hadesmem::detail::ConvertData(L"?? ??");
+  auto const wildcards_pattern = hadesmem::detail::CompilePattern(
+    std::begin(wildcards), std::end(wildcards));
+  BOOST_TEST_EQ(wildcards_pattern.anchor, hadesmem::detail::kNoPatternMatch);
+
+  // A nibble wildcard matches 16 values, so it's weighed by the sum of their
+  // frequencies.
+  auto const nibbles = hadesmem::detail::ConvertData(L"?5 3D 3?");
+  auto const nibbles_pattern =
+    hadesmem::detail::CompilePattern(std::begin(nibbles), std::end(nibbles));
+  BOOST_TEST_EQ(nibbles_pattern.anchor, 1U);
+  BOOST_TEST_EQ(nibbles_pattern.check, 2U);
+}
+
+void TestFindCompiledPattern()
+{
+  std::vector<std::uint8_t> haystack(100);
+  haystack[40] = 0xFF;
+  haystack[41] = 0xD0;
+  haystack[42] = 0xEB;
+  haystack[50] = 0xFF;
+  haystack[51] = 0xD3;
+  haystack[52] = 0xEB;
+  haystack[97] = 0x12;
+  haystack[98] = 0x34;
+  haystack[99] = 0x56;
+
+  auto const at_end = hadesmem::detail::ConvertData(L"12 ?? 56");
+  auto const past_end = hadesmem::detail::ConvertData(L"12 34 56 00");
+  auto const wildcards = hadesmem::detail::ConvertData(L"?? ??");
+  auto const nibble = hadesmem::detail::ConvertData(L"FF D? EB");
+  auto const nibble_low = hadesmem::detail::ConvertData(L"FF ?3 EB");
+  auto const compile = [](
+    std::vector<hadesmem::detail::PatternDataByte> const& needle) {
+    return hadesmem::detail::CompilePattern(std::begin(needle),
+                                            std::end(needle));
+  };
+  for (auto const level : GetSimdLevels())
+  {
+    BOOST_TEST_EQ(hadesmem::detail::FindCompiledPattern(
+                    haystack.data(), haystack.size(), compile(at_end), level),
+                  97U);
+    BOOST_TEST_EQ(hadesmem::detail::FindCompiledPattern(
+                    haystack.data(), haystack.size(), compile(past_end), level),
+                  hadesmem::detail::kNoPatternMatch);
+    BOOST_TEST_EQ(
+      hadesmem::detail::FindCompiledPattern(
+        haystack.data(), haystack.size(), compile(wildcards), level),
+      0U);
+    BOOST_TEST_EQ(hadesmem::detail::FindCompiledPattern(
+                    haystack.data(), 1, compile(wildcards), level),
+                  hadesmem::detail::kNoPatternMatch);
+    BOOST_TEST_EQ(hadesmem::detail::FindCompiledPattern(
+                    haystack.data(), haystack.size(), compile(nibble), level),
+                  40U);
+    BOOST_TEST_EQ(
+      hadesmem::detail::FindCompiledPattern(
+        haystack.data(), haystack.size(), compile(nibble_low), level),
+      50U);
+  }
+}
+
+void TestFindCompiledPatternRandom()
+{
+  // A small alphabet so that there are plenty of candidates and partial
+  // matches, and every length so that all of the tails are covered.
+  std::mt19937 engine{4321};
+  std::uniform_int_distribution<int> byte_dist{0, 3};
+  std::uniform_int_distribution<std::size_t> len_dist{1, 20};
+  std::uniform_int_distribution<std::size_t> mask_dist{0, 5};
+  auto const levels = GetSimdLevels();
+  bool all_equal = true;
+  for (std::size_t size = 0; size < 300; ++size)
+  {
+    std::vector<std::uint8_t> haystack(size);
+    for (auto& b : haystack)
+    {
+      b = kAlphabet[byte_dist(engine)];
+    }
+
+    for (std::size_t round = 0; round < 5; ++round)
+    {
+      std::vector<hadesmem::detail::PatternDataByte> needle(len_dist(engine));
+      for (auto& n : needle)
+      {
+        n.mask = kMasks[mask_dist(engine)];
+        n.value = kAlphabet[byte_dist(engine)] & n.mask;
+      }
+
+      auto const pattern =
+        hadesmem::detail::CompilePattern(std::begin(needle), std::end(needle));
+      std::size_t const expected = FindSlow(haystack, needle);
+      for (auto const level : levels)
+      {
+        all_equal =
+          all_equal && hadesmem::detail::FindCompiledPattern(
+                         haystack.data(), haystack.size(), pattern, level) ==
+                         expected;
+      }
+    }
+  }
+  BOOST_TEST(all_equal);
+}
+
+int main()
+{
+  TestConvertData();
+  TestCompilePattern();
+  TestFindCompiledPattern();
+  TestFindCompiledPatternRandom();
+  return boost::report_errors();
+}
@@ -0,0 +1,155 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/find_raw_multi.hpp>
+#include <hadesmem/detail/find_raw_multi.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+
+namespace
+{
+// A small alphabet with both nibbles in use, and masks for every kind of
+// wildcard.
+std::uint8_t const kAlphabet[] = {0x00, 0x01, 0x10, 0x11};
+std::uint8_t const kMasks[] = {0x00, 0x0F, 0xF0, 0xFF, 0xFF, 0xFF};
+
+std::size_t FindFirstSlow(std::vector<std::uint8_t> const& haystack,
+                          std::vector<hadesmem::detail::PatternDataByte> const&
+                            needle,
+                          std::size_t begin)
+{
+  auto const iter =
+    std::search(std::begin(haystack) + begin,
+                std::end(haystack),
+                std::begin(needle),
+                std::end(needle),
+                [](std::uint8_t h_cur,
+                   hadesmem::detail::PatternDataByte const& n_cur) {
+                  return (h_cur & n_cur.mask) == n_cur.value;
+                });
+  return iter == std::end(haystack)
+           ? hadesmem::detail::kNoPatternMatch
+           : static_cast<std::size_t>(iter - std::begin(haystack));
+}
+}
+
+void TestFindRawMulti()
+{
+  std::vector<std::uint8_t> const haystack = {
+    0x00, 0x55, 0x8B, 0xEC, 0x90, 0x90, 0xE8, 0x10, 0x20, 0x30, 0x40, 0xC3,
+    0x55, 0x8B, 0xEC, 0x83, 0xEC, 0x10, 0x90, 0xC3};
+
+  hadesmem::detail::MultiPatternFinder finder;
+  auto const prologue = hadesmem::detail::ConvertData(L"55 8B EC");
+  auto const call = hadesmem::detail::ConvertData(L"E8 ?? ?? ?? ?? C3");
+  auto const nop = hadesmem::detail::ConvertData(L"90");
+  auto const any = hadesmem::detail::ConvertData(L"?? ??");
+  auto const tail = hadesmem::detail::ConvertData(L"?? C3");
+  auto const missing = hadesmem::detail::ConvertData(L"55 8B EC 00");
+  BOOST_TEST_EQ(finder.Add(prologue), 0U);
+  BOOST_TEST_EQ(finder.Add(call), 1U);
+  BOOST_TEST_EQ(finder.Add(nop), 2U);
+  BOOST_TEST_EQ(finder.Add(any), 3U);
+  BOOST_TEST_EQ(finder.Add(tail), 4U);
+  BOOST_TEST_EQ(finder.Add(missing), 5U);
+  BOOST_TEST_EQ(finder.GetSize(), 6U);
+
+  std::vector<std::size_t> results;
+  std::vector<std::size_t> begins(finder.GetSize(), 0);
+  finder.FindFirst(haystack.data(), haystack.size(), begins, results);
+  std::vector<std::size_t> const expected = {
+    1, 6, 4, 0, 10, hadesmem::detail::kNoPatternMatch};
+  BOOST_TEST(results == expected);
+
+  // Patterns can start at different offsets, or be skipped entirely.
+  begins[0] = 2;
+  begins[1] = hadesmem::detail::kNoPatternMatch;
+  begins[2] = 5;
+  begins[3] = 19;
+  begins[4] = 12;
+  finder.FindFirst(haystack.data(), haystack.size(), begins, results);
+  std::vector<std::size_t> const expected_begins = {
+    12,
+    hadesmem::detail::kNoPatternMatch,
+    5,
+    hadesmem::detail::kNoPatternMatch,
+    18,
+    hadesmem::detail::kNoPatternMatch};
+  BOOST_TEST(results == expected_begins);
+
+  // A single pattern is searched for on its own.
+  std::vector<std::size_t> single(finder.GetSize(),
+                                  hadesmem::detail::kNoPatternMatch);
+  single[1] = 1;
+  finder.FindFirst(haystack.data(), haystack.size(), single, results);
+  std::vector<std::size_t> expected_single(finder.GetSize(),
+                                           hadesmem::detail::kNoPatternMatch);
+  expected_single[1] = 6;
+  BOOST_TEST(results == expected_single);
+}
+
+void TestFindRawMultiRandom()
+{
+  // A small alphabet so that there are plenty of partial matches.
+  std::mt19937 engine{1234};
+  std::uniform_int_distribution<int> byte_dist{0, 3};
+  std::vector<std::uint8_t> haystack(0x4000);
+  for (auto& b : haystack)
+  {
+    b = kAlphabet[byte_dist(engine)];
+  }
+
+  std::uniform_int_distribution<std::size_t> len_dist{1, 8};
+  std::uniform_int_distribution<std::size_t> mask_dist{0, 5};
+  std::uniform_int_distribution<std::size_t> begin_dist{0, haystack.size()};
+  for (std::size_t round = 0; round < 20; ++round)
+  {
+    hadesmem::detail::MultiPatternFinder finder;
+    std::vector<std::vector<hadesmem::detail::PatternDataByte>> needles;
+    std::vector<std::size_t> begins;
+    for (std::size_t i = 0; i < 50; ++i)
+    {
+      std::vector<hadesmem::detail::PatternDataByte> needle(len_dist(engine));
+      for (auto& n : needle)
+      {
+        n.mask = kMasks[mask_dist(engine)];
+        n.value = kAlphabet[byte_dist(engine)] & n.mask;
+      }
+      needles.push_back(needle);
+      finder.Add(needle);
+      begins.push_back(i % 10 == 9 ? hadesmem::detail::kNoPatternMatch
+                                   : begin_dist(engine));
+    }
+
+    std::vector<std::size_t> results;
+    finder.FindFirst(haystack.data(), haystack.size(), begins, results);
+    bool all_equal = true;
+    for (std::size_t i = 0; i < needles.size(); ++i)
+    {
+      std::size_t const expected =
+        begins[i] == hadesmem::detail::kNoPatternMatch
+          ? hadesmem::detail::kNoPatternMatch
+          : FindFirstSlow(haystack, needles[i], begins[i]);
+      all_equal = all_equal && results[i] == expected;
+    }
+    BOOST_TEST(all_equal);
+  }
+}
+
+int main()
+{
+  TestFindRawMulti();
+  TestFindRawMultiRandom();
+  return boost::report_errors();
+}
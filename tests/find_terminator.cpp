@@ -0,0 +1,101 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/find_terminator.hpp>
+#include <hadesmem/detail/find_terminator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/detail/simd.hpp>
+
+namespace
+{
+std::vector<hadesmem::detail::SimdLevel> GetTestSimdLevels()
+{
+  std::vector<hadesmem::detail::SimdLevel> levels{
+    hadesmem::detail::SimdLevel::kScalar};
+  auto const best = hadesmem::detail::GetSimdLevel();
+  if (best >= hadesmem::detail::SimdLevel::kSse2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kSse2);
+  }
+  if (best >= hadesmem::detail::SimdLevel::kAvx2)
+  {
+    levels.push_back(hadesmem::detail::SimdLevel::kAvx2);
+  }
+  return levels;
+}
+}
+
+template <typename T>
+void TestFindTerminatorType(hadesmem::detail::SimdLevel level)
+{
+  // Cover every alignment relative to the vector width, terminators in both
+  // the vectorized body and the scalar tail, and ranges with no terminator at
+  // all. The buffer is padded so that any read outside of [beg, end) would hit
+  // a zero and give the wrong answer.
+  std::size_t const kMaxLen = 100;
+  std::size_t const kPad = 64;
+  std::vector<T> buf(kPad + kMaxLen + kPad);
+  for (std::size_t offset = 0; offset < 16; ++offset)
+  {
+    for (std::size_t len = 0; len <= kMaxLen; ++len)
+    {
+      std::fill(std::begin(buf), std::end(buf), T());
+      T* const beg = &buf[kPad + offset];
+      T* const end = beg + len;
+      std::fill(beg, end, static_cast<T>(0x41));
+      BOOST_TEST(hadesmem::detail::FindTerminator(beg, end, level) == end);
+
+      for (std::size_t pos = 0; pos < len; ++pos)
+      {
+        beg[pos] = T();
+        BOOST_TEST(hadesmem::detail::FindTerminator(beg, end, level) ==
+                   beg + pos);
+        T const* const cbeg = beg;
+        BOOST_TEST(hadesmem::detail::FindTerminator(
+                     cbeg, cbeg + len, level) == cbeg + pos);
+        beg[pos] = static_cast<T>(0x41);
+      }
+    }
+  }
+
+  // Only the first terminator counts, and elements which are only partially
+  // zero aren't terminators.
+  std::vector<T> mixed(40, static_cast<T>(0x100 + 1));
+  mixed[33] = T();
+  mixed[35] = T();
+  BOOST_TEST(hadesmem::detail::FindTerminator(
+               mixed.data(), mixed.data() + mixed.size(), level) ==
+             &mixed[33]);
+}
+
+void TestFindTerminator()
+{
+  for (auto const level : GetTestSimdLevels())
+  {
+    TestFindTerminatorType<char>(level);
+    TestFindTerminatorType<wchar_t>(level);
+    TestFindTerminatorType<char16_t>(level);
+    TestFindTerminatorType<char32_t>(level);
+    TestFindTerminatorType<std::uint8_t>(level);
+  }
+
+  // The default picks the best level the CPU supports.
+  char const str[] = "Hello, world!";
+  BOOST_TEST(hadesmem::detail::FindTerminator(str, str + sizeof(str)) ==
+             str + sizeof(str) - 1);
+}
+
+int main()
+{
+  TestFindTerminator();
+  return boost::report_errors();
+}
@@ -0,0 +1,199 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/memory_source.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+#if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <unistd.h>
+#endif // #if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace
+{
+template <typename MemorySource>
+bool ContainsAddress(MemorySource const& source, void const* address)
+{
+  auto const regions = source.GetRegions();
+  return std::any_of(std::begin(regions),
+                     std::end(regions),
+                     [&](MEMORY_BASIC_INFORMATION const& mbi) {
+                       auto const beg =
+                         static_cast<std::uint8_t const*>(mbi.BaseAddress);
+                       return address >= beg && address < beg + mbi.RegionSize;
+                     });
+}
+
+// Exercises a source for our own address space through the generic interface
+// only.
+template <typename MemorySource>
+void TestGenericSource(MemorySource const& source)
+{
+  std::uint32_t value = 0x12345678;
+  BOOST_TEST_EQ(hadesmem::detail::SourceRead<std::uint32_t>(source, &value),
+                0x12345678U);
+  hadesmem::detail::SourceWrite(source, &value, 0xCAFEBABEU);
+  BOOST_TEST_EQ(value, 0xCAFEBABEU);
+
+  std::vector<std::uint8_t> data(0x3000);
+  for (std::size_t i = 0; i < data.size(); ++i)
+  {
+    data[i] = static_cast<std::uint8_t>(i * 7);
+  }
+  BOOST_TEST(hadesmem::detail::SourceReadVector<std::uint8_t>(
+               source, data.data(), data.size()) == data);
+
+  auto const mbi = source.Query(data.data());
+  BOOST_TEST(hadesmem::detail::IsRegionReadable(mbi));
+  BOOST_TEST(ContainsAddress(source, data.data()));
+
+  auto const needle = hadesmem::detail::ConvertData(L"E3 ?? F1 F8");
+  auto const found = hadesmem::detail::FindRaw(source,
+                                               data.data(),
+                                               data.data() + data.size(),
+                                               std::begin(needle),
+                                               std::end(needle));
+  BOOST_TEST_EQ(found, static_cast<void*>(&data[0x45]));
+}
+}
+
+void TestParseProcMaps()
+{
+  std::istringstream maps{
+    "7f0000002000-7f0000003000 r-xp 00001000 08:01 1234    /usr/lib/libc.so\n"
+    "55d000000000-55d000001000 r--p 00000000 08:01 5678    /usr/bin/app\n"
+    "7f0000000000-7f0000001000 ---p 00000000 00:00 0\n"
+    "7f0000001000-7f0000002000 rw-p 00000000 00:00 0       [heap]\n"
+    "7f0000003000-7f0000004000 rw-s 00000000 00:05 42      /dev/shm/x\n"
+    "ffffffffff600000-ffffffffff601000 --xp 00000000 00:00 0 [vsyscall]\n"};
+  auto const regions = hadesmem::detail::ParseProcMaps(maps);
+  BOOST_TEST_EQ(regions.size(), 5U);
+
+  BOOST_TEST_EQ(regions[0].BaseAddress,
+                reinterpret_cast<PVOID>(0x55d000000000ULL));
+  BOOST_TEST_EQ(regions[0].Protect, static_cast<DWORD>(PAGE_READONLY));
+  BOOST_TEST_EQ(regions[0].Type, static_cast<DWORD>(MEM_MAPPED));
+
+  BOOST_TEST_EQ(regions[1].State, static_cast<DWORD>(MEM_RESERVE));
+  BOOST_TEST(!hadesmem::detail::IsRegionReadable(regions[1]));
+
+  BOOST_TEST_EQ(regions[2].Protect, static_cast<DWORD>(PAGE_READWRITE));
+  BOOST_TEST_EQ(regions[2].Type, static_cast<DWORD>(MEM_PRIVATE));
+  BOOST_TEST_EQ(regions[3].Protect, static_cast<DWORD>(PAGE_EXECUTE_READ));
+  BOOST_TEST_EQ(regions[3].RegionSize, 0x1000U);
+  BOOST_TEST_EQ(regions[4].Protect, static_cast<DWORD>(PAGE_READWRITE));
+
+  // Queries in a gap synthesize a free region.
+  auto const in_region = hadesmem::detail::QueryRegionList(
+    regions, reinterpret_cast<void*>(0x7f0000001800ULL));
+  BOOST_TEST_EQ(in_region.BaseAddress,
+                reinterpret_cast<PVOID>(0x7f0000001000ULL));
+  auto const in_gap = hadesmem::detail::QueryRegionList(
+    regions, reinterpret_cast<void*>(0x600000000000ULL));
+  BOOST_TEST_EQ(in_gap.State, static_cast<DWORD>(MEM_FREE));
+  BOOST_TEST_EQ(in_gap.BaseAddress,
+                reinterpret_cast<PVOID>(0x55d000001000ULL));
+  BOOST_TEST_EQ(in_gap.RegionSize, 0x7f0000000000ULL - 0x55d000001000ULL);
+  auto const below = hadesmem::detail::QueryRegionList(
+    regions, reinterpret_cast<void*>(0x1000));
+  BOOST_TEST_EQ(below.BaseAddress, static_cast<PVOID>(nullptr));
+
+  std::istringstream bad_maps{"not a valid line\n"};
+  BOOST_TEST_THROWS(hadesmem::detail::ParseProcMaps(bad_maps),
+                    hadesmem::Error);
+}
+
+void TestBufferMemorySource()
+{
+  // A snapshot presented at its original (fake) address.
+  std::vector<std::uint8_t> snapshot(0x100);
+  for (std::size_t i = 0; i < snapshot.size(); ++i)
+  {
+    snapshot[i] = static_cast<std::uint8_t>(i);
+  }
+  auto const fake_base = reinterpret_cast<std::uint8_t*>(0x10000000);
+  hadesmem::BufferMemorySource const source{
+    snapshot.data(), snapshot.size(), fake_base};
+  BOOST_TEST_EQ(source.GetBase(), static_cast<void*>(fake_base));
+  BOOST_TEST_EQ(
+    hadesmem::detail::SourceRead<std::uint8_t>(source, fake_base + 0x42),
+    0x42);
+  hadesmem::detail::SourceWrite<std::uint8_t>(source, fake_base + 0x42, 0xFF);
+  BOOST_TEST_EQ(snapshot[0x42], 0xFF);
+  BOOST_TEST_THROWS(
+    hadesmem::detail::SourceRead<std::uint32_t>(source, fake_base + 0xFE),
+    hadesmem::Error);
+  BOOST_TEST_THROWS(
+    hadesmem::detail::SourceRead<std::uint8_t>(source, fake_base - 1),
+    hadesmem::Error);
+
+  auto const regions = source.GetRegions();
+  BOOST_TEST_EQ(regions.size(), 1U);
+  BOOST_TEST_EQ(source.Query(fake_base + 0x80).BaseAddress,
+                static_cast<PVOID>(fake_base));
+  BOOST_TEST_EQ(source.Query(fake_base + 0x100).State,
+                static_cast<DWORD>(MEM_FREE));
+
+  auto const needle = hadesmem::detail::ConvertData(L"10 11 ?? 13");
+  BOOST_TEST_EQ(hadesmem::detail::FindRaw(source,
+                                          fake_base,
+                                          fake_base + snapshot.size(),
+                                          std::begin(needle),
+                                          std::end(needle)),
+                static_cast<void*>(fake_base + 0x10));
+
+  std::vector<std::uint8_t> const read_only(0x10);
+  hadesmem::BufferMemorySource const source_ro{read_only.data(),
+                                               read_only.size()};
+  BOOST_TEST_EQ(source_ro.GetRegions()[0].Protect,
+                static_cast<DWORD>(PAGE_READONLY));
+  BOOST_TEST_THROWS(hadesmem::detail::SourceWrite<std::uint8_t>(
+                      source_ro, const_cast<std::uint8_t*>(&read_only[0]), 1),
+                    hadesmem::Error);
+
+}
+
+void TestLocalMemorySource()
+{
+  TestGenericSource(hadesmem::LocalMemorySource{});
+}
+
+void TestProcessMemorySource()
+{
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  hadesmem::Process const process{::GetCurrentProcessId()};
+  TestGenericSource(hadesmem::ProcessMemorySource{process});
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  hadesmem::Process const process{static_cast<DWORD>(::getpid())};
+  hadesmem::ProcMemorySource const source{process};
+  TestGenericSource(source);
+
+  std::uint32_t value = 0;
+  BOOST_TEST_THROWS(source.Read(nullptr, &value, sizeof(value)),
+                    hadesmem::Error);
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+int main()
+{
+  TestParseProcMaps();
+  TestBufferMemorySource();
+  TestLocalMemorySource();
+  TestProcessMemorySource();
+  return boost::report_errors();
+}
@@ -0,0 +1,292 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/page_cache.hpp>
+#include <hadesmem/page_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/cached_process_view.hpp>
+#include <hadesmem/module.hpp>
+#include <hadesmem/pelib/export_list.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace
+{
+std::size_t const kPageSize = 0x1000;
+
+// Fake address space backed by a page aligned buffer, with an optional
+// unreadable page.
+class MockMemory
+{
+public:
+  MockMemory() : storage_(0x20 * kPageSize + kPageSize)
+  {
+    auto const addr = reinterpret_cast<std::uintptr_t>(storage_.data());
+    base_ = storage_.data() + ((kPageSize - (addr & (kPageSize - 1))) %
+                               kPageSize);
+    std::iota(base_, base_ + 0x20 * kPageSize, static_cast<std::uint8_t>(0));
+  }
+
+  std::uint8_t* At(std::size_t offset)
+  {
+    return base_ + offset;
+  }
+
+  void SetBadPage(std::size_t offset)
+  {
+    bad_page_ = At(offset);
+  }
+
+  void Fetch(void* address, void* data, std::size_t len)
+  {
+    BOOST_TEST_EQ(reinterpret_cast<std::uintptr_t>(address) % kPageSize, 0U);
+    BOOST_TEST_EQ(len % kPageSize, 0U);
+
+    ++count_;
+
+    auto const beg = static_cast<std::uint8_t*>(address);
+    if (bad_page_ && bad_page_ >= beg && bad_page_ < beg + len)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        hadesmem::Error{} << hadesmem::ErrorString{"Unreadable."});
+    }
+
+    std::memcpy(data, address, len);
+  }
+
+  std::size_t GetCount() const noexcept
+  {
+    return count_;
+  }
+
+private:
+  std::vector<std::uint8_t> storage_;
+  std::uint8_t* base_{};
+  std::uint8_t* bad_page_{};
+  std::size_t count_{};
+};
+
+template <typename T>
+T DoRead(hadesmem::PageCache& cache, MockMemory& mem, void* p)
+{
+  T data;
+  cache.Read(p, &data, sizeof(data), [&](void* a, void* d, std::size_t l) {
+    mem.Fetch(a, d, l);
+  });
+  return data;
+}
+
+template <typename T> T Expected(void* p)
+{
+  T data;
+  std::memcpy(&data, p, sizeof(data));
+  return data;
+}
+}
+
+void TestPageCacheMock()
+{
+  MockMemory mem;
+  hadesmem::PageCache cache{4 * kPageSize, kPageSize};
+  auto const fetch = [&](void* a, void* d, std::size_t l) {
+    mem.Fetch(a, d, l);
+  };
+
+  BOOST_TEST_EQ(cache.GetBudget(), 4 * kPageSize);
+
+  // Lots of small reads from the same page (e.g. PE headers) only fetch once.
+  for (std::size_t i = 0; i < 0x100; i += 4)
+  {
+    BOOST_TEST_EQ(DoRead<std::uint32_t>(cache, mem, mem.At(i)),
+                  Expected<std::uint32_t>(mem.At(i)));
+  }
+  BOOST_TEST_EQ(mem.GetCount(), 1U);
+  BOOST_TEST_EQ(cache.GetMisses(), 1U);
+  BOOST_TEST_EQ(cache.GetHits(), 0x40U - 1);
+
+  // Reads straddling a page boundary work, and consecutive missing pages are
+  // fetched together.
+  std::vector<std::uint8_t> buf(2 * kPageSize + 0x20);
+  cache.Read(mem.At(kPageSize - 0x10), buf.data(), buf.size(), fetch);
+  BOOST_TEST_EQ(
+    std::memcmp(buf.data(), mem.At(kPageSize - 0x10), buf.size()), 0);
+  BOOST_TEST_EQ(mem.GetCount(), 2U);
+  BOOST_TEST_EQ(cache.GetFetches(), 2U);
+  BOOST_TEST_EQ(cache.GetSize(), 4U);
+
+  // Budget is 4 pages, so page 0 (least recently used) is evicted.
+  BOOST_TEST_EQ(DoRead<std::uint32_t>(cache, mem, mem.At(1 * kPageSize)),
+                Expected<std::uint32_t>(mem.At(1 * kPageSize)));
+  BOOST_TEST_EQ(DoRead<std::uint32_t>(cache, mem, mem.At(4 * kPageSize)),
+                Expected<std::uint32_t>(mem.At(4 * kPageSize)));
+  BOOST_TEST_EQ(cache.GetEvictions(), 1U);
+  BOOST_TEST_EQ(cache.GetSize(), 4U);
+  auto const count_after_evict = mem.GetCount();
+  DoRead<std::uint32_t>(cache, mem, mem.At(1 * kPageSize));
+  DoRead<std::uint32_t>(cache, mem, mem.At(4 * kPageSize));
+  BOOST_TEST_EQ(mem.GetCount(), count_after_evict);
+  DoRead<std::uint32_t>(cache, mem, mem.At(0));
+  BOOST_TEST_EQ(mem.GetCount(), count_after_evict + 1);
+
+  // A hole in the middle of the range splits the fetch. Pages 0, 1 and 4 are
+  // cached at this point, so reading 0-5 needs two fetches (2-3 and 5).
+  hadesmem::PageCache big_cache{0x10 * kPageSize, kPageSize};
+  std::vector<std::uint8_t> wide(6 * kPageSize);
+  for (std::size_t page : {0U, 1U, 4U})
+  {
+    DoRead<std::uint8_t>(big_cache, mem, mem.At(page * kPageSize));
+  }
+  auto const count_before_split = mem.GetCount();
+  big_cache.Read(mem.At(0), wide.data(), wide.size(), fetch);
+  BOOST_TEST_EQ(std::memcmp(wide.data(), mem.At(0), wide.size()), 0);
+  BOOST_TEST_EQ(mem.GetCount(), count_before_split + 2);
+
+  // Write-through keeps the cached copy up to date without another fetch.
+  std::uint32_t const new_value = 0xDEADBEEF;
+  std::memcpy(mem.At(0x10), &new_value, sizeof(new_value));
+  BOOST_TEST(DoRead<std::uint32_t>(big_cache, mem, mem.At(0x10)) != new_value);
+  big_cache.Update(mem.At(0x10), &new_value, sizeof(new_value));
+  auto const count_before_update = mem.GetCount();
+  BOOST_TEST_EQ(DoRead<std::uint32_t>(big_cache, mem, mem.At(0x10)), new_value);
+  BOOST_TEST_EQ(mem.GetCount(), count_before_update);
+
+  // Invalidation (e.g. for a write without write-through) forces a fetch.
+  std::uint32_t const newer_value = 0xCAFEBABE;
+  std::memcpy(mem.At(0x10), &newer_value, sizeof(newer_value));
+  big_cache.Invalidate(mem.At(0x10), sizeof(newer_value));
+  BOOST_TEST_EQ(DoRead<std::uint32_t>(big_cache, mem, mem.At(0x10)),
+                newer_value);
+  BOOST_TEST_EQ(mem.GetCount(), count_before_update + 1);
+
+  // Invalidating a range larger than the cache.
+  BOOST_TEST(big_cache.GetSize() > 1U);
+  big_cache.Invalidate(mem.At(0), 0x100000 * kPageSize);
+  BOOST_TEST_EQ(big_cache.GetSize(), 0U);
+
+  // Strings are read a page at a time, and never past the page containing the
+  // terminator.
+  char const str[] = "Hello, World!";
+  std::size_t const str_offset = 8 * kPageSize - 5;
+  std::memcpy(mem.At(str_offset), str, sizeof(str));
+  mem.SetBadPage(9 * kPageSize);
+  BOOST_TEST_EQ(big_cache.ReadString<char>(mem.At(str_offset), fetch),
+                std::string(str));
+
+  // A bounded read stops at the bound even without a terminator.
+  BOOST_TEST_EQ(big_cache.ReadString<char>(mem.At(str_offset),
+                                           fetch,
+                                           mem.At(str_offset + 5)),
+                std::string("Hello"));
+
+  // Failed fetches propagate and aren't cached.
+  auto const size_before_fail = big_cache.GetSize();
+  std::vector<std::uint8_t> bad(2 * kPageSize);
+  BOOST_TEST_THROWS(
+    big_cache.Read(mem.At(8 * kPageSize + 0x10), bad.data(), bad.size(), fetch),
+    hadesmem::Error);
+  BOOST_TEST_EQ(big_cache.GetSize(), size_before_fail);
+
+  // A new epoch drops everything.
+  auto const epoch = big_cache.GetEpoch();
+  big_cache.NewEpoch();
+  BOOST_TEST_EQ(big_cache.GetEpoch(), epoch + 1);
+  BOOST_TEST_EQ(big_cache.GetSize(), 0U);
+}
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestCachedProcessView()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+  hadesmem::CachedProcessView const view(process);
+
+  std::vector<std::uint32_t> data(0x1000);
+  std::iota(std::begin(data), std::end(data), 0U);
+  BOOST_TEST_EQ(view.Read<std::uint32_t>(&data[10]), 10U);
+  BOOST_TEST(view.ReadVector<std::uint32_t>(data.data(), data.size()) == data);
+
+  std::wstring const str = L"Cached string";
+  BOOST_TEST(view.ReadString<wchar_t>(const_cast<wchar_t*>(str.c_str())) ==
+             str);
+
+  // Without write-through, writes invalidate the cached copy.
+  view.Write(&data[10], 1234U);
+  BOOST_TEST_EQ(data[10], 1234U);
+  BOOST_TEST_EQ(view.Read<std::uint32_t>(&data[10]), 1234U);
+
+  // Changes made behind our back aren't seen until the next epoch.
+  data[11] = 5678U;
+  BOOST_TEST_EQ(view.Read<std::uint32_t>(&data[11]), 11U);
+  view.NewEpoch();
+  BOOST_TEST_EQ(view.Read<std::uint32_t>(&data[11]), 5678U);
+
+  hadesmem::CachedProcessView const view_wt(
+    process,
+    hadesmem::PageCache::kDefaultBudget,
+    hadesmem::CachedProcessViewFlags::kWriteThrough);
+  BOOST_TEST_EQ(view_wt.Read<std::uint32_t>(&data[12]), 12U);
+  auto const misses = view_wt.GetPageCache()->GetMisses();
+  view_wt.Write(&data[12], 4321U);
+  BOOST_TEST_EQ(data[12], 4321U);
+  BOOST_TEST_EQ(view_wt.Read<std::uint32_t>(&data[12]), 4321U);
+  BOOST_TEST_EQ(view_wt.GetPageCache()->GetMisses(), misses);
+
+  hadesmem::CachedProcessView const view_assume(
+    process,
+    hadesmem::PageCache::kDefaultBudget,
+    hadesmem::CachedProcessViewFlags::kAssumeAccessible);
+  BOOST_TEST_EQ(view_assume.Read<std::uint32_t>(&data[13]), 13U);
+
+  // Walking the exports of a live image through the cache gives the same
+  // results, with far fewer calls to ReadProcessMemory.
+  hadesmem::Module const module(process, L"kernel32");
+  hadesmem::PeFile const pe_file(
+    process, module.GetHandle(), hadesmem::PeFileType::kImage, 0);
+  hadesmem::PeFile pe_file_cached(pe_file);
+  pe_file_cached.SetPageCache(view.GetPageCache());
+  BOOST_TEST(pe_file_cached.GetPageCache() == view.GetPageCache().get());
+  hadesmem::ExportList const exports(process, pe_file);
+  hadesmem::ExportList const exports_cached(process, pe_file_cached);
+  auto iter = std::begin(exports);
+  auto iter_cached = std::begin(exports_cached);
+  std::size_t num_exports = 0;
+  for (; iter != std::end(exports) && iter_cached != std::end(exports_cached);
+       ++iter, ++iter_cached, ++num_exports)
+  {
+    BOOST_TEST_EQ(iter->GetRva(), iter_cached->GetRva());
+    BOOST_TEST_EQ(iter->GetName(), iter_cached->GetName());
+  }
+  BOOST_TEST(iter == std::end(exports));
+  BOOST_TEST(iter_cached == std::end(exports_cached));
+  BOOST_TEST(num_exports > 0);
+  auto const cache = view.GetPageCache();
+  BOOST_TEST(cache->GetHits() > cache->GetFetches() * 10);
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+int main()
+{
+  TestPageCacheMock();
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestCachedProcessView();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  return boost::report_errors();
+}
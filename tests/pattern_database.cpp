@@ -0,0 +1,228 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/pattern_database.hpp>
+#include <hadesmem/detail/pattern_database.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/error.hpp>
+
+namespace
+{
+hadesmem::detail::CompiledPattern CompileString(wchar_t const* data)
+{
+  auto const needle = hadesmem::detail::ConvertData(data);
+  return hadesmem::detail::CompilePattern(std::begin(needle), std::end(needle));
+}
+
+hadesmem::detail::PatternDatabasePattern
+  MakeRecord(std::uint32_t flags,
+             hadesmem::detail::PatternDatabaseStart start_type,
+             std::uint64_t start,
+             std::uint32_t wave)
+{
+  hadesmem::detail::PatternDatabasePattern record{};
+  record.flags = flags;
+  record.start_type = static_cast<std::uint32_t>(start_type);
+  record.start = start;
+  record.wave = wave;
+  return record;
+}
+
+// Two modules, with a pattern which starts at another one, and one of each
+// kind of start and manipulator.
+std::vector<std::uint8_t> MakeDatabase()
+{
+  using hadesmem::detail::PatternDatabaseManipulator;
+  using hadesmem::detail::PatternDatabaseOp;
+  using hadesmem::detail::PatternDatabaseStart;
+
+  hadesmem::detail::PatternDatabaseWriter writer;
+  writer.AddModule(L"FOO.DLL", 2);
+  writer.AddPattern(L"First",
+                    CompileString(L"55 8B EC ?? 3?"),
+                    MakeRecord(1, PatternDatabaseStart::kNone, 0, 0),
+                    std::wstring{},
+                    {PatternDatabaseManipulator{
+                       static_cast<std::uint32_t>(PatternDatabaseOp::kAdd),
+                       1,
+                       0x10,
+                       0},
+                     PatternDatabaseManipulator{
+                       static_cast<std::uint32_t>(PatternDatabaseOp::kRel),
+                       2,
+                       5,
+                       1}});
+  writer.AddPattern(L"Second",
+                    CompileString(L"E8"),
+                    MakeRecord(0, PatternDatabaseStart::kPattern, 0, 1),
+                    std::wstring{},
+                    {});
+  writer.AddPattern(L"Third",
+                    CompileString(L"?? ??"),
+                    MakeRecord(0, PatternDatabaseStart::kExportName, 0, 0),
+                    L"Export",
+                    {PatternDatabaseManipulator{
+                      static_cast<std::uint32_t>(PatternDatabaseOp::kLea),
+                      0,
+                      0,
+                      0}});
+  writer.AddModule(L"BAR.DLL", 1);
+  writer.AddPattern(L"Fourth",
+                    CompileString(L"C3"),
+                    MakeRecord(0, PatternDatabaseStart::kRva, 0x1000, 0),
+                    std::wstring{},
+                    {});
+  writer.AddPattern(L"Fifth",
+                    CompileString(L"CC"),
+                    MakeRecord(0, PatternDatabaseStart::kExportOrdinal, 3, 0),
+                    std::wstring{},
+                    {});
+  return writer.GetData();
+}
+
+// Checks that a copy of the database with the given change is rejected.
+template <typename T>
+void CheckInvalid(std::vector<std::uint8_t> const& data,
+                  std::size_t offset,
+                  T value)
+{
+  auto copy = data;
+  std::memcpy(copy.data() + offset, &value, sizeof(value));
+  BOOST_TEST_THROWS(
+    hadesmem::detail::PatternDatabaseView(copy.data(), copy.size()),
+    hadesmem::Error);
+}
+
+std::size_t GetPatternOffset(std::size_t num_modules, std::size_t index)
+{
+  return sizeof(hadesmem::detail::PatternDatabaseHeader) +
+         num_modules * sizeof(hadesmem::detail::PatternDatabaseModule) +
+         index * sizeof(hadesmem::detail::PatternDatabasePattern);
+}
+}
+
+void TestPatternDatabase()
+{
+  using hadesmem::detail::PatternDatabaseOp;
+  using hadesmem::detail::PatternDatabaseStart;
+
+  auto const data = MakeDatabase();
+  hadesmem::detail::PatternDatabaseView const view{data.data(), data.size()};
+  BOOST_TEST_EQ(view.GetNumModules(), 2U);
+
+  auto const& foo = view.GetModule(0);
+  BOOST_TEST(view.GetName(foo) == L"FOO.DLL");
+  BOOST_TEST_EQ(foo.num_patterns, 3U);
+  BOOST_TEST_EQ(foo.num_waves, 2U);
+
+  auto const& first = view.GetPattern(foo, 0);
+  BOOST_TEST(view.GetName(first) == L"First");
+  BOOST_TEST_EQ(first.flags, 1U);
+  auto const first_pattern = view.GetCompiledPattern(first);
+  auto const expected = CompileString(L"55 8B EC ?? 3?");
+  BOOST_TEST(first_pattern.value == expected.value);
+  BOOST_TEST(first_pattern.mask == expected.mask);
+  BOOST_TEST_EQ(first_pattern.anchor, expected.anchor);
+  BOOST_TEST_EQ(first_pattern.check, expected.check);
+  BOOST_TEST_EQ(first.num_manipulators, 2U);
+  auto const& rel = view.GetManipulator(first, 1);
+  BOOST_TEST_EQ(rel.op, static_cast<std::uint32_t>(PatternDatabaseOp::kRel));
+  BOOST_TEST_EQ(rel.operand1, 5U);
+  BOOST_TEST_EQ(rel.operand2, 1U);
+
+  auto const& second = view.GetPattern(foo, 1);
+  BOOST_TEST_EQ(second.start, 0U);
+  BOOST_TEST_EQ(second.wave, 1U);
+
+  auto const& third = view.GetPattern(foo, 2);
+  BOOST_TEST(view.GetString(static_cast<std::uint32_t>(third.start),
+                            third.start_length) == L"Export");
+  auto const third_pattern = view.GetCompiledPattern(third);
+  BOOST_TEST_EQ(third_pattern.anchor, hadesmem::detail::kNoPatternMatch);
+  BOOST_TEST_EQ(third_pattern.check, hadesmem::detail::kNoPatternMatch);
+  BOOST_TEST_EQ(view.GetManipulator(third, 0).op,
+                static_cast<std::uint32_t>(PatternDatabaseOp::kLea));
+
+  auto const& bar = view.GetModule(1);
+  BOOST_TEST(view.GetName(bar) == L"BAR.DLL");
+  BOOST_TEST_EQ(bar.num_patterns, 2U);
+  BOOST_TEST_EQ(view.GetPattern(bar, 0).start, 0x1000U);
+  BOOST_TEST_EQ(
+    view.GetPattern(bar, 1).start_type,
+    static_cast<std::uint32_t>(PatternDatabaseStart::kExportOrdinal));
+
+  hadesmem::detail::PatternDatabaseView const empty;
+  BOOST_TEST_EQ(empty.GetNumModules(), 0U);
+
+  auto const nothing = hadesmem::detail::PatternDatabaseWriter{}.GetData();
+  hadesmem::detail::PatternDatabaseView const nothing_view{nothing.data(),
+                                                           nothing.size()};
+  BOOST_TEST_EQ(nothing_view.GetNumModules(), 0U);
+}
+
+void TestPatternDatabaseInvalid()
+{
+  using hadesmem::detail::PatternDatabasePattern;
+
+  auto const data = MakeDatabase();
+  BOOST_TEST_THROWS(
+    hadesmem::detail::PatternDatabaseView(data.data(), data.size() - 1),
+    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::detail::PatternDatabaseView(data.data(), 16),
+                    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::detail::PatternDatabaseView(nullptr, 0),
+                    hadesmem::Error);
+
+  // The header.
+  CheckInvalid(data, 0, std::uint32_t{0});
+  CheckInvalid(data, 4, std::uint32_t{2});
+  CheckInvalid(data, 8, std::uint32_t{0});
+  CheckInvalid(data, 12, std::uint32_t{3});
+
+  // The patterns.
+  auto const second = GetPatternOffset(2, 1);
+  auto const third = GetPatternOffset(2, 2);
+  auto const fifth = GetPatternOffset(2, 4);
+  CheckInvalid(
+    data, second + offsetof(PatternDatabasePattern, start), std::uint64_t{1});
+  CheckInvalid(
+    data, second + offsetof(PatternDatabasePattern, wave), std::uint32_t{0});
+  CheckInvalid(
+    data, second + offsetof(PatternDatabasePattern, anchor), std::uint32_t{1});
+  CheckInvalid(data,
+               second + offsetof(PatternDatabasePattern, start_type),
+               std::uint32_t{5});
+  CheckInvalid(data,
+               third + offsetof(PatternDatabasePattern, start_length),
+               std::uint32_t{0x1000});
+  CheckInvalid(data,
+               fifth + offsetof(PatternDatabasePattern, start),
+               std::uint64_t{0x10000});
+  CheckInvalid(data,
+               fifth + offsetof(PatternDatabasePattern, num_manipulators),
+               std::uint32_t{1});
+
+  // The manipulators.
+  auto const manipulators = GetPatternOffset(2, 5);
+  CheckInvalid(data, manipulators, std::uint32_t{5});
+  CheckInvalid(data, manipulators + 4, std::uint32_t{2});
+}
+
+int main()
+{
+  TestPatternDatabase();
+  TestPatternDatabaseInvalid();
+  return boost::report_errors();
+}
@@ -0,0 +1,98 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pattern_literal.hpp>
+#include <hadesmem/pattern_literal.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/find_raw.hpp>
+#include <hadesmem/error.hpp>
+
+// A malformed pattern fails to compile, e.g.
+//   constexpr auto bad = HADESMEM_PATTERN("FF ZZ");
+
+namespace
+{
+constexpr auto kPattern = HADESMEM_PATTERN(" 8D 8D\t40 FF ?? ?? 3? ?d 0 ");
+static_assert(kPattern.bytes.size() == 9, "Wrong pattern size.");
+static_assert(kPattern.anchor == 2, "Wrong pattern anchor.");
+static_assert(kPattern.check == 0, "Wrong pattern check.");
+
+void CheckConvertData(char const* str,
+                      std::vector<std::uint8_t> const& value,
+                      std::vector<std::uint8_t> const& mask,
+                      std::size_t anchor,
+                      std::size_t check)
+{
+  std::string const narrow{str};
+  auto const needle =
+    hadesmem::detail::ConvertData(std::wstring(narrow.begin(), narrow.end()));
+  auto const expected =
+    hadesmem::detail::CompilePattern(std::begin(needle), std::end(needle));
+  BOOST_TEST(expected.value == value);
+  BOOST_TEST(expected.mask == mask);
+  BOOST_TEST_EQ(expected.anchor, anchor);
+  BOOST_TEST_EQ(expected.check, check);
+}
+}
+
+void TestPatternLiteral()
+{
+  auto const pattern = hadesmem::detail::CompilePattern(kPattern);
+  std::vector<std::uint8_t> const value = {
+    0x8D, 0x8D, 0x40, 0xFF, 0x00, 0x00, 0x30, 0x0D, 0x00};
+  std::vector<std::uint8_t> const mask = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0xF0, 0x0F, 0xFF};
+  BOOST_TEST(pattern.value == value);
+  BOOST_TEST(pattern.mask == mask);
+  BOOST_TEST_EQ(pattern.anchor, 2U);
+  BOOST_TEST_EQ(pattern.check, 0U);
+
+  // The same as parsing the pattern at runtime.
+  CheckConvertData(" 8D 8D\t40 FF ?? ?? 3? ?d 0 ", value, mask, 2, 0);
+
+  constexpr auto single = HADESMEM_PATTERN("?? E8 ??");
+  BOOST_TEST_EQ(single.anchor, 1U);
+  BOOST_TEST_EQ(single.check, 1U);
+
+  constexpr auto wildcards = HADESMEM_PATTERN("?? ??");
+  BOOST_TEST_EQ(wildcards.anchor, hadesmem::detail::kNoPatternMatch);
+  BOOST_TEST_EQ(wildcards.check, hadesmem::detail::kNoPatternMatch);
+
+  constexpr auto nibbles = HADESMEM_PATTERN("?5 3D 3?");
+  auto const nibbles_needle = hadesmem::detail::ConvertData(L"?5 3D 3?");
+  auto const nibbles_pattern = hadesmem::detail::CompilePattern(
+    std::begin(nibbles_needle), std::end(nibbles_needle));
+  BOOST_TEST_EQ(nibbles.anchor, nibbles_pattern.anchor);
+  BOOST_TEST_EQ(nibbles.check, nibbles_pattern.check);
+}
+
+void TestPatternLiteralInvalid()
+{
+  // Outside of a constant expression the checks throw instead.
+  char const* const invalid[] = {"FF ZZ", "FF ???", "?", "100", "G?", "0x1"};
+  for (auto const str : invalid)
+  {
+    BOOST_TEST_THROWS(hadesmem::detail::CountPatternLiteralBytes(str),
+                      hadesmem::Error);
+  }
+
+  BOOST_TEST_EQ(hadesmem::detail::CountPatternLiteralBytes(""), 0U);
+  BOOST_TEST_EQ(hadesmem::detail::CountPatternLiteralBytes(" 0 ff "), 2U);
+}
+
+int main()
+{
+  TestPatternLiteral();
+  TestPatternLiteralInvalid();
+  return boost::report_errors();
+}
@@ -4,8 +4,11 @@
 #include <hadesmem/pelib/export_list.hpp>
 #include <hadesmem/pelib/export_list.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
@@ -13,13 +16,21 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/pelib/export.hpp>
 #include <hadesmem/pelib/export_dir.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include "sample_pe.hpp"
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
 // Export something to ensure tests pass...
 extern "C" __declspec(dllexport) void Dummy();
@@ -93,8 +104,73 @@ void TestExportList()
   BOOST_TEST(processed_one_export_list);
 }
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestExportListSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  hadesmem::PeFile const pe_file(process,
+                                 file.data(),
+                                 hadesmem::PeFileType::kData,
+                                 static_cast<DWORD>(file.size()),
+                                 hadesmem::PeFileBacking::kBuffer);
+
+  hadesmem::ExportDir const export_dir(process, pe_file);
+  BOOST_TEST_EQ(export_dir.GetName(), is_64 ? "sample64.dll" : "sample32.dll");
+  BOOST_TEST_EQ(export_dir.GetTimeDateStamp(), 0x5A5A5A5AUL);
+  BOOST_TEST_EQ(export_dir.GetOrdinalBase(), 1UL);
+  BOOST_TEST_EQ(export_dir.GetNumberOfFunctions(), 4UL);
+  BOOST_TEST_EQ(export_dir.GetNumberOfNames(), 3UL);
+  BOOST_TEST_EQ(export_dir.GetAddressOfFunctions(), 0x2028UL);
+
+  std::vector<hadesmem::Export> exports;
+  hadesmem::ExportList const export_list(process, pe_file);
+  std::copy(std::begin(export_list),
+            std::end(export_list),
+            std::back_inserter(exports));
+  BOOST_TEST_EQ(exports.size(), 4U);
+  if (exports.size() != 4)
+  {
+    return;
+  }
+
+  BOOST_TEST_EQ(exports[0].GetProcedureNumber(), 1);
+  BOOST_TEST_EQ(exports[0].GetOrdinalNumber(), 0);
+  BOOST_TEST(exports[0].ByName());
+  BOOST_TEST_EQ(exports[0].GetName(), "Alpha");
+  BOOST_TEST_EQ(exports[0].GetRva(), 0x1000UL);
+  BOOST_TEST_EQ(exports[0].GetVa(), static_cast<void*>(file.data() + 0x400));
+  BOOST_TEST(!exports[0].IsForwarded());
+
+  BOOST_TEST_EQ(exports[1].GetName(), "Beta");
+  BOOST_TEST_EQ(exports[1].GetRva(), 0x1010UL);
+
+  BOOST_TEST_EQ(exports[2].GetProcedureNumber(), 3);
+  BOOST_TEST(exports[2].ByOrdinal());
+  BOOST_TEST(!exports[2].ByName());
+  BOOST_TEST_EQ(exports[2].GetRva(), 0x1020UL);
+
+  BOOST_TEST_EQ(exports[3].GetProcedureNumber(), 4);
+  BOOST_TEST_EQ(exports[3].GetName(), "Gamma");
+  BOOST_TEST(exports[3].IsForwarded());
+  BOOST_TEST_EQ(exports[3].GetForwarder(), "other.Delta");
+  BOOST_TEST_EQ(exports[3].GetForwarderModule(), "other");
+  BOOST_TEST_EQ(exports[3].GetForwarderFunction(), "Delta");
+  BOOST_TEST(!exports[3].IsForwardedByOrdinal());
+
+  hadesmem::Export const beta(process, pe_file, 2);
+  BOOST_TEST_EQ(beta.GetName(), "Beta");
+  BOOST_TEST_THROWS(hadesmem::Export(process, pe_file, 5), hadesmem::Error);
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestExportList();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestExportListSample("sample32.dll", false);
+  TestExportListSample("sample64.dll", true);
   return boost::report_errors();
 }
@@ -4,8 +4,12 @@
 #include <hadesmem/pelib/import_dir_list.hpp>
 #include <hadesmem/pelib/import_dir_list.hpp>
 
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
@@ -13,17 +17,25 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/pelib/import_dir.hpp>
 #include <hadesmem/pelib/import_thunk.hpp>
 #include <hadesmem/pelib/import_thunk_list.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include "sample_pe.hpp"
 
 // TODO: Split up and improve these import tests.
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 // Export something to ensure tests pass...
 extern "C" __declspec(dllexport) void Dummy();
 extern "C" __declspec(dllexport) void Dummy()
@@ -158,8 +170,72 @@ void TestImportDirList()
   BOOST_TEST(processed_one_import_dir);
 }
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestImportDirListSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  hadesmem::PeFile const pe_file(process,
+                                 file.data(),
+                                 hadesmem::PeFileType::kData,
+                                 static_cast<DWORD>(file.size()),
+                                 hadesmem::PeFileBacking::kBuffer);
+
+  std::vector<hadesmem::ImportDir> import_dirs;
+  hadesmem::ImportDirList const import_dir_list(process, pe_file);
+  std::copy(std::begin(import_dir_list),
+            std::end(import_dir_list),
+            std::back_inserter(import_dirs));
+  BOOST_TEST_EQ(import_dirs.size(), 1U);
+  if (import_dirs.size() != 1)
+  {
+    return;
+  }
+
+  auto const& import_dir = import_dirs[0];
+  BOOST_TEST_EQ(import_dir.GetBase(), static_cast<void*>(file.data() + 0x700));
+  BOOST_TEST_EQ(import_dir.GetName(), "kernel32.dll");
+  BOOST_TEST_EQ(import_dir.GetOriginalFirstThunk(), 0x2130UL);
+  BOOST_TEST_EQ(import_dir.GetFirstThunk(), 0x2150UL);
+  BOOST_TEST_EQ(import_dir.GetTimeDateStamp(), 0UL);
+  BOOST_TEST(!import_dir.IsVirtualBegin());
+  BOOST_TEST(!import_dir.IsVirtualTerminated());
+  BOOST_TEST(!import_dir.IsTlsAoiTerminated());
+
+  for (auto const thunk_rva :
+       {import_dir.GetOriginalFirstThunk(), import_dir.GetFirstThunk()})
+  {
+    std::vector<hadesmem::ImportThunk> thunks;
+    hadesmem::ImportThunkList const thunk_list(process, pe_file, thunk_rva);
+    std::copy(
+      std::begin(thunk_list), std::end(thunk_list), std::back_inserter(thunks));
+    BOOST_TEST_EQ(thunks.size(), 2U);
+    if (thunks.size() != 2)
+    {
+      continue;
+    }
+
+    BOOST_TEST(!thunks[0].ByOrdinal());
+    BOOST_TEST_EQ(thunks[0].GetAddressOfData(), 0x2180ULL);
+    BOOST_TEST_EQ(thunks[0].GetHint(), 0x10);
+    BOOST_TEST_EQ(thunks[0].GetName(), "GetCurrentProcessId");
+
+    BOOST_TEST(thunks[1].ByOrdinal());
+    BOOST_TEST_EQ(thunks[1].GetOrdinal(), 5);
+    BOOST_TEST_EQ(thunks[1].GetBase(),
+                  static_cast<void*>(file.data() + thunk_rva - 0x2000 + 0x600 +
+                                     (is_64 ? 8 : 4)));
+  }
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestImportDirList();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestImportDirListSample("sample32.dll", false);
+  TestImportDirListSample("sample64.dll", true);
   return boost::report_errors();
 }
@@ -13,11 +13,19 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include "sample_pe.hpp"
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 
 void TestNtHeaders()
 {
@@ -142,8 +150,69 @@ void TestNtHeaders()
   }
 }
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestNtHeadersSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  hadesmem::PeFile const pe_file(process,
+                                 file.data(),
+                                 hadesmem::PeFileType::kData,
+                                 static_cast<DWORD>(file.size()),
+                                 hadesmem::PeFileBacking::kBuffer);
+  hadesmem::NtHeaders nt_headers(process, pe_file);
+  BOOST_TEST_EQ(nt_headers.GetBase(), static_cast<void*>(file.data() + 0x80));
+  BOOST_TEST(nt_headers.IsValid());
+  BOOST_TEST_EQ(nt_headers.GetSignature(), static_cast<DWORD>(0x4550));
+  BOOST_TEST_EQ(nt_headers.GetMachine(),
+                is_64 ? IMAGE_FILE_MACHINE_AMD64 : IMAGE_FILE_MACHINE_I386);
+  BOOST_TEST_EQ(nt_headers.GetNumberOfSections(), 4);
+  BOOST_TEST_EQ(nt_headers.GetTimeDateStamp(), 0x5A5A5A5AUL);
+  BOOST_TEST_EQ(nt_headers.GetSizeOfOptionalHeader(), is_64 ? 240 : 224);
+  BOOST_TEST(!!(nt_headers.GetCharacteristics() & IMAGE_FILE_DLL));
+  BOOST_TEST_EQ(nt_headers.GetMagic(),
+                is_64 ? IMAGE_NT_OPTIONAL_HDR64_MAGIC
+                      : IMAGE_NT_OPTIONAL_HDR32_MAGIC);
+  BOOST_TEST_EQ(nt_headers.GetAddressOfEntryPoint(), 0x1000UL);
+  BOOST_TEST_EQ(nt_headers.GetImageBase(),
+                is_64 ? 0x180000000ULL : 0x10000000ULL);
+  BOOST_TEST_EQ(nt_headers.GetSectionAlignment(), 0x1000UL);
+  BOOST_TEST_EQ(nt_headers.GetFileAlignment(), 0x200UL);
+  BOOST_TEST_EQ(nt_headers.GetSizeOfImage(), 0x5000UL);
+  BOOST_TEST_EQ(nt_headers.GetSizeOfHeaders(), 0x400UL);
+  BOOST_TEST_EQ(nt_headers.GetSubsystem(), 2);
+  BOOST_TEST_EQ(nt_headers.GetSizeOfStackReserve(), 0x100000ULL);
+  BOOST_TEST_EQ(nt_headers.GetNumberOfRvaAndSizes(), 16UL);
+  BOOST_TEST_EQ(
+    nt_headers.GetDataDirectoryVirtualAddress(hadesmem::PeDataDir::Export),
+    0x2000UL);
+  BOOST_TEST_EQ(nt_headers.GetDataDirectorySize(hadesmem::PeDataDir::Import),
+                40UL);
+  BOOST_TEST_EQ(
+    nt_headers.GetDataDirectoryVirtualAddress(hadesmem::PeDataDir::BaseReloc),
+    0x4000UL);
+  BOOST_TEST_EQ(nt_headers.GetDataDirectorySize(hadesmem::PeDataDir::TLS),
+                is_64 ? 40UL : 24UL);
+  BOOST_TEST_EQ(
+    nt_headers.GetDataDirectoryVirtualAddress(hadesmem::PeDataDir::Resource),
+    0UL);
+
+  // Writes go to the buffer.
+  nt_headers.SetTimeDateStamp(0x12345678);
+  nt_headers.UpdateWrite();
+  hadesmem::NtHeaders const nt_headers_new(process, pe_file);
+  BOOST_TEST_EQ(nt_headers_new.GetTimeDateStamp(), 0x12345678UL);
+  BOOST_TEST_EQ(file[0x88], 0x78);
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestNtHeaders();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestNtHeadersSample("sample32.dll", false);
+  TestNtHeadersSample("sample64.dll", true);
   return boost::report_errors();
 }
@@ -4,8 +4,11 @@
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
@@ -13,9 +16,16 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/pelib/dos_header.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/section_list.hpp>
 #include <hadesmem/process.hpp>
 
+#include "sample_pe.hpp"
+
 // TODO: More comprehensive PE file testing.
 
 // TODO: Add PeFile tests for modules mapped as data (currently only testing
@@ -23,6 +33,8 @@
 
 // TODO: Run tests on worst case scenario targets like Corkami for PE files.
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 void TestPeFile()
 {
   hadesmem::Process const process(::GetCurrentProcessId());
@@ -84,8 +96,117 @@ void TestPeFile()
   BOOST_TEST_NE(test_str_1.str(), test_str_3.str());
 }
 
+void TestPeFileBuffer()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  hadesmem::PeFile const pe_file_proc(
+    process, ::GetModuleHandleW(nullptr), hadesmem::PeFileType::kImage, 0);
+  hadesmem::NtHeaders const nt_headers_proc(process, pe_file_proc);
+
+  // Take a private copy of our own image and parse it without going through
+  // ReadProcessMemory. The results should be identical.
+  std::vector<std::uint8_t> image(nt_headers_proc.GetSizeOfImage());
+  std::memcpy(image.data(), pe_file_proc.GetBase(), image.size());
+
+  hadesmem::PeFile const pe_file_buf(process,
+                                     image.data(),
+                                     hadesmem::PeFileType::kImage,
+                                     static_cast<DWORD>(image.size()),
+                                     hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST(pe_file_buf.GetBacking() == hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST_EQ(pe_file_buf.Is64(), pe_file_proc.Is64());
+
+  hadesmem::NtHeaders const nt_headers_buf(process, pe_file_buf);
+  BOOST_TEST_EQ(nt_headers_buf.GetNumberOfSections(),
+                nt_headers_proc.GetNumberOfSections());
+  BOOST_TEST_EQ(nt_headers_buf.GetAddressOfEntryPoint(),
+                nt_headers_proc.GetAddressOfEntryPoint());
+
+  hadesmem::SectionList const sections_proc(process, pe_file_proc);
+  hadesmem::SectionList const sections_buf(process, pe_file_buf);
+  auto section_proc = std::begin(sections_proc);
+  for (auto const& section : sections_buf)
+  {
+    BOOST_TEST(section_proc != std::end(sections_proc));
+    BOOST_TEST_EQ(section.GetName(), section_proc->GetName());
+    BOOST_TEST_EQ(section.GetVirtualAddress(),
+                  section_proc->GetVirtualAddress());
+    ++section_proc;
+  }
+  BOOST_TEST(section_proc == std::end(sections_proc));
+
+  // Reads past the end of the buffer must be caught rather than silently
+  // touching whatever happens to follow it in memory.
+  hadesmem::PeFile const pe_file_trunc(process,
+                                       image.data(),
+                                       hadesmem::PeFileType::kData,
+                                       sizeof(IMAGE_DOS_HEADER) / 2,
+                                       hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST_THROWS(hadesmem::DosHeader{process, pe_file_trunc},
+                    hadesmem::Error);
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestPeFileSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  BOOST_TEST_EQ(file.size(), 0xC00U);
+  hadesmem::PeFile const pe_file_data(process,
+                                      file.data(),
+                                      hadesmem::PeFileType::kData,
+                                      static_cast<DWORD>(file.size()),
+                                      hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST(pe_file_data.GetType() == hadesmem::PeFileType::kData);
+  BOOST_TEST(pe_file_data.GetBacking() == hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST_EQ(pe_file_data.GetBase(), static_cast<void*>(file.data()));
+  BOOST_TEST_EQ(pe_file_data.GetSize(), file.size());
+  BOOST_TEST_EQ(pe_file_data.Is64(), is_64);
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file_data, 0),
+                static_cast<void*>(nullptr));
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file_data, 0x1010),
+                static_cast<void*>(file.data() + 0x410));
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file_data, 0x2050),
+                static_cast<void*>(file.data() + 0x650));
+  BOOST_TEST_EQ(hadesmem::FileOffsetToRva(process, pe_file_data, 0x820),
+                0x3020UL);
+
+  auto image = hadesmem::test::MapSample(name);
+  BOOST_TEST_EQ(image.size(), 0x5000U);
+  hadesmem::PeFile const pe_file_image(process,
+                                       image.data(),
+                                       hadesmem::PeFileType::kImage,
+                                       static_cast<DWORD>(image.size()),
+                                       hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST(pe_file_image.GetType() == hadesmem::PeFileType::kImage);
+  BOOST_TEST_EQ(pe_file_image.Is64(), is_64);
+  BOOST_TEST_EQ(hadesmem::RvaToVa(process, pe_file_image, 0x2050),
+                static_cast<void*>(image.data() + 0x2050));
+  BOOST_TEST_NE(pe_file_image, pe_file_data);
+
+  // Everything is bounds checked against the buffer, so a truncated file
+  // throws rather than reading past the end.
+  hadesmem::PeFile const pe_file_trunc(process,
+                                       file.data(),
+                                       hadesmem::PeFileType::kData,
+                                       0x100,
+                                       hadesmem::PeFileBacking::kBuffer);
+  BOOST_TEST_THROWS((hadesmem::NtHeaders{process, pe_file_trunc}),
+                    hadesmem::Error);
+  BOOST_TEST_THROWS(hadesmem::RvaToVa(process, pe_file_trunc, 0x2050),
+                    hadesmem::Error);
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestPeFile();
+  TestPeFileBuffer();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestPeFileSample("sample32.dll", false);
+  TestPeFileSample("sample64.dll", true);
   return boost::report_errors();
 }
@@ -0,0 +1,110 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pelib/relocation_block_list.hpp>
+#include <hadesmem/pelib/relocation_block_list.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/pelib/nt_headers.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/pelib/relocation.hpp>
+#include <hadesmem/pelib/relocation_block.hpp>
+#include <hadesmem/pelib/relocation_list.hpp>
+#include <hadesmem/process.hpp>
+
+#include "sample_pe.hpp"
+
+void TestRelocationBlockListSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  hadesmem::PeFile const pe_file(process,
+                                 file.data(),
+                                 hadesmem::PeFileType::kData,
+                                 static_cast<DWORD>(file.size()),
+                                 hadesmem::PeFileBacking::kBuffer);
+
+  std::vector<hadesmem::RelocationBlock> blocks;
+  hadesmem::RelocationBlockList const block_list(process, pe_file);
+  std::copy(
+    std::begin(block_list), std::end(block_list), std::back_inserter(blocks));
+  BOOST_TEST_EQ(blocks.size(), 2U);
+  if (blocks.size() != 2)
+  {
+    return;
+  }
+
+  std::uint8_t const type = is_64 ? IMAGE_REL_BASED_DIR64
+                                  : IMAGE_REL_BASED_HIGHLOW;
+  std::uint16_t const pointer_size = is_64 ? 8 : 4;
+
+  BOOST_TEST_EQ(blocks[0].GetBase(), static_cast<void*>(file.data() + 0xA00));
+  BOOST_TEST(!blocks[0].IsInvalid());
+  BOOST_TEST_EQ(blocks[0].GetVirtualAddress(), 0x2000UL);
+  BOOST_TEST_EQ(blocks[0].GetSizeOfBlock(), 20UL);
+  BOOST_TEST_EQ(blocks[0].GetNumberOfRelocations(), 6UL);
+
+  std::vector<std::uint16_t> const expected_offsets = {
+    0x1A0,
+    static_cast<std::uint16_t>(0x1A0 + pointer_size),
+    static_cast<std::uint16_t>(0x1A0 + pointer_size * 2),
+    static_cast<std::uint16_t>(0x1A0 + pointer_size * 3),
+    0x1D0,
+    static_cast<std::uint16_t>(0x1D0 + pointer_size)};
+  std::vector<std::uint16_t> offsets;
+  hadesmem::RelocationList const relocs_1(process,
+                                          pe_file,
+                                          blocks[0].GetRelocationDataStart(),
+                                          blocks[0].GetNumberOfRelocations());
+  for (auto const& reloc : relocs_1)
+  {
+    BOOST_TEST_EQ(reloc.GetType(), type);
+    offsets.push_back(reloc.GetOffset());
+  }
+  BOOST_TEST(offsets == expected_offsets);
+
+  BOOST_TEST_EQ(blocks[1].GetVirtualAddress(), 0x1000UL);
+  BOOST_TEST_EQ(blocks[1].GetSizeOfBlock(), 12UL);
+  BOOST_TEST_EQ(blocks[1].GetNumberOfRelocations(), 2UL);
+
+  std::vector<hadesmem::Relocation> relocs;
+  hadesmem::RelocationList const relocs_2(process,
+                                          pe_file,
+                                          blocks[1].GetRelocationDataStart(),
+                                          blocks[1].GetNumberOfRelocations());
+  std::copy(
+    std::begin(relocs_2), std::end(relocs_2), std::back_inserter(relocs));
+  BOOST_TEST_EQ(relocs.size(), 2U);
+  if (relocs.size() == 2)
+  {
+    BOOST_TEST_EQ(relocs[0].GetType(), type);
+    BOOST_TEST_EQ(relocs[0].GetOffset(), 0x50);
+    BOOST_TEST_EQ(relocs[1].GetType(), IMAGE_REL_BASED_ABSOLUTE);
+  }
+
+  // No relocation directory means an empty list rather than an error.
+  hadesmem::NtHeaders nt_headers(process, pe_file);
+  nt_headers.SetDataDirectoryVirtualAddress(hadesmem::PeDataDir::BaseReloc, 0);
+  nt_headers.SetDataDirectorySize(hadesmem::PeDataDir::BaseReloc, 0);
+  nt_headers.UpdateWrite();
+  hadesmem::RelocationBlockList const empty_list(process, pe_file);
+  BOOST_TEST(std::begin(empty_list) == std::end(empty_list));
+}
+
+int main()
+{
+  TestRelocationBlockListSample("sample32.dll", false);
+  TestRelocationBlockListSample("sample64.dll", true);
+  return boost::report_errors();
+}
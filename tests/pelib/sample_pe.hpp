@@ -0,0 +1,114 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+
+// Helpers for the PeLib tests which parse the sample files in tests/pelib/data
+// from a buffer, so that they run on every platform.
+//
+// sample32.dll and sample64.dll are the same minimal DLL built as PE32 and
+// PE32+ respectively (ImageBase 0x10000000 and 0x180000000):
+//
+//   .text   RVA 0x1000, file offset 0x400. 'ret' at 0x1000, 0x1010, 0x1020,
+//           0x1030 and 0x1040, 'int 3' everywhere else.
+//   .rdata  RVA 0x2000, file offset 0x600. Exports (0x2000), imports
+//           (0x2100), IAT (0x2150), TLS directory (0x21A0) and TLS callbacks
+//           (0x21D0).
+//   .data   RVA 0x3000, file offset 0x800. TLS raw data (0x3000-0x3010) and
+//           the TLS index (0x3020).
+//   .reloc  RVA 0x4000, file offset 0xA00.
+//
+// Exports (ordinal base 1): Alpha (1, 0x1000), Beta (2, 0x1010), an unnamed
+// export (3, 0x1020) and Gamma (4, forwarded to other.Delta).
+//
+// Imports: kernel32.dll, GetCurrentProcessId (hint 0x10) then ordinal 5.
+//
+// TLS: callbacks at 0x1030 and 0x1040, SizeOfZeroFill 0x20.
+//
+// Relocations: a block at 0x2000 for the four TLS directory pointers and the
+// two callbacks, then a block at 0x1000 with one relocation at 0x1050 and an
+// IMAGE_REL_BASED_ABSOLUTE padding entry. They're IMAGE_REL_BASED_HIGHLOW in
+// the PE32 file and IMAGE_REL_BASED_DIR64 in the PE32+ file.
+
+namespace hadesmem
+{
+namespace test
+{
+inline std::string GetSamplePath(char const* name)
+{
+  std::string path = __FILE__;
+  auto const separator = path.find_last_of("\\/");
+  path.erase(separator == std::string::npos ? 0 : separator + 1);
+  return path + "data/" + name;
+}
+
+// The file as it is on disk (for PeFileType::kData).
+inline std::vector<std::uint8_t> LoadSample(char const* name)
+{
+  std::ifstream file{GetSamplePath(name), std::ios::binary};
+  if (!file)
+  {
+    HADESMEM_DETAIL_THROW_EXCEPTION(Error{}
+                                    << ErrorString{"Failed to open sample."});
+  }
+
+  return std::vector<std::uint8_t>{std::istreambuf_iterator<char>{file},
+                                   std::istreambuf_iterator<char>{}};
+}
+
+// The file as the loader would map it, but without applying relocations or
+// resolving imports (for PeFileType::kImage).
+inline std::vector<std::uint8_t> MapSample(char const* name)
+{
+  auto const file = LoadSample(name);
+  auto const read_dword = [&](std::size_t offset) {
+    DWORD value;
+    std::memcpy(&value, file.data() + offset, sizeof(value));
+    return value;
+  };
+  auto const read_word = [&](std::size_t offset) {
+    WORD value;
+    std::memcpy(&value, file.data() + offset, sizeof(value));
+    return value;
+  };
+
+  std::size_t const nt_headers = read_dword(0x3C);
+  std::size_t const file_header = nt_headers + sizeof(DWORD);
+  std::size_t const optional_header = file_header + sizeof(IMAGE_FILE_HEADER);
+  // SizeOfImage and SizeOfHeaders are at the same offset in PE32 and PE32+.
+  std::vector<std::uint8_t> image(read_dword(optional_header + 56));
+  std::size_t const size_of_headers = read_dword(optional_header + 60);
+  std::copy(std::begin(file),
+            std::begin(file) + size_of_headers,
+            std::begin(image));
+
+  auto const num_sections = read_word(file_header + 2);
+  std::size_t const sections = optional_header + read_word(file_header + 16);
+  for (std::size_t i = 0; i < num_sections; ++i)
+  {
+    IMAGE_SECTION_HEADER section;
+    std::memcpy(&section,
+                file.data() + sections + i * sizeof(section),
+                sizeof(section));
+    std::copy(std::begin(file) + section.PointerToRawData,
+              std::begin(file) + section.PointerToRawData +
+                section.SizeOfRawData,
+              std::begin(image) + section.VirtualAddress);
+  }
+
+  return image;
+}
+}
+}
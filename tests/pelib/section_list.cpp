@@ -13,13 +13,19 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/pelib/nt_headers.hpp>
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/pelib/section.hpp>
 #include <hadesmem/process.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include "sample_pe.hpp"
 
 // TODO: Better tests. (In reference to assuming every module has at least one
 // section, and that being the only constraint.)
@@ -27,6 +33,8 @@
 // TODO: Better tests. (In reference to assuming every module has a .data
 // section and that being the only constraint.
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 void TestSectionList()
 {
   hadesmem::Process const process(::GetCurrentProcessId());
@@ -121,8 +129,79 @@ void TestSectionList()
   }
 }
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestSectionListSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  auto file = hadesmem::test::LoadSample(name);
+  hadesmem::PeFile const pe_file(process,
+                                 file.data(),
+                                 hadesmem::PeFileType::kData,
+                                 static_cast<DWORD>(file.size()),
+                                 hadesmem::PeFileBacking::kBuffer);
+
+  struct ExpectedSection
+  {
+    char const* name;
+    DWORD virtual_address;
+    DWORD virtual_size;
+    DWORD pointer_to_raw_data;
+    DWORD characteristics;
+  };
+  ExpectedSection const expected[] = {
+    {".text", 0x1000, 0x50, 0x400, 0x60000020},
+    {".rdata", 0x2000, 0x1F0, 0x600, 0x40000040},
+    {".data", 0x3000, 0x30, 0x800, 0xC0000040},
+    {".reloc", 0x4000, 0x20, 0xA00, 0x42000040}};
+
+  auto const section_headers =
+    file.data() + 0x80 + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER) +
+    (is_64 ? sizeof(IMAGE_OPTIONAL_HEADER64) : sizeof(IMAGE_OPTIONAL_HEADER32));
+  std::size_t index = 0;
+  hadesmem::SectionList const sections(process, pe_file);
+  for (auto const& section : sections)
+  {
+    BOOST_TEST(index < 4);
+    if (index >= 4)
+    {
+      break;
+    }
+
+    BOOST_TEST_EQ(section.GetBase(),
+                  static_cast<void*>(section_headers +
+                                     index * sizeof(IMAGE_SECTION_HEADER)));
+    BOOST_TEST_EQ(section.GetName(), expected[index].name);
+    BOOST_TEST_EQ(section.GetVirtualAddress(),
+                  expected[index].virtual_address);
+    BOOST_TEST_EQ(section.GetVirtualSize(), expected[index].virtual_size);
+    BOOST_TEST_EQ(section.GetSizeOfRawData(), 0x200UL);
+    BOOST_TEST_EQ(section.GetPointerToRawData(),
+                  expected[index].pointer_to_raw_data);
+    BOOST_TEST_EQ(section.GetCharacteristics(),
+                  expected[index].characteristics);
+    ++index;
+  }
+  BOOST_TEST_EQ(index, 4U);
+
+  hadesmem::Section const data_section(process, pe_file, WORD{2});
+  BOOST_TEST_EQ(data_section.GetName(), ".data");
+
+  // The header is written back to the buffer.
+  hadesmem::Section text_section(process, pe_file, WORD{0});
+  text_section.SetName(".code");
+  text_section.UpdateWrite();
+  BOOST_TEST_EQ(hadesmem::SectionList(process, pe_file).begin()->GetName(),
+                ".code");
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestSectionList();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestSectionListSample("sample32.dll", false);
+  TestSectionListSample("sample64.dll", true);
   return boost::report_errors();
 }
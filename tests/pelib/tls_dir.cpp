@@ -4,8 +4,11 @@
 #include <hadesmem/pelib/tls_dir.hpp>
 #include <hadesmem/pelib/tls_dir.hpp>
 
+#include <initializer_list>
+#include <iterator>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include <hadesmem/detail/warning_disable_prefix.hpp>
 #include <boost/detail/lightweight_test.hpp>
@@ -13,15 +16,23 @@
 
 #include <hadesmem/config.hpp>
 #include <hadesmem/error.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/module.hpp>
 #include <hadesmem/module_list.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/pelib/pe_file.hpp>
 #include <hadesmem/process.hpp>
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
 #include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+#include "sample_pe.hpp"
 
 // TODO: Ensure that base address is different across modules (similar to other
 // tests)
 
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
 void TestTlsDir()
 {
   // Use TLS to ensure that at least one module has a TLS dir
@@ -94,8 +105,64 @@ void TestTlsDir()
   BOOST_TEST_NE(tls_dummy, 0);
 }
 
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestTlsDirSample(char const* name, bool is_64)
+{
+  hadesmem::Process const process(hadesmem::detail::GetCurrentProcessId());
+
+  ULONGLONG const image_base = is_64 ? 0x180000000ULL : 0x10000000ULL;
+  auto file = hadesmem::test::LoadSample(name);
+  auto image = hadesmem::test::MapSample(name);
+  hadesmem::PeFile const pe_file_data(process,
+                                      file.data(),
+                                      hadesmem::PeFileType::kData,
+                                      static_cast<DWORD>(file.size()),
+                                      hadesmem::PeFileBacking::kBuffer);
+  hadesmem::PeFile const pe_file_image(process,
+                                       image.data(),
+                                       hadesmem::PeFileType::kImage,
+                                       static_cast<DWORD>(image.size()),
+                                       hadesmem::PeFileBacking::kBuffer);
+  for (auto const pe_file : {&pe_file_data, &pe_file_image})
+  {
+    hadesmem::TlsDir tls_dir(process, *pe_file);
+    BOOST_TEST_EQ(tls_dir.GetBase(),
+                  hadesmem::RvaToVa(process, *pe_file, 0x21A0));
+    BOOST_TEST_EQ(tls_dir.GetStartAddressOfRawData(), image_base + 0x3000);
+    BOOST_TEST_EQ(tls_dir.GetEndAddressOfRawData(), image_base + 0x3010);
+    BOOST_TEST_EQ(tls_dir.GetAddressOfIndex(), image_base + 0x3020);
+    BOOST_TEST_EQ(tls_dir.GetAddressOfCallBacks(), image_base + 0x21D0);
+    BOOST_TEST_EQ(tls_dir.GetSizeOfZeroFill(), 0x20UL);
+    BOOST_TEST_EQ(tls_dir.GetCharacteristics(), 0UL);
+
+    // The mapped sample isn't relocated, so its callbacks are only usable
+    // relative to the preferred base.
+    if (pe_file->GetType() == hadesmem::PeFileType::kData)
+    {
+      std::vector<ULONGLONG> callbacks;
+      tls_dir.GetCallbacks(std::back_inserter(callbacks));
+      BOOST_TEST_EQ(callbacks.size(), 2U);
+      if (callbacks.size() == 2)
+      {
+        BOOST_TEST_EQ(callbacks[0], 0x1030ULL);
+        BOOST_TEST_EQ(callbacks[1], 0x1040ULL);
+      }
+    }
+
+    tls_dir.SetSizeOfZeroFill(0x40);
+    tls_dir.UpdateWrite();
+    BOOST_TEST_EQ(hadesmem::TlsDir(process, *pe_file).GetSizeOfZeroFill(),
+                  0x40UL);
+  }
+}
+
 int main()
 {
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
   TestTlsDir();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestTlsDirSample("sample32.dll", false);
+  TestTlsDirSample("sample64.dll", true);
   return boost::report_errors();
 }
@@ -0,0 +1,187 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/pointer_scanner.hpp>
+#include <hadesmem/pointer_scanner.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+
+namespace
+{
+// A fake 'module' in the first page of the buffer, with a static pointer to
+// an object, which points to another object, which contains the target.
+class FakeTarget
+{
+public:
+  FakeTarget() : buf_(0x4000)
+  {
+  }
+
+  void Build(std::size_t a, std::size_t b)
+  {
+    std::fill(std::begin(buf_), std::end(buf_), 0);
+    Put(0x10, At(a));
+    Put(a + 0x20, At(b));
+  }
+
+  void Put(std::size_t offset, std::uintptr_t value)
+  {
+    buf_[offset / sizeof(std::uintptr_t)] = value;
+  }
+
+  std::uintptr_t At(std::size_t offset) const
+  {
+    return reinterpret_cast<std::uintptr_t>(buf_.data()) + offset;
+  }
+
+  std::vector<hadesmem::PointerScanBase> GetBases() const
+  {
+    return {hadesmem::PointerScanBase{L"game.exe", At(0), 0x1000}};
+  }
+
+  hadesmem::BufferMemorySource GetSource() const
+  {
+    return hadesmem::BufferMemorySource{buf_.data(),
+                                        buf_.size() * sizeof(buf_[0])};
+  }
+
+private:
+  std::vector<std::uintptr_t> buf_;
+};
+}
+
+void TestPointerMap()
+{
+  FakeTarget target;
+  target.Build(0x8000, 0x10000);
+  auto const source = target.GetSource();
+
+  hadesmem::PointerScanOptions options;
+  options.scan.chunk_size = 0x1000;
+  options.scan.num_threads = 4;
+  hadesmem::PointerScanner<hadesmem::BufferMemorySource> const scanner{
+    source, options};
+
+  auto const map = scanner.BuildMap();
+  BOOST_TEST_EQ(map.GetSize(), 2U);
+  BOOST_TEST_EQ(map.GetEntries()[0].pointee, target.At(0x8000));
+  BOOST_TEST_EQ(map.GetEntries()[0].location, target.At(0x10));
+  BOOST_TEST_EQ(map.GetEntries()[1].pointee, target.At(0x10000));
+  BOOST_TEST_EQ(map.GetEntries()[1].location, target.At(0x8020));
+
+  // Many pointers across many chunks come out sorted.
+  for (std::size_t i = 0; i < 0x800; ++i)
+  {
+    target.Put(0x1000 + i * sizeof(std::uintptr_t),
+               target.At((i * 7919) % 0x20000));
+  }
+  auto const big_map = scanner.BuildMap();
+  BOOST_TEST_EQ(big_map.GetSize(), 0x800U + 2U);
+  BOOST_TEST(std::is_sorted(std::begin(big_map.GetEntries()),
+                            std::end(big_map.GetEntries())));
+
+  auto const range =
+    big_map.FindPointersTo(target.At(0x8000), target.At(0x8000));
+  BOOST_TEST(range.first != range.second);
+  for (auto iter = range.first; iter != range.second; ++iter)
+  {
+    BOOST_TEST_EQ(iter->pointee, target.At(0x8000));
+  }
+}
+
+void TestPointerPaths()
+{
+  FakeTarget target;
+  target.Build(0x8000, 0x10000);
+  auto const source = target.GetSource();
+
+  hadesmem::PointerScanOptions options;
+  options.scan.num_threads = 2;
+  options.max_depth = 3;
+  options.max_offset = 0x100;
+  hadesmem::PointerScanner<hadesmem::BufferMemorySource> const scanner{
+    source, options};
+
+  auto const bases = target.GetBases();
+  auto const map = scanner.BuildMap();
+  auto const goal = reinterpret_cast<void*>(target.At(0x10030));
+  auto const results = scanner.FindPaths(map, bases, goal);
+  BOOST_TEST_EQ(results.GetSize(), 1U);
+
+  auto const path = results.GetPath(0);
+  BOOST_TEST(path.module == L"game.exe");
+  BOOST_TEST_EQ(path.module_offset, 0x10U);
+  BOOST_TEST(path.offsets == (std::vector<std::uintptr_t>{0x20, 0x30}));
+  BOOST_TEST_EQ(scanner.Resolve(path, bases), target.At(0x10030));
+
+  // Too deep, or too far from the pointers.
+  hadesmem::PointerScanOptions shallow_options = options;
+  shallow_options.max_depth = 1;
+  hadesmem::PointerScanner<hadesmem::BufferMemorySource> const shallow{
+    source, shallow_options};
+  BOOST_TEST(shallow.FindPaths(map, bases, goal).IsEmpty());
+  hadesmem::PointerScanOptions near_options = options;
+  near_options.max_offset = 0x28;
+  hadesmem::PointerScanner<hadesmem::BufferMemorySource> const near{
+    source, near_options};
+  BOOST_TEST(near.FindPaths(map, bases, goal).IsEmpty());
+
+  // Round trip, then check the path in a 'new run' with a different heap
+  // layout.
+  std::stringstream stream;
+  results.Save(stream);
+  auto const loaded = hadesmem::PointerScanResults::Load(stream);
+  BOOST_TEST_EQ(loaded.GetSize(), 1U);
+  BOOST_TEST(loaded.GetPath(0).offsets == path.offsets);
+
+  target.Build(0x9000, 0x12000);
+  auto const new_goal = reinterpret_cast<void*>(target.At(0x12030));
+  BOOST_TEST_EQ(scanner.Revalidate(loaded, bases, new_goal).GetSize(), 1U);
+  BOOST_TEST(scanner.Revalidate(loaded, bases, goal).IsEmpty());
+
+  target.Put(0x9020, 0);
+  BOOST_TEST(scanner.Revalidate(loaded, bases, new_goal).IsEmpty());
+  BOOST_TEST_EQ(scanner.Resolve(path, bases), 0x30U);
+
+  // Every shortest path is found, including ones sharing a node.
+  target.Build(0x8000, 0x10000);
+  target.Put(0x18, target.At(0x8008));
+  auto const multi =
+    scanner.FindPaths(scanner.BuildMap(), bases, goal);
+  BOOST_TEST_EQ(multi.GetSize(), 2U);
+  BOOST_TEST_EQ(multi.GetPath(1).module_offset, 0x18U);
+  BOOST_TEST(multi.GetPath(1).offsets ==
+             (std::vector<std::uintptr_t>{0x18, 0x30}));
+
+  std::stringstream bad{"not a pointer scan"};
+  bool thrown = false;
+  try
+  {
+    hadesmem::PointerScanResults::Load(bad);
+  }
+  catch (hadesmem::Error const&)
+  {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+}
+
+int main()
+{
+  TestPointerMap();
+  TestPointerPaths();
+  return boost::report_errors();
+}
@@ -78,6 +78,34 @@ void TestReadPod()
     nullptr, sizeof(void*), MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE);
   BOOST_TEST(execute_page != nullptr);
   hadesmem::Read<void*>(process, execute_page);
+
+  // kAssumeAccessible should fall back to the guarded path when the direct
+  // read fails.
+  std::uint32_t const assume_flags = hadesmem::ReadFlags::kAssumeAccessible;
+  BOOST_TEST_EQ(
+    hadesmem::ReadEx<std::int64_t>(process, &test_pod_type.d, assume_flags),
+    test_pod_type.d);
+  hadesmem::ReadEx<void*>(process, noaccess_page, assume_flags);
+  hadesmem::ReadEx<void*>(process, execute_page, assume_flags);
+
+  // A normal read refuses to touch a guard page and leaves the guard in
+  // place. kAssumeAccessible doesn't check, so the direct read consumes the
+  // guard and the fallback then succeeds.
+  PVOID const guard_page_2 = VirtualAlloc(nullptr,
+                                          sizeof(void*),
+                                          MEM_RESERVE | MEM_COMMIT,
+                                          PAGE_READWRITE | PAGE_GUARD);
+  BOOST_TEST(guard_page_2 != nullptr);
+  BOOST_TEST_THROWS(hadesmem::ReadEx<void*>(
+                      process, guard_page_2, hadesmem::ReadFlags::kNone),
+                    hadesmem::Error);
+  MEMORY_BASIC_INFORMATION mbi{};
+  BOOST_TEST(::VirtualQuery(guard_page_2, &mbi, sizeof(mbi)) != 0);
+  BOOST_TEST(!!(mbi.Protect & PAGE_GUARD));
+  BOOST_TEST_EQ(hadesmem::ReadEx<void*>(process, guard_page_2, assume_flags),
+                static_cast<void*>(nullptr));
+  BOOST_TEST(::VirtualQuery(guard_page_2, &mbi, sizeof(mbi)) != 0);
+  BOOST_TEST(!(mbi.Protect & PAGE_GUARD));
 }
 
 void TestReadString()
@@ -0,0 +1,306 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/read_batch.hpp>
+#include <hadesmem/detail/read_batch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/process.hpp>
+#include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace
+{
+// Fake address space backed by a buffer, with an optional unreadable hole and
+// optional region boundaries.
+class MockMemory
+{
+public:
+  MockMemory() : mem_(0x40000)
+  {
+    std::iota(std::begin(mem_), std::end(mem_), static_cast<std::uint8_t>(0));
+  }
+
+  void* At(std::size_t offset)
+  {
+    return &mem_[offset];
+  }
+
+  void SetHole(std::size_t beg, std::size_t end)
+  {
+    hole_beg_ = beg;
+    hole_end_ = end;
+  }
+
+  // Boundaries must be added in ascending order.
+  void AddRegionBoundary(std::size_t offset)
+  {
+    boundaries_.push_back(offset);
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address)
+  {
+    ++query_count_;
+
+    auto const offset = static_cast<std::size_t>(
+      static_cast<std::uint8_t const*>(address) - &mem_[0]);
+    std::size_t beg = 0;
+    std::size_t end = mem_.size();
+    for (auto const boundary : boundaries_)
+    {
+      if (boundary <= offset)
+      {
+        beg = boundary;
+      }
+      else
+      {
+        end = boundary;
+        break;
+      }
+    }
+
+    MEMORY_BASIC_INFORMATION mbi{};
+    mbi.BaseAddress = &mem_[beg];
+    mbi.RegionSize = end - beg;
+    mbi.State = MEM_COMMIT;
+    mbi.Protect = PAGE_READWRITE;
+    return mbi;
+  }
+
+  void Read(void* address, void* data, std::size_t len)
+  {
+    ++count_;
+
+    auto const beg = static_cast<std::size_t>(
+      static_cast<std::uint8_t*>(address) - &mem_[0]);
+    if (beg < hole_end_ && beg + len > hole_beg_)
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(
+        hadesmem::Error{} << hadesmem::ErrorString{"Unreadable."});
+    }
+
+    std::memcpy(data, address, len);
+  }
+
+  std::size_t GetCount() const noexcept
+  {
+    return count_;
+  }
+
+  std::size_t GetQueryCount() const noexcept
+  {
+    return query_count_;
+  }
+
+  void ResetCount() noexcept
+  {
+    count_ = 0;
+    query_count_ = 0;
+  }
+
+private:
+  std::vector<std::uint8_t> mem_;
+  std::size_t hole_beg_{};
+  std::size_t hole_end_{};
+  std::vector<std::size_t> boundaries_;
+  std::size_t count_{};
+  std::size_t query_count_{};
+};
+
+std::size_t DoBatch(MockMemory& mem,
+                    std::vector<hadesmem::ReadRequest> const& requests,
+                    std::size_t merge_gap)
+{
+  mem.ResetCount();
+  std::size_t const num_reads = hadesmem::detail::ReadBatchImpl(
+    requests.data(),
+    requests.size(),
+    merge_gap,
+    [&](void* address, void* data, std::size_t len) {
+      mem.Read(address, data, len);
+    },
+    [&](void const* address) { return mem.Query(address); });
+  BOOST_TEST_EQ(num_reads, mem.GetCount());
+  return num_reads;
+}
+}
+
+void TestReadBatchMock()
+{
+  MockMemory mem;
+
+  // Adjacent requests (e.g. walking an array of pointers) collapse into a
+  // single read.
+  std::vector<std::uint32_t> out(256);
+  std::vector<hadesmem::ReadRequest> requests;
+  for (std::size_t i = 0; i < out.size(); ++i)
+  {
+    requests.push_back(
+      hadesmem::MakeReadRequest(mem.At(0x1000 + i * 4), out[i]));
+  }
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0), 1U);
+  for (std::size_t i = 0; i < out.size(); ++i)
+  {
+    std::uint32_t expected = 0;
+    std::memcpy(&expected, mem.At(0x1000 + i * 4), sizeof(expected));
+    BOOST_TEST_EQ(out[i], expected);
+  }
+
+  // Nearly adjacent requests (e.g. one field from each element of an array of
+  // structs) are only merged if they're within the gap. Order of the requests
+  // shouldn't matter.
+  std::vector<std::uint16_t> fields(64);
+  requests.clear();
+  for (std::size_t i = fields.size(); i-- > 0;)
+  {
+    requests.push_back(
+      hadesmem::MakeReadRequest(mem.At(0x2000 + i * 0x100), fields[i]));
+  }
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x100), 1U);
+  // They're all in the same region, so it's only queried once.
+  BOOST_TEST_EQ(mem.GetQueryCount(), 1U);
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x80), fields.size());
+  for (std::size_t i = 0; i < fields.size(); ++i)
+  {
+    std::uint16_t expected = 0;
+    std::memcpy(&expected, mem.At(0x2000 + i * 0x100), sizeof(expected));
+    BOOST_TEST_EQ(fields[i], expected);
+  }
+
+  // Overlapping and zero length requests.
+  std::uint64_t a = 0;
+  std::uint32_t b = 0;
+  std::uint8_t c = 0xCC;
+  requests.clear();
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x3000), a));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x3002), b));
+  requests.push_back(hadesmem::ReadRequest{mem.At(0x3010), &c, 0});
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0), 1U);
+  BOOST_TEST_EQ(std::memcmp(&a, mem.At(0x3000), sizeof(a)), 0);
+  BOOST_TEST_EQ(std::memcmp(&b, mem.At(0x3002), sizeof(b)), 0);
+  BOOST_TEST_EQ(c, 0xCC);
+
+  // Merged reads are capped in size.
+  std::vector<std::uint8_t> spread(8);
+  requests.clear();
+  for (std::size_t i = 0; i < spread.size(); ++i)
+  {
+    requests.push_back(
+      hadesmem::MakeReadRequest(mem.At(i * 0x4000), spread[i]));
+  }
+  std::size_t const capped_reads = DoBatch(mem, requests, 0x4000);
+  BOOST_TEST(capped_reads > 1U);
+  BOOST_TEST(capped_reads < spread.size());
+
+  // A merged read which fails anyway (e.g. because the region information
+  // was stale) falls back to individual reads.
+  mem.SetHole(0x5010, 0x5020);
+  requests.clear();
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x5000), a));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x5030), b));
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x100), 3U);
+  BOOST_TEST_EQ(std::memcmp(&a, mem.At(0x5000), sizeof(a)), 0);
+  BOOST_TEST_EQ(std::memcmp(&b, mem.At(0x5030), sizeof(b)), 0);
+
+  // Requests which are actually unreadable still fail.
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x5018), c));
+  BOOST_TEST_THROWS(DoBatch(mem, requests, 0x100), hadesmem::Error);
+
+  // Gaps are only merged within a region, as another region may have a
+  // different protection. Adjacent requests are still merged across a
+  // boundary, since no unrequested bytes are read.
+  mem.AddRegionBoundary(0x6010);
+  mem.AddRegionBoundary(0x6020);
+  mem.AddRegionBoundary(0x7000);
+  requests.clear();
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6000), a));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6030), b));
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x100), 2U);
+  BOOST_TEST_EQ(std::memcmp(&a, mem.At(0x6000), sizeof(a)), 0);
+  BOOST_TEST_EQ(std::memcmp(&b, mem.At(0x6030), sizeof(b)), 0);
+
+  // The gap lies in the same region as the last byte of the first request,
+  // even though that request starts in the previous region.
+  requests.clear();
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x600C), a));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x601C), b));
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x100), 1U);
+  BOOST_TEST_EQ(std::memcmp(&a, mem.At(0x600C), sizeof(a)), 0);
+  BOOST_TEST_EQ(std::memcmp(&b, mem.At(0x601C), sizeof(b)), 0);
+
+  requests.clear();
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6008), a));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6010), b));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6FF0), c));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x6FF8), c));
+  requests.push_back(hadesmem::MakeReadRequest(mem.At(0x7004), c));
+  BOOST_TEST_EQ(DoBatch(mem, requests, 0x1000), 3U);
+}
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestReadBatchProcess()
+{
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  struct Entity
+  {
+    float pos[3];
+    std::int32_t health;
+    void* next;
+  };
+
+  std::vector<Entity> entities(100);
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    entities[i].pos[0] = static_cast<float>(i);
+    entities[i].health = static_cast<std::int32_t>(i * 10);
+    entities[i].next = &entities[(i + 1) % entities.size()];
+  }
+
+  std::vector<std::int32_t> health(entities.size());
+  std::vector<void*> next(entities.size());
+  std::vector<hadesmem::ReadRequest> requests;
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    requests.push_back(
+      hadesmem::MakeReadRequest(&entities[i].health, health[i]));
+    requests.push_back(hadesmem::MakeReadRequest(&entities[i].next, next[i]));
+  }
+
+  std::size_t const num_reads = hadesmem::ReadBatch(process, requests);
+  BOOST_TEST_EQ(num_reads, 1U);
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    BOOST_TEST_EQ(health[i], entities[i].health);
+    BOOST_TEST_EQ(next[i], entities[i].next);
+  }
+
+  // Adjacent fields are still merged with a zero gap, but the unrequested
+  // fields between entities aren't.
+  BOOST_TEST_EQ(hadesmem::ReadBatch(process, requests, 0), entities.size());
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+int main()
+{
+  TestReadBatchMock();
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestReadBatchProcess();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  return boost::report_errors();
+}
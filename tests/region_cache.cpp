@@ -0,0 +1,228 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/region_cache.hpp>
+#include <hadesmem/region_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/alloc.hpp>
+#include <hadesmem/module.hpp>
+#include <hadesmem/pelib/export_list.hpp>
+#include <hadesmem/pelib/import_dir_list.hpp>
+#include <hadesmem/pelib/import_thunk_list.hpp>
+#include <hadesmem/pelib/pe_file.hpp>
+#include <hadesmem/protect.hpp>
+#include <hadesmem/read.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace
+{
+std::size_t const kPageSize = 0x1000;
+
+// Stand-in for VirtualQueryEx over a fake address space which looks roughly
+// like a loaded module (headers, .text, .rdata, .data).
+class MockQuery
+{
+public:
+  MockQuery()
+  {
+    AddRegion(0x10000, 0x1000, PAGE_READONLY);
+    AddRegion(0x11000, 0x8000, PAGE_EXECUTE_READ);
+    AddRegion(0x19000, 0x4000, PAGE_READONLY);
+    AddRegion(0x1D000, 0x2000, PAGE_READWRITE);
+  }
+
+  MEMORY_BASIC_INFORMATION operator()(LPCVOID address)
+  {
+    ++count_;
+
+    auto const addr = reinterpret_cast<std::uintptr_t>(address);
+    auto const page = addr & ~(kPageSize - 1);
+    for (auto const& region : regions_)
+    {
+      auto const beg = reinterpret_cast<std::uintptr_t>(region.BaseAddress);
+      auto const end = beg + region.RegionSize;
+      if (addr >= beg && addr < end)
+      {
+        MEMORY_BASIC_INFORMATION mbi = region;
+        mbi.BaseAddress = reinterpret_cast<PVOID>(page);
+        mbi.RegionSize = end - page;
+        return mbi;
+      }
+    }
+
+    HADESMEM_DETAIL_THROW_EXCEPTION(hadesmem::Error{}
+                                    << hadesmem::ErrorString{"Bad address."});
+  }
+
+  std::size_t GetCount() const noexcept
+  {
+    return count_;
+  }
+
+private:
+  void AddRegion(std::uintptr_t base, std::size_t size, DWORD protect)
+  {
+    MEMORY_BASIC_INFORMATION mbi{};
+    mbi.BaseAddress = reinterpret_cast<PVOID>(base);
+    mbi.AllocationBase = reinterpret_cast<PVOID>(0x10000);
+    mbi.AllocationProtect = PAGE_EXECUTE_WRITECOPY;
+    mbi.RegionSize = size;
+    mbi.State = MEM_COMMIT;
+    mbi.Protect = protect;
+    mbi.Type = MEM_IMAGE;
+    regions_.push_back(mbi);
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> regions_;
+  std::size_t count_{};
+};
+
+LPCVOID MakePtr(std::uintptr_t address)
+{
+  return reinterpret_cast<LPCVOID>(address);
+}
+}
+
+void TestRegionCacheMock()
+{
+  hadesmem::RegionCache cache{kPageSize};
+  MockQuery mock;
+  auto query = [&](LPCVOID address) { return mock(address); };
+
+  // Simulate PeLib walking a module with lots of tiny sequential reads. Every
+  // read needs a query, but only the first in each region should reach the
+  // backend.
+  std::size_t num_reads = 0;
+  for (std::uintptr_t addr = 0x10000; addr < 0x1F000; addr += 4)
+  {
+    auto const mbi = cache.Query(MakePtr(addr), query);
+    auto const expected = mock(MakePtr(addr));
+    BOOST_TEST_EQ(mbi.BaseAddress, expected.BaseAddress);
+    BOOST_TEST_EQ(mbi.RegionSize, expected.RegionSize);
+    BOOST_TEST_EQ(mbi.Protect, expected.Protect);
+    ++num_reads;
+  }
+  // Discount the reference queries made above.
+  std::size_t const backend_queries = mock.GetCount() - num_reads;
+  BOOST_TEST_EQ(backend_queries, 4U);
+  BOOST_TEST_EQ(cache.GetMisses(), 4U);
+  BOOST_TEST_EQ(cache.GetHits(), num_reads - 4);
+  BOOST_TEST_EQ(cache.GetSize(), 4U);
+
+  // Querying below the cached part of a region is a miss (we only know about
+  // the region from the page we first saw onwards), and replaces the entry.
+  hadesmem::RegionCache cache_partial{kPageSize};
+  cache_partial.Query(MakePtr(0x15000), query);
+  cache_partial.Query(MakePtr(0x17123), query);
+  BOOST_TEST_EQ(cache_partial.GetMisses(), 1U);
+  cache_partial.Query(MakePtr(0x11000), query);
+  BOOST_TEST_EQ(cache_partial.GetMisses(), 2U);
+  BOOST_TEST_EQ(cache_partial.GetSize(), 1U);
+  cache_partial.Query(MakePtr(0x15000), query);
+  BOOST_TEST_EQ(cache_partial.GetMisses(), 2U);
+
+  // Range invalidation only drops overlapping regions.
+  auto const count_before_invalidate = mock.GetCount();
+  cache.Invalidate(MakePtr(0x12000), 0x10);
+  BOOST_TEST_EQ(cache.GetSize(), 3U);
+  cache.Query(MakePtr(0x10000), query);
+  cache.Query(MakePtr(0x1D000), query);
+  BOOST_TEST_EQ(mock.GetCount(), count_before_invalidate);
+  cache.Query(MakePtr(0x12000), query);
+  BOOST_TEST_EQ(mock.GetCount(), count_before_invalidate + 1);
+
+  // A new epoch drops everything.
+  auto const epoch = cache.GetEpoch();
+  cache.NewEpoch();
+  BOOST_TEST_EQ(cache.GetEpoch(), epoch + 1);
+  BOOST_TEST_EQ(cache.GetSize(), 0U);
+  cache.Query(MakePtr(0x10000), query);
+  BOOST_TEST_EQ(mock.GetCount(), count_before_invalidate + 2);
+
+  // Failed queries aren't cached.
+  BOOST_TEST_THROWS(cache.Query(MakePtr(0x50000), query), hadesmem::Error);
+  BOOST_TEST_THROWS(cache.Query(MakePtr(0x50000), query), hadesmem::Error);
+  BOOST_TEST_EQ(mock.GetCount(), count_before_invalidate + 4);
+}
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestRegionCacheProcess()
+{
+  hadesmem::Process process(::GetCurrentProcessId());
+  BOOST_TEST(process.GetRegionCache() == nullptr);
+
+  auto const cache = std::make_shared<hadesmem::RegionCache>();
+  process.SetRegionCache(cache);
+  BOOST_TEST(process.GetRegionCache() == cache.get());
+
+  hadesmem::Process const process_copy(process);
+  BOOST_TEST(process_copy.GetRegionCache() == cache.get());
+
+  // Walk the imports and exports of a few modules, which results in thousands
+  // of small reads.
+  std::size_t num_thunks = 0;
+  for (auto const name : {L"ntdll", L"kernel32"})
+  {
+    hadesmem::Module const module(process, name);
+    hadesmem::PeFile const pe_file(
+      process, module.GetHandle(), hadesmem::PeFileType::kImage, 0);
+    for (auto const& e : hadesmem::ExportList(process, pe_file))
+    {
+      (void)e;
+    }
+    for (auto const& dir : hadesmem::ImportDirList(process, pe_file))
+    {
+      hadesmem::ImportThunkList const thunks(
+        process, pe_file, dir.GetOriginalFirstThunk());
+      for (auto const& thunk : thunks)
+      {
+        (void)thunk;
+        ++num_thunks;
+      }
+    }
+  }
+  BOOST_TEST(num_thunks > 0);
+  BOOST_TEST(cache->GetHits() > cache->GetMisses() * 10);
+
+  // Changing protection through hadesmem keeps the cache coherent.
+  hadesmem::Allocator const allocator(process, 0x1000);
+  auto const data_ptr = static_cast<std::uint32_t*>(allocator.GetBase());
+  *data_ptr = 0x12345678;
+  BOOST_TEST(hadesmem::CanWrite(process, data_ptr));
+  DWORD const old_protect =
+    hadesmem::Protect(process, data_ptr, PAGE_READONLY);
+  BOOST_TEST(!hadesmem::CanWrite(process, data_ptr));
+  BOOST_TEST_EQ(hadesmem::Read<std::uint32_t>(process, data_ptr), 0x12345678U);
+  hadesmem::Protect(process, data_ptr, old_protect);
+  BOOST_TEST(hadesmem::CanWrite(process, data_ptr));
+
+  process.SetRegionCache(nullptr);
+  BOOST_TEST(process.GetRegionCache() == nullptr);
+  BOOST_TEST(process_copy.GetRegionCache() == cache.get());
+}
+
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+int main()
+{
+  TestRegionCacheMock();
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  TestRegionCacheProcess();
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  return boost::report_errors();
+}
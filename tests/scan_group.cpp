@@ -0,0 +1,131 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scan_group.hpp>
+#include <hadesmem/scan_group.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scan_compare.hpp>
+#include <hadesmem/scanner.hpp>
+
+namespace
+{
+template <typename T>
+void Put(std::vector<std::uint8_t>& buf, std::size_t offset, T value)
+{
+  std::memcpy(&buf[offset], &value, sizeof(value));
+}
+}
+
+void TestScanGroup()
+{
+  std::vector<std::uint8_t> buf(0x40000);
+  for (std::size_t i = 0; i < buf.size(); i += 4)
+  {
+    // Plenty of decoys for the common value.
+    Put<std::int32_t>(buf, i, i % 64 ? static_cast<std::int32_t>(i) : 100);
+  }
+
+  // A complete group, in order.
+  Put<std::int32_t>(buf, 0x1000, 100);
+  Put<float>(buf, 0x1008, 1.5f);
+  Put<std::int16_t>(buf, 0x1010, 7);
+  Put<std::int16_t>(buf, 0x1020, 7);
+
+  // Out of order, and straddling the boundary between two chunks.
+  Put<std::int16_t>(buf, 0x7FF8, 7);
+  Put<float>(buf, 0x8004, 1.5f);
+  Put<std::int32_t>(buf, 0x8010, 100);
+
+  // Too far apart.
+  Put<float>(buf, 0x20000, 1.5f);
+  Put<std::int16_t>(buf, 0x20100, 7);
+
+  // At the very start and end of the region.
+  Put<float>(buf, 0, 1.5f);
+  Put<std::int16_t>(buf, 6, 7);
+  Put<std::int32_t>(buf, 0x10, 100);
+  Put<std::int32_t>(buf, 0x3FFF0, 100);
+  Put<float>(buf, 0x3FFF8, 1.5f);
+  Put<std::int16_t>(buf, 0x3FFFE, 7);
+
+  hadesmem::BufferMemorySource const source{buf.data(), buf.size()};
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x8000;
+  options.num_threads = 4;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  hadesmem::ScanGroup group{0x20};
+  group.Add<std::int32_t>(100).Add(1.5f).Add<std::int16_t>(7);
+  auto const matches = scanner.GroupScan(group);
+  BOOST_TEST_EQ(matches.size(), 4U);
+  if (matches.size() == 4)
+  {
+    BOOST_TEST_EQ(matches[0].address, static_cast<void*>(&buf[0]));
+    BOOST_TEST_EQ(matches[0].values[0], static_cast<void*>(&buf[0x10]));
+    BOOST_TEST_EQ(matches[0].values[1], static_cast<void*>(&buf[0]));
+    BOOST_TEST_EQ(matches[0].values[2], static_cast<void*>(&buf[6]));
+    BOOST_TEST_EQ(matches[1].address, static_cast<void*>(&buf[0x1000]));
+    std::vector<void*> const expected{
+      &buf[0x1000], &buf[0x1008], &buf[0x1010]};
+    BOOST_TEST(matches[1].values == expected);
+    BOOST_TEST_EQ(matches[2].address, static_cast<void*>(&buf[0x7FF8]));
+    // The lowest candidate which fits is used.
+    BOOST_TEST_EQ(matches[2].values[0], static_cast<void*>(&buf[0x8000]));
+    BOOST_TEST_EQ(matches[3].address, static_cast<void*>(&buf[0x3FFF0]));
+  }
+
+  // Only the groups whose values are in the order they were added.
+  hadesmem::ScanGroup ordered{0x20, hadesmem::ScanGroupOrder::kOrdered};
+  ordered.Add<std::int32_t>(100).Add(1.5f).Add<std::int16_t>(7);
+  auto const ordered_matches = scanner.GroupScan(ordered);
+  BOOST_TEST_EQ(ordered_matches.size(), 2U);
+  if (ordered_matches.size() == 2)
+  {
+    BOOST_TEST_EQ(ordered_matches[0].address,
+                  static_cast<void*>(&buf[0x1000]));
+    BOOST_TEST_EQ(ordered_matches[1].address,
+                  static_cast<void*>(&buf[0x3FFF0]));
+  }
+
+  // Approximate values, and the same value twice (which must be found at two
+  // different addresses).
+  hadesmem::ScanCompare<float> approx;
+  approx.type = hadesmem::ScanCompareType::kApprox;
+  approx.value = 1.4999f;
+  approx.epsilon = 0.001f;
+  hadesmem::ScanGroup twice{0x100};
+  twice.Add(approx).Add<std::int16_t>(7).Add<std::int16_t>(7);
+  BOOST_TEST_EQ(scanner.GroupScan(twice).size(), 1U);
+
+  bool thrown = false;
+  try
+  {
+    hadesmem::ScanGroup too_small{4};
+    too_small.Add<std::int32_t>(1).Add<std::int32_t>(2);
+    scanner.GroupScan(too_small);
+  }
+  catch (hadesmem::Error const&)
+  {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+}
+
+int main()
+{
+  TestScanGroup();
+  return boost::report_errors();
+}
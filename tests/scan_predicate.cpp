@@ -0,0 +1,154 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scan_predicate.hpp>
+#include <hadesmem/scan_predicate.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scanner.hpp>
+
+namespace
+{
+struct Entity
+{
+  std::int32_t health;
+  std::int32_t flags;
+  std::int32_t max_health;
+};
+}
+
+void TestScanIf()
+{
+  std::vector<std::int32_t> buf(0x10000);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+  {
+    buf[i] = static_cast<std::int32_t>(i * 7919 % 1000) - 500;
+  }
+  // A few plausible entities, where the health is between 0 and the maximum
+  // health stored 8 bytes later.
+  std::size_t const entities[] = {0x100, 0x1001, 0x8000, 0xFFFD};
+  for (auto const i : entities)
+  {
+    buf[i] = 75;
+    buf[i + 2] = 100;
+  }
+
+  hadesmem::BufferMemorySource const source{buf.data(),
+                                            buf.size() * sizeof(buf[0])};
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x3000;
+  options.num_threads = 4;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  auto const is_entity = [](Entity const& e) {
+    return e.health >= 0 && e.max_health >= 100 &&
+           e.health <= e.max_health && e.max_health <= 1000;
+  };
+  auto const found = hadesmem::ScanIf<Entity>(scanner, is_entity);
+
+  // Check against a plain loop.
+  std::vector<void*> expected;
+  for (std::size_t i = 0; i + 2 < buf.size(); ++i)
+  {
+    if (buf[i] >= 0 && buf[i + 2] >= 100 && buf[i] <= buf[i + 2] &&
+        buf[i + 2] <= 1000)
+    {
+      expected.push_back(&buf[i]);
+    }
+  }
+  BOOST_TEST(found == expected);
+  for (auto const i : entities)
+  {
+    BOOST_TEST(std::find(std::begin(found), std::end(found), &buf[i]) !=
+               std::end(found));
+  }
+
+  auto const set = scanner.FirstScanIf<Entity>(is_entity);
+  BOOST_TEST_EQ(set.GetCount(), expected.size());
+  std::size_t checked = 0;
+  set.ForEach([&](void* address, void const* value) {
+    BOOST_TEST(std::memcmp(address, value, sizeof(Entity)) == 0);
+    ++checked;
+  });
+  BOOST_TEST_EQ(checked, expected.size());
+}
+
+void TestScanIfBatch()
+{
+  std::vector<std::uint8_t> buf(0x20000 + 3);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+  {
+    buf[i] = static_cast<std::uint8_t>(i * 31 % 251);
+  }
+
+  // Offset by one byte, so that the buffer isn't aligned for the values.
+  hadesmem::BufferMemorySource const source{buf.data() + 1, buf.size() - 1};
+  auto const in_range = [](std::uint16_t v) {
+    return v >= 0x1000 && v < 0x4000;
+  };
+  auto const batch_in_range = [](
+    hadesmem::ScanSpan<std::uint16_t const> values,
+    hadesmem::ScanBitmask& bits) {
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      if (values[i] >= 0x1000 && values[i] < 0x4000)
+      {
+        bits.Set(i);
+      }
+    }
+    // Garbage past the end of the span is ignored.
+    if (values.size() % 64)
+    {
+      bits.GetWords()[bits.GetNumWords() - 1] |= ~0ULL << (values.size() % 64);
+    }
+  };
+
+  // Packed, packed but misaligned in the buffer, and overlapping values.
+  std::size_t const alignments[] = {0, 2, 1};
+  std::size_t const chunk_sizes[] = {0x1001, 0x8000};
+  for (auto const alignment : alignments)
+  {
+    for (auto const chunk_size : chunk_sizes)
+    {
+      hadesmem::ScanOptions options;
+      options.alignment = alignment;
+      options.chunk_size = chunk_size;
+      hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                    options};
+
+      auto const expected = scanner.ScanIf<std::uint16_t>(in_range);
+      BOOST_TEST(!expected.empty());
+      BOOST_TEST(
+        hadesmem::ScanIfBatch<std::uint16_t>(scanner, batch_in_range) ==
+        expected);
+
+      auto const set =
+        scanner.FirstScanIfBatch<std::uint16_t>(batch_in_range);
+      BOOST_TEST_EQ(set.GetCount(), expected.size());
+      std::vector<void*> addresses;
+      set.ForEach([&](void* address, void const* /*value*/) {
+        addresses.push_back(address);
+      });
+      BOOST_TEST(addresses == expected);
+    }
+  }
+}
+
+int main()
+{
+  TestScanIf();
+  TestScanIfBatch();
+  return boost::report_errors();
+}
@@ -0,0 +1,220 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scan_results.hpp>
+#include <hadesmem/scan_results.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scanner.hpp>
+
+namespace
+{
+std::vector<std::uint32_t> DecodeSlots(hadesmem::detail::ScanBlock const& block,
+                                       std::size_t value_size,
+                                       std::vector<std::uint32_t>* values)
+{
+  std::vector<std::uint32_t> slots;
+  hadesmem::detail::DecodeScanBlock(
+    block.header,
+    block.data.data(),
+    value_size,
+    [&](std::uint32_t slot, void const* value) {
+      slots.push_back(slot);
+      if (values)
+      {
+        std::uint32_t v = 0;
+        std::memcpy(&v, value, sizeof(v));
+        values->push_back(v);
+      }
+    });
+  return slots;
+}
+}
+
+void TestScanBlockEncoding()
+{
+  using hadesmem::detail::EncodeScanBlock;
+  using hadesmem::detail::ScanBlockEncoding;
+
+  // Sparse matches are delta encoded.
+  std::vector<std::uint32_t> const sparse = {3, 1000, 50000};
+  auto const sparse_block =
+    EncodeScanBlock(0x1000, 0x10000, sparse, nullptr, 0);
+  BOOST_TEST(sparse_block.header.encoding == ScanBlockEncoding::kDelta);
+  BOOST_TEST(DecodeSlots(sparse_block, 0, nullptr) == sparse);
+
+  // Long runs are stored as ranges.
+  std::vector<std::uint32_t> runs;
+  for (std::uint32_t i = 100; i < 5000; ++i)
+  {
+    runs.push_back(i);
+  }
+  auto const runs_block = EncodeScanBlock(0x1000, 0x10000, runs, nullptr, 0);
+  BOOST_TEST(runs_block.header.encoding == ScanBlockEncoding::kRanges);
+  BOOST_TEST(runs_block.data.size() < 8U);
+  BOOST_TEST(DecodeSlots(runs_block, 0, nullptr) == runs);
+
+  // Dense but scattered matches use a bitmap.
+  std::vector<std::uint32_t> dense;
+  for (std::uint32_t i = 0; i < 0x1000; i += 3)
+  {
+    dense.push_back(i);
+  }
+  auto const dense_block = EncodeScanBlock(0x1000, 0x1000, dense, nullptr, 0);
+  BOOST_TEST(dense_block.header.encoding == ScanBlockEncoding::kBitmap);
+  BOOST_TEST_EQ(dense_block.data.size(), 0x200U);
+  BOOST_TEST(DecodeSlots(dense_block, 0, nullptr) == dense);
+
+  // Identical values are only stored once.
+  std::vector<std::uint32_t> const same(runs.size(), 0xDEADBEEF);
+  auto const same_block =
+    EncodeScanBlock(0x1000, 0x10000, runs, same.data(), sizeof(std::uint32_t));
+  BOOST_TEST(!!(same_block.header.flags &
+                hadesmem::detail::ScanBlockFlags::kUniformValue));
+  BOOST_TEST(same_block.data.size() < 12U);
+  std::vector<std::uint32_t> same_decoded;
+  DecodeSlots(same_block, sizeof(std::uint32_t), &same_decoded);
+  BOOST_TEST(same_decoded == same);
+
+  std::vector<std::uint32_t> const different = {1, 2, 3};
+  auto const different_block = EncodeScanBlock(
+    0x1000, 0x10000, sparse, different.data(), sizeof(std::uint32_t));
+  BOOST_TEST(!(different_block.header.flags &
+               hadesmem::detail::ScanBlockFlags::kUniformValue));
+  std::vector<std::uint32_t> different_decoded;
+  DecodeSlots(different_block, sizeof(std::uint32_t), &different_decoded);
+  BOOST_TEST(different_decoded == different);
+}
+
+void TestScanResultSetSpill()
+{
+  // A tiny budget forces the set to move to a file almost immediately.
+  hadesmem::ScanResultSet set{4, 0, 0x100};
+  std::vector<void*> expected;
+  for (std::uint32_t b = 0; b < 64; ++b)
+  {
+    std::uintptr_t const base = 0x10000 + b * 0x4000;
+    std::vector<std::uint32_t> slots;
+    for (std::uint32_t i = b % 7; i < 0x1000; i += 5 + b % 11)
+    {
+      slots.push_back(i);
+      expected.push_back(reinterpret_cast<void*>(base + i * 4));
+    }
+    set.Append(
+      hadesmem::detail::EncodeScanBlock(base, 0x1000, slots, nullptr, 0));
+  }
+
+  BOOST_TEST(set.IsSpilled());
+  BOOST_TEST_EQ(set.GetCount(), expected.size());
+  BOOST_TEST_EQ(set.GetBlocks().size(), 64U);
+  BOOST_TEST(set.GetAddresses() == expected);
+
+  hadesmem::ScanResultSet const moved{std::move(set)};
+  BOOST_TEST(moved.GetAddresses() == expected);
+
+  hadesmem::ScanResultSet small{4, 0};
+  small.Append(hadesmem::detail::EncodeScanBlock(
+    0x10000, 0x1000, std::vector<std::uint32_t>{1, 2, 3}, nullptr, 0));
+  BOOST_TEST(!small.IsSpilled());
+  BOOST_TEST_EQ(small.GetCount(), 3U);
+
+  // Empty blocks are discarded.
+  small.Append(hadesmem::detail::EncodeScanBlock(
+    0x20000, 0x1000, std::vector<std::uint32_t>{}, nullptr, 0));
+  BOOST_TEST_EQ(small.GetBlocks().size(), 1U);
+}
+
+void TestNextScan()
+{
+  std::vector<std::uint32_t> buf(0x10000);
+  for (std::size_t i = 0; i < buf.size(); i += 3)
+  {
+    buf[i] = 100;
+  }
+  hadesmem::BufferMemorySource const source{
+    buf.data(), buf.size() * sizeof(buf[0])};
+
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x1000;
+  options.num_threads = 4;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  auto const first = scanner.FirstScan<std::uint32_t>(100);
+  BOOST_TEST_EQ(first.GetCount(), (buf.size() + 2) / 3);
+  BOOST_TEST_EQ(first.GetValueSize(), sizeof(std::uint32_t));
+  BOOST_TEST(first.GetAddresses() == scanner.ScanExact<std::uint32_t>(100));
+
+  auto const unchanged =
+    scanner.NextScan<std::uint32_t>(first, hadesmem::ScanNextType::kUnchanged);
+  BOOST_TEST_EQ(unchanged.GetCount(), first.GetCount());
+
+  buf[0] = 101;
+  buf[3] = 99;
+  buf[6] = 150;
+  buf[0xFFFF] = 5;
+
+  auto const changed =
+    scanner.NextScan<std::uint32_t>(first, hadesmem::ScanNextType::kChanged);
+  BOOST_TEST_EQ(changed.GetCount(), 4U);
+
+  auto const increased =
+    scanner.NextScan<std::uint32_t>(first, hadesmem::ScanNextType::kIncreased);
+  BOOST_TEST_EQ(increased.GetCount(), 2U);
+  auto const increased_addresses = increased.GetAddresses();
+  BOOST_TEST_EQ(increased_addresses[0], static_cast<void*>(&buf[0]));
+  BOOST_TEST_EQ(increased_addresses[1], static_cast<void*>(&buf[6]));
+
+  // The new values are stored, so the next pass compares against them.
+  std::vector<std::uint32_t> increased_values;
+  increased.ForEach([&](void* /*address*/, void const* value) {
+    std::uint32_t v = 0;
+    std::memcpy(&v, value, sizeof(v));
+    increased_values.push_back(v);
+  });
+  BOOST_TEST(increased_values == (std::vector<std::uint32_t>{101, 150}));
+
+  auto const decreased =
+    scanner.NextScan<std::uint32_t>(first, hadesmem::ScanNextType::kDecreased);
+  BOOST_TEST_EQ(decreased.GetCount(), 2U);
+
+  auto const equal = scanner.NextScan<std::uint32_t>(
+    changed, hadesmem::ScanNextType::kEqual, 150);
+  BOOST_TEST_EQ(equal.GetCount(), 1U);
+  BOOST_TEST_EQ(equal.GetAddresses()[0], static_cast<void*>(&buf[6]));
+
+  buf[6] = 150;
+  auto const unchanged_again = scanner.NextScan<std::uint32_t>(
+    increased, hadesmem::ScanNextType::kUnchanged);
+  BOOST_TEST_EQ(unchanged_again.GetCount(), 2U);
+
+  bool thrown = false;
+  try
+  {
+    scanner.NextScan<std::uint64_t>(first, hadesmem::ScanNextType::kChanged);
+  }
+  catch (hadesmem::Error const&)
+  {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+}
+
+int main()
+{
+  TestScanBlockEncoding();
+  TestScanResultSetSpill();
+  TestNextScan();
+  return boost::report_errors();
+}
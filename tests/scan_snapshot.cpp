@@ -0,0 +1,128 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scan_snapshot.hpp>
+#include <hadesmem/scan_snapshot.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scan_results.hpp>
+#include <hadesmem/scanner.hpp>
+
+void TestScanSnapshot()
+{
+  std::vector<std::int32_t> buf(0x20000);
+  for (std::size_t i = 0; i < buf.size(); ++i)
+  {
+    buf[i] = static_cast<std::int32_t>(i % 1000);
+  }
+  hadesmem::BufferMemorySource const source{buf.data(),
+                                            buf.size() * sizeof(buf[0])};
+
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x3000;
+  options.num_threads = 4;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  auto snapshot = scanner.TakeSnapshot<std::int32_t>();
+  BOOST_TEST_EQ(snapshot.GetCount(), buf.size());
+  BOOST_TEST_EQ(snapshot.GetValueSize(), sizeof(std::int32_t));
+  BOOST_TEST_EQ(snapshot.GetAlignment(), alignof(std::int32_t));
+  BOOST_TEST(snapshot.GetFileSize() >= buf.size() * sizeof(buf[0]));
+
+  scanner.NextScan<std::int32_t>(snapshot, hadesmem::ScanNextType::kUnchanged);
+  BOOST_TEST_EQ(snapshot.GetCount(), buf.size());
+
+  buf[5] += 10;
+  buf[0x3000] += 10;
+  buf[0x1FFFF] += 3;
+  buf[0x10000] -= 1;
+  scanner.NextScan<std::int32_t>(snapshot, hadesmem::ScanNextType::kChanged);
+  BOOST_TEST_EQ(snapshot.GetCount(), 4U);
+
+  // The snapshot now holds the values from the last pass.
+  buf[5] += 10;
+  buf[0x3000] += 1;
+  buf[0x1FFFF] += 10;
+  scanner.NextScan<std::int32_t>(
+    snapshot, hadesmem::ScanNextType::kIncreasedBy, 10);
+  BOOST_TEST_EQ(snapshot.GetCount(), 2U);
+
+  std::vector<void*> addresses;
+  std::vector<std::int32_t> values;
+  snapshot.ForEach([&](void* address, void const* value) {
+    addresses.push_back(address);
+    values.push_back(*static_cast<std::int32_t const*>(value));
+  });
+  BOOST_TEST(addresses ==
+             (std::vector<void*>{&buf[5], &buf[0x1FFFF]}));
+  BOOST_TEST(values == (std::vector<std::int32_t>{25, buf[0x1FFFF]}));
+
+  // Hand over to a regular result set once the candidates are few enough.
+  auto const results = snapshot.ToResultSet();
+  BOOST_TEST_EQ(results.GetCount(), 2U);
+  BOOST_TEST(results.GetAddresses() == addresses);
+  buf[5] -= 1;
+  auto const decreased = scanner.NextScan<std::int32_t>(
+    results, hadesmem::ScanNextType::kDecreasedBy, 1);
+  BOOST_TEST_EQ(decreased.GetCount(), 1U);
+  BOOST_TEST_EQ(decreased.GetAddresses()[0], static_cast<void*>(&buf[5]));
+
+  scanner.NextScan<std::int32_t>(snapshot, hadesmem::ScanNextType::kDecreased);
+  BOOST_TEST_EQ(snapshot.GetCount(), 1U);
+
+  scanner.NextScan<std::int32_t>(snapshot, hadesmem::ScanNextType::kEqual, 0);
+  BOOST_TEST_EQ(snapshot.GetCount(), 0U);
+
+  bool thrown = false;
+  try
+  {
+    scanner.NextScan<std::int64_t>(snapshot,
+                                   hadesmem::ScanNextType::kUnchanged);
+  }
+  catch (hadesmem::Error const&)
+  {
+    thrown = true;
+  }
+  BOOST_TEST(thrown);
+}
+
+void TestScanSnapshotUnaligned()
+{
+  std::vector<std::uint8_t> buf(0x1000);
+  hadesmem::BufferMemorySource const source{buf.data(), buf.size()};
+
+  hadesmem::ScanOptions options;
+  options.alignment = 1;
+  options.chunk_size = 0x100;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  auto snapshot = scanner.TakeSnapshot<std::uint16_t>();
+  BOOST_TEST_EQ(snapshot.GetCount(), buf.size() - 1);
+
+  // Values which straddle two chunks are still compared.
+  buf[0x100] = 1;
+  scanner.NextScan<std::uint16_t>(snapshot, hadesmem::ScanNextType::kChanged);
+  BOOST_TEST_EQ(snapshot.GetCount(), 2U);
+  auto const results = snapshot.ToResultSet();
+  BOOST_TEST(results.GetAddresses() ==
+             (std::vector<void*>{&buf[0xFF], &buf[0x100]}));
+}
+
+int main()
+{
+  TestScanSnapshot();
+  TestScanSnapshotUnaligned();
+  return boost::report_errors();
+}
@@ -0,0 +1,254 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scan_string.hpp>
+#include <hadesmem/scan_string.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/scanner.hpp>
+
+namespace
+{
+void PutUtf8(std::vector<std::uint8_t>& buf,
+             std::size_t offset,
+             std::string const& str)
+{
+  std::memcpy(&buf[offset], str.data(), str.size());
+}
+
+void PutUtf16(std::vector<std::uint8_t>& buf,
+              std::size_t offset,
+              std::vector<std::uint16_t> const& units)
+{
+  for (std::size_t i = 0; i < units.size(); ++i)
+  {
+    buf[offset + i * 2] = static_cast<std::uint8_t>(units[i] & 0xFF);
+    buf[offset + i * 2 + 1] = static_cast<std::uint8_t>(units[i] >> 8);
+  }
+}
+
+std::vector<std::size_t> GetOffsets(std::vector<void*> const& found,
+                                    std::vector<std::uint8_t> const& buf)
+{
+  std::vector<std::size_t> offsets;
+  for (auto const p : found)
+  {
+    offsets.push_back(static_cast<std::size_t>(
+      static_cast<std::uint8_t const*>(p) - buf.data()));
+  }
+  return offsets;
+}
+
+bool Throws(std::string const& pattern)
+{
+  try
+  {
+    hadesmem::ScanStringOptions options;
+    options.regex = true;
+    hadesmem::ScanStringPattern const compiled{pattern, options};
+  }
+  catch (hadesmem::Error const&)
+  {
+    return true;
+  }
+  return false;
+}
+}
+
+void TestScanStringLiteral()
+{
+  std::vector<std::uint8_t> buf(0x20000, 'x');
+  PutUtf8(buf, 0x100, "Hello World");
+  PutUtf8(buf, 0x200, "hello world");
+  PutUtf8(buf, 0x300, "HELLO WORLD");
+  // Straddling the boundary between two chunks.
+  PutUtf8(buf, 0x7FFC, "Hello World");
+  // Overlapping matches.
+  PutUtf8(buf, 0x1000, "aaaa");
+  // Non-ASCII letters (e-acute and Cyrillic De), which differ in more than
+  // the last byte in some cases.
+  PutUtf8(buf, 0x2000, "Caf\xC3\xA9 \xD0\x94");
+  PutUtf8(buf, 0x2100, "CAF\xC3\x89 \xD0\xB4");
+  // At the very end.
+  PutUtf8(buf, buf.size() - 5, "HeLLo");
+
+  hadesmem::BufferMemorySource const source{buf.data(), buf.size()};
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x8000;
+  options.num_threads = 4;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  std::vector<std::size_t> const sensitive{0x100, 0x7FFC};
+  BOOST_TEST(GetOffsets(scanner.ScanString("Hello World"), buf) == sensitive);
+
+  hadesmem::ScanStringOptions insensitive;
+  insensitive.case_insensitive = true;
+  std::vector<std::size_t> const all{0x100, 0x200, 0x300, 0x7FFC};
+  BOOST_TEST(GetOffsets(scanner.ScanString("hELLO wORLD", insensitive), buf) ==
+             all);
+  std::vector<std::size_t> const hello{
+    0x100, 0x200, 0x300, 0x7FFC, buf.size() - 5};
+  BOOST_TEST(GetOffsets(scanner.ScanString("hello", insensitive), buf) ==
+             hello);
+
+  std::vector<std::size_t> const overlapping{0x1000, 0x1001, 0x1002};
+  BOOST_TEST(GetOffsets(scanner.ScanString("aa"), buf) == overlapping);
+
+  std::vector<std::size_t> const cafe{0x2000, 0x2100};
+  BOOST_TEST(GetOffsets(scanner.ScanString("caf\xC3\xA9 \xD0\x94", insensitive),
+                        buf) == cafe);
+  BOOST_TEST_EQ(scanner.ScanString("caf\xC3\xA9 \xD0\x94").size(), 0U);
+
+  // Every chunk size gives the same results.
+  std::size_t const chunk_sizes[] = {0x7, 0x10, 0x1000};
+  for (auto const chunk_size : chunk_sizes)
+  {
+    hadesmem::ScanOptions small_options{options};
+    small_options.chunk_size = chunk_size;
+    hadesmem::Scanner<hadesmem::BufferMemorySource> const small_scanner{
+      source, small_options};
+    BOOST_TEST(
+      GetOffsets(small_scanner.ScanString("hello", insensitive), buf) == hello);
+    BOOST_TEST(GetOffsets(small_scanner.ScanString("aa"), buf) ==
+               overlapping);
+  }
+}
+
+void TestScanStringWide()
+{
+  std::vector<std::uint8_t> buf(0x4000);
+  // "Hello" and "HELLO" in UTF-16, and a misaligned copy which must not be
+  // found.
+  std::vector<std::uint16_t> const mixed{'H', 'e', 'l', 'l', 'o'};
+  std::vector<std::uint16_t> const upper{'H', 'E', 'L', 'L', 'O'};
+  PutUtf16(buf, 0x100, mixed);
+  PutUtf16(buf, 0x201, mixed);
+  PutUtf16(buf, 0x300, upper);
+  // Greek, and a character outside the BMP (U+1F600) as a surrogate pair.
+  std::vector<std::uint16_t> const greek{0x391, 0x3B2, 0xD83D, 0xDE00};
+  std::vector<std::uint16_t> const greek_lower{0x3B1, 0x392, 0xD83D, 0xDE00};
+  PutUtf16(buf, 0x400, greek);
+  PutUtf16(buf, 0x500, greek_lower);
+
+  hadesmem::BufferMemorySource const source{buf.data(), buf.size()};
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x101;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  std::vector<std::size_t> const sensitive{0x100};
+  BOOST_TEST(GetOffsets(scanner.ScanString(std::wstring{L"Hello"}), buf) ==
+             sensitive);
+
+  hadesmem::ScanStringOptions insensitive;
+  insensitive.case_insensitive = true;
+  std::vector<std::size_t> const all{0x100, 0x300};
+  BOOST_TEST(GetOffsets(scanner.ScanString(std::wstring{L"hello"}, insensitive),
+                        buf) == all);
+
+  // Greek letters in either case.
+  std::wstring const wide_greek{
+    static_cast<wchar_t>(0x3B1), static_cast<wchar_t>(0x3B2)};
+  std::vector<std::size_t> const both_greek{0x400, 0x500};
+  BOOST_TEST(GetOffsets(scanner.ScanString(wide_greek, insensitive), buf) ==
+             both_greek);
+
+  // Ranges of code points, and '.' matching a surrogate pair as a whole. The
+  // same pattern in narrow text searches for UTF-8 instead.
+  hadesmem::ScanStringOptions regex;
+  regex.regex = true;
+  std::vector<std::size_t> const capitals{0x400, 0x502};
+  BOOST_TEST(GetOffsets(scanner.ScanString(std::wstring{L"[\\u0391-\\u03A9]"},
+                                           regex),
+                        buf) == capitals);
+  BOOST_TEST_EQ(
+    scanner.ScanString(std::string{"[\\u0391-\\u03A9]"}, regex).size(), 0U);
+  hadesmem::ScanStringPattern const pair{std::wstring{L"\\u03B2."}, regex};
+  std::vector<std::size_t> const after_beta{0x402};
+  BOOST_TEST(GetOffsets(scanner.ScanString(pair), buf) == after_beta);
+}
+
+void TestScanStringRegex()
+{
+  std::vector<std::uint8_t> buf(0x10000, '.');
+  PutUtf8(buf, 0x100, "user@example.com");
+  PutUtf8(buf, 0x200, "Admin@Example.COM");
+  PutUtf8(buf, 0x300, "not an email@");
+  PutUtf8(buf, 0x3FF8, "player_42@host.com");
+  PutUtf8(buf, 0x500, "id=12345;");
+  PutUtf8(buf, 0x600, "id=7;");
+  PutUtf8(buf, 0x700, "id=;");
+
+  hadesmem::BufferMemorySource const source{buf.data(), buf.size()};
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x1000;
+  options.num_threads = 2;
+  hadesmem::Scanner<hadesmem::BufferMemorySource> const scanner{source,
+                                                                options};
+
+  hadesmem::ScanStringOptions regex;
+  regex.regex = true;
+  hadesmem::ScanStringPattern const email{"\\w+@[a-z]+\\.com", regex};
+  std::vector<std::size_t> const emails{0x100, 0x3FF8};
+  BOOST_TEST(GetOffsets(scanner.ScanString(email), buf) == emails);
+
+  hadesmem::ScanStringOptions regex_insensitive{regex};
+  regex_insensitive.case_insensitive = true;
+  std::vector<std::size_t> const all_emails{0x100, 0x200, 0x3FF8};
+  BOOST_TEST(GetOffsets(scanner.ScanString("\\w+@[a-z]+\\.com",
+                                           regex_insensitive),
+                        buf) == all_emails);
+
+  std::vector<std::size_t> const ids{0x500, 0x600};
+  BOOST_TEST(GetOffsets(scanner.ScanString("id=\\d{1,5};", regex), buf) ==
+             ids);
+  std::vector<std::size_t> const long_ids{0x500};
+  BOOST_TEST(GetOffsets(scanner.ScanString("id=(?:\\d\\d)+\\d;", regex), buf) ==
+             long_ids);
+  std::vector<std::size_t> const any_ids{0x500, 0x600, 0x700};
+  BOOST_TEST(GetOffsets(scanner.ScanString("id=[^;]*;", regex), buf) ==
+             any_ids);
+  std::vector<std::size_t> const alternation{0x304, 0x500, 0x600, 0x700};
+  BOOST_TEST(GetOffsets(scanner.ScanString("(an|id=)[0-9]*[ ;]", regex),
+                        buf) == alternation);
+
+  // Runs are found once, from their start.
+  std::vector<std::size_t> const runs{0x106, 0x207};
+  BOOST_TEST(GetOffsets(scanner.ScanString("x[a-z]+", regex), buf) == runs);
+  std::vector<std::size_t> const names{0x100, 0x201, 0x307};
+  BOOST_TEST(GetOffsets(scanner.ScanString("[a-z]{4,}@", regex), buf) ==
+             names);
+
+  BOOST_TEST(Throws("a|*"));
+  BOOST_TEST(Throws("(abc"));
+  BOOST_TEST(Throws("abc)"));
+  BOOST_TEST(Throws("[abc"));
+  BOOST_TEST(Throws("[z-a]"));
+  BOOST_TEST(Throws("a*"));
+  BOOST_TEST(Throws("^abc"));
+  BOOST_TEST(Throws("\\q"));
+  BOOST_TEST(Throws("a{2,1}"));
+  BOOST_TEST(!Throws("a{,1}"));
+  BOOST_TEST(!Throws("[]a]"));
+}
+
+int main()
+{
+  TestScanStringLiteral();
+  TestScanStringWide();
+  TestScanStringRegex();
+  return boost::report_errors();
+}
@@ -0,0 +1,279 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/scanner.hpp>
+#include <hadesmem/scanner.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+#include <hadesmem/process.hpp>
+
+#if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <unistd.h>
+#endif // #if !defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+namespace
+{
+// Several fake regions with different types and protections, all backed by a
+// single buffer.
+class FakeMemorySource
+{
+public:
+  FakeMemorySource() : buf_(0x4000)
+  {
+    AddRegion(0x0000, 0x1000, MEM_PRIVATE, PAGE_READWRITE);
+    AddRegion(0x1000, 0x1000, MEM_IMAGE, PAGE_EXECUTE_READ);
+    AddRegion(0x2000, 0x1000, MEM_MAPPED, PAGE_READONLY);
+    AddRegion(0x3000, 0x800, MEM_IMAGE, PAGE_WRITECOPY);
+    AddRegion(0x3800, 0x800, MEM_PRIVATE, PAGE_READWRITE | PAGE_GUARD);
+  }
+
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    auto const offset = GetOffset(address, len);
+    std::memcpy(data, &buf_[offset], len);
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    auto const offset = GetOffset(address, len);
+    std::memcpy(&buf_[offset], data, len);
+  }
+
+  MEMORY_BASIC_INFORMATION Query(void const* address) const
+  {
+    return hadesmem::detail::QueryRegionList(regions_, address);
+  }
+
+  std::vector<MEMORY_BASIC_INFORMATION> GetRegions() const
+  {
+    return regions_;
+  }
+
+  std::uint8_t* At(std::size_t offset) const noexcept
+  {
+    return kBase + offset;
+  }
+
+private:
+  void AddRegion(std::size_t offset, std::size_t len, DWORD type, DWORD prot)
+  {
+    MEMORY_BASIC_INFORMATION mbi{};
+    mbi.BaseAddress = At(offset);
+    mbi.AllocationBase = mbi.BaseAddress;
+    mbi.RegionSize = len;
+    mbi.State = MEM_COMMIT;
+    mbi.Protect = prot;
+    mbi.AllocationProtect = prot;
+    mbi.Type = type;
+    regions_.push_back(mbi);
+  }
+
+  std::size_t GetOffset(void* address, std::size_t len) const
+  {
+    auto const p = static_cast<std::uint8_t*>(address);
+    if (p < kBase || p + len > kBase + buf_.size())
+    {
+      HADESMEM_DETAIL_THROW_EXCEPTION(hadesmem::Error{}
+                                      << hadesmem::ErrorString{"Bad read."});
+    }
+    return static_cast<std::size_t>(p - kBase);
+  }
+
+  std::uint8_t* const kBase = reinterpret_cast<std::uint8_t*>(0x10000000);
+  mutable std::vector<std::uint8_t> buf_;
+  std::vector<MEMORY_BASIC_INFORMATION> regions_;
+};
+
+template <typename T>
+void PutValue(FakeMemorySource const& source, std::size_t offset, T value)
+{
+  hadesmem::detail::SourceWrite(source, source.At(offset), value);
+}
+}
+
+void TestScanFilters()
+{
+  FakeMemorySource const source;
+
+  hadesmem::ScanOptions options;
+  BOOST_TEST_EQ(hadesmem::Scanner<FakeMemorySource>(source, options)
+                  .GetRegions()
+                  .size(),
+                4U);
+
+  options.protect_required = hadesmem::ScanProtectFlags::kWrite;
+  options.protect_excluded = hadesmem::ScanProtectFlags::kCopyOnWrite;
+  auto const writable =
+    hadesmem::Scanner<FakeMemorySource>(source, options).GetRegions();
+  BOOST_TEST_EQ(writable.size(), 1U);
+  BOOST_TEST_EQ(writable[0].BaseAddress, static_cast<PVOID>(source.At(0)));
+
+  options = hadesmem::ScanOptions{};
+  options.types = hadesmem::ScanTypeFlags::kImage;
+  options.protect_excluded = hadesmem::ScanProtectFlags::kExecute;
+  auto const image_data =
+    hadesmem::Scanner<FakeMemorySource>(source, options).GetRegions();
+  BOOST_TEST_EQ(image_data.size(), 1U);
+  BOOST_TEST_EQ(image_data[0].BaseAddress,
+                static_cast<PVOID>(source.At(0x3000)));
+
+  // Regions are clipped to the range.
+  options = hadesmem::ScanOptions{};
+  options.start = source.At(0x0800);
+  options.end = source.At(0x1800);
+  auto const clipped =
+    hadesmem::Scanner<FakeMemorySource>(source, options).GetRegions();
+  BOOST_TEST_EQ(clipped.size(), 2U);
+  BOOST_TEST_EQ(clipped[0].BaseAddress, static_cast<PVOID>(source.At(0x800)));
+  BOOST_TEST_EQ(clipped[0].RegionSize, 0x800U);
+  BOOST_TEST_EQ(clipped[1].RegionSize, 0x800U);
+
+  options.chunk_size = 0;
+  BOOST_TEST_THROWS(hadesmem::Scanner<FakeMemorySource>(source, options),
+                    hadesmem::Error);
+}
+
+void TestScanChunks()
+{
+  MEMORY_BASIC_INFORMATION mbi{};
+  mbi.BaseAddress = reinterpret_cast<PVOID>(0x1000);
+  mbi.RegionSize = 0x2800;
+  auto const chunks = hadesmem::detail::MakeScanChunks({mbi}, 0x1000, 3);
+  BOOST_TEST_EQ(chunks.size(), 3U);
+  BOOST_TEST_EQ(chunks[0].address, 0x1000U);
+  BOOST_TEST_EQ(chunks[0].len, 0x1000U);
+  BOOST_TEST_EQ(chunks[0].read_len, 0x1003U);
+  BOOST_TEST_EQ(chunks[2].address, 0x3000U);
+  BOOST_TEST_EQ(chunks[2].len, 0x800U);
+  BOOST_TEST_EQ(chunks[2].read_len, 0x800U);
+}
+
+template <typename T> void TestScanExactType(T value)
+{
+  FakeMemorySource const source;
+  PutValue(source, 0x10, value);
+  // Straddles a chunk boundary.
+  PutValue(source, 0x200 - sizeof(T) / 2, value);
+  // Misaligned.
+  PutValue(source, 0x401, value);
+  // Read-only image region.
+  PutValue(source, 0x1100, value);
+  // Straddles the end of a region, so is never found.
+  PutValue(source, 0x1000 - sizeof(T) / 2, value);
+  // Guard page.
+  PutValue(source, 0x3900, value);
+
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x100;
+  options.num_threads = 4;
+  auto const aligned =
+    hadesmem::Scanner<FakeMemorySource>(source, options).ScanExact(value);
+
+  std::vector<void*> expected{source.At(0x10), source.At(0x1100)};
+  if (sizeof(T) == 1)
+  {
+    expected = {source.At(0x10),
+                source.At(0x200),
+                source.At(0x401),
+                source.At(0x1000),
+                source.At(0x1100)};
+  }
+  else if ((0x200 - sizeof(T) / 2) % sizeof(T) == 0)
+  {
+    expected.insert(std::begin(expected) + 1,
+                    source.At(0x200 - sizeof(T) / 2));
+  }
+  BOOST_TEST(aligned == expected);
+
+  options.alignment = 1;
+  options.num_threads = 1;
+  auto const unaligned =
+    hadesmem::Scanner<FakeMemorySource>(source, options).ScanExact(value);
+  if (sizeof(T) == 1)
+  {
+    BOOST_TEST(unaligned == expected);
+  }
+  else
+  {
+    std::vector<void*> const expected_unaligned{
+      source.At(0x10),
+      source.At(0x200 - sizeof(T) / 2),
+      source.At(0x401),
+      source.At(0x1100)};
+    BOOST_TEST(unaligned == expected_unaligned);
+  }
+}
+
+void TestScanExact()
+{
+  TestScanExactType<std::int8_t>(-0x12);
+  TestScanExactType<std::uint16_t>(0xBEEF);
+  TestScanExactType<std::int32_t>(-0x12345678);
+  TestScanExactType<std::uint64_t>(0x1122334455667788ULL);
+  TestScanExactType<float>(1234.5f);
+  TestScanExactType<double>(-98765.4321);
+
+  // Threading doesn't affect the results or their order.
+  FakeMemorySource const source;
+  for (std::size_t i = 0; i < 0x1000; i += 12)
+  {
+    PutValue(source, i, std::uint32_t{0xCAFEBABE});
+  }
+  hadesmem::ScanOptions options;
+  options.chunk_size = 0x40;
+  options.num_threads = 1;
+  auto const single =
+    hadesmem::Scanner<FakeMemorySource>(source, options).ScanExact(0xCAFEBABEU);
+  options.num_threads = 8;
+  auto const multi =
+    hadesmem::Scanner<FakeMemorySource>(source, options).ScanExact(0xCAFEBABEU);
+  BOOST_TEST_EQ(single.size(), 0x1000U / 12 + 1);
+  BOOST_TEST(single == multi);
+}
+
+void TestScanProcess()
+{
+  std::vector<std::uint64_t> data(0x10000);
+  data[0x1234] = 0x0123456789ABCDEFULL;
+  data[0xFFFF] = 0x0123456789ABCDEFULL;
+
+  hadesmem::ScanOptions options;
+  options.protect_required = hadesmem::ScanProtectFlags::kWrite;
+  options.start = data.data();
+  options.end = data.data() + data.size();
+  options.chunk_size = 0x1000;
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  using MemorySource = hadesmem::ProcessMemorySource;
+  hadesmem::Process const process{::GetCurrentProcessId()};
+#else  // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  using MemorySource = hadesmem::ProcMemorySource;
+  hadesmem::Process const process{static_cast<DWORD>(::getpid())};
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  MemorySource const source{process};
+
+  hadesmem::Scanner<MemorySource> const scanner{source, options};
+  auto const found = scanner.ScanExact(0x0123456789ABCDEFULL);
+  std::vector<void*> const expected{&data[0x1234], &data[0xFFFF]};
+  BOOST_TEST(found == expected);
+}
+
+int main()
+{
+  TestScanFilters();
+  TestScanChunks();
+  TestScanExact();
+  TestScanProcess();
+  return boost::report_errors();
+}
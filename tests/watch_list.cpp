@@ -0,0 +1,304 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/watch_list.hpp>
+#include <hadesmem/watch_list.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+#include <hadesmem/detail/spsc_queue.hpp>
+#include <hadesmem/error.hpp>
+#include <hadesmem/memory_source.hpp>
+
+namespace
+{
+// Counts the reads and writes, and serializes them with changes made by the
+// test so that the background thread doesn't race with it.
+class CountingSource
+{
+public:
+  CountingSource(void* data, std::size_t size) : source_{data, size}
+  {
+  }
+
+  void Read(void* address, void* data, std::size_t len) const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++reads_;
+    source_.Read(address, data, len);
+  }
+
+  void Write(void* address, void const* data, std::size_t len) const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++writes_;
+    source_.Write(address, data, len);
+  }
+
+  template <typename T> void Set(void* address, T value)
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::memcpy(address, &value, sizeof(value));
+  }
+
+  template <typename T> T Get(void* address) const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    T value;
+    std::memcpy(&value, address, sizeof(value));
+    return value;
+  }
+
+  std::size_t GetReads() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return reads_;
+  }
+
+  std::size_t GetWrites() const
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return writes_;
+  }
+
+private:
+  hadesmem::BufferMemorySource source_;
+  mutable std::mutex mutex_;
+  mutable std::size_t reads_{0};
+  mutable std::size_t writes_{0};
+};
+}
+
+void TestSpscQueue()
+{
+  hadesmem::detail::SpscQueue<int> queue{3};
+  BOOST_TEST_EQ(queue.GetCapacity(), 4U);
+  for (int i = 0; i < 4; ++i)
+  {
+    BOOST_TEST(queue.TryPush(i));
+  }
+  BOOST_TEST(!queue.TryPush(4));
+  int value = -1;
+  BOOST_TEST(queue.TryPop(value));
+  BOOST_TEST_EQ(value, 0);
+  BOOST_TEST(queue.TryPush(4));
+
+  // Everything arrives, in order, when one thread pushes while another pops.
+  hadesmem::detail::SpscQueue<int> shared{16};
+  int const count = 100000;
+  std::thread producer{[&]() {
+    for (int i = 0; i < count;)
+    {
+      if (shared.TryPush(i))
+      {
+        ++i;
+      }
+    }
+  }};
+  int expected = 0;
+  bool in_order = true;
+  while (expected < count)
+  {
+    int v;
+    if (shared.TryPop(v))
+    {
+      in_order = in_order && v == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+  BOOST_TEST(in_order);
+}
+
+void TestWatchList()
+{
+  std::vector<std::uint8_t> buf(0x5000);
+  CountingSource source{buf.data(), buf.size()};
+  hadesmem::WatchList<CountingSource> watches{source};
+
+  // Two pages with a few values each, and a third with a frozen array of
+  // adjacent values.
+  auto const health = hadesmem::detail::kWatchPageSize + 0x10;
+  auto const ammo = hadesmem::detail::kWatchPageSize + 0x40;
+  auto const pos = 0x100;
+  auto const frozen = 3 * hadesmem::detail::kWatchPageSize;
+  source.Set<std::int32_t>(&buf[health], 100);
+  source.Set<float>(&buf[pos], 1.5f);
+  auto const health_id = watches.Watch<std::int32_t>(&buf[health]);
+  auto const ammo_id = watches.Watch<std::int16_t>(&buf[ammo]);
+  std::vector<float> callbacks;
+  auto const pos_id =
+    watches.Watch<float>(&buf[pos], [&](hadesmem::WatchEvent const& event) {
+      callbacks.push_back(event.GetNewValue<float>());
+    });
+  for (std::size_t i = 0; i < 8; ++i)
+  {
+    watches.Freeze<std::int32_t>(&buf[frozen + i * 4], 999);
+  }
+  BOOST_TEST_EQ(watches.GetSize(), 11U);
+
+  // The first poll only reads the values, one read per page, and writes all
+  // of the frozen values at once.
+  BOOST_TEST_EQ(watches.Poll(), 3U);
+  BOOST_TEST_EQ(source.GetReads(), 3U);
+  BOOST_TEST_EQ(source.GetWrites(), 1U);
+  BOOST_TEST_EQ(source.Get<std::int32_t>(&buf[frozen + 28]), 999);
+  std::int32_t value = 0;
+  BOOST_TEST(watches.GetValue(health_id, value));
+  BOOST_TEST_EQ(value, 100);
+  hadesmem::WatchEvent event{};
+  BOOST_TEST(!watches.PopEvent(event));
+
+  // Nothing changed, so nothing is written.
+  watches.Poll();
+  BOOST_TEST_EQ(source.GetWrites(), 1U);
+
+  source.Set<std::int32_t>(&buf[health], 75);
+  source.Set<float>(&buf[pos], 2.5f);
+  source.Set<std::int32_t>(&buf[frozen + 8], 0);
+  source.Set<std::int32_t>(&buf[frozen + 12], 0);
+  watches.Poll();
+  BOOST_TEST_EQ(source.GetWrites(), 2U);
+  BOOST_TEST_EQ(source.Get<std::int32_t>(&buf[frozen + 8]), 999);
+  BOOST_TEST_EQ(source.Get<std::int32_t>(&buf[frozen + 12]), 999);
+
+  // Events are ordered by address within a poll.
+  BOOST_TEST(watches.PopEvent(event));
+  BOOST_TEST(event.type == hadesmem::WatchEventType::kChanged);
+  BOOST_TEST_EQ(event.id, pos_id);
+  BOOST_TEST(watches.PopEvent(event));
+  BOOST_TEST_EQ(event.id, health_id);
+  BOOST_TEST_EQ(event.GetOldValue<std::int32_t>(), 100);
+  BOOST_TEST_EQ(event.GetNewValue<std::int32_t>(), 75);
+  BOOST_TEST(!watches.PopEvent(event));
+
+  // Callbacks are called when the events are dispatched.
+  source.Set<float>(&buf[pos], 1.5f);
+  watches.Poll();
+  source.Set<float>(&buf[pos], 2.5f);
+  watches.Poll();
+  BOOST_TEST_EQ(watches.DispatchEvents(), 2U);
+  BOOST_TEST_EQ(callbacks.size(), 2U);
+  BOOST_TEST(callbacks.size() == 2 && callbacks[0] == 1.5f &&
+             callbacks[1] == 2.5f);
+
+  // Removed entries are no longer read.
+  watches.Remove(ammo_id);
+  watches.Remove(health_id);
+  std::size_t const reads = source.GetReads();
+  BOOST_TEST_EQ(watches.Poll(), 2U);
+  BOOST_TEST_EQ(source.GetReads(), reads + 2);
+
+  // Values which can't be read are reported once. The value straddles the end
+  // of the buffer, on a page of its own.
+  auto const bad_id = watches.Watch<std::int32_t>(&buf[0] + buf.size() - 2);
+  watches.Poll();
+  watches.Poll();
+  BOOST_TEST(watches.PopEvent(event));
+  BOOST_TEST(event.type == hadesmem::WatchEventType::kReadFailed);
+  BOOST_TEST_EQ(event.id, bad_id);
+  BOOST_TEST(!watches.PopEvent(event));
+
+  auto const stats = watches.GetStats();
+  BOOST_TEST_EQ(stats.writes, 2U);
+  BOOST_TEST_EQ(stats.dropped_events, 0U);
+}
+
+void TestWatchListBudget()
+{
+  std::vector<std::uint8_t> buf(0x10000);
+  CountingSource source{buf.data(), buf.size()};
+  hadesmem::WatchListOptions options;
+  options.max_pages_per_poll = 3;
+  options.queue_capacity = 4;
+  hadesmem::WatchList<CountingSource> watches{source, options};
+
+  std::size_t const num_pages = buf.size() / hadesmem::detail::kWatchPageSize;
+  for (std::size_t i = 0; i < num_pages; ++i)
+  {
+    watches.Watch<std::uint8_t>(&buf[i * hadesmem::detail::kWatchPageSize]);
+  }
+
+  // Every page is polled once every few polls, never more than 3 at a time.
+  std::size_t const polls = (num_pages + 2) / 3;
+  for (std::size_t i = 0; i < polls; ++i)
+  {
+    BOOST_TEST_EQ(watches.Poll(), 3U);
+  }
+  BOOST_TEST_EQ(source.GetReads(), polls * 3);
+
+  for (std::size_t i = 0; i < num_pages; ++i)
+  {
+    source.Set<std::uint8_t>(&buf[i * hadesmem::detail::kWatchPageSize], 1);
+  }
+  for (std::size_t i = 0; i < polls; ++i)
+  {
+    watches.Poll();
+  }
+
+  // The queue only has room for 4 events.
+  BOOST_TEST_EQ(watches.DispatchEvents(), 4U);
+  BOOST_TEST_EQ(watches.GetStats().dropped_events, num_pages - 4);
+}
+
+void TestWatchListBackground()
+{
+  std::vector<std::uint8_t> buf(0x2000);
+  CountingSource source{buf.data(), buf.size()};
+  hadesmem::WatchListOptions options;
+  options.interval = std::chrono::milliseconds{1};
+  hadesmem::WatchList<CountingSource> watches{source, options};
+  watches.Freeze<std::uint32_t>(&buf[0x1000], 0xDEADBEEF);
+  auto const id = watches.Watch<std::uint32_t>(&buf[0x10]);
+  watches.Start();
+
+  auto const wait_for = [](auto pred) {
+    for (std::size_t i = 0; i < 5000; ++i)
+    {
+      if (pred())
+      {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return false;
+  };
+  BOOST_TEST(wait_for(
+    [&]() { return source.Get<std::uint32_t>(&buf[0x1000]) == 0xDEADBEEF; }));
+
+  // Wait for the watched value to be read before changing it.
+  BOOST_TEST(wait_for([&]() {
+    std::uint32_t v;
+    return watches.GetValue(id, v);
+  }));
+  source.Set<std::uint32_t>(&buf[0x10], 42);
+  hadesmem::WatchEvent event{};
+  BOOST_TEST(wait_for([&]() { return watches.PopEvent(event); }));
+  BOOST_TEST_EQ(event.GetNewValue<std::uint32_t>(), 42U);
+
+  watches.Stop();
+  watches.Stop();
+  std::size_t const polls = watches.GetStats().polls;
+  std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  BOOST_TEST_EQ(watches.GetStats().polls, polls);
+}
+
+int main()
+{
+  TestSpscQueue();
+  TestWatchList();
+  TestWatchListBudget();
+  TestWatchListBackground();
+  return boost::report_errors();
+}
@@ -112,6 +112,16 @@ void TestWritePod()
     nullptr, sizeof(void*), MEM_RESERVE | MEM_COMMIT, PAGE_READONLY);
   BOOST_TEST(readonly_page != nullptr);
   hadesmem::Write(process, readonly_page, static_cast<void*>(nullptr));
+
+  // kAssumeAccessible should fall back to the guarded path when the direct
+  // write fails.
+  std::uint32_t const assume_flags = hadesmem::WriteFlags::kAssumeAccessible;
+  std::int32_t assume_int = 0;
+  hadesmem::WriteEx(process, &assume_int, 1234, assume_flags);
+  BOOST_TEST_EQ(assume_int, 1234);
+  hadesmem::WriteEx(process, noaccess_page, assume_int, assume_flags);
+  hadesmem::WriteEx(process, readonly_page, assume_int, assume_flags);
+  BOOST_TEST_EQ(*static_cast<std::int32_t*>(readonly_page), 1234);
 }
 
 void TestWriteString()
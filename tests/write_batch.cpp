@@ -0,0 +1,158 @@
+// Copyright (C) 2010-2015 Joshua Boyce
+// See the file COPYING for copying permission.
+
+#include <hadesmem/detail/write_batch.hpp>
+#include <hadesmem/detail/write_batch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <hadesmem/detail/warning_disable_prefix.hpp>
+#include <boost/detail/lightweight_test.hpp>
+#include <hadesmem/detail/warning_disable_suffix.hpp>
+
+#include <hadesmem/config.hpp>
+
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+#include <hadesmem/error.hpp>
+#include <hadesmem/process.hpp>
+#include <hadesmem/protect.hpp>
+#include <hadesmem/write_batch.hpp>
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+
+void TestMakeWriteRuns()
+{
+  using Bytes = std::vector<std::uint8_t>;
+  std::vector<hadesmem::detail::WriteBatchEntry> entries{
+    {0x1010, Bytes{1, 2, 3, 4}},
+    {0x1000, Bytes{5, 6}},
+    // Touches the first entry, so it's merged.
+    {0x1014, Bytes{7}},
+    // Overlaps the first entry and was added later, so it wins.
+    {0x1012, Bytes{8, 9}},
+    {0x6000, Bytes{}},
+    {0x5FFF, Bytes{10, 11}}};
+  auto const runs = hadesmem::detail::MakeWriteRuns(entries);
+  BOOST_TEST_EQ(runs.size(), 3U);
+  BOOST_TEST_EQ(runs[0].address, 0x1000U);
+  BOOST_TEST(runs[0].data == (Bytes{5, 6}));
+  BOOST_TEST_EQ(runs[1].address, 0x1010U);
+  BOOST_TEST(runs[1].data == (Bytes{1, 2, 8, 9, 7}));
+  BOOST_TEST_EQ(runs[2].address, 0x5FFFU);
+  BOOST_TEST(runs[2].data == (Bytes{10, 11}));
+
+  // A write which is completely covered by an earlier one.
+  std::vector<hadesmem::detail::WriteBatchEntry> nested{
+    {0x1000, Bytes{1, 2, 3, 4}}, {0x1001, Bytes{5}}, {0x1000, Bytes{6}}};
+  auto const nested_runs = hadesmem::detail::MakeWriteRuns(nested);
+  BOOST_TEST_EQ(nested_runs.size(), 1U);
+  BOOST_TEST(nested_runs[0].data == (Bytes{6, 5, 3, 4}));
+
+  // Runs 0 and 1 share a page, and run 2 straddles two pages.
+  auto const pages = hadesmem::detail::GetWriteRunPages(runs, 0x1000);
+  BOOST_TEST_EQ(pages.size(), 2U);
+  BOOST_TEST_EQ(pages[0].first, 0x1000U);
+  BOOST_TEST_EQ(pages[0].second, 0x2000U);
+  BOOST_TEST_EQ(pages[1].first, 0x5000U);
+  BOOST_TEST_EQ(pages[1].second, 0x7000U);
+
+  // Consecutive pages are combined into a single range.
+  std::vector<hadesmem::detail::WriteBatchEntry> adjacent{
+    {0x1FFF, Bytes{1}}, {0x2000, Bytes{2}}, {0x3800, Bytes{3}}};
+  auto const adjacent_pages = hadesmem::detail::GetWriteRunPages(
+    hadesmem::detail::MakeWriteRuns(adjacent), 0x1000);
+  BOOST_TEST_EQ(adjacent_pages.size(), 1U);
+  BOOST_TEST_EQ(adjacent_pages[0].first, 0x1000U);
+  BOOST_TEST_EQ(adjacent_pages[0].second, 0x4000U);
+
+  BOOST_TEST(hadesmem::detail::MakeWriteRuns({}).empty());
+}
+
+void TestWriteBatch()
+{
+#if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+  hadesmem::Process const process(::GetCurrentProcessId());
+
+  SYSTEM_INFO sys_info{};
+  ::GetSystemInfo(&sys_info);
+  std::size_t const page_size = sys_info.dwPageSize;
+
+  auto const mem = static_cast<std::uint8_t*>(::VirtualAlloc(
+    nullptr, page_size * 4, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+  BOOST_TEST(mem != nullptr);
+  DWORD old_protect = 0;
+  BOOST_TEST(
+    ::VirtualProtect(mem, page_size * 2, PAGE_EXECUTE_READ, &old_protect));
+
+  // Many small patches spread over two read-only pages and one writable page.
+  hadesmem::WriteBatch batch{process};
+  std::size_t const kNumPatches = 300;
+  for (std::size_t i = 0; i < kNumPatches; ++i)
+  {
+    batch.Add(mem + i * (page_size * 3 / kNumPatches),
+              static_cast<std::uint8_t>(0xCC));
+  }
+  batch.Add(mem + page_size - 2, std::uint32_t{0x11223344});
+  BOOST_TEST_EQ(batch.GetSize(), kNumPatches + 1);
+
+  auto const stats = batch.Apply();
+  BOOST_TEST(batch.IsApplied());
+  BOOST_TEST_EQ(stats.suspensions, 1U);
+  // One change and one restore for the read-only pages, which form a single
+  // range since they're in the same region.
+  BOOST_TEST_EQ(stats.protect_changes, 2U);
+  // None of the patches touch, so each is its own run.
+  BOOST_TEST_EQ(stats.writes, kNumPatches + 1);
+  BOOST_TEST_EQ(stats.flushes, kNumPatches + 1);
+  BOOST_TEST_EQ(mem[0], 0xCC);
+  BOOST_TEST_EQ(*reinterpret_cast<std::uint32_t*>(mem + page_size - 2),
+                0x11223344U);
+  BOOST_TEST(!hadesmem::CanWrite(process, mem));
+  BOOST_TEST(hadesmem::CanExecute(process, mem));
+  BOOST_TEST(hadesmem::CanWrite(process, mem + page_size * 2));
+
+  BOOST_TEST_THROWS(batch.Add(mem, std::uint8_t{0}), hadesmem::Error);
+
+  batch.Revert();
+  BOOST_TEST(!batch.IsApplied());
+  for (std::size_t i = 0; i < page_size * 3; ++i)
+  {
+    BOOST_TEST_EQ(mem[i], 0);
+  }
+  BOOST_TEST(!hadesmem::CanWrite(process, mem));
+
+  // A failure anywhere in the batch leaves the target untouched.
+  BOOST_TEST(::VirtualFree(mem + page_size * 3, page_size, MEM_DECOMMIT));
+  hadesmem::WriteBatch bad_batch{process};
+  bad_batch.Add(mem, std::uint32_t{0xDEADBEEF});
+  bad_batch.Add(mem + page_size * 3, std::uint32_t{0xDEADBEEF});
+  BOOST_TEST_THROWS(bad_batch.Apply(), hadesmem::Error);
+  BOOST_TEST(!bad_batch.IsApplied());
+  BOOST_TEST_EQ(*reinterpret_cast<std::uint32_t*>(mem), 0U);
+  BOOST_TEST(!hadesmem::CanWrite(process, mem));
+
+  // A failure after the protection of some of the targets has been changed
+  // restores it, and leaves the batch applied so that it matches the target.
+  hadesmem::WriteBatch fail_batch{process};
+  fail_batch.Add(mem, std::uint32_t{0xDEADBEEF});
+  fail_batch.Add(mem + page_size * 2, std::uint32_t{0xDEADBEEF});
+  fail_batch.Apply(hadesmem::WriteBatchFlags::kFlushInstructionCache);
+  BOOST_TEST(fail_batch.IsApplied());
+  BOOST_TEST(::VirtualFree(mem + page_size * 2, page_size, MEM_DECOMMIT));
+  BOOST_TEST_THROWS(fail_batch.Revert(), hadesmem::Error);
+  BOOST_TEST(fail_batch.IsApplied());
+  BOOST_TEST_EQ(*reinterpret_cast<std::uint32_t*>(mem), 0xDEADBEEFU);
+  BOOST_TEST(!hadesmem::CanWrite(process, mem));
+  BOOST_TEST(hadesmem::CanExecute(process, mem));
+
+  BOOST_TEST(::VirtualFree(mem, 0, MEM_RELEASE));
+#endif // #if defined(HADESMEM_DETAIL_PLATFORM_WINDOWS)
+}
+
+int main()
+{
+  TestMakeWriteRuns();
+  TestWriteBatch();
+  return boost::report_errors();
+}